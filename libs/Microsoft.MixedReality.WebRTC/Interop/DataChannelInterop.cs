@@ -54,6 +54,8 @@ namespace Microsoft.MixedReality.WebRTC.Interop
             public uint flags;
             [MarshalAs(UnmanagedType.LPStr)]
             public string label;
+            public int maxRetransmits;
+            public int maxPacketLifeTimeMs;
         }
 
         [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
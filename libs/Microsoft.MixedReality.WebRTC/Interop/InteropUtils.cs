@@ -151,6 +151,10 @@ namespace Microsoft.MixedReality.WebRTC.Interop
             EntryPoint = "mrsLibraryUseAudioDeviceModule")]
         public static unsafe extern uint LibraryUseAudioDeviceModule(AudioDeviceModule adm);
 
+        [DllImport(dllPath, CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Ansi,
+            EntryPoint = "mrsLibrarySetThreadGroupCount")]
+        public static unsafe extern uint LibrarySetThreadGroupCount(uint count);
+
         [DllImport(dllPath, CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Ansi,
             EntryPoint = "mrsLibraryGetAudioDeviceModule")]
         public static unsafe extern AudioDeviceModule LibraryGetAudioDeviceModule();
@@ -18,6 +18,7 @@ namespace Microsoft.MixedReality.WebRTC.Interop
         {
             [MarshalAs(UnmanagedType.LPStr)]
             public string TrackName;
+            public int ThreadGroup;
         }
 
 
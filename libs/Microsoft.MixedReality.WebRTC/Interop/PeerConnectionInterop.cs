@@ -243,6 +243,9 @@ namespace Microsoft.MixedReality.WebRTC.Interop
             public IceTransportType IceTransportType;
             public BundlePolicy BundlePolicy;
             public SdpSemantic SdpSemantic;
+            public int IceCandidatePoolSize;
+            public ContinualGatheringPolicy ContinualGatheringPolicy;
+            public int ThreadGroup;
         }
 
         [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
@@ -528,6 +531,10 @@ namespace Microsoft.MixedReality.WebRTC.Interop
             EntryPoint = "mrsPeerConnectionCreateAnswer")]
         public static extern uint PeerConnection_CreateAnswer(PeerConnectionHandle peerHandle);
 
+        [DllImport(Utils.dllPath, CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Ansi,
+            EntryPoint = "mrsPeerConnectionPrewarm")]
+        public static extern uint PeerConnection_Prewarm(PeerConnectionHandle peerHandle, int poolSize);
+
         [DllImport(Utils.dllPath, CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Ansi,
             EntryPoint = "mrsPeerConnectionSetBitrate")]
         public static extern uint PeerConnection_SetBitrate(PeerConnectionHandle peerHandle, int minBitrate, int startBitrate, int maxBitrate);
@@ -541,6 +548,10 @@ namespace Microsoft.MixedReality.WebRTC.Interop
             EntryPoint = "mrsPeerConnectionClose")]
         public static extern uint PeerConnection_Close(PeerConnectionHandle peerHandle);
 
+        [DllImport(Utils.dllPath, CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Ansi,
+            EntryPoint = "mrsPeerConnectionGetThreadGroup")]
+        public static extern uint PeerConnection_GetThreadGroup(PeerConnectionHandle peerHandle, out int threadGroup);
+
         [DllImport(Utils.dllPath, CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Ansi,
             EntryPoint = "mrsPeerConnectionGetSimpleStats")]
         public static extern void PeerConnection_GetSimpleStats(PeerConnectionHandle peerHandle, PeerConnectionSimpleStatsCallback callback, IntPtr userData);
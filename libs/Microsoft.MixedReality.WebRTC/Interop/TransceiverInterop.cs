@@ -31,6 +31,11 @@ namespace Microsoft.MixedReality.WebRTC.Interop
         public static unsafe extern uint Transceiver_SetDirection(TransceiverHandle handle,
             Transceiver.Direction newDirection);
 
+        [DllImport(Utils.dllPath, CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Ansi,
+            EntryPoint = "mrsTransceiverSetVideoEncodingParameters")]
+        public static unsafe extern uint Transceiver_SetVideoEncodingParameters(TransceiverHandle handle,
+            [In] VideoEncodingParametersMarshal[] encodings, uint encodingCount);
+
         [DllImport(Utils.dllPath, CallingConvention = CallingConvention.StdCall, CharSet = CharSet.Ansi,
             EntryPoint = "mrsTransceiverSetLocalAudioTrack")]
         public static unsafe extern uint Transceiver_SetLocalAudioTrack(TransceiverHandle handle,
@@ -89,12 +94,86 @@ namespace Microsoft.MixedReality.WebRTC.Interop
             [MarshalAs(UnmanagedType.LPStr)]
             public string encodedStreamIds;
 
+            /// <summary>
+            /// Optional user data, unused by the C# library.
+            /// </summary>
+            public IntPtr userData;
+
+            /// <summary>
+            /// Unmanaged array of <see cref="VideoEncodingParametersMarshal"/> holding the send
+            /// encodings, or <c>IntPtr.Zero</c> for none. Must be released with <see cref="FreeSendEncodings"/>.
+            /// </summary>
+            public IntPtr sendEncodings;
+
+            /// <summary>
+            /// Number of elements in <see cref="sendEncodings"/>.
+            /// </summary>
+            public uint sendEncodingCount;
+
             public InitConfig(MediaKind mediaKind, TransceiverInitSettings settings)
             {
                 name = settings?.Name;
                 this.mediaKind = mediaKind;
                 desiredDirection = (settings != null ? settings.InitialDesiredDirection : new TransceiverInitSettings().InitialDesiredDirection);
                 encodedStreamIds = Utils.EncodeTransceiverStreamIDs(settings?.StreamIDs);
+                userData = IntPtr.Zero;
+                sendEncodings = IntPtr.Zero;
+                sendEncodingCount = 0;
+                var encodings = settings?.SendEncodings;
+                if ((encodings != null) && (encodings.Count > 0))
+                {
+                    int elementSize = Marshal.SizeOf<VideoEncodingParametersMarshal>();
+                    sendEncodings = Marshal.AllocHGlobal(elementSize * encodings.Count);
+                    foreach (var encoding in encodings)
+                    {
+                        var ptr = new IntPtr(sendEncodings.ToInt64() + elementSize * sendEncodingCount);
+                        Marshal.StructureToPtr(new VideoEncodingParametersMarshal(encoding), ptr, fDeleteOld: false);
+                        ++sendEncodingCount;
+                    }
+                }
+            }
+
+            /// <summary>
+            /// Release the unmanaged array of send encodings, if any.
+            /// </summary>
+            public void FreeSendEncodings()
+            {
+                if (sendEncodings == IntPtr.Zero)
+                {
+                    return;
+                }
+                int elementSize = Marshal.SizeOf<VideoEncodingParametersMarshal>();
+                for (uint i = 0; i < sendEncodingCount; ++i)
+                {
+                    var ptr = new IntPtr(sendEncodings.ToInt64() + elementSize * i);
+                    Marshal.DestroyStructure<VideoEncodingParametersMarshal>(ptr);
+                }
+                Marshal.FreeHGlobal(sendEncodings);
+                sendEncodings = IntPtr.Zero;
+                sendEncodingCount = 0;
+            }
+        }
+
+        /// <summary>
+        /// Marshaling struct for <see cref="VideoEncodingParameters"/>.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
+        internal struct VideoEncodingParametersMarshal
+        {
+            [MarshalAs(UnmanagedType.LPStr)]
+            public string rid;
+            public mrsBool active;
+            public double scaleResolutionDownBy;
+            public uint maxBitrateBps;
+            public uint maxFramerate;
+
+            public VideoEncodingParametersMarshal(VideoEncodingParameters encoding)
+            {
+                rid = encoding.Rid;
+                active = (mrsBool)encoding.Active;
+                scaleResolutionDownBy = encoding.ScaleResolutionDownBy;
+                maxBitrateBps = encoding.MaxBitrateBps;
+                maxFramerate = encoding.MaxFramerate;
             }
         }
 
@@ -20,7 +20,17 @@ namespace Microsoft.MixedReality.WebRTC
         /// <summary>
         /// New CoreAudio based audio device module (ADM2). This is the default.
         /// </summary>
-        DefaultModule = 2
+        DefaultModule = 2,
+
+        /// <summary>
+        /// Headless audio device module not using any audio device, driven by an internal
+        /// 10 ms timer. Audio flows through the entire pipeline as with a real device: the
+        /// recorded audio is sent to the remote peers, and the received audio is decoded
+        /// and mixed, then discarded instead of being played out. By default the recorded
+        /// audio is silence; the native configuration of the module can make it record a
+        /// looped audio clip instead. Available on all platforms except UWP.
+        /// </summary>
+        HeadlessModule = 3
     }
 
     /// <summary>
@@ -66,6 +76,30 @@ namespace Microsoft.MixedReality.WebRTC
             }
         }
 
+        /// <summary>
+        /// Set the number of thread groups created when the library is initialized, to spread the
+        /// packet processing of many concurrent peer connections across CPU cores. Each group has its
+        /// own WebRTC networking and worker threads, and each peer connection is assigned to a single
+        /// group, see <see cref="PeerConnectionConfiguration.ThreadGroup"/>.
+        /// </summary>
+        /// <remarks>
+        /// Only the first group uses <see cref="UsedAudioDeviceModule"/>. The other groups use a headless
+        /// audio device, so their peer connections do not capture from a microphone nor play out to a
+        /// speaker. Local video tracks must be created on the thread group of the peer connections
+        /// sending them, see <see cref="LocalVideoTrackInitConfig.threadGroup"/>. Peer connections use
+        /// the first group unless configured otherwise, either with an explicit index or with
+        /// <see cref="PeerConnectionConfiguration.RoundRobinThreadGroup"/>.
+        ///
+        /// This must be called before any peer connection is created/initialized; otherwise an
+        /// <see cref="InvalidOperationException"/> is raised.
+        /// </remarks>
+        /// <param name="count">Number of thread groups, at least 1.</param>
+        public static void SetThreadGroupCount(uint count)
+        {
+            uint res = Utils.LibrarySetThreadGroupCount(count);
+            Utils.ThrowOnErrorCode(res);
+        }
+
         /// <summary>
         /// Options for library shutdown.
         /// </summary>
@@ -89,6 +89,16 @@ namespace Microsoft.MixedReality.WebRTC
         /// random track name.
         /// </summary>
         public string trackName = string.Empty;
+
+        /// <summary>
+        /// Index of the thread group the track is bound to, which must be the thread group of the
+        /// peer connections sending the track, see <see cref="PeerConnection.ThreadGroup"/>. Like for
+        /// peer connections, the default is the first group, so this must be set explicitly for tracks
+        /// sent by connections of another group. Tracks cannot be assigned round-robin. Adding the track to a transceiver of a peer connection of another
+        /// thread group raises an <see cref="InvalidOperationException"/>.
+        /// </summary>
+        /// <seealso cref="Library.SetThreadGroupCount(uint)"/>
+        public int threadGroup = 0;
     }
 
     /// <summary>
@@ -241,7 +251,8 @@ namespace Microsoft.MixedReality.WebRTC
             }
             var config = new LocalVideoTrackInterop.TrackInitConfig
             {
-                TrackName = trackName
+                TrackName = trackName,
+                ThreadGroup = initConfig?.threadGroup ?? 0
             };
 
             // Create interop wrappers
@@ -83,6 +83,23 @@ namespace Microsoft.MixedReality.WebRTC
         PlanB = 1
     }
 
+    /// <summary>
+    /// Policy for gathering local ICE candidates.
+    /// </summary>
+    public enum ContinualGatheringPolicy : int
+    {
+        /// <summary>
+        /// Gather candidates once, until ICE gathering completes.
+        /// </summary>
+        GatherOnce = 0,
+
+        /// <summary>
+        /// Keep gathering candidates for the lifetime of the connection, so that network changes
+        /// produce new candidates without an ICE restart. ICE gathering never completes with this policy.
+        /// </summary>
+        GatherContinually = 1
+    }
+
     /// <summary>
     /// ICE server configuration (STUN and/or TURN).
     /// </summary>
@@ -157,6 +174,32 @@ namespace Microsoft.MixedReality.WebRTC
         /// </summary>
         /// <remarks>Plan B is deprecated, do not use it.</remarks>
         public SdpSemantic SdpSemantic = SdpSemantic.UnifiedPlan;
+
+        /// <summary>
+        /// Number of sets of ICE candidates to pre-gather as soon as the connection is created, each
+        /// set serving one ICE transport. This shortens the time to connect, at the expense of
+        /// contacting the ICE servers before an offer or answer is created.
+        /// </summary>
+        public int IceCandidatePoolSize = 0;
+
+        /// <summary>
+        /// Policy for gathering local ICE candidates.
+        /// </summary>
+        public ContinualGatheringPolicy ContinualGatheringPolicy = ContinualGatheringPolicy.GatherOnce;
+
+        /// <summary>
+        /// Value of <see cref="ThreadGroup"/> assigning the connection to the next thread group in
+        /// round-robin order, including the groups using a headless audio device.
+        /// </summary>
+        public const int RoundRobinThreadGroup = -2;
+
+        /// <summary>
+        /// Index of the thread group to assign the connection to, or <see cref="RoundRobinThreadGroup"/>
+        /// to assign thread groups to connections in round-robin order. The default is the first group,
+        /// the only one using the audio device of the library. Other negative values are invalid.
+        /// </summary>
+        /// <seealso cref="Library.SetThreadGroupCount(uint)"/>
+        public int ThreadGroup = 0;
     }
 
     /// <summary>
@@ -299,6 +342,58 @@ namespace Microsoft.MixedReality.WebRTC
         /// List of stream IDs to associate the transceiver with.
         /// </summary>
         public List<string> StreamIDs;
+
+        /// <summary>
+        /// Optional list of encodings sent by a video transceiver, or <c>null</c> for a single encoding
+        /// with default parameters. Configuring more than one encoding would enable simulcast, but the
+        /// underlying WebRTC implementation cannot negotiate it, so this raises a
+        /// <see cref="NotSupportedException"/>. With <see cref="SdpSemantic.PlanB"/> the encoding cannot
+        /// be configured on creation. Must be <c>null</c> for audio transceivers.
+        /// </summary>
+        /// <seealso cref="Transceiver.SetVideoEncodingParameters(IList{VideoEncodingParameters})"/>
+        public List<VideoEncodingParameters> SendEncodings;
+    }
+
+    /// <summary>
+    /// Parameters of one encoding sent by a video transceiver.
+    ///
+    /// Sending several encodings of the same video track, each at a different resolution and bitrate,
+    /// allows a selective forwarding unit (SFU) to forward to each remote peer the encoding best suited
+    /// to its bandwidth (simulcast).
+    /// </summary>
+    public class VideoEncodingParameters
+    {
+        /// <summary>
+        /// RTP stream ID (RID) of the encoding. This must be a valid SDP token. Required and unique when
+        /// several encodings are configured, optional otherwise. The RID of an existing encoding cannot
+        /// be changed.
+        /// </summary>
+        public string Rid;
+
+        /// <summary>
+        /// Send the encoding. Inactive encodings are not encoded at all, and can be reactivated without
+        /// any renegotiation.
+        /// </summary>
+        public bool Active = true;
+
+        /// <summary>
+        /// Factor by which the resolution of the video track is scaled down before being encoded, e.g.
+        /// 2.0 for half the width and half the height. Must be 0 to let the implementation choose, or
+        /// greater than or equal to 1.0.
+        /// </summary>
+        public double ScaleResolutionDownBy = 0.0;
+
+        /// <summary>
+        /// Maximum bitrate of the encoding, in bits per second, or 0 for no limit other than the
+        /// bandwidth estimate.
+        /// </summary>
+        public uint MaxBitrateBps = 0;
+
+        /// <summary>
+        /// Maximum framerate of the encoding, in frames per second, or 0 for no limit other than the
+        /// framerate of the video track.
+        /// </summary>
+        public uint MaxFramerate = 0;
     }
 
     /// <summary>
@@ -767,6 +862,24 @@ namespace Microsoft.MixedReality.WebRTC
         /// </remarks>
         public bool IsConnected { get; private set; } = false;
 
+        /// <summary>
+        /// Index of the thread group the peer connection was assigned to when initialized. The local
+        /// video tracks sent by this connection must be created for that thread group, see
+        /// <see cref="LocalVideoTrackInitConfig.threadGroup"/>.
+        /// </summary>
+        /// <exception xref="InvalidOperationException">The peer connection is not initialized.</exception>
+        /// <seealso cref="PeerConnectionConfiguration.ThreadGroup"/>
+        public int ThreadGroup
+        {
+            get
+            {
+                ThrowIfConnectionNotOpen();
+                uint res = PeerConnectionInterop.PeerConnection_GetThreadGroup(_nativePeerhandle, out int threadGroup);
+                Utils.ThrowOnErrorCode(res);
+                return threadGroup;
+            }
+        }
+
         /// <summary>
         /// Collection of transceivers for the peer connection. Once a transceiver is added
         /// to the peer connection, it cannot be removed, but its tracks can be changed.
@@ -1103,11 +1216,17 @@ namespace Microsoft.MixedReality.WebRTC
                             IceTransportType = config.IceTransportType,
                             BundlePolicy = config.BundlePolicy,
                             SdpSemantic = config.SdpSemantic,
+                            IceCandidatePoolSize = config.IceCandidatePoolSize,
+                            ContinualGatheringPolicy = config.ContinualGatheringPolicy,
+                            ThreadGroup = config.ThreadGroup,
                         };
                     }
                     else
                     {
-                        nativeConfig = new PeerConnectionInterop.PeerConnectionConfiguration();
+                        nativeConfig = new PeerConnectionInterop.PeerConnectionConfiguration
+                        {
+                            ThreadGroup = 0,
+                        };
                     }
 
                     uint res = PeerConnectionInterop.PeerConnection_Create(nativeConfig, out _nativePeerhandle);
@@ -1316,8 +1435,17 @@ namespace Microsoft.MixedReality.WebRTC
                 // Create the transceiver implementation
                 settings = settings ?? new TransceiverInitSettings();
                 TransceiverInterop.InitConfig config = new TransceiverInterop.InitConfig(mediaKind, settings);
-                uint res = PeerConnectionInterop.PeerConnection_AddTransceiver(_nativePeerhandle, config,
-                    out IntPtr transceiverHandle);
+                uint res;
+                IntPtr transceiverHandle;
+                try
+                {
+                    res = PeerConnectionInterop.PeerConnection_AddTransceiver(_nativePeerhandle, config,
+                        out transceiverHandle);
+                }
+                finally
+                {
+                    config.FreeSendEncodings();
+                }
                 Utils.ThrowOnErrorCode(res);
 
                 // The implementation fires the TransceiverAdded event, which creates the wrapper and
@@ -1369,12 +1497,50 @@ namespace Microsoft.MixedReality.WebRTC
         /// </remarks>
         public Task<DataChannel> AddDataChannelAsync(ushort id, string label, bool ordered, bool reliable,
             CancellationToken cancellationToken = default)
+        {
+            return AddDataChannelAsync(id, label, ordered, reliable, null, null, cancellationToken);
+        }
+
+        /// <summary>
+        /// Add a new out-of-band data channel with the given ID, optionally partially reliable.
+        ///
+        /// This is identical to <see cref="AddDataChannelAsync(ushort, string, bool, bool, CancellationToken)"/>,
+        /// but additionally allows limiting the number of retransmissions or the lifetime of a message on an
+        /// unreliable data channel.
+        /// </summary>
+        /// <param name="id">The unique data channel identifier to use.</param>
+        /// <param name="label">The data channel name.</param>
+        /// <param name="ordered">Indicates whether data channel messages are ordered (see
+        /// <see cref="DataChannel.Ordered"/>).</param>
+        /// <param name="reliable">Indicates whether data channel messages are reliably delivered
+        /// (see <see cref="DataChannel.Reliable"/>).</param>
+        /// <param name="maxRetransmits">Maximum number of retransmissions of a message before
+        /// it is dropped, or <c>null</c> for no limit. Setting a limit makes the channel partially reliable, which requires
+        /// <paramref name="reliable"/> to be <c>false</c>. Cannot be combined with
+        /// <paramref name="maxPacketLifeTimeMs"/>.</param>
+        /// <param name="maxPacketLifeTimeMs">Maximum time in milliseconds during which a message
+        /// is retransmitted before being dropped, or <c>null</c> for no limit. Setting a limit makes the channel partially reliable,
+        /// which requires <paramref name="reliable"/> to be <c>false</c>. Cannot be combined with
+        /// <paramref name="maxRetransmits"/>.</param>
+        /// <param name="cancellationToken">Cancellation token for the task returned.</param>
+        /// <returns>Returns a task which completes once the data channel is created.</returns>
+        /// <exception xref="InvalidOperationException">The peer connection is not initialized.</exception>
+        /// <exception cref="SctpNotNegotiatedException">SCTP not negotiated. Call <see cref="CreateOffer()"/> first.</exception>
+        /// <exception xref="ArgumentOutOfRangeException">Invalid data channel ID, must be in [0:65535].</exception>
+        /// <exception xref="ArgumentOutOfRangeException">Negative retransmit or packet lifetime limit.</exception>
+        /// <exception xref="ArgumentException">Both a retransmit and a packet lifetime limit are specified,
+        /// or a limit is specified for a reliable channel.</exception>
+        /// <remarks>
+        /// See the critical remark about SCTP handshake in <see cref="AddDataChannelAsync(ushort, string, bool, bool, CancellationToken)"/>.
+        /// </remarks>
+        public Task<DataChannel> AddDataChannelAsync(ushort id, string label, bool ordered, bool reliable,
+            int? maxRetransmits, int? maxPacketLifeTimeMs, CancellationToken cancellationToken = default)
         {
             if (id < 0)
             {
                 throw new ArgumentOutOfRangeException("id", id, "Data channel ID must be greater than or equal to zero.");
             }
-            return AddDataChannelAsyncImpl(id, label, ordered, reliable, cancellationToken);
+            return AddDataChannelAsyncImpl(id, label, ordered, reliable, maxRetransmits, maxPacketLifeTimeMs, cancellationToken);
         }
 
         /// <summary>
@@ -1405,7 +1571,44 @@ namespace Microsoft.MixedReality.WebRTC
         public Task<DataChannel> AddDataChannelAsync(string label, bool ordered, bool reliable,
             CancellationToken cancellationToken = default)
         {
-            return AddDataChannelAsyncImpl(-1, label, ordered, reliable, cancellationToken);
+            return AddDataChannelAsyncImpl(-1, label, ordered, reliable, null, null, cancellationToken);
+        }
+
+        /// <summary>
+        /// Add a new in-band data channel whose ID will be determined by the implementation, optionally
+        /// partially reliable.
+        ///
+        /// This is identical to <see cref="AddDataChannelAsync(string, bool, bool, CancellationToken)"/>,
+        /// but additionally allows limiting the number of retransmissions or the lifetime of a message on an
+        /// unreliable data channel.
+        /// </summary>
+        /// <param name="label">The data channel name.</param>
+        /// <param name="ordered">Indicates whether data channel messages are ordered (see
+        /// <see cref="DataChannel.Ordered"/>).</param>
+        /// <param name="reliable">Indicates whether data channel messages are reliably delivered
+        /// (see <see cref="DataChannel.Reliable"/>).</param>
+        /// <param name="maxRetransmits">Maximum number of retransmissions of a message before
+        /// it is dropped, or <c>null</c> for no limit. Setting a limit makes the channel partially reliable, which requires
+        /// <paramref name="reliable"/> to be <c>false</c>. Cannot be combined with
+        /// <paramref name="maxPacketLifeTimeMs"/>.</param>
+        /// <param name="maxPacketLifeTimeMs">Maximum time in milliseconds during which a message
+        /// is retransmitted before being dropped, or <c>null</c> for no limit. Setting a limit makes the channel partially reliable,
+        /// which requires <paramref name="reliable"/> to be <c>false</c>. Cannot be combined with
+        /// <paramref name="maxRetransmits"/>.</param>
+        /// <param name="cancellationToken">Cancellation token for the task returned.</param>
+        /// <returns>Returns a task which completes once the data channel is created.</returns>
+        /// <exception xref="System.InvalidOperationException">The peer connection is not initialized.</exception>
+        /// <exception cref="SctpNotNegotiatedException">SCTP not negotiated. Call <see cref="CreateOffer()"/> first.</exception>
+        /// <exception xref="System.ArgumentOutOfRangeException">Negative retransmit or packet lifetime limit.</exception>
+        /// <exception xref="System.ArgumentException">Both a retransmit and a packet lifetime limit are specified,
+        /// or a limit is specified for a reliable channel.</exception>
+        /// <remarks>
+        /// See the critical remark about SCTP handshake in <see cref="AddDataChannelAsync(ushort, string, bool, bool, CancellationToken)"/>.
+        /// </remarks>
+        public Task<DataChannel> AddDataChannelAsync(string label, bool ordered, bool reliable,
+            int? maxRetransmits, int? maxPacketLifeTimeMs, CancellationToken cancellationToken = default)
+        {
+            return AddDataChannelAsyncImpl(-1, label, ordered, reliable, maxRetransmits, maxPacketLifeTimeMs, cancellationToken);
         }
 
         /// <summary>
@@ -1417,15 +1620,42 @@ namespace Microsoft.MixedReality.WebRTC
         /// <see cref="DataChannel.Ordered"/>).</param>
         /// <param name="reliable">Indicates whether data channel messages are reliably delivered
         /// (see <see cref="DataChannel.Reliable"/>).</param>
+        /// <param name="maxRetransmits">Optional maximum number of retransmissions of a message before
+        /// it is dropped. Setting a limit makes the channel partially reliable, which requires
+        /// <paramref name="reliable"/> to be <c>false</c>. Cannot be combined with
+        /// <paramref name="maxPacketLifeTimeMs"/>.</param>
+        /// <param name="maxPacketLifeTimeMs">Optional maximum time in milliseconds during which a message
+        /// is retransmitted before being dropped. Setting a limit makes the channel partially reliable,
+        /// which requires <paramref name="reliable"/> to be <c>false</c>. Cannot be combined with
+        /// <paramref name="maxRetransmits"/>.</param>
         /// <param name="cancellationToken">Cancellation token for the task returned.</param>
         /// <returns>Returns a task which completes once the data channel is created.</returns>
         /// <exception xref="System.InvalidOperationException">The peer connection is not initialized.</exception>
         /// <exception xref="System.InvalidOperationException">SCTP not negotiated.</exception>
         /// <exception xref="System.ArgumentOutOfRangeException">Invalid data channel ID, must be in [0:65535].</exception>
+        /// <exception xref="System.ArgumentOutOfRangeException">Negative retransmit or packet lifetime limit.</exception>
+        /// <exception xref="System.ArgumentException">Both a retransmit and a packet lifetime limit are specified,
+        /// or a limit is specified for a reliable channel.</exception>
         private Task<DataChannel> AddDataChannelAsyncImpl(int id, string label, bool ordered, bool reliable,
-            CancellationToken cancellationToken)
+            int? maxRetransmits, int? maxPacketLifeTimeMs, CancellationToken cancellationToken)
         {
             ThrowIfConnectionNotOpen();
+            if (maxRetransmits.HasValue && (maxRetransmits.Value < 0))
+            {
+                throw new ArgumentOutOfRangeException("maxRetransmits", maxRetransmits.Value, "Maximum retransmit count must be greater than or equal to zero.");
+            }
+            if (maxPacketLifeTimeMs.HasValue && (maxPacketLifeTimeMs.Value < 0))
+            {
+                throw new ArgumentOutOfRangeException("maxPacketLifeTimeMs", maxPacketLifeTimeMs.Value, "Maximum packet lifetime must be greater than or equal to zero.");
+            }
+            if (maxRetransmits.HasValue && maxPacketLifeTimeMs.HasValue)
+            {
+                throw new ArgumentException("Cannot specify both a maximum retransmit count and a maximum packet lifetime.");
+            }
+            if (reliable && (maxRetransmits.HasValue || maxPacketLifeTimeMs.HasValue))
+            {
+                throw new ArgumentException("Cannot specify a retransmit or packet lifetime limit for a reliable data channel.");
+            }
 
             // Create the native data channel
             return Task.Run(() =>
@@ -1439,6 +1669,8 @@ namespace Microsoft.MixedReality.WebRTC
                     flags = (uint)((ordered ? DataChannelInterop.Flags.Ordered : DataChannelInterop.Flags.None)
                         | (reliable ? DataChannelInterop.Flags.Reliable : DataChannelInterop.Flags.None)),
                     label = label,
+                    maxRetransmits = maxRetransmits ?? -1,
+                    maxPacketLifeTimeMs = maxPacketLifeTimeMs ?? -1,
                 };
                 uint res = PeerConnectionInterop.PeerConnection_AddDataChannel(_nativePeerhandle, config, out IntPtr nativeHandle);
                 Utils.ThrowOnErrorCode(res);
@@ -1544,6 +1776,22 @@ namespace Microsoft.MixedReality.WebRTC
             return (PeerConnectionInterop.PeerConnection_CreateAnswer(_nativePeerhandle) == Utils.MRS_SUCCESS);
         }
 
+        /// <summary>
+        /// Start gathering ICE candidates ahead of the first offer or answer, to shorten the time
+        /// to connect once the remote peer is known. The pre-gathered candidates are used by the
+        /// first local description, so this must be called before <see cref="CreateOffer"/> or
+        /// <see cref="CreateAnswer"/>.
+        /// </summary>
+        /// <param name="poolSize">Minimum number of sets of ICE candidates to pre-gather, each set
+        /// serving one ICE transport (one per media line, or a single one when bundling).</param>
+        /// <seealso cref="PeerConnectionConfiguration.IceCandidatePoolSize"/>
+        public void Prewarm(int poolSize = 1)
+        {
+            ThrowIfConnectionNotOpen();
+            uint res = PeerConnectionInterop.PeerConnection_Prewarm(_nativePeerhandle, poolSize);
+            Utils.ThrowOnErrorCode(res);
+        }
+
         /// <summary>
         /// Set the bitrate allocated to all RTP streams sent by this connection.
         /// Other limitations might affect these limits and are respected (for example "b=AS" in SDP).
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 using System;
+using System.Collections.Generic;
 using System.Diagnostics;
 using Microsoft.MixedReality.WebRTC.Interop;
 
@@ -338,6 +339,39 @@ namespace Microsoft.MixedReality.WebRTC
             TransceiverInterop.RegisterCallbacks(this, out _argsRef);
         }
 
+        /// <summary>
+        /// Change the parameters of the encodings sent by a video transceiver, for example to
+        /// deactivate an encoding or lower its bitrate. This does not trigger any
+        /// renegotiation.
+        ///
+        /// The number of encodings cannot be changed after the transceiver was created, so the list
+        /// must contain as many encodings as <see cref="TransceiverInitSettings.SendEncodings"/>, or a
+        /// single one if the transceiver was created without any. Encodings are matched by position,
+        /// and their <see cref="VideoEncodingParameters.Rid"/> is ignored. With Plan B this requires a
+        /// local video track to be attached to the transceiver.
+        /// </summary>
+        /// <param name="encodings">The new parameters of the encodings.</param>
+        /// <exception xref="InvalidOperationException">The transceiver is not a video transceiver.</exception>
+        public void SetVideoEncodingParameters(IList<VideoEncodingParameters> encodings)
+        {
+            if (MediaKind != MediaKind.Video)
+            {
+                throw new InvalidOperationException("Cannot set video encoding parameters on audio transceiver.");
+            }
+            if (encodings == null)
+            {
+                throw new ArgumentNullException(nameof(encodings));
+            }
+            var encodingsMarshal = new TransceiverInterop.VideoEncodingParametersMarshal[encodings.Count];
+            for (int i = 0; i < encodings.Count; ++i)
+            {
+                encodingsMarshal[i] = new TransceiverInterop.VideoEncodingParametersMarshal(encodings[i]);
+            }
+            uint res = TransceiverInterop.Transceiver_SetVideoEncodingParameters(_nativeHandle,
+                encodingsMarshal, (uint)encodingsMarshal.Length);
+            Utils.ThrowOnErrorCode(res);
+        }
+
         /// <summary>
         /// Change the local audio track sending data to the remote peer.
         ///
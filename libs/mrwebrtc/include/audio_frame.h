@@ -31,6 +31,22 @@ struct AudioFrame {
   std::uint32_t sample_count_;
 };
 
+/// Audio level of an audio track, metered natively on each 10 ms audio frame.
+struct AudioLevel {
+  /// Root mean square of the samples of the last audio frame, normalized in
+  /// [0:1] where 1 is a full-scale square wave.
+  float rms_;
+
+  /// Absolute peak value of the samples of the last audio frame, normalized
+  /// in [0:1].
+  float peak_;
+
+  /// Result of a simple energy-based voice activity detector. This is set when
+  /// the level rises sufficiently above the estimated noise floor, and stays
+  /// set for a short hangover period after the level falls back.
+  bool voice_active_;
+};
+
 }  // namespace WebRTC
 }  // namespace MixedReality
 }  // namespace Microsoft
@@ -32,6 +32,124 @@ enum class mrsMessageKind : int32_t {
     kText = 2, 
 };
 
+/// Number of buckets of the message callback duration histogram of
+/// |mrsDataChannelMetrics|.
+constexpr size_t kMrsDataChannelHistogramSize = 6;
+
+/// Default maximum number of messages waiting in the receive queue of a data
+/// channel in polling mode. See |mrsDataChannelSetReceiveQueueCapacity()|.
+constexpr uint32_t kMrsDataChannelDefaultReceiveQueueCapacity = 4096;
+
+/// Metrics of a data channel, counted since its creation.
+struct mrsDataChannelMetrics {
+  /// Number and total byte size of the messages handed to the SCTP transport.
+  uint64_t messages_sent{0};
+  uint64_t bytes_sent{0};
+
+  /// Number and total byte size of the messages received.
+  uint64_t messages_received{0};
+  uint64_t bytes_received{0};
+
+  /// Number of messages which could not be sent, for example because the
+  /// internal buffer was full.
+  uint64_t send_rejections{0};
+
+  /// Number of messages received in polling mode which were dropped because
+  /// the receive queue was full.
+  uint64_t receive_drops{0};
+
+  /// Highest byte size of the data buffered by the SCTP transport.
+  uint64_t peak_buffered_amount{0};
+
+  /// Histogram of the time spent in the message callbacks for each received
+  /// message. Bucket #i counts the messages whose callbacks took less than
+  /// 10^(i+1) microseconds (and more than the previous bucket), with the last
+  /// bucket counting all longer durations.
+  uint64_t callback_duration_histogram[kMrsDataChannelHistogramSize]{};
+};
+
+/// Mode of delivery of the messages received on a data channel.
+enum class mrsDataChannelReceiveMode : int32_t {
+  /// Received messages are delivered to the message callbacks, from the WebRTC
+  /// signaling thread. This is the default.
+  kCallback = 0,
+
+  /// Received messages are queued, and retrieved by the application with
+  /// |mrsDataChannelReceive()|. Message callbacks are not invoked.
+  kPolling = 1,
+};
+
+/// Opaque handle to a message received with |mrsDataChannelReceive()|.
+using mrsDataChannelMessageHandle = void*;
+
+/// Message received with |mrsDataChannelReceive()|.
+struct mrsDataChannelReceivedMessage {
+  /// Kind of the message.
+  mrsMessageKind kind{mrsMessageKind::kBinary};
+
+  /// Message content, of byte length |size|. This is valid until the message
+  /// is released with |mrsDataChannelReleaseMessages()|.
+  const void* data{nullptr};
+  uint64_t size{0};
+
+  /// Handle owning the message content.
+  mrsDataChannelMessageHandle handle{nullptr};
+};
+
+/// Configuration of the managed send queue of a data channel.
+struct mrsDataChannelSendQueueConfig {
+  /// Maximum total byte size of the messages waiting in the queue, beyond
+  /// which sending fails. Zero disables the send queue.
+  uint64_t capacity{0};
+
+  /// Maximum byte size of the data buffered by the SCTP transport. Messages
+  /// sent while this amount is reached are queued instead, and handed to the
+  /// SCTP transport as its buffering drains.
+  uint64_t high_watermark{1024 * 1024};
+
+  /// Byte size of the data buffered by the SCTP transport below which the
+  /// writable event fires, once the queue is empty, if some messages were
+  /// queued or rejected since it last fired.
+  uint64_t low_watermark{256 * 1024};
+};
+
+/// State of the managed send queue of a data channel.
+struct mrsDataChannelSendQueueState {
+  /// Total byte size of the messages waiting in the send queue.
+  uint64_t queued_bytes{0};
+
+  /// Number of messages waiting in the send queue.
+  uint64_t queued_message_count{0};
+
+  /// Byte size of the data currently buffered by the SCTP transport.
+  uint64_t buffered_amount{0};
+
+  /// Whether the writable event is armed, that is whether no message was
+  /// queued or rejected since it last fired.
+  mrsBool writable{mrsBool::kTrue};
+};
+
+/// Callback fired when the managed send queue of a data channel drained down
+/// to its low watermark after some messages were queued or rejected.
+///
+/// The code responding to this callback should unwind the stack before
+/// using any other MR-WebRTC APIs; re-entrancy is not supported.
+using mrsDataChannelWritableCallback = void(MRS_CALL*)(void* user_data);
+
+/// Single message of a batch sent with |mrsDataChannelSendMessages()|.
+struct mrsDataChannelMessage {
+  /// Kind of the message.
+  mrsMessageKind kind{mrsMessageKind::kBinary};
+
+  /// Message content, of byte length |size|.
+  const void* data{nullptr};
+  uint64_t size{0};
+};
+
+/// Opaque handle to a send buffer leased from a data channel with
+/// |mrsDataChannelLeaseSendBuffer()|.
+using mrsDataChannelSendBufferHandle = void*;
+
 /// Assign some opaque user data to the data channel. The implementation will
 /// store the pointer in the data channel object and not touch it. It can be
 /// retrieved with |mrsDataChannelGetUserData()| at any point during the data
@@ -132,4 +250,267 @@ mrsDataChannelSendMessageEx(mrsDataChannelHandle data_channel_handle,
                           const void* data,
                           uint64_t size) noexcept;
 
+/// Get a snapshot of the metrics of the given data channel. This is lock-free
+/// and does not dispatch to any WebRTC thread, so is cheap enough to be called
+/// every frame. Each counter is read atomically, but different counters may be
+/// updated concurrently while taking the snapshot.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelGetMetrics(mrsDataChannelHandle data_channel_handle,
+                         mrsDataChannelMetrics* metrics_out) noexcept;
+
+/// Change the mode of delivery of the messages received on the given data
+/// channel.
+///
+/// In polling mode, received messages are pushed into a lock-free queue
+/// without copying their content nor blocking the WebRTC threads, and the
+/// application drains them in batches with |mrsDataChannelReceive()|, for
+/// example once per frame of its main loop. The queue is bounded; see
+/// |mrsDataChannelSetReceiveQueueCapacity()|. Messages already queued when
+/// switching back to callback mode remain available to
+/// |mrsDataChannelReceive()|.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSetReceiveMode(mrsDataChannelHandle data_channel_handle,
+                             mrsDataChannelReceiveMode mode) noexcept;
+
+/// Set the maximum number of messages waiting in the receive queue of the
+/// given data channel in polling mode, which defaults to
+/// |kMrsDataChannelDefaultReceiveQueueCapacity|. This bounds the memory used
+/// when the application does not drain the queue fast enough. Messages
+/// received while the queue is full are dropped, even on a reliable channel,
+/// and counted in |mrsDataChannelMetrics::receive_drops|. Lowering the
+/// capacity below the number of messages already queued does not drop them.
+///
+/// This returns |mrsResult::kInvalidParameter| if |capacity| is zero.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSetReceiveQueueCapacity(mrsDataChannelHandle data_channel_handle,
+                                      uint32_t capacity) noexcept;
+
+/// Retrieve up to |max_count| messages received on the given data channel in
+/// polling mode, in reception order, into the |messages| array. On return
+/// |count_out| contains the number of messages retrieved, which is zero if no
+/// message is queued.
+///
+/// The caller owns the retrieved messages, which must be released with
+/// |mrsDataChannelReleaseMessages()| once their content is not needed anymore.
+/// This must not be called concurrently from multiple threads for the same
+/// data channel.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelReceive(mrsDataChannelHandle data_channel_handle,
+                      mrsDataChannelReceivedMessage* messages,
+                      uint32_t max_count,
+                      uint32_t* count_out) noexcept;
+
+/// Release |count| messages retrieved with |mrsDataChannelReceive()|. The
+/// content of those messages becomes invalid.
+MRS_API void MRS_CALL
+mrsDataChannelReleaseMessages(const mrsDataChannelReceivedMessage* messages,
+                              uint32_t count) noexcept;
+
+/// Send the same message |data| of byte length |size| and kind |message_kind|
+/// through each of the |count| data channels in |data_channel_handles|, which
+/// may belong to different peer connections.
+///
+/// The message content is copied only once into a reference-counted buffer
+/// shared by all channels, and all channels are sent to with a single dispatch
+/// to the WebRTC signaling thread. If |results| is not null, it must point to
+/// an array of |count| elements, which receive on return the result of the
+/// send on the corresponding channel, for example an error if the channel
+/// buffer is full.
+///
+/// This returns |mrsResult::kSuccess| if the message was sent to all
+/// channels, or the error code of the first channel it could not be sent to
+/// otherwise.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelBroadcast(const mrsDataChannelHandle* data_channel_handles,
+                        uint32_t count,
+                        mrsMessageKind message_kind,
+                        const void* data,
+                        uint64_t size,
+                        mrsResult* results) noexcept;
+
+/// Enable, reconfigure, or disable the managed send queue of the given data
+/// channel.
+///
+/// By default a data channel has no send queue, and sending fails as soon as
+/// the SCTP transport buffers too much data. When the send queue is enabled,
+/// messages sent while the SCTP buffering exceeds |config.high_watermark| are
+/// stored in the queue instead, and handed to the SCTP transport in order as
+/// it drains. Sending only fails if the queue is full, or if the channel is
+/// not open. The writable event registered with
+/// |mrsDataChannelRegisterWritableCallback()| then signals when sending can
+/// resume, so bulk transfers can run at the link rate without polling.
+///
+/// Queued messages are dropped if the channel closes. The send queue cannot be
+/// disabled while not empty.
+MRS_API mrsResult MRS_CALL mrsDataChannelConfigureSendQueue(
+    mrsDataChannelHandle data_channel_handle,
+    const mrsDataChannelSendQueueConfig* config) noexcept;
+
+/// Get the current state of the managed send queue of the given data channel.
+MRS_API mrsResult MRS_CALL mrsDataChannelGetSendQueueState(
+    mrsDataChannelHandle data_channel_handle,
+    mrsDataChannelSendQueueState* state_out) noexcept;
+
+/// Register a callback fired when the managed send queue of the given data
+/// channel drained down to its low watermark. Pass a null callback to
+/// unregister it.
+MRS_API void MRS_CALL mrsDataChannelRegisterWritableCallback(
+    mrsDataChannelHandle data_channel_handle,
+    mrsDataChannelWritableCallback callback,
+    void* user_data) noexcept;
+
+/// Send through the given data channel a batch of |count| messages, in order.
+/// This is equivalent to calling |mrsDataChannelSendMessageEx()| for each
+/// message, but checks the buffering amount and dispatches to the WebRTC
+/// signaling thread only once for the entire batch, which amortizes the
+/// per-message overhead for large numbers of small messages.
+///
+/// Sending stops at the first message which cannot be sent, either because
+/// the data channel is not open or because the internal buffer is full, so
+/// that an ordered channel never delivers a later message without an earlier
+/// one. If |results| is not null, it must point to an array of |count|
+/// elements, which receive on return the result of each message:
+/// |mrsResult::kSuccess| if sent, an error code for the first message which
+/// could not be sent, and |mrsResult::kInvalidOperation| for all messages
+/// after it, which were not attempted.
+///
+/// This returns |mrsResult::kSuccess| if all messages were sent, or the error
+/// code of the first message which could not be sent otherwise.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSendMessages(mrsDataChannelHandle data_channel_handle,
+                           const mrsDataChannelMessage* messages,
+                           uint32_t count,
+                           mrsResult* results) noexcept;
+
+/// Status of a stream transfer, as reported by progress callbacks.
+enum class mrsDataChannelStreamStatus : int32_t {
+  /// Some more payload bytes were transferred.
+  kInProgress = 0,
+
+  /// The entire payload was transferred. On the sending side, this means all
+  /// chunks were handed to the SCTP transport.
+  kCompleted = 1,
+
+  /// The transfer failed, for example because the data channel closed or the
+  /// payload does not fit in the receiving destination.
+  kFailed = 2,
+
+  /// The transfer was aborted by either peer.
+  kAborted = 3,
+};
+
+/// Callback fired to report the progress of a stream transfer. The
+/// |transferred_bytes| and |total_bytes| values count payload bytes only. The
+/// callback fires once with a final status other than
+/// |mrsDataChannelStreamStatus::kInProgress| at the end of the transfer.
+///
+/// The code responding to this callback should unwind the stack before
+/// using any other MR-WebRTC APIs; re-entrancy is not supported.
+using mrsDataChannelStreamProgressCallback =
+    void(MRS_CALL*)(void* user_data,
+                    uint32_t stream_id,
+                    mrsDataChannelStreamStatus status,
+                    uint64_t transferred_bytes,
+                    uint64_t total_bytes);
+
+/// Source of the payload of a stream transfer.
+struct mrsDataChannelStreamSource {
+  /// Payload in memory, of byte length |size|. The memory must remain valid
+  /// until the transfer completes.
+  const void* data{nullptr};
+  uint64_t size{0};
+
+  /// Path of a file to read the payload from, incrementally as the transfer
+  /// progresses, so that the file is never entirely loaded in memory. If not
+  /// null or empty, this takes precedence over |data|.
+  const char* file_path{nullptr};
+};
+
+/// Destination of the payload of a received stream transfer.
+struct mrsDataChannelStreamDestination {
+  /// Preallocated memory buffer of |capacity| bytes receiving the payload. The
+  /// memory must remain valid until the transfer completes.
+  void* data{nullptr};
+  uint64_t capacity{0};
+
+  /// Path of a file to write the payload to, incrementally as the transfer
+  /// progresses. If not null or empty, this takes precedence over |data|.
+  const char* file_path{nullptr};
+};
+
+/// Send a large payload through the given data channel, split into chunks
+/// reassembled by the remote peer with |mrsDataChannelReceiveStream()|.
+///
+/// Chunks are sized for SCTP, and are only sent as the SCTP buffering drains,
+/// so the transfer runs at the link rate without overflowing the data channel
+/// buffer. If the managed send queue of the channel is enabled, chunks go
+/// through it, and so stay ordered with the other messages sent on the
+/// channel. The payload is read from memory, or incrementally from a file.
+/// Stream transfers require a reliable and ordered data channel, which should
+/// preferably be dedicated to them, and only a single stream can be sent at a
+/// time on a given channel. On success, |stream_id_out| receives the
+/// identifier of the stream, also reported by |callback|.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSendStream(mrsDataChannelHandle data_channel_handle,
+                         const mrsDataChannelStreamSource* source,
+                         mrsDataChannelStreamProgressCallback callback,
+                         void* user_data,
+                         uint32_t* stream_id_out) noexcept;
+
+/// Receive the next stream sent by the remote peer on the given data channel
+/// with |mrsDataChannelSendStream()| into |destination|, reporting the
+/// progress to |callback|.
+///
+/// This must be called before the remote peer starts sending the stream. From
+/// the first call onward, the data channel is dedicated to stream transfers,
+/// and stream messages are no longer reported to the message callbacks. Only a
+/// single stream can be received at a time on a given channel.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelReceiveStream(mrsDataChannelHandle data_channel_handle,
+                            const mrsDataChannelStreamDestination* destination,
+                            mrsDataChannelStreamProgressCallback callback,
+                            void* user_data) noexcept;
+
+/// Abort the stream transfers in progress on the given data channel, in both
+/// directions. The remote peer is notified of an aborted send.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelAbortStreams(mrsDataChannelHandle data_channel_handle) noexcept;
+
+/// Lease a send buffer of |capacity| bytes from the given data channel, to
+/// serialize a message directly into memory owned by the implementation. On
+/// success, |buffer_handle_out| receives the handle of the leased buffer and
+/// |data_out| a pointer to its writable storage.
+///
+/// The lease ends either by sending the buffer with
+/// |mrsDataChannelSendLeasedBuffer()|, which hands its storage to the SCTP
+/// transport without copying it, or by discarding it with
+/// |mrsDataChannelReleaseSendBuffer()|. The storage pointer must not be used
+/// after the lease ended.
+///
+/// This returns |mrsResult::kInvalidParameter| if |capacity| exceeds the
+/// maximum buffering size of the data channel.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelLeaseSendBuffer(mrsDataChannelHandle data_channel_handle,
+                              uint64_t capacity,
+                              mrsDataChannelSendBufferHandle* buffer_handle_out,
+                              void** data_out) noexcept;
+
+/// Send through the given data channel a message of kind |message_kind|
+/// made of the first |size| bytes of a buffer previously leased with
+/// |mrsDataChannelLeaseSendBuffer()|. The buffer is consumed by this call,
+/// even on error, so its handle and storage pointer become invalid.
+///
+/// This returns |mrsResult::kInvalidParameter| if |size| exceeds the capacity
+/// the buffer was leased with.
+MRS_API mrsResult MRS_CALL
+mrsDataChannelSendLeasedBuffer(mrsDataChannelHandle data_channel_handle,
+                               mrsDataChannelSendBufferHandle buffer_handle,
+                               mrsMessageKind message_kind,
+                               uint64_t size) noexcept;
+
+/// Discard a buffer leased with |mrsDataChannelLeaseSendBuffer()| without
+/// sending it.
+MRS_API void MRS_CALL mrsDataChannelReleaseSendBuffer(
+    mrsDataChannelSendBufferHandle buffer_handle) noexcept;
+
 }  // extern "C"
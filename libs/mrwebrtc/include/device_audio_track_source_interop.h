@@ -12,10 +12,24 @@ extern "C" {
 struct mrsLocalAudioDeviceInitConfig {
   /// Enable auto gain control (AGC).
   mrsOptBool auto_gain_control_{mrsOptBool::kUnset};
+
+  /// Enable acoustic echo cancellation (AEC).
+  mrsOptBool echo_cancellation_{mrsOptBool::kUnset};
+
+  /// Enable noise suppression (NS).
+  mrsOptBool noise_suppression_{mrsOptBool::kUnset};
+
+  /// Enable the high-pass filter (HPF).
+  mrsOptBool highpass_filter_{mrsOptBool::kUnset};
 };
 
 /// Create an audio track source by opening a local audio capture device
 /// (microphone).
+///
+/// The audio processing options which are unset in |init_config| default to the
+/// ones configured with |mrsLibrarySetAudioProcessingConfig()|. Note that the
+/// audio processing module is shared by all sources, so the options of the
+/// source most recently used by a peer connection to send audio apply.
 MRS_API mrsResult MRS_CALL mrsDeviceAudioTrackSourceCreate(
     const mrsLocalAudioDeviceInitConfig* init_config,
     mrsDeviceAudioTrackSourceHandle* source_handle_out) noexcept;
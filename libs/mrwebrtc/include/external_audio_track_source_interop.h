@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "interop_api.h"
+
+extern "C" {
+
+/// Configuration for creating an external audio track source.
+struct mrsExternalAudioTrackSourceConfig {
+  /// Sampling rate, in Hertz, of the audio frames pushed into the source.
+  uint32_t sample_rate = 48000;
+
+  /// Number of interleaved channels of the audio frames pushed into the
+  /// source. Must be 1 or 2.
+  uint32_t channel_count = 1;
+
+  /// Capacity of the internal buffer, in milliseconds. Frames pushed while the
+  /// buffer is full are rejected.
+  uint32_t buffer_ms = 200;
+};
+
+/// Create a custom audio track source external to the implementation. This
+/// allows feeding into WebRTC audio from any source, including generated or
+/// synthetic audio (game audio, text-to-speech, ...), for example for testing
+/// without any audio capture device. The audio is pushed by the application
+/// with |mrsExternalAudioTrackSourcePushFrame()| in chunks of any size, and the
+/// source delivers it to its audio tracks in 10 ms frames at a steady pace,
+/// independently of the pace of the application. The frames are paced by the
+/// audio device module, one frame each time it pulls a frame to play out, so
+/// that the source does not drift from the audio device. While the audio
+/// device is not playing out, the system clock paces the frames instead. This
+/// returns a handle to a newly allocated object, which must be released once
+/// not used anymore with |mrsRefCountedObjectRemoveRef()|.
+///
+/// The source is paced by the audio device module of the first thread group,
+/// so its audio tracks can only be sent by peer connections of that group.
+/// |mrsTransceiverSetLocalAudioTrack()| fails with
+/// |mrsResult::kInvalidOperation| for a transceiver of a peer connection of
+/// another group. See |mrsLibrarySetThreadGroupCount()|.
+///
+/// Note that the audio device module still mixes the audio captured from the
+/// recording device, if any, into the audio sent to the remote peer. Use this
+/// source in combination with an audio device module without recording to
+/// only send the pushed audio.
+MRS_API mrsResult MRS_CALL mrsExternalAudioTrackSourceCreate(
+    const mrsExternalAudioTrackSourceConfig* config,
+    mrsExternalAudioTrackSourceHandle* source_handle_out) noexcept;
+
+/// Push a chunk of 16-bit PCM audio into the external audio track source. The
+/// format of |frame| must match the one the source was created with, but its
+/// number of samples is arbitrary. The data is copied, so the caller keeps
+/// ownership of the buffer.
+///
+/// This call never blocks. It returns |mrsResult::kBufferTooSmall| without
+/// pushing anything if the internal buffer does not have enough space left for
+/// the entire frame. Calls must not be made concurrently from several threads.
+MRS_API mrsResult MRS_CALL mrsExternalAudioTrackSourcePushFrame(
+    mrsExternalAudioTrackSourceHandle source_handle,
+    const mrsAudioFrame* frame) noexcept;
+
+/// Irreversibly stop the audio source frame production and shutdown the audio
+/// source.
+MRS_API void MRS_CALL mrsExternalAudioTrackSourceShutdown(
+    mrsExternalAudioTrackSourceHandle source_handle) noexcept;
+
+}  // extern "C"
@@ -24,10 +24,10 @@ enum class mrsOptBool : int8_t { kTrue = -1, kFalse = 0, kUnset = 0b01010101 };
 /// Report live objects to debug output, and return the number of live objects.
 MRS_API uint32_t MRS_CALL mrsReportLiveObjects() noexcept;
 
-/// Available audio device modules for Windows Desktop. The audio device module
-/// is the internal audio component responsible for audio capture and playback.
-/// Those options are only meaningful for Windows Desktop; other platforms use a
-/// predefined platform-dependent built-in module.
+/// Available audio device modules. The audio device module is the internal
+/// audio component responsible for audio capture and playback. Except for
+/// |kHeadless|, those options are only meaningful for Windows Desktop; other
+/// platforms use a predefined platform-dependent built-in module.
 enum class mrsAudioDeviceModule : uint8_t {
   /// Legacy audio device module (ADM1) for backward compatibility. This is not
   /// recommended, unless there is an issue with the default new module (ADM2).
@@ -35,7 +35,21 @@ enum class mrsAudioDeviceModule : uint8_t {
 
   /// New CoreAudio-based audio device module (ADM2). This is the default and
   /// recommended audio module on Windows Desktop.
-  kDefault = 2
+  kDefault = 2,
+
+  /// Headless audio device module not using any audio device, for servers and
+  /// automated testing. Recording and playout are driven by an internal 10 ms
+  /// timer; the recorded audio is read from memory or from a file, or is
+  /// silence, and the playout audio is discarded. This is available on all
+  /// platforms except UWP. See |mrsLibrarySetHeadlessAudioDeviceConfig()|.
+  kHeadless = 3,
+
+  /// Audio device module driven by the application, which pulls the playout
+  /// audio and pushes the captured audio from its own audio thread with
+  /// |mrsAudioDevicePullPlayout()| and |mrsAudioDevicePushCapture()|. This is
+  /// available on all platforms except UWP. See
+  /// |mrsLibrarySetApplicationAudioDeviceConfig()|.
+  kApplication = 4
 };
 
 /// Select the audio device module to use on Windows Desktop.
@@ -54,8 +68,11 @@ enum class mrsAudioDeviceModule : uint8_t {
 /// device module cannot be changed after the library is initialized, and this
 /// call will fail with |mrsResult::kInvalidOperation| if invoked too late.
 ///
-/// This has no effect on UWP and non-Windows platforms, and will always
-/// succeed if timely called before the library is initialized.
+/// Except for |mrsAudioDeviceModule::kHeadless| and
+/// |mrsAudioDeviceModule::kApplication|, this has no effect on UWP and
+/// non-Windows platforms, and will always succeed if timely called before the
+/// library is initialized. Selecting either of those two modules on UWP fails
+/// with |mrsResult::kUnsupported|.
 MRS_API mrsResult MRS_CALL
 mrsLibraryUseAudioDeviceModule(mrsAudioDeviceModule adm) noexcept;
 
@@ -63,6 +80,200 @@ mrsLibraryUseAudioDeviceModule(mrsAudioDeviceModule adm) noexcept;
 /// By default the new CoreAudio-based audio device module (ADM2) is used.
 MRS_API mrsAudioDeviceModule MRS_CALL mrsLibraryGetAudioDeviceModule() noexcept;
 
+/// Configuration of the headless audio device module.
+struct mrsHeadlessAudioDeviceConfig {
+  /// Sampling rate, in Hertz, of the recorded and played out audio. Must be a
+  /// multiple of 100 Hz. Ignored if |capture_file_path| is a WAV file.
+  uint32_t sample_rate = 48000;
+
+  /// Number of interleaved channels of the recorded and played out audio. Must
+  /// be 1 or 2. Ignored if |capture_file_path| is a WAV file.
+  uint32_t channel_count = 1;
+
+  /// Rate at which the virtual clock of the module advances relative to the
+  /// real time. A value of 1.0 delivers a 10 ms frame every 10 ms; larger
+  /// values run the audio pipeline faster than real time, for benchmarks.
+  float clock_rate = 1.0f;
+
+  /// Optional interleaved 16-bit PCM samples to record, looped indefinitely.
+  /// The samples are copied, so the caller keeps ownership of the buffer.
+  const int16_t* capture_samples = nullptr;
+
+  /// Number of samples (all channels included) in |capture_samples|.
+  uint32_t capture_sample_count = 0;
+
+  /// Optional path to a file containing the audio to record, looped
+  /// indefinitely. Files with a ".wav" extension are read as 16-bit PCM WAV
+  /// files; any other file is read as raw interleaved 16-bit PCM samples in the
+  /// format given by |sample_rate| and |channel_count|. Ignored if
+  /// |capture_samples| is not NULL. If neither is specified, silence is
+  /// recorded.
+  const char* capture_file_path = nullptr;
+};
+
+/// Configure the headless audio device module selected with
+/// |mrsLibraryUseAudioDeviceModule(mrsAudioDeviceModule::kHeadless)|. Like the
+/// selection of the module itself, this must be called before the library is
+/// initialized, and returns |mrsResult::kInvalidOperation| otherwise. Any
+/// capture file is read entirely during this call, which returns
+/// |mrsResult::kNotFound| if the file cannot be opened.
+MRS_API mrsResult MRS_CALL mrsLibrarySetHeadlessAudioDeviceConfig(
+    const mrsHeadlessAudioDeviceConfig* config) noexcept;
+
+/// Configuration of the application-driven audio device module.
+struct mrsApplicationAudioDeviceConfig {
+  /// Sampling rate, in Hertz, of the audio pulled and pushed by the
+  /// application. Must be a multiple of 100 Hz.
+  uint32_t sample_rate = 48000;
+
+  /// Number of interleaved channels of the audio pulled and pushed by the
+  /// application. Must be 1 or 2.
+  uint32_t channel_count = 2;
+};
+
+/// Configure the application-driven audio device module selected with
+/// |mrsLibraryUseAudioDeviceModule(mrsAudioDeviceModule::kApplication)|. This
+/// must be called before the library is initialized, and returns
+/// |mrsResult::kInvalidOperation| otherwise.
+MRS_API mrsResult MRS_CALL mrsLibrarySetApplicationAudioDeviceConfig(
+    const mrsApplicationAudioDeviceConfig* config) noexcept;
+
+/// Pull |frame_count| frames of mixed playout audio from the application-driven
+/// audio device module into |data|, as interleaved floating-point samples in
+/// [-1:1] in the format configured with
+/// |mrsLibrarySetApplicationAudioDeviceConfig()|. This is designed to be called
+/// directly from the audio callback of the application: the audio is decoded
+/// and mixed synchronously on the calling thread, in 10 ms frames, without any
+/// intermediate buffering other than the remainder of the last frame. The
+/// number of frames is arbitrary.
+///
+/// If the library is not initialized, or if nothing is playing yet, |data| is
+/// filled with silence. This returns |mrsResult::kNotInitialized| in the former
+/// case, and |mrsResult::kInvalidOperation| if the application-driven audio
+/// device module is not in use. Calls must not be made concurrently from
+/// several threads.
+///
+/// This call takes no library lock and does not hold a reference to the
+/// library, so it never initializes nor shuts down the library from the audio
+/// thread. Instead, shutting down the library waits for any call in progress
+/// to return.
+MRS_API mrsResult MRS_CALL
+mrsAudioDevicePullPlayout(float* data, uint32_t frame_count) noexcept;
+
+/// Push |frame_count| frames of captured audio into the application-driven
+/// audio device module, as interleaved floating-point samples in [-1:1] in the
+/// format configured with |mrsLibrarySetApplicationAudioDeviceConfig()|. The
+/// audio is sent to the local audio tracks using a device audio track source,
+/// each time a complete 10 ms frame is available, synchronously on the calling
+/// thread. The number of frames is arbitrary.
+///
+/// This returns |mrsResult::kNotInitialized| if the library is not initialized,
+/// and |mrsResult::kInvalidOperation| if the application-driven audio device
+/// module is not in use. Calls must not be made concurrently from several
+/// threads, but can be made concurrently with |mrsAudioDevicePullPlayout()|.
+/// Like the latter, this call takes no library lock.
+MRS_API mrsResult MRS_CALL
+mrsAudioDevicePushCapture(const float* data, uint32_t frame_count) noexcept;
+
+/// Library-level configuration of the audio processing module (APM), which
+/// processes the captured audio before it is encoded, and analyzes the played
+/// out audio for echo cancellation.
+struct mrsAudioProcessingConfig {
+  /// Enable the audio processing module. If |mrsBool::kFalse|, the module is
+  /// bypassed entirely and no submodule runs, whatever the other options, which
+  /// saves the most CPU for server-side applications not capturing from a
+  /// microphone.
+  mrsBool enabled = mrsBool::kTrue;
+
+  /// Default for enabling acoustic echo cancellation (AEC), for device audio
+  /// track sources which do not specify it. If unset, use the WebRTC default.
+  mrsOptBool echo_cancellation = mrsOptBool::kUnset;
+
+  /// Default for enabling auto gain control (AGC), for device audio track
+  /// sources which do not specify it. If unset, use the WebRTC default.
+  mrsOptBool auto_gain_control = mrsOptBool::kUnset;
+
+  /// Default for enabling noise suppression (NS), for device audio track
+  /// sources which do not specify it. If unset, use the WebRTC default.
+  mrsOptBool noise_suppression = mrsOptBool::kUnset;
+
+  /// Default for enabling the high-pass filter (HPF), for device audio track
+  /// sources which do not specify it. If unset, use the WebRTC default.
+  mrsOptBool highpass_filter = mrsOptBool::kUnset;
+};
+
+/// Configure the audio processing module. This must be called before the
+/// library is initialized, and returns |mrsResult::kInvalidOperation|
+/// otherwise. This has no effect on UWP.
+MRS_API mrsResult MRS_CALL mrsLibrarySetAudioProcessingConfig(
+    const mrsAudioProcessingConfig* config) noexcept;
+
+/// Processing cost of the audio processing module, accumulated since the
+/// library was initialized.
+struct mrsAudioProcessingStats {
+  /// Whether the audio processing module is bypassed. In that case no frame is
+  /// processed, and all counters stay zero.
+  mrsBool bypassed = mrsBool::kFalse;
+
+  /// Number of captured 10 ms frames processed.
+  uint64_t capture_frame_count = 0;
+
+  /// Total time spent processing captured frames, in microseconds.
+  uint64_t capture_total_time_us = 0;
+
+  /// Longest time spent processing a single captured frame, in microseconds.
+  uint32_t capture_max_time_us = 0;
+
+  /// Number of played out 10 ms frames analyzed.
+  uint64_t render_frame_count = 0;
+
+  /// Total time spent analyzing played out frames, in microseconds.
+  uint64_t render_total_time_us = 0;
+
+  /// Longest time spent analyzing a single played out frame, in microseconds.
+  uint32_t render_max_time_us = 0;
+};
+
+/// Get the processing cost of the audio processing modules, aggregated over
+/// all thread groups, see |mrsLibrarySetThreadGroupCount()|. The average cost
+/// per 10 ms frame is the total time divided by the frame count. This does not
+/// initialize the library, and returns |mrsResult::kNotInitialized| if it is
+/// not initialized yet. This returns |mrsResult::kUnsupported| on UWP.
+MRS_API mrsResult MRS_CALL
+mrsLibraryGetAudioProcessingStats(mrsAudioProcessingStats* stats) noexcept;
+
+/// Set the number of thread groups the library creates when initialized, to
+/// spread the packet processing of many concurrent peer connections across CPU
+/// cores. Each group has its own WebRTC networking and worker threads, and each
+/// peer connection is assigned to a single group when created, see
+/// |mrsPeerConnectionConfiguration::thread_group|. The signaling thread is
+/// shared by all groups. The default is a single group.
+///
+/// The first group uses the audio device module selected with
+/// |mrsLibraryUseAudioDeviceModule()|. The other groups use a headless audio
+/// device module configured with |mrsLibrarySetHeadlessAudioDeviceConfig()|,
+/// since a system audio device cannot be shared between groups; so peer
+/// connections of those groups do not capture from a microphone nor play out
+/// to a speaker, but their remote audio tracks still deliver audio frames.
+/// Local video tracks are bound to the threads of a group, and must only be
+/// sent by peer connections of that group, see
+/// |mrsLocalVideoTrackInitSettings::thread_group|.
+///
+/// Peer connections use the first group unless configured otherwise, so the
+/// extra groups are only used by connections explicitly assigned to them,
+/// either by index or with |kMrsThreadGroupRoundRobin|.
+///
+/// This must be called before the library is initialized, and returns
+/// |mrsResult::kInvalidOperation| otherwise. This returns
+/// |mrsResult::kUnsupported| on UWP for more than one group.
+MRS_API mrsResult MRS_CALL
+mrsLibrarySetThreadGroupCount(uint32_t count) noexcept;
+
+/// Value of |mrsPeerConnectionConfiguration::thread_group| assigning the peer
+/// connection to the next thread group in round-robin order, including the
+/// groups using a headless audio device.
+constexpr int32_t kMrsThreadGroupRoundRobin = -2;
+
 /// Global MixedReality-WebRTC library shutdown options.
 enum class mrsShutdownOptions : uint32_t {
   kNone = 0,
@@ -161,6 +372,9 @@ using mrsDeviceVideoTrackSourceHandle = mrsVideoTrackSourceHandle;
 /// Opaque handle to a native DeviceAudioTrackSource interop object.
 using mrsDeviceAudioTrackSourceHandle = mrsAudioTrackSourceHandle;
 
+/// Opaque handle to a native ExternalAudioTrackSource interop object.
+using mrsExternalAudioTrackSourceHandle = mrsAudioTrackSourceHandle;
+
 //
 // Video capture enumeration
 //
@@ -372,6 +586,70 @@ using mrsPeerConnectionLocalSdpReadytoSendCallback = void(
 using mrsPeerConnectionIceCandidateReadytoSendCallback =
     void(MRS_CALL*)(void* user_data, const mrsIceCandidate* candidate);
 
+/// Callback invoked when a batch of ICE candidates has been prepared and is
+/// ready to be sent by the user via the signaling service. The |candidates|
+/// array of |count| elements is only valid during the callback.
+using mrsPeerConnectionIceCandidatesReadytoSendCallback =
+    void(MRS_CALL*)(void* user_data,
+                    const mrsIceCandidate* candidates,
+                    uint32_t count);
+
+/// Configuration of the batching of ICE candidates.
+struct mrsIceCandidateBatchConfig {
+  /// Maximum delay in milliseconds between the time a candidate is gathered
+  /// and the time it is delivered in a batch.
+  uint32_t max_delay_ms{50};
+
+  /// Maximum number of candidates in a batch. A batch reaching this size is
+  /// delivered immediately. Must be non-zero.
+  uint32_t max_count{16};
+};
+
+/// Milestone of the establishment of a peer connection. Only the first
+/// occurrence of each milestone is recorded, except for
+/// |kLastIceCandidateGathered|.
+enum class mrsConnectionMilestone : int32_t {
+  /// |mrsPeerConnectionCreateOffer()| was called.
+  kCreateOfferStarted = 0,
+  /// |mrsPeerConnectionCreateAnswer()| was called.
+  kCreateAnswerStarted = 1,
+  /// The WebRTC engine finished creating a local offer or answer.
+  kLocalDescriptionCreated = 2,
+  /// The local offer or answer was applied to the peer connection.
+  kLocalDescriptionApplied = 3,
+  /// A remote offer or answer was applied to the peer connection.
+  kRemoteDescriptionApplied = 4,
+  /// The first local ICE candidate was gathered.
+  kFirstIceCandidateGathered = 5,
+  /// The latest local ICE candidate was gathered.
+  kLastIceCandidateGathered = 6,
+  /// The gathering of local ICE candidates completed.
+  kIceGatheringCompleted = 7,
+  /// ICE started checking the candidate pairs.
+  kIceChecking = 8,
+  /// ICE connected. The current implementation (M71) only reports this once
+  /// the DTLS handshake also completed, so this is also the time at which the
+  /// DTLS transport is connected.
+  kIceConnected = 9,
+  /// The first RTP packet was received on any remote track.
+  kFirstRtpPacketReceived = 10,
+  /// The first audio frame was decoded on any remote audio track.
+  kFirstAudioFrameDecoded = 11,
+  /// The first video frame was decoded on any remote video track.
+  kFirstVideoFrameDecoded = 12,
+};
+
+/// Number of values of |mrsConnectionMilestone|.
+constexpr size_t kMrsConnectionMilestoneCount = 13;
+
+/// Timestamps of the connection milestones of a peer connection.
+struct mrsConnectionMilestones {
+  /// Time elapsed in microseconds between the creation of the peer connection
+  /// and each milestone, indexed by |mrsConnectionMilestone|, or -1 if the
+  /// milestone was not reached yet.
+  int64_t elapsed_us[kMrsConnectionMilestoneCount]{};
+};
+
 /// State of the ICE connection.
 /// See https://www.w3.org/TR/webrtc/#rtciceconnectionstate-enum.
 /// Note that there is a mismatch currently due to the m71 implementation.
@@ -534,6 +812,37 @@ using mrsAudioFrame = Microsoft::MixedReality::WebRTC::AudioFrame;
 using mrsAudioFrameCallback = void(MRS_CALL*)(void* user_data,
                                               const mrsAudioFrame& frame);
 
+/// Callback invoked when a batch of consecutive audio frames of a local or
+/// remote audio track is available. The batch is delivered as a single
+/// contiguous buffer of interleaved samples, which is only valid for the
+/// duration of the call. |timestamp_ms| is the time, in milliseconds on the
+/// monotonic clock of the library, at which the first sample of the batch was
+/// received.
+using mrsAudioFrameBatchCallback = void(MRS_CALL*)(void* user_data,
+                                                   const mrsAudioFrame& frame,
+                                                   int64_t timestamp_ms);
+
+/// Configuration of the size of the batches delivered to an audio frame batch
+/// callback.
+struct mrsAudioFrameBatchConfig {
+  /// Duration of a batch, in milliseconds. This should be a multiple of the 10
+  /// ms duration of the audio frames produced by WebRTC, otherwise frames are
+  /// split across batches. Ignored if |sample_count| is non-zero.
+  uint32_t duration_ms = 40;
+
+  /// Number of samples per channel of a batch. If non-zero, this takes
+  /// precedence over |duration_ms|.
+  uint32_t sample_count = 0;
+};
+
+using mrsAudioLevel = Microsoft::MixedReality::WebRTC::AudioLevel;
+
+/// Callback invoked when the level of an audio track changed, either because
+/// its voice activity state toggled or because the configured interval since
+/// the previous invocation elapsed.
+using mrsAudioLevelCallback = void(MRS_CALL*)(void* user_data,
+                                              const mrsAudioLevel& level);
+
 /// ICE transport type. See webrtc::PeerConnectionInterface::IceTransportsType.
 /// Currently values are aligned, but kept as a separate structure to allow
 /// backward compatilibity in case of changes in WebRTC.
@@ -563,6 +872,17 @@ enum class mrsSdpSemantic : int32_t {
   kPlanB = 1
 };
 
+/// Policy for gathering local ICE candidates. See
+/// webrtc::PeerConnectionInterface::ContinualGatheringPolicy.
+enum class mrsContinualGatheringPolicy : int32_t {
+  /// Gather candidates once, until ICE gathering completes.
+  kGatherOnce = 0,
+  /// Keep gathering candidates for the lifetime of the connection, so that
+  /// network changes produce new candidates without an ICE restart. ICE
+  /// gathering never completes with this policy.
+  kGatherContinually = 1
+};
+
 /// Configuration to intialize a peer connection object.
 struct mrsPeerConnectionConfiguration {
   /// ICE servers, encoded as a single string buffer.
@@ -595,6 +915,27 @@ struct mrsPeerConnectionConfiguration {
   /// SDP semantic for connection negotiation.
   /// Do not use Plan B unless there is a problem with Unified Plan.
   mrsSdpSemantic sdp_semantic = mrsSdpSemantic::kUnifiedPlan;
+
+  /// Number of sets of ICE candidates to pre-gather, each set serving one ICE
+  /// transport (one per media line, or a single one when bundling). When
+  /// non-zero, the ICE servers are contacted and candidates are gathered as
+  /// soon as the peer connection is created, instead of when the first local
+  /// description is applied, so that they are readily available when the
+  /// offer or answer is created. This can later be increased with
+  /// |mrsPeerConnectionPrewarm()|.
+  int32_t ice_candidate_pool_size = 0;
+
+  /// Policy for gathering local ICE candidates.
+  mrsContinualGatheringPolicy continual_gathering_policy =
+      mrsContinualGatheringPolicy::kGatherOnce;
+
+  /// Index of the thread group to assign the connection to, or
+  /// |kMrsThreadGroupRoundRobin| to assign thread groups to connections in
+  /// round-robin order. The default is the first group, the only one using the
+  /// audio device module of the library. Other negative values are invalid.
+  /// The assigned group can be queried with |mrsPeerConnectionGetThreadGroup()|.
+  /// See |mrsLibrarySetThreadGroupCount()|.
+  int32_t thread_group = 0;
 };
 
 /// Create a peer connection and return a handle to it.
@@ -632,6 +973,26 @@ MRS_API void MRS_CALL mrsPeerConnectionRegisterIceCandidateReadytoSendCallback(
     mrsPeerConnectionIceCandidateReadytoSendCallback callback,
     void* user_data) noexcept;
 
+/// Register a callback invoked with batches of ICE candidates ready to be sent
+/// via the signaling service to a remote peer. This allows sending fewer and
+/// larger signaling messages than with the per-candidate callback registered
+/// with |mrsPeerConnectionRegisterIceCandidateReadytoSendCallback()|.
+/// Candidates are gathered until the batch holds |config->max_count| of them,
+/// until the oldest one waited for |config->max_delay_ms|, or until ICE
+/// gathering completes, whichever comes first. If |config| is null, the default
+/// configuration is used.
+///
+/// This callback is independent of the per-candidate callback; if both are
+/// registered, each candidate is delivered to both. Only one batch callback can
+/// be registered at a time, and registering a null callback disables batching
+/// and drops any pending candidate.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsIceCandidateBatchConfig* config,
+    mrsPeerConnectionIceCandidatesReadytoSendCallback callback,
+    void* user_data) noexcept;
+
 /// Register a callback invoked when the ICE connection state changes. Only one
 /// callback can be registered at a time.
 MRS_API void MRS_CALL mrsPeerConnectionRegisterIceStateChangedCallback(
@@ -729,6 +1090,36 @@ enum class mrsTransceiverOptDirection : int32_t {
 /// Media kind for tracks and transceivers.
 enum class mrsMediaKind : uint32_t { kAudio = 0, kVideo = 1 };
 
+/// Parameters of one encoding sent by a video transceiver. Sending several
+/// encodings of the same video track, each at a different resolution and
+/// bitrate, allows a selective forwarding unit (SFU) to forward to each remote
+/// peer the encoding best suited to its bandwidth (simulcast).
+struct mrsVideoEncodingParameters {
+  /// RTP stream ID (RID) of the encoding. This must be a valid SDP token; see
+  /// |mrsSdpIsValidToken()|. Required and unique when several encodings are
+  /// configured, optional otherwise. The RID of an existing encoding cannot be
+  /// changed, so this is ignored when changing the parameters of an encoding
+  /// with |mrsTransceiverSetVideoEncodingParameters()|.
+  const char* rid{nullptr};
+
+  /// Send the encoding. Inactive encodings are not encoded at all, and can be
+  /// reactivated without any renegotiation.
+  mrsBool active{mrsBool::kTrue};
+
+  /// Factor by which the resolution of the video track is scaled down before
+  /// being encoded, e.g. 2.0 for half the width and half the height. Must be 0
+  /// to let the implementation choose, or greater than or equal to 1.0.
+  double scale_resolution_down_by{0.0};
+
+  /// Maximum bitrate of the encoding, in bits per second, or 0 for no limit
+  /// other than the bandwidth estimate.
+  uint32_t max_bitrate_bps{0};
+
+  /// Maximum framerate of the encoding, in frames per second, or 0 for no
+  /// limit other than the framerate of the video track.
+  uint32_t max_framerate{0};
+};
+
 /// Configuration for creating a new transceiver.
 struct mrsTransceiverInitConfig {
   /// Optional name of the transceiver. This must be a valid SDP token; see
@@ -748,6 +1139,19 @@ struct mrsTransceiverInitConfig {
 
   /// Optional user data.
   void* user_data{nullptr};
+
+  /// Optional array of |send_encoding_count| encodings sent by a video
+  /// transceiver, or null for a single encoding with default parameters.
+  /// Configuring more than one encoding would enable simulcast, but the WebRTC
+  /// implementation cannot negotiate it, so after validating the encodings
+  /// this fails with |mrsResult::kUnsupported|. With Plan B the encoding cannot
+  /// be configured on creation, and can be changed after creation with
+  /// |mrsTransceiverSetVideoEncodingParameters()|. Must be null for audio
+  /// transceivers.
+  const mrsVideoEncodingParameters* send_encodings{nullptr};
+
+  /// Number of elements in the |send_encodings| array.
+  uint32_t send_encoding_count{0};
 };
 
 using mrsRequestExternalI420AVideoFrameCallback =
@@ -802,6 +1206,20 @@ struct mrsDataChannelConfig {
   int32_t id = -1;  // -1 for auto; >=0 for negotiated
   mrsDataChannelConfigFlags flags{};
   const char* label{};  // optional; can be null or empty string
+
+  /// Maximum number of retransmissions of a message before it is dropped, or
+  /// -1 for no limit. Setting a limit makes the channel partially reliable,
+  /// and requires |flags| not to contain |mrsDataChannelConfigFlags::kReliable|.
+  /// Combined with an unordered channel, a value of zero ensures that stale
+  /// messages never delay the delivery of more recent ones.
+  int32_t max_retransmits = -1;
+
+  /// Maximum time in milliseconds during which a message is retransmitted
+  /// before being dropped, or -1 for no limit. Setting a limit makes the
+  /// channel partially reliable, and requires |flags| not to contain
+  /// |mrsDataChannelConfigFlags::kReliable|. This cannot be combined with
+  /// |max_retransmits|.
+  int32_t max_packet_life_time_ms = -1;
 };
 
 /// Add a new data channel to a peer connection.
@@ -838,6 +1256,36 @@ MRS_API mrsResult MRS_CALL
 mrsPeerConnectionAddIceCandidate(mrsPeerConnectionHandle peer_handle,
                                  const mrsIceCandidate* candidate) noexcept;
 
+/// Add a batch of |count| ICE candidates received from a signaling service, in
+/// order. This is equivalent to calling |mrsPeerConnectionAddIceCandidate()|
+/// for each candidate, but dispatches to the WebRTC signaling thread only once
+/// for the entire batch.
+///
+/// All candidates are attempted even if some fail. If |results| is not null, it
+/// must point to an array of |count| elements, which receive on return the
+/// result of each candidate. This returns |mrsResult::kSuccess| if all
+/// candidates were added, or the error code of the first candidate which could
+/// not be added otherwise.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionAddIceCandidates(mrsPeerConnectionHandle peer_handle,
+                                  const mrsIceCandidate* candidates,
+                                  uint32_t count,
+                                  mrsResult* results) noexcept;
+
+/// Start gathering ICE candidates ahead of the first offer or answer, to
+/// shorten the time to connect once the remote peer is known. This grows the
+/// ICE candidate pool to hold at least |pool_size| sets of candidates, which
+/// starts contacting the ICE servers immediately; the pooled candidates are
+/// then used by the first local description, which does not have to wait for
+/// them. See |mrsPeerConnectionConfiguration::ice_candidate_pool_size|.
+///
+/// This must be called before a local description is applied, otherwise it
+/// returns |mrsResult::kInvalidOperation|. It is a no-op if the candidate pool
+/// is already at least |pool_size| large.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionPrewarm(mrsPeerConnectionHandle peer_handle,
+                         int32_t pool_size) noexcept;
+
 /// Create a new JSEP offer to try to establish a connection with a remote peer.
 /// This will generate a local offer message, then invoke the
 /// |LocalSdpReadytoSendCallback| callback, which should send to the remote peer
@@ -910,6 +1358,21 @@ MRS_API mrsResult MRS_CALL mrsPeerConnectionSetRemoteDescriptionAsync(
 MRS_API mrsResult MRS_CALL
 mrsPeerConnectionClose(mrsPeerConnectionHandle peer_handle) noexcept;
 
+/// Get the time at which each milestone of the establishment of a peer
+/// connection was reached, to diagnose where the connection time goes. The
+/// milestones are also emitted as WebRTC trace events in the "mrwebrtc"
+/// category, which can be captured with the WebRTC event tracer.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionGetConnectionMilestones(
+    mrsPeerConnectionHandle peer_handle,
+    mrsConnectionMilestones* milestones_out) noexcept;
+
+/// Get the index of the thread group a peer connection was assigned to when
+/// created, which is the thread group the local video tracks it sends must be
+/// created for. See |mrsLibrarySetThreadGroupCount()|.
+MRS_API mrsResult MRS_CALL
+mrsPeerConnectionGetThreadGroup(mrsPeerConnectionHandle peer_handle,
+                                int32_t* thread_group_out) noexcept;
+
 //
 // SDP utilities
 //
@@ -1118,6 +1581,62 @@ mrsStatsReportGetObjects(mrsStatsReportHandle report_handle,
 MRS_API mrsResult MRS_CALL
 mrsStatsReportRemoveRef(mrsStatsReportHandle stats_report);
 
+/// Bandwidth estimate of a peer connection, sampled from the selected ICE
+/// candidate pairs of its transports.
+struct mrsBandwidthEstimate {
+  /// Time at which the estimate was sampled, in microseconds, with the same
+  /// origin as the timestamps of the stats reports.
+  int64_t timestamp_us = 0;
+
+  /// Send-side estimate of the available outgoing bandwidth, in bits per
+  /// second. This is the target bitrate shared by all the encoders of the
+  /// connection, which they adapt to; when it drops below the bitrate they
+  /// need, frames start being dropped. Zero while no estimate is available.
+  double available_outgoing_bitrate_bps = 0.0;
+
+  /// Receive-side estimate of the available incoming bandwidth, in bits per
+  /// second, as reported to the remote peer. Zero while no estimate is
+  /// available.
+  double available_incoming_bitrate_bps = 0.0;
+
+  /// Latest round-trip time measured by ICE connectivity checks, in
+  /// milliseconds. Zero while no measure is available.
+  double round_trip_time_ms = 0.0;
+
+  /// Total number of bytes sent on the selected candidate pairs, to compare
+  /// the actual outgoing bitrate with the estimate.
+  uint64_t bytes_sent = 0;
+
+  /// Total number of bytes received on the selected candidate pairs.
+  uint64_t bytes_received = 0;
+};
+
+/// Callback invoked with a new bandwidth estimate sample.
+using mrsPeerConnectionBandwidthEstimateCallback =
+    void(MRS_CALL*)(void* user_data, const mrsBandwidthEstimate* estimate);
+
+/// Start sampling the bandwidth estimate of the peer connection every
+/// |interval_ms| milliseconds, and invoke |callback| with each sample. The
+/// callback is invoked from the WebRTC signaling thread. Each sample collects a
+/// stats report, so an interval below 100 ms is rounded up to it. Sampling
+/// continues without callback if |callback| is null, to only use
+/// |mrsPeerConnectionGetBandwidthEstimate()|, and stops if |interval_ms| is
+/// zero. Sampling stops when the peer connection is closed, after which this
+/// returns |mrsResult::kInvalidOperation|.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionRegisterBandwidthEstimateCallback(
+    mrsPeerConnectionHandle peer_handle,
+    uint32_t interval_ms,
+    mrsPeerConnectionBandwidthEstimateCallback callback,
+    void* user_data) noexcept;
+
+/// Get the latest bandwidth estimate sampled since sampling was started with
+/// |mrsPeerConnectionRegisterBandwidthEstimateCallback()|. This does not
+/// collect any stats so is cheap to call, for example once per frame. Returns
+/// |mrsResult::kNotFound| if no sample was taken yet.
+MRS_API mrsResult MRS_CALL mrsPeerConnectionGetBandwidthEstimate(
+    mrsPeerConnectionHandle peer_handle,
+    mrsBandwidthEstimate* estimate_out) noexcept;
+
 
 /// H.264 encoding profile.
 enum class mrsH264Profile : int32_t {
@@ -29,6 +29,15 @@ mrsLocalAudioTrackRegisterFrameCallback(mrsLocalAudioTrackHandle trackHandle,
                                         mrsAudioFrameCallback callback,
                                         void* user_data) noexcept;
 
+/// Register a custom callback to be called when the local audio track captured
+/// enough audio frames to fill a batch of the size specified by |config|.
+/// See |mrsRemoteAudioTrackRegisterFrameBatchCallback| for details.
+MRS_API mrsResult MRS_CALL mrsLocalAudioTrackRegisterFrameBatchCallback(
+    mrsLocalAudioTrackHandle track_handle,
+    const mrsAudioFrameBatchConfig* config,
+    mrsAudioFrameBatchCallback callback,
+    void* user_data) noexcept;
+
 /// Enable or disable a local audio track. Enabled tracks output their media
 /// content as usual. Disabled track output some void media content (silent
 /// audio frames). Enabling/disabling a track is a lightweight concept similar
@@ -12,6 +12,16 @@ struct mrsLocalVideoTrackInitSettings {
   /// Track name. This must be a valid SDP token (see |mrsSdpIsValidToken()|),
   /// or |nullptr| to let the implementation generate a valid unique track name.
   const char* track_name{};
+
+  /// Index of the thread group whose threads the track is bound to, which must
+  /// be the thread group of the peer connections sending the track, as returned
+  /// by |mrsPeerConnectionGetThreadGroup()|. Like for peer connections, the
+  /// default is the first group, so this must be set explicitly for tracks sent
+  /// by connections of another group. Tracks cannot be assigned round-robin,
+  /// and negative values are invalid. Adding the
+  /// track to a transceiver of a connection of another group fails with
+  /// |mrsResult::kInvalidOperation|. See |mrsLibrarySetThreadGroupCount()|.
+  int32_t thread_group{0};
 };
 
 /// Create a new local video track from a video track source.
@@ -23,6 +23,47 @@ mrsRemoteAudioTrackRegisterFrameCallback(mrsRemoteAudioTrackHandle trackHandle,
                                          mrsAudioFrameCallback callback,
                                          void* user_data) noexcept;
 
+/// Register a custom callback to be called when the remote audio track received
+/// enough audio frames to fill a batch of the size specified by |config|.
+///
+/// This is a lower-frequency alternative to
+/// |mrsRemoteAudioTrackRegisterFrameCallback|, which invokes its callback for
+/// each 10 ms audio frame. Batching the frames natively reduces the number of
+/// calls crossing the interop boundary, at the cost of some added latency. The
+/// batch is flushed early if the audio format changes. Pass a NULL |callback|
+/// to unregister, in which case |config| is ignored.
+///
+/// When unregistering or replacing a callback, any partial batch pending is
+/// first delivered to the previous callback, synchronously on the calling
+/// thread before this function returns, so that no audio is lost. This last
+/// batch is shorter than the configured size.
+MRS_API mrsResult MRS_CALL mrsRemoteAudioTrackRegisterFrameBatchCallback(
+    mrsRemoteAudioTrackHandle track_handle,
+    const mrsAudioFrameBatchConfig* config,
+    mrsAudioFrameBatchCallback callback,
+    void* user_data) noexcept;
+
+/// Register a custom callback to be called when the level of the remote audio
+/// track changed.
+///
+/// The level (RMS, peak, and voice activity) is metered natively on each 10 ms
+/// audio frame. The callback is invoked each time the voice activity state
+/// toggles, and otherwise at most every |interval_ms| milliseconds, which makes
+/// it suitable to drive an active speaker indicator without copying any audio
+/// data out of the library. Pass a NULL |callback| to unregister.
+MRS_API void MRS_CALL mrsRemoteAudioTrackRegisterAudioLevelCallback(
+    mrsRemoteAudioTrackHandle track_handle,
+    mrsAudioLevelCallback callback,
+    void* user_data,
+    int interval_ms) noexcept;
+
+/// Get the level metered on the last audio frame received by the remote audio
+/// track. This is a lightweight call which can be polled, e.g. once per
+/// rendered frame.
+MRS_API mrsResult MRS_CALL
+mrsRemoteAudioTrackGetAudioLevel(mrsRemoteAudioTrackHandle track_handle,
+                                 mrsAudioLevel* level_out) noexcept;
+
 /// Enable or disable a remote audio track. Enabled tracks output their media
 /// content as usual. Disabled tracks output some void media content (silent
 /// audio frames). Enabling/disabling a track is a lightweight concept similar
@@ -136,4 +177,63 @@ mrsAudioTrackReadBufferRead(mrsAudioTrackReadBufferHandle buffer,
 MRS_API void MRS_CALL
 mrsAudioTrackReadBufferDestroy(mrsAudioTrackReadBufferHandle buffer);
 
+/// High level interface for consuming several remote audio tracks as a single
+/// mixed stream.
+///
+/// Audio frames of all the tracks added to the buffer are converted on arrival
+/// to the format of the buffer, aligned on the 10 ms WebRTC audio grid, scaled
+/// by a per-track gain, and summed with saturation. The application then reads
+/// the mixed samples with a single call to |mrsAudioTrackMixedReadBufferRead|,
+/// instead of reading one |mrsAudioTrackReadBufferHandle| per track and mixing
+/// them itself.
+using mrsAudioTrackMixedReadBufferHandle = void*;
+
+/// Create a new mixed read buffer producing interleaved samples with
+/// |num_channels| channels (1 or 2) at |sample_rate| Hz, and buffering at most
+/// |buffer_ms| milliseconds of mixed audio. Pass 0 for |buffer_ms| to use the
+/// default of 500 ms.
+MRS_API mrsResult MRS_CALL
+mrsAudioTrackMixedReadBufferCreate(int sample_rate,
+                                   int num_channels,
+                                   int buffer_ms,
+                                   mrsAudioTrackMixedReadBufferHandle* buffer_out);
+
+/// Add a remote audio track to the mix, with the given linear |gain|. A track
+/// can only be added once to a given buffer.
+///
+/// Tracks output to the audio device are still mixed, but for best performance
+/// use |mrsRemoteAudioTrackOutputToDevice| to disable device output for tracks
+/// consumed through this buffer.
+MRS_API mrsResult MRS_CALL
+mrsAudioTrackMixedReadBufferAddTrack(mrsAudioTrackMixedReadBufferHandle buffer,
+                                     mrsRemoteAudioTrackHandle track_handle,
+                                     float gain);
+
+/// Change the linear gain applied to a track already added to the mix.
+MRS_API mrsResult MRS_CALL mrsAudioTrackMixedReadBufferSetTrackGain(
+    mrsAudioTrackMixedReadBufferHandle buffer,
+    mrsRemoteAudioTrackHandle track_handle,
+    float gain);
+
+/// Remove a remote audio track from the mix. This must be called before the
+/// track is destroyed, typically from the track removed callback.
+MRS_API mrsResult MRS_CALL mrsAudioTrackMixedReadBufferRemoveTrack(
+    mrsAudioTrackMixedReadBufferHandle buffer,
+    mrsRemoteAudioTrackHandle track_handle);
+
+/// Fill |samples_out| with mixed samples from the internal buffer, in the
+/// format specified when creating the buffer. See |mrsAudioTrackReadBufferRead|
+/// for the meaning of the other parameters.
+MRS_API mrsResult MRS_CALL
+mrsAudioTrackMixedReadBufferRead(mrsAudioTrackMixedReadBufferHandle buffer,
+                                 mrsAudioTrackReadBufferPadBehavior pad_behavior,
+                                 float* samples_out,
+                                 int num_samples_max,
+                                 int* num_samples_read_out,
+                                 mrsBool* has_overrun_out);
+
+/// Release the mixed read buffer, removing all its tracks.
+MRS_API void MRS_CALL
+mrsAudioTrackMixedReadBufferDestroy(mrsAudioTrackMixedReadBufferHandle buffer);
+
 }  // extern "C"
@@ -32,16 +32,81 @@ MRS_API mrsResult MRS_CALL
 mrsTransceiverSetDirection(mrsTransceiverHandle transceiver_handle,
                            mrsTransceiverDirection new_direction) noexcept;
 
+/// Parameters of the Opus encoder sending the audio of an audio transceiver.
+/// Zero and unset values leave the corresponding WebRTC default unchanged.
+struct mrsAudioSendParameters {
+  /// Duration of an encoded audio frame, in milliseconds. Must be 0, 10, 20,
+  /// 40, or 60. Longer frames reduce the packet rate and the CPU usage, at the
+  /// expense of latency.
+  uint32_t frame_duration_ms = 0;
+
+  /// Enable discontinuous transmission (DTX), to stop sending packets during
+  /// silence.
+  mrsOptBool dtx = mrsOptBool::kUnset;
+
+  /// Enable in-band forward error correction (FEC), to recover from packet
+  /// losses at the expense of some bandwidth.
+  mrsOptBool inband_fec = mrsOptBool::kUnset;
+
+  /// Enable stereo encoding.
+  mrsOptBool stereo = mrsOptBool::kUnset;
+
+  /// Maximum average bitrate, in bits per second. Must be 0 or in the
+  /// [6000:510000] range.
+  uint32_t max_average_bitrate_bps = 0;
+};
+
+/// Set the parameters of the Opus encoder sending the audio of an audio
+/// transceiver. This fails with |mrsResult::kInvalidMediaKind| if the
+/// transceiver is a video transceiver.
+///
+/// The maximum bitrate applies immediately to the RTP encoding of the sender
+/// of the transceiver, if any, without any renegotiation. All parameters are
+/// also applied to the Opus format parameters (fmtp) of the media line of the
+/// transceiver in the remote descriptions (offers and answers) applied from
+/// now on, which configure the local encoder. So the other parameters take
+/// effect on the next negotiation. Local descriptions are never modified, and
+/// the parameters are not signaled to the remote peer. A transceiver created
+/// by a remote offer only uses its parameters from the next negotiation. With
+/// Plan B, all audio transceivers share a single media line, which uses the
+/// parameters of the first audio transceiver having some.
+MRS_API mrsResult MRS_CALL mrsTransceiverSetAudioSendParameters(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsAudioSendParameters* params) noexcept;
+
+/// Change the parameters of the encodings sent by a video transceiver, without
+/// any renegotiation. This fails with |mrsResult::kInvalidMediaKind| if the
+/// transceiver is an audio transceiver.
+///
+/// The number of encodings cannot be changed after creation, so
+/// |encoding_count| must be equal to the number of encodings of the RTP sender
+/// of the transceiver, that is the number of encodings the transceiver was
+/// created with, or 1 if it was created without any. With Plan B the RTP
+/// sender only exists while a local video track is associated with the
+/// transceiver, and this fails with |mrsResult::kInvalidOperation| otherwise.
+/// The |rid| field of the encodings is ignored; encodings are matched by their
+/// position in the array.
+MRS_API mrsResult MRS_CALL mrsTransceiverSetVideoEncodingParameters(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsVideoEncodingParameters* encodings,
+    uint32_t encoding_count) noexcept;
+
 /// Set the local audio track associated with this transceiver. This new track
 /// replaces the existing one, if any. This doesn't require any SDP
-/// renegotiation. This fails if the transceiver is a video transceiver.
+/// renegotiation. This fails if the transceiver is a video transceiver. This
+/// also fails with |mrsResult::kInvalidOperation| if the track was created from
+/// an external audio track source and the peer connection does not belong to
+/// the first thread group (see |mrsExternalAudioTrackSourceCreate()|).
 MRS_API mrsResult MRS_CALL mrsTransceiverSetLocalAudioTrack(
     mrsTransceiverHandle transceiver_handle,
     mrsLocalAudioTrackHandle track_handle) noexcept;
 
 /// Set the local video track associated with this transceiver. This new track
 /// replaces the existing one, if any. This doesn't require any SDP
-/// renegotiation. This fails if the transceiver is an audio transceiver.
+/// renegotiation. This fails if the transceiver is an audio transceiver, and
+/// returns |mrsResult::kInvalidOperation| if the track was created for another
+/// thread group than the one of the peer connection owning the transceiver (see
+/// |mrsLocalVideoTrackInitSettings::thread_group|).
 MRS_API mrsResult MRS_CALL mrsTransceiverSetLocalVideoTrack(
     mrsTransceiverHandle transceiver_handle,
     mrsLocalVideoTrackHandle track_handle) noexcept;
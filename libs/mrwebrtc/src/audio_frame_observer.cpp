@@ -6,6 +6,35 @@
 
 #include "audio_frame_observer.h"
 
+namespace {
+
+/// Minimum RMS level for a frame to be considered as voice, whatever the noise
+/// floor. This is about -40 dBFS.
+constexpr float kVadMinRms = 0.01f;
+
+/// Ratio of the RMS level to the noise floor above which a frame is considered
+/// as voice. This is about +10 dB.
+constexpr float kVadNoiseRatio = 3.16f;
+
+/// Number of 10 ms frames the voice activity state is held after the level
+/// fell back below the threshold, to bridge the short pauses between words.
+constexpr int kVadHangoverFrames = 20;
+
+/// Smoothing factor for the rise of the noise floor estimate, per frame. The
+/// estimate falls instantly to lower levels, and rises slowly so that voice
+/// does not get absorbed into it.
+constexpr float kNoiseFloorRise = 0.002f;
+
+/// Number of consecutive 10 ms frames with voice activity after which the level
+/// is assumed to be a stationary noise rather than speech, and the noise floor
+/// estimate resumes rising. This is 10 seconds, longer than any utterance.
+constexpr int kNoiseFloorFreezeMaxFrames = 1000;
+
+/// Normalization factor of 16-bit samples to [-1:1].
+constexpr float kNormalize = 1.0f / 32768.0f;
+
+}  // namespace
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
@@ -16,12 +45,177 @@ void AudioFrameObserver::SetCallback(
   callback_ = std::move(callback);
 }
 
+void AudioFrameObserver::SetBatchCallback(
+    AudioFrameBatchReadyCallback callback,
+    uint32_t batch_duration_ms,
+    uint32_t batch_sample_count) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Deliver any pending audio to the previous callback before replacing it.
+  FlushBatchNoLock();
+  batch_callback_ = std::move(callback);
+  batch_duration_ms_ = (batch_sample_count > 0 ? 0 : batch_duration_ms);
+  batch_sample_count_ = batch_sample_count;
+  batch_capacity_ = 0;
+  if (!batch_callback_) {
+    // Release the memory of the pooled buffer.
+    std::vector<uint8_t>().swap(batch_data_);
+  }
+}
+
+void AudioFrameObserver::FlushBatchNoLock() noexcept {
+  if (batch_size_ == 0) {
+    return;
+  }
+  AudioFrame frame;
+  frame.data_ = batch_data_.data();
+  frame.bits_per_sample_ = static_cast<uint32_t>(batch_bits_per_sample_);
+  frame.sampling_rate_hz_ = static_cast<uint32_t>(batch_sample_rate_);
+  frame.channel_count_ = static_cast<uint32_t>(batch_channel_count_);
+  frame.sample_count_ = static_cast<uint32_t>(batch_size_);
+  batch_callback_(frame, batch_timestamp_ms_);
+  batch_size_ = 0;
+}
+
+void AudioFrameObserver::AppendToBatchNoLock(const void* audio_data,
+                                             int bits_per_sample,
+                                             int sample_rate,
+                                             size_t number_of_channels,
+                                             size_t number_of_frames) noexcept {
+  // On format change, deliver the partial batch in the old format and resize
+  // the batch for the new one.
+  if ((batch_capacity_ == 0) || (bits_per_sample != batch_bits_per_sample_) ||
+      (sample_rate != batch_sample_rate_) ||
+      (number_of_channels != batch_channel_count_)) {
+    FlushBatchNoLock();
+    batch_bits_per_sample_ = bits_per_sample;
+    batch_sample_rate_ = sample_rate;
+    batch_channel_count_ = number_of_channels;
+    batch_capacity_ =
+        (batch_sample_count_ > 0
+             ? batch_sample_count_
+             : std::max<size_t>(
+                   (size_t)sample_rate * batch_duration_ms_ / 1000, 1));
+    batch_data_.resize(batch_capacity_ * number_of_channels *
+                       (bits_per_sample / 8));
+  }
+
+  const size_t bytes_per_sample = number_of_channels * (bits_per_sample / 8);
+  const int64_t now_ms = rtc::TimeMillis();
+  auto src = static_cast<const uint8_t*>(audio_data);
+  size_t offset = 0;
+  while (offset < number_of_frames) {
+    if (batch_size_ == 0) {
+      // Timestamp of the first sample of the batch, which may be in the middle
+      // of the current frame if the previous batch split it.
+      batch_timestamp_ms_ = now_ms + (int64_t)(offset * 1000 / sample_rate);
+    }
+    const size_t count =
+        std::min(number_of_frames - offset, batch_capacity_ - batch_size_);
+    memcpy(batch_data_.data() + batch_size_ * bytes_per_sample,
+           src + offset * bytes_per_sample, count * bytes_per_sample);
+    batch_size_ += count;
+    offset += count;
+    if (batch_size_ == batch_capacity_) {
+      FlushBatchNoLock();
+    }
+  }
+}
+
+void AudioFrameObserver::SetLevelCallback(AudioLevelCallback callback,
+                                          int interval_ms) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  level_callback_ = std::move(callback);
+  level_callback_interval_ = std::max(interval_ms / 10, 1);
+  frames_since_level_callback_ = 0;
+}
+
+AudioLevel AudioFrameObserver::GetLevel() const noexcept {
+  const uint64_t packed = packed_level_.load(std::memory_order_relaxed);
+  AudioLevel level;
+  const uint32_t rms_bits = (uint32_t)packed;
+  memcpy(&level.rms_, &rms_bits, sizeof(float));
+  level.peak_ =
+      std::min((float)((packed >> 32) & 0xFFFFu) * kNormalize, 1.0f);
+  level.voice_active_ = ((packed >> 48) & 1u) != 0;
+  return level;
+}
+
+void AudioFrameObserver::UpdateLevelNoLock(const int16_t* samples,
+                                           size_t count) noexcept {
+  if (count == 0) {
+    return;
+  }
+
+  // Single pass over the frame. Keep the loop free of branches and of integer
+  // overflow so that it gets vectorized.
+  float sum_squares = 0.0f;
+  int peak = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const int value = samples[i];
+    sum_squares += (float)(value * value);
+    peak = std::max(peak, std::abs(value));
+  }
+  AudioLevel level;
+  level.peak_ = std::min(peak * kNormalize, 1.0f);
+  // The RMS level never exceeds the peak level; only clamp rounding errors.
+  level.rms_ = std::min(std::sqrt(sum_squares / count) * kNormalize,
+                        level.peak_);
+
+  // Energy-based voice activity detection against an adaptive noise floor.
+  const float threshold = std::max(noise_floor_ * kVadNoiseRatio, kVadMinRms);
+  if (level.rms_ > threshold) {
+    vad_hangover_ = kVadHangoverFrames;
+  } else if (vad_hangover_ > 0) {
+    --vad_hangover_;
+  }
+  level.voice_active_ = (vad_hangover_ > 0);
+  voice_frames_ =
+      (level.voice_active_
+           ? std::min(voice_frames_ + 1, kNoiseFloorFreezeMaxFrames + 1)
+           : 0);
+
+  // The noise floor falls instantly, and only rises outside of voice activity,
+  // so that sustained speech does not get absorbed into it.
+  if (level.rms_ < noise_floor_) {
+    noise_floor_ = level.rms_;
+  } else if (!level.voice_active_ ||
+             (voice_frames_ > kNoiseFloorFreezeMaxFrames)) {
+    noise_floor_ += (level.rms_ - noise_floor_) * kNoiseFloorRise;
+  }
+
+  uint32_t rms_bits;
+  memcpy(&rms_bits, &level.rms_, sizeof(float));
+  const uint64_t packed = (uint64_t)rms_bits | ((uint64_t)peak << 32) |
+                          ((uint64_t)level.voice_active_ << 48);
+  const uint64_t previous =
+      packed_level_.exchange(packed, std::memory_order_relaxed);
+  const bool vad_changed = (((previous >> 48) & 1u) != 0) !=
+                           level.voice_active_;
+
+  if (level_callback_) {
+    ++frames_since_level_callback_;
+    if (vad_changed ||
+        (frames_since_level_callback_ >= level_callback_interval_)) {
+      frames_since_level_callback_ = 0;
+      level_callback_(level);
+    }
+  }
+}
+
 void AudioFrameObserver::OnData(const void* audio_data,
                                 int bits_per_sample,
                                 int sample_rate,
                                 size_t number_of_channels,
                                 size_t number_of_frames) noexcept {
   std::lock_guard<std::mutex> lock(mutex_);
+  if (bits_per_sample == 16) {
+    UpdateLevelNoLock(static_cast<const int16_t*>(audio_data),
+                      number_of_channels * number_of_frames);
+  }
+  if (batch_callback_) {
+    AppendToBatchNoLock(audio_data, bits_per_sample, sample_rate,
+                        number_of_channels, number_of_frames);
+  }
   if (!callback_) {
     return;
   }
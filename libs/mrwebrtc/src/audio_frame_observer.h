@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
+#include <vector>
 
 #include "api/mediastreaminterface.h"
 
@@ -17,11 +19,42 @@ namespace WebRTC {
 /// Callback fired on newly available audio frame.
 using AudioFrameReadyCallback = Callback<const AudioFrame&>;
 
+/// Callback fired on newly available batch of audio frames, with the timestamp
+/// of the first sample of the batch in milliseconds.
+using AudioFrameBatchReadyCallback = Callback<const AudioFrame&, int64_t>;
+
+/// Callback fired when the audio level changed.
+using AudioLevelCallback = Callback<const AudioLevel&>;
+
 /// Audio frame observer to get notified of newly available audio frames.
+///
+/// The observer also meters the level of each 16-bit frame it receives, so
+/// that the application can query the level of a track or be notified of voice
+/// activity without having the audio data itself cross the interop boundary.
 class AudioFrameObserver : public webrtc::AudioTrackSinkInterface {
  public:
   void SetCallback(AudioFrameReadyCallback callback) noexcept;
 
+  /// Register a callback fired with batches of consecutive audio frames. Each
+  /// batch holds |batch_sample_count| samples per channel if non-zero, or
+  /// |batch_duration_ms| milliseconds of audio otherwise. The batch buffer is
+  /// reused from one batch to the next, so delivering a batch does not
+  /// allocate once the buffer reached its steady-state size. Any partial batch
+  /// pending is delivered to the previous callback, on the calling thread,
+  /// before it is replaced.
+  void SetBatchCallback(AudioFrameBatchReadyCallback callback,
+                        uint32_t batch_duration_ms,
+                        uint32_t batch_sample_count) noexcept;
+
+  /// Register a callback fired when the voice activity state changes, and in
+  /// any case at most every |interval_ms| milliseconds (rounded to the 10 ms
+  /// frame duration) while frames are received.
+  void SetLevelCallback(AudioLevelCallback callback, int interval_ms) noexcept;
+
+  /// Get the level metered on the last audio frame received. This is lock-free
+  /// and can be called from any thread.
+  AudioLevel GetLevel() const noexcept;
+
  protected:
   // AudioTrackSinkInterface interface
   void OnData(const void* audio_data,
@@ -31,8 +64,70 @@ class AudioFrameObserver : public webrtc::AudioTrackSinkInterface {
               size_t number_of_frames) noexcept override;
 
  private:
+  /// Meter the level of a frame of |count| interleaved samples, publish it for
+  /// |GetLevel()|, and fire the level callback if needed.
+  void UpdateLevelNoLock(const int16_t* samples, size_t count) noexcept;
+
+  /// Append a frame to the current batch, delivering the batch each time it is
+  /// full.
+  void AppendToBatchNoLock(const void* audio_data,
+                           int bits_per_sample,
+                           int sample_rate,
+                           size_t number_of_channels,
+                           size_t number_of_frames) noexcept;
+
+  /// Deliver the current batch, if not empty, and reset it.
+  void FlushBatchNoLock() noexcept;
+
   AudioFrameReadyCallback callback_ RTC_GUARDED_BY(mutex_);
+  AudioFrameBatchReadyCallback batch_callback_ RTC_GUARDED_BY(mutex_);
+  AudioLevelCallback level_callback_ RTC_GUARDED_BY(mutex_);
   std::mutex mutex_;
+
+  /// Requested batch size, in milliseconds or samples per channel. Exactly one
+  /// of those is non-zero while |batch_callback_| is set.
+  uint32_t batch_duration_ms_ RTC_GUARDED_BY(mutex_){0};
+  uint32_t batch_sample_count_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Audio data of the current batch, in the format of the frames appended.
+  std::vector<uint8_t> batch_data_ RTC_GUARDED_BY(mutex_);
+
+  /// Format of the current batch.
+  int batch_bits_per_sample_ RTC_GUARDED_BY(mutex_){0};
+  int batch_sample_rate_ RTC_GUARDED_BY(mutex_){0};
+  size_t batch_channel_count_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Number of samples per channel in the current batch, and in a full batch.
+  size_t batch_size_ RTC_GUARDED_BY(mutex_){0};
+  size_t batch_capacity_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Timestamp of the first sample of the current batch.
+  int64_t batch_timestamp_ms_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Minimum number of frames between two invocations of |level_callback_|
+  /// when the voice activity state doesn't change.
+  int level_callback_interval_ RTC_GUARDED_BY(mutex_){10};
+
+  /// Number of frames since the last invocation of |level_callback_|.
+  int frames_since_level_callback_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Slowly adapting estimate of the background noise RMS level.
+  float noise_floor_ RTC_GUARDED_BY(mutex_){0.0f};
+
+  /// Number of frames the voice activity state remains set after the level
+  /// fell below the detection threshold.
+  int vad_hangover_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Number of consecutive frames with voice activity, during which the noise
+  /// floor estimate is frozen.
+  int voice_frames_ RTC_GUARDED_BY(mutex_){0};
+
+  /// Last metered level, read without lock by |GetLevel()|. All fields are
+  /// packed into a single word so that readers always observe the level of a
+  /// single frame: the bits of the RMS level as a float in the low 32 bits,
+  /// the absolute peak sample value in the next 16 bits, and the voice
+  /// activity state in bit 48.
+  std::atomic<uint64_t> packed_level_{0};
 };
 
 }  // namespace WebRTC
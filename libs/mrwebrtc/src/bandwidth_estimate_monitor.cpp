@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "bandwidth_estimate_monitor.h"
+
+#include "api/stats/rtcstats_objects.h"
+
+namespace {
+
+/// Message ID of the sampling timer.
+constexpr uint32_t kSampleMessageId = 1;
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+constexpr uint32_t BandwidthEstimateMonitor::kMinIntervalMs;
+
+/// Stats callback forwarding the report to the monitor, unless the monitor was
+/// destroyed while the report was being collected.
+class BandwidthEstimateMonitor::Collector
+    : public webrtc::RTCStatsCollectorCallback {
+ public:
+  explicit Collector(BandwidthEstimateMonitor* monitor) : monitor_(monitor) {}
+
+  void Detach() noexcept { monitor_ = nullptr; }
+
+  void OnStatsDelivered(
+      const rtc::scoped_refptr<const webrtc::RTCStatsReport>& report) override {
+    if (monitor_) {
+      monitor_->OnReport(*report);
+    }
+  }
+
+ private:
+  BandwidthEstimateMonitor* monitor_;
+};
+
+BandwidthEstimateMonitor::BandwidthEstimateMonitor(
+    rtc::Thread* signaling_thread,
+    webrtc::PeerConnectionInterface* peer) noexcept
+    : signaling_thread_(signaling_thread), peer_(peer) {}
+
+BandwidthEstimateMonitor::~BandwidthEstimateMonitor() {
+  signaling_thread_->Clear(this);
+  if (pending_collector_) {
+    pending_collector_->Detach();
+  }
+}
+
+bool BandwidthEstimateMonitor::Configure(uint32_t interval_ms,
+                                         EstimateCallback callback) noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  if (stopped_) {
+    return false;
+  }
+  const bool was_sampling = (interval_ms_ > 0);
+  interval_ms_ = (interval_ms > 0 ? std::max(interval_ms, kMinIntervalMs) : 0);
+  callback_ = callback;
+  if (!was_sampling && (interval_ms_ > 0)) {
+    // Take the first sample immediately, to seed |GetLatest()|.
+    signaling_thread_->Post(RTC_FROM_HERE, this, kSampleMessageId);
+  } else if (interval_ms_ == 0) {
+    signaling_thread_->Clear(this, kSampleMessageId);
+  }
+  return true;
+}
+
+void BandwidthEstimateMonitor::Stop() noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  stopped_ = true;
+  interval_ms_ = 0;
+  callback_ = {};
+  signaling_thread_->Clear(this);
+  if (pending_collector_) {
+    pending_collector_->Detach();
+    pending_collector_ = nullptr;
+  }
+}
+
+bool BandwidthEstimateMonitor::GetLatest(
+    mrsBandwidthEstimate& estimate) const noexcept {
+  std::lock_guard<std::mutex> lock(latest_mutex_);
+  if (!has_latest_) {
+    return false;
+  }
+  estimate = latest_;
+  return true;
+}
+
+void BandwidthEstimateMonitor::OnMessage(rtc::Message* message) {
+  if (message->message_id != kSampleMessageId) {
+    return;
+  }
+  if (interval_ms_ == 0) {
+    return;
+  }
+  signaling_thread_->PostDelayed(RTC_FROM_HERE, (int)interval_ms_, this,
+                                 kSampleMessageId);
+  if (pending_collector_) {
+    // The previous report is still being collected; skip this sample rather
+    // than piling up requests on a busy connection.
+    return;
+  }
+  pending_collector_ = new rtc::RefCountedObject<Collector>(this);
+  peer_->GetStats(pending_collector_.get());
+}
+
+void BandwidthEstimateMonitor::OnReport(
+    const webrtc::RTCStatsReport& report) noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  pending_collector_ = nullptr;
+
+  // The estimate is the one of the call, reported on each selected candidate
+  // pair; there are several only without bundling.
+  mrsBandwidthEstimate estimate{};
+  estimate.timestamp_us = report.timestamp_us();
+  for (const webrtc::RTCTransportStats* transport :
+       report.GetStatsOfType<webrtc::RTCTransportStats>()) {
+    if (!transport->selected_candidate_pair_id.is_defined()) {
+      continue;
+    }
+    const webrtc::RTCStats* stats =
+        report.Get(*transport->selected_candidate_pair_id);
+    if (!stats) {
+      continue;
+    }
+    const auto& pair = stats->cast_to<webrtc::RTCIceCandidatePairStats>();
+    if (pair.available_outgoing_bitrate.is_defined()) {
+      estimate.available_outgoing_bitrate_bps =
+          std::max(estimate.available_outgoing_bitrate_bps,
+                   *pair.available_outgoing_bitrate);
+    }
+    if (pair.available_incoming_bitrate.is_defined()) {
+      estimate.available_incoming_bitrate_bps =
+          std::max(estimate.available_incoming_bitrate_bps,
+                   *pair.available_incoming_bitrate);
+    }
+    if (pair.current_round_trip_time.is_defined()) {
+      estimate.round_trip_time_ms =
+          std::max(estimate.round_trip_time_ms,
+                   *pair.current_round_trip_time * 1000.0);
+    }
+    if (pair.bytes_sent.is_defined()) {
+      estimate.bytes_sent += *pair.bytes_sent;
+    }
+    if (pair.bytes_received.is_defined()) {
+      estimate.bytes_received += *pair.bytes_received;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(latest_mutex_);
+    latest_ = estimate;
+    has_latest_ = true;
+  }
+  if (callback_) {
+    const EstimateCallback callback = callback_;
+    callback(&estimate);
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
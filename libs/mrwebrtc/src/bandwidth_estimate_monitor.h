@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <mutex>
+
+#include "api/peerconnectioninterface.h"
+#include "api/stats/rtcstatscollectorcallback.h"
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/thread.h"
+
+#include "callback.h"
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Periodic sampler of the bandwidth estimate of a peer connection.
+///
+/// Each sample collects a stats report and extracts the estimate from the
+/// selected ICE candidate pairs, where WebRTC reports the bandwidth estimate of
+/// the call. Sampling and delivery happen on the signaling thread, on which
+/// stats reports are delivered, and a sample is skipped if the previous report
+/// is still being collected. The latest sample can be read from any thread.
+class BandwidthEstimateMonitor : public rtc::MessageHandler {
+ public:
+  /// Callback invoked with each new sample.
+  using EstimateCallback = Callback<const mrsBandwidthEstimate*>;
+
+  /// Minimum sampling interval, to bound the cost of collecting stats.
+  static constexpr uint32_t kMinIntervalMs = 100;
+
+  BandwidthEstimateMonitor(rtc::Thread* signaling_thread,
+                           webrtc::PeerConnectionInterface* peer) noexcept;
+  ~BandwidthEstimateMonitor() override;
+
+  /// Change the sampling interval and the callback receiving the samples.
+  /// Sampling stops if |interval_ms| is zero. Returns false once |Stop()| was
+  /// called. Only call from the signaling thread.
+  bool Configure(uint32_t interval_ms, EstimateCallback callback) noexcept;
+
+  /// Stop sampling for good when the peer connection closes, dropping any
+  /// stats request in flight and releasing the callback. The latest sample
+  /// remains available. Only call from the signaling thread.
+  void Stop() noexcept;
+
+  /// Get the latest sample, if any. This is multithread-safe.
+  bool GetLatest(mrsBandwidthEstimate& estimate) const noexcept;
+
+ protected:
+  class Collector;
+
+  void OnMessage(rtc::Message* message) override;
+
+  /// Extract the estimate from a collected report and deliver it.
+  void OnReport(const webrtc::RTCStatsReport& report) noexcept;
+
+  rtc::Thread* const signaling_thread_;
+  webrtc::PeerConnectionInterface* const peer_;
+  uint32_t interval_ms_{0};
+  EstimateCallback callback_;
+  bool stopped_{false};
+
+  /// Stats request in flight, if any. Detached on destruction so that a late
+  /// report is dropped.
+  rtc::scoped_refptr<Collector> pending_collector_;
+
+  mutable std::mutex latest_mutex_;
+  mrsBandwidthEstimate latest_ RTC_GUARDED_BY(latest_mutex_);
+  bool has_latest_ RTC_GUARDED_BY(latest_mutex_){false};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -4,6 +4,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include "export.h"
 
 namespace Microsoft {
@@ -72,6 +80,190 @@ struct RetCallback {
   }
 };
 
+namespace detail {
+
+/// Lease held by the current thread on a callback slot, see |CallbackSlot|.
+struct ThreadLease {
+  const void* slot;
+  uint32_t generation;
+};
+
+/// Leases held by the current thread, to let |CallbackSlot::Store()| skip the
+/// invocations it cannot wait for because they are up its own call stack.
+inline std::vector<ThreadLease>& GetThreadLeases() noexcept {
+  static thread_local std::vector<ThreadLease> leases;
+  return leases;
+}
+
+}  // namespace detail
+
+/// Slot holding a |Callback| or |RetCallback| which can be registered and
+/// invoked concurrently from any thread without locking.
+///
+/// The function pointer and user data are published together under a sequence
+/// counter, so that readers always observe a consistent pair without blocking
+/// writers. Invoking the callback first takes a lease on that pair, then calls
+/// it without holding any lock, so a callback can re-register itself or any
+/// other callback from inside its invocation.
+///
+/// Each |Store()| starts a new generation of the slot, and leases are counted
+/// per generation. Replacing a callback waits for all in-flight invocations of
+/// the previous generation on other threads to return, so that once |Store()|
+/// returns the previous user data is not accessed anymore and can be released.
+/// Leases taken on the new callback are counted in the new generation, so they
+/// do not delay that |Store()| unless another one completes meanwhile, since
+/// only the current and previous generations are counted apart. Invocations on the calling thread are not waited
+/// for, since they are the ones re-registering from inside a callback. As a
+/// consequence, a callback must not block on another thread which is
+/// registering a callback on the same slot.
+template <typename CallbackT>
+class CallbackSlot {
+ public:
+  using callback_type = typename CallbackT::callback_type;
+
+  /// Copy of the registered callback, which keeps the slot from completing a
+  /// |Store()| on another thread until destroyed. A lease is bound to the
+  /// thread which took it, so it cannot be copied nor moved, and must be
+  /// destroyed on that thread.
+  class Lease {
+   public:
+    Lease(const Lease&) = delete;
+    Lease(Lease&&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    Lease& operator=(Lease&&) = delete;
+    ~Lease() noexcept {
+      if (slot_) {
+        slot_->Release(generation_);
+      }
+    }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(cb_); }
+    operator const CallbackT&() const noexcept { return cb_; }
+
+    template <typename... Args>
+    auto operator()(Args&&... args) const noexcept {
+      return cb_(std::forward<Args>(args)...);
+    }
+
+   private:
+    friend class CallbackSlot;
+    Lease(const CallbackSlot* slot,
+          uint32_t generation,
+          const CallbackT& cb) noexcept
+        : slot_(slot), generation_(generation), cb_(cb) {}
+
+    const CallbackSlot* const slot_;
+    const uint32_t generation_;
+    const CallbackT cb_;
+  };
+
+  CallbackSlot() noexcept = default;
+  CallbackSlot(const CallbackSlot&) = delete;
+  CallbackSlot& operator=(const CallbackSlot&) = delete;
+
+  /// Take a lease on the currently registered callback. This never blocks, and
+  /// only retries if racing with a concurrent |Store()|.
+  Lease Load() const noexcept {
+    CallbackT cb;
+    uint32_t generation = 0;
+    for (;;) {
+      const uint32_t seq = sequence_.load(std::memory_order_acquire);
+      if (seq & 1u) {
+        continue;
+      }
+      cb.callback_ = callback_.load(std::memory_order_relaxed);
+      cb.user_data_ = user_data_.load(std::memory_order_relaxed);
+      generation = GenerationIndex(seq);
+      in_flight_[generation].fetch_add(1, std::memory_order_relaxed);
+      // Pairs with the fence in |Store()|: either the sequence is unchanged
+      // and the next store waits for this lease, or this lease is retried on
+      // the new callback. This also validates the pair read above.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (sequence_.load(std::memory_order_relaxed) == seq) {
+        break;
+      }
+      in_flight_[generation].fetch_sub(1, std::memory_order_release);
+    }
+    if (!cb) {
+      in_flight_[generation].fetch_sub(1, std::memory_order_release);
+      return Lease(nullptr, 0, cb);
+    }
+    detail::GetThreadLeases().push_back({this, generation});
+    return Lease(this, generation, cb);
+  }
+
+  /// Replace the registered callback, and wait for the in-flight invocations
+  /// of the previous one on other threads to return. Concurrent calls are
+  /// serialized.
+  void Store(const CallbackT& cb) noexcept {
+    // Acquire the slot by making the sequence odd.
+    uint32_t seq = sequence_.load(std::memory_order_relaxed);
+    do {
+      while (seq & 1u) {
+        seq = sequence_.load(std::memory_order_relaxed);
+      }
+    } while (!sequence_.compare_exchange_weak(seq, seq + 1,
+                                              std::memory_order_acquire,
+                                              std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_release);
+    callback_.store(cb.callback_, std::memory_order_relaxed);
+    user_data_.store(cb.user_data_, std::memory_order_relaxed);
+    sequence_.store(seq + 2, std::memory_order_release);
+
+    // Wait for the leases of the previous generation, which were all taken
+    // before the new callback was published.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const uint32_t generation = GenerationIndex(seq);
+    const std::vector<detail::ThreadLease>& leases = detail::GetThreadLeases();
+    const uint32_t own_count = (uint32_t)std::count_if(
+        leases.begin(), leases.end(),
+        [this, generation](const detail::ThreadLease& lease) {
+          return ((lease.slot == this) && (lease.generation == generation));
+        });
+    while (in_flight_[generation].load(std::memory_order_acquire) >
+           own_count) {
+      std::this_thread::yield();
+    }
+  }
+
+  /// Invoke the currently registered callback, if any.
+  template <typename... Args>
+  auto operator()(Args&&... args) const noexcept {
+    return Load()(std::forward<Args>(args)...);
+  }
+
+ private:
+  /// Index of the lease counter of the generation published with the even
+  /// sequence value |seq|. A |Store()| only waits for the generation right
+  /// before its own, so two counters are enough.
+  static constexpr uint32_t GenerationIndex(uint32_t seq) noexcept {
+    return ((seq >> 1) & 1u);
+  }
+
+  void Release(uint32_t generation) const noexcept {
+    std::vector<detail::ThreadLease>& leases = detail::GetThreadLeases();
+    auto it = std::find_if(leases.rbegin(), leases.rend(),
+                           [this, generation](const detail::ThreadLease& lease) {
+                             return ((lease.slot == this) &&
+                                     (lease.generation == generation));
+                           });
+    if (it != leases.rend()) {
+      leases.erase(std::next(it).base());
+    }
+    in_flight_[generation].fetch_sub(1, std::memory_order_release);
+  }
+
+  /// Sequence counter, odd while a |Store()| is in progress. Each store starts
+  /// a new generation of the slot.
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<callback_type> callback_{nullptr};
+  std::atomic<void*> user_data_{nullptr};
+
+  /// Number of leases currently held on this slot across all threads, for the
+  /// current and previous generations, indexed by |GenerationIndex()|.
+  mutable std::atomic<uint32_t> in_flight_[2]{};
+};
+
 }  // namespace WebRTC
 }  // namespace MixedReality
 }  // namespace Microsoft
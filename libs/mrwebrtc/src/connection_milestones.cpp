@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "connection_milestones.h"
+
+#include "rtc_base/timeutils.h"
+#include "rtc_base/trace_event.h"
+
+namespace {
+
+static_assert((size_t)mrsConnectionMilestone::kFirstVideoFrameDecoded + 1 ==
+                  kMrsConnectionMilestoneCount,
+              "Milestone count mismatch");
+
+/// Names of the trace events of the milestones, indexed by milestone. Trace
+/// events reference their name, so those must be static strings.
+constexpr const char* kMilestoneNames[kMrsConnectionMilestoneCount] = {
+    "CreateOfferStarted",        "CreateAnswerStarted",
+    "LocalDescriptionCreated",   "LocalDescriptionApplied",
+    "RemoteDescriptionApplied",  "FirstIceCandidateGathered",
+    "LastIceCandidateGathered",  "IceGatheringCompleted",
+    "IceChecking",               "IceConnected",
+    "FirstRtpPacketReceived",    "FirstAudioFrameDecoded",
+    "FirstVideoFrameDecoded"};
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+ConnectionMilestones::ConnectionMilestones(const void* owner) noexcept
+    : owner_(owner), created_us_(rtc::TimeMicros()) {
+  for (auto&& elapsed_us : elapsed_us_) {
+    elapsed_us.store(-1, std::memory_order_relaxed);
+  }
+}
+
+void ConnectionMilestones::Record(mrsConnectionMilestone milestone) noexcept {
+  std::atomic<int64_t>& elapsed_us = elapsed_us_[(size_t)milestone];
+  // Fast path for the milestones recorded on each media frame.
+  if (elapsed_us.load(std::memory_order_relaxed) >= 0) {
+    return;
+  }
+  int64_t expected = -1;
+  if (elapsed_us.compare_exchange_strong(expected,
+                                         rtc::TimeMicros() - created_us_,
+                                         std::memory_order_relaxed)) {
+    Trace(milestone);
+  }
+}
+
+void ConnectionMilestones::RecordLatest(
+    mrsConnectionMilestone milestone) noexcept {
+  elapsed_us_[(size_t)milestone].store(rtc::TimeMicros() - created_us_,
+                                       std::memory_order_relaxed);
+  Trace(milestone);
+}
+
+void ConnectionMilestones::Get(
+    mrsConnectionMilestones& milestones) const noexcept {
+  for (size_t i = 0; i < kMrsConnectionMilestoneCount; ++i) {
+    milestones.elapsed_us[i] = elapsed_us_[i].load(std::memory_order_relaxed);
+  }
+}
+
+void ConnectionMilestones::OnFirstPacketReceived(
+    cricket::MediaType /*media_type*/) {
+  Record(mrsConnectionMilestone::kFirstRtpPacketReceived);
+}
+
+void ConnectionMilestones::Trace(
+    mrsConnectionMilestone milestone) const noexcept {
+  TRACE_EVENT_INSTANT1("mrwebrtc", kMilestoneNames[(size_t)milestone],
+                       "peer_connection", owner_);
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
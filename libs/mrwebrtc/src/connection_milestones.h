@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "api/rtpreceiverinterface.h"
+
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Recorder of the time at which a peer connection reaches each milestone of
+/// its establishment. Shared between the peer connection and its remote
+/// tracks, which record the first decoded frames from the decoding threads.
+/// This is lock-free and can be used from any thread.
+///
+/// This also observes the RTP receivers of the peer connection to record the
+/// first RTP packet received.
+class ConnectionMilestones : public webrtc::RtpReceiverObserverInterface {
+ public:
+  /// Create a recorder for the peer connection |owner|, which is only used to
+  /// identify the trace events. The milestone times are relative to the
+  /// creation of the recorder.
+  explicit ConnectionMilestones(const void* owner) noexcept;
+
+  /// Record that |milestone| was reached now, unless it was already reached.
+  void Record(mrsConnectionMilestone milestone) noexcept;
+
+  /// Record that |milestone| was reached now, overwriting any previous time.
+  void RecordLatest(mrsConnectionMilestone milestone) noexcept;
+
+  /// Get the time elapsed from the creation of the recorder to each milestone.
+  void Get(mrsConnectionMilestones& milestones) const noexcept;
+
+  // RtpReceiverObserverInterface
+  void OnFirstPacketReceived(cricket::MediaType media_type) override;
+
+ protected:
+  void Trace(mrsConnectionMilestone milestone) const noexcept;
+
+  const void* const owner_;
+  const int64_t created_us_;
+  std::array<std::atomic<int64_t>, kMrsConnectionMilestoneCount> elapsed_us_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
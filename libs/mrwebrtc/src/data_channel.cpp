@@ -4,9 +4,13 @@
 
 #include "pch.h"
 
+#include <algorithm>
+
 #include "data_channel.h"
 #include "peer_connection.h"
 
+#include "rtc_base/timeutils.h"
+
 namespace {
 
 using RtcDataState = webrtc::DataChannelInterface::DataState;
@@ -22,6 +26,26 @@ inline ApiDataState apiStateFromRtcState(RtcDataState rtcState) {
   return (ApiDataState)rtcState;
 }
 
+/// Atomically raise |max_value| to |value| if lower.
+void UpdateMax(std::atomic<uint64_t>& max_value, uint64_t value) noexcept {
+  uint64_t current = max_value.load(std::memory_order_relaxed);
+  while ((value > current) && !max_value.compare_exchange_weak(
+                                  current, value, std::memory_order_relaxed)) {
+  }
+}
+
+/// Get the index of the bucket of the message callback duration histogram for
+/// a duration of |duration_us| microseconds. Buckets are decades from 10 us.
+size_t GetCallbackDurationBucket(int64_t duration_us) noexcept {
+  size_t bucket = 0;
+  for (int64_t limit = 10;
+       (duration_us >= limit) && (bucket < kMrsDataChannelHistogramSize - 1);
+       limit *= 10) {
+    ++bucket;
+  }
+  return bucket;
+}
+
 }  // namespace
 
 namespace Microsoft {
@@ -30,9 +54,13 @@ namespace WebRTC {
 
 DataChannel::DataChannel(
     PeerConnection* owner,
+    rtc::Thread* signaling_thread,
     rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) noexcept
-    : owner_(owner), data_channel_(std::move(data_channel)) {
+    : owner_(owner),
+      signaling_thread_(signaling_thread),
+      data_channel_(std::move(data_channel)) {
   RTC_CHECK(owner_);
+  RTC_CHECK(signaling_thread_);
   data_channel_->RegisterObserver(this);
 }
 
@@ -76,23 +104,416 @@ size_t DataChannel::GetMaxBufferingSize() const noexcept {
 }
 
 bool DataChannel::Send(const void* data, size_t size) noexcept {
-  if (data_channel_->buffered_amount() + size > GetMaxBufferingSize()) {
+  return SendEx(mrsMessageKind::kBinary, data, size);
+}
+
+bool DataChannel::SendEx(mrsMessageKind messageKind, const void* data, size_t size) noexcept {
+  return SendBuffer(messageKind, rtc::CopyOnWriteBuffer((const char*)data, size));
+}
+
+Result DataChannel::SendBatch(const mrsDataChannelMessage* messages,
+                              size_t count,
+                              mrsResult* results) noexcept {
+  // Copy the message contents before dispatching to the signaling thread, to
+  // keep the work done on that thread to a minimum.
+  std::vector<webrtc::DataBuffer> buffers;
+  buffers.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    const mrsDataChannelMessage& message = messages[i];
+    buffers.emplace_back(
+        rtc::CopyOnWriteBuffer((const char*)message.data, (size_t)message.size),
+        message.kind == mrsMessageKind::kBinary);
+  }
+
+  // The data channel interface is a proxy which synchronously dispatches each
+  // call to the signaling thread, unless already called from that thread. So
+  // dispatch the whole batch at once, and call the data channel from there.
+  size_t sent_count = 0;
+  InvokeOnSignalingThread([&]() {
+    if (IsSendQueueEnabled()) {
+      for (const webrtc::DataBuffer& buffer : buffers) {
+        if (!SendOrEnqueue(buffer)) {
+          break;
+        }
+        ++sent_count;
+      }
+      return;
+    }
+    const size_t max_buffering_size = GetMaxBufferingSize();
+    uint64_t buffered_amount = data_channel_->buffered_amount();
+    for (const webrtc::DataBuffer& buffer : buffers) {
+      buffered_amount += buffer.size();
+      if ((buffered_amount > max_buffering_size) || !SendNow(buffer)) {
+        break;
+      }
+      ++sent_count;
+    }
+  });
+
+  const Result result =
+      (sent_count == count ? Result::kSuccess : Result::kUnknownError);
+  if (sent_count < count) {
+    metrics_.send_rejections.fetch_add(count - sent_count,
+                                       std::memory_order_relaxed);
+  }
+  if (results) {
+    size_t i = 0;
+    for (; i < sent_count; ++i) {
+      results[i] = Result::kSuccess;
+    }
+    if (i < count) {
+      results[i++] = result;
+    }
+    for (; i < count; ++i) {
+      results[i] = Result::kInvalidOperation;
+    }
+  }
+  return result;
+}
+
+std::unique_ptr<rtc::CopyOnWriteBuffer> DataChannel::LeaseSendBuffer(
+    size_t capacity) const noexcept {
+  if (capacity > GetMaxBufferingSize()) {
+    return nullptr;
+  }
+  return std::make_unique<rtc::CopyOnWriteBuffer>(capacity);
+}
+
+bool DataChannel::SendBuffer(mrsMessageKind messageKind,
+                             rtc::CopyOnWriteBuffer buffer) noexcept {
+  // The data buffer only holds a reference to the storage of |buffer|, which
+  // is also the one queued by the SCTP transport if the message cannot be sent
+  // immediately, so the message content is never copied until SCTP packs it.
+  webrtc::DataBuffer data_buffer(std::move(buffer),
+                                 messageKind == mrsMessageKind::kBinary);
+
+  // The data channel interface is a proxy which synchronously dispatches each
+  // call to the signaling thread. So dispatch once, and check the capacity,
+  // send, and sample the buffered amount from there without any other hop.
+  bool success = false;
+  InvokeOnSignalingThread([&]() { success = SendOrEnqueue(data_buffer); });
+  if (!success) {
+    metrics_.send_rejections.fetch_add(1, std::memory_order_relaxed);
+  }
+  return success;
+}
+
+Result DataChannel::Broadcast(DataChannel* const* channels,
+                              size_t count,
+                              mrsMessageKind messageKind,
+                              const void* data,
+                              size_t size,
+                              mrsResult* results) noexcept {
+  // Copy the content once; each send only adds a reference to it.
+  const rtc::CopyOnWriteBuffer buffer((const char*)data, size);
+  Result result = Result::kSuccess;
+  auto send_all = [&]() {
+    for (size_t i = 0; i < count; ++i) {
+      Result channel_result = Result::kSuccess;
+      if (!channels[i]) {
+        channel_result = Result::kInvalidNativeHandle;
+      } else if (!channels[i]->SendBuffer(messageKind, buffer)) {
+        channel_result = Result::kUnknownError;
+      }
+      if (results) {
+        results[i] = channel_result;
+      }
+      if ((channel_result != Result::kSuccess) &&
+          (result == Result::kSuccess)) {
+        result = channel_result;
+      }
+    }
+  };
+  // All channels share the signaling thread of the global factory, so dispatch
+  // through any of them. If all are null, there is nothing to send anyway.
+  DataChannel* const* const first_channel = std::find_if(
+      channels, channels + count,
+      [](const DataChannel* channel) { return (channel != nullptr); });
+  if (first_channel != channels + count) {
+    (*first_channel)->InvokeOnSignalingThread(send_all);
+  } else {
+    send_all();
+  }
+  return result;
+}
+
+void DataChannel::GetMetrics(mrsDataChannelMetrics& metrics) const noexcept {
+  metrics.messages_sent =
+      metrics_.messages_sent.load(std::memory_order_relaxed);
+  metrics.bytes_sent = metrics_.bytes_sent.load(std::memory_order_relaxed);
+  metrics.messages_received =
+      metrics_.messages_received.load(std::memory_order_relaxed);
+  metrics.bytes_received =
+      metrics_.bytes_received.load(std::memory_order_relaxed);
+  metrics.send_rejections =
+      metrics_.send_rejections.load(std::memory_order_relaxed);
+  metrics.receive_drops =
+      metrics_.receive_drops.load(std::memory_order_relaxed);
+  metrics.peak_buffered_amount =
+      metrics_.peak_buffered_amount.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < kMrsDataChannelHistogramSize; ++i) {
+    metrics.callback_duration_histogram[i] =
+        metrics_.callback_duration_histogram[i].load(
+            std::memory_order_relaxed);
+  }
+}
+
+bool DataChannel::SendNow(const webrtc::DataBuffer& buffer) noexcept {
+  if (!data_channel_->Send(buffer)) {
     return false;
   }
+  metrics_.messages_sent.fetch_add(1, std::memory_order_relaxed);
+  metrics_.bytes_sent.fetch_add(buffer.size(), std::memory_order_relaxed);
+  // Sample the buffered amount right after the message was queued by SCTP,
+  // which is where the buffering peaks. This is called on the signaling
+  // thread, so this does not dispatch through the proxy.
+  UpdateMax(metrics_.peak_buffered_amount, data_channel_->buffered_amount());
+  return true;
+}
 
-  rtc::CopyOnWriteBuffer bufferStorage((const char*)data, size);
-  webrtc::DataBuffer buffer(bufferStorage, /* binary = */ true);
-  return data_channel_->Send(buffer);
+void DataChannel::SetReceiveMode(mrsDataChannelReceiveMode mode) noexcept {
+  polling_receive_.store(mode == mrsDataChannelReceiveMode::kPolling,
+                         std::memory_order_release);
 }
 
-bool DataChannel::SendEx(mrsMessageKind messageKind, const void* data, size_t size) noexcept {
-  if (data_channel_->buffered_amount() + size > GetMaxBufferingSize()) {
+void DataChannel::SetReceiveQueueCapacity(uint32_t capacity) noexcept {
+  receive_queue_capacity_.store(capacity, std::memory_order_relaxed);
+}
+
+size_t DataChannel::Receive(mrsDataChannelReceivedMessage* messages,
+                            size_t max_count) noexcept {
+  size_t count = 0;
+  while (count < max_count) {
+    MpscQueue<webrtc::DataBuffer>::Node* const node = receive_queue_.Pop();
+    if (!node) {
+      break;
+    }
+    mrsDataChannelReceivedMessage& message = messages[count++];
+    message.kind =
+        (node->value.binary ? mrsMessageKind::kBinary : mrsMessageKind::kText);
+    message.data = node->value.data.data();
+    message.size = node->value.size();
+    message.handle = node;
+  }
+  if (count > 0) {
+    receive_queue_size_.fetch_sub((uint32_t)count, std::memory_order_relaxed);
+  }
+  return count;
+}
+
+void DataChannel::ReleaseMessage(mrsDataChannelMessageHandle handle) noexcept {
+  delete static_cast<MpscQueue<webrtc::DataBuffer>::Node*>(handle);
+}
+
+Result DataChannel::SendStream(const mrsDataChannelStreamSource& source,
+                               StreamProgressCallback callback,
+                               uint32_t& stream_id_out) noexcept {
+  if (!data_channel_->reliable() || !data_channel_->ordered()) {
+    RTC_LOG(LS_ERROR) << "Stream transfers require a reliable and ordered "
+                         "data channel.";
+    return Result::kInvalidOperation;
+  }
+  Result result = Result::kSuccess;
+  InvokeOnSignalingThread([&]() {
+    if (data_channel_->state() != webrtc::DataChannelInterface::kOpen) {
+      result = Result::kInvalidOperation;
+      return;
+    }
+    if (stream_sender_) {
+      RTC_LOG(LS_ERROR) << "A stream is already being sent on data channel "
+                        << label() << ".";
+      result = Result::kInvalidOperation;
+      return;
+    }
+    ErrorOr<std::unique_ptr<DataChannelStreamSender>> sender =
+        DataChannelStreamSender::Create(next_stream_id_, source, callback);
+    if (!sender.ok()) {
+      result = sender.error().result();
+      return;
+    }
+    stream_id_out = next_stream_id_++;
+    stream_sender_ = sender.MoveValue();
+    PumpStream();
+  });
+  return result;
+}
+
+Result DataChannel::ReceiveStream(
+    const mrsDataChannelStreamDestination& destination,
+    StreamProgressCallback callback) noexcept {
+  Result result = Result::kSuccess;
+  InvokeOnSignalingThread([&]() {
+    if (stream_receiver_) {
+      RTC_LOG(LS_ERROR) << "A stream is already being received on data "
+                           "channel "
+                        << label() << ".";
+      result = Result::kInvalidOperation;
+      return;
+    }
+    ErrorOr<std::unique_ptr<DataChannelStreamReceiver>> receiver =
+        DataChannelStreamReceiver::Create(destination, callback);
+    if (!receiver.ok()) {
+      result = receiver.error().result();
+      return;
+    }
+    stream_receiver_ = receiver.MoveValue();
+    stream_receive_enabled_ = true;
+  });
+  return result;
+}
+
+void DataChannel::AbortStreams() noexcept {
+  InvokeOnSignalingThread([&]() {
+    if (stream_sender_) {
+      stream_sender_->Abort(this);
+      stream_sender_.reset();
+    }
+    if (stream_receiver_) {
+      stream_receiver_->Abort();
+      stream_receiver_.reset();
+    }
+  });
+}
+
+void DataChannel::PumpStream() noexcept {
+  if (stream_sender_ && !stream_sender_->Pump(*this)) {
+    stream_sender_.reset();
+  }
+}
+
+Result DataChannel::ConfigureSendQueue(
+    const mrsDataChannelSendQueueConfig& config) noexcept {
+  if (config.capacity > 0) {
+    if ((config.low_watermark > config.high_watermark) ||
+        (config.high_watermark == 0) ||
+        (config.high_watermark > GetMaxBufferingSize())) {
+      RTC_LOG(LS_ERROR) << "Invalid send queue watermarks for data channel "
+                        << label() << ".";
+      return Result::kInvalidParameter;
+    }
+  }
+  std::lock_guard<std::mutex> lock(send_queue_mutex_);
+  if ((config.capacity == 0) && !send_queue_.empty()) {
+    RTC_LOG(LS_ERROR) << "Cannot disable the non-empty send queue of data "
+                         "channel "
+                      << label() << ".";
+    return Result::kInvalidOperation;
+  }
+  send_queue_config_ = config;
+  return Result::kSuccess;
+}
+
+void DataChannel::GetSendQueueState(
+    mrsDataChannelSendQueueState& state) const noexcept {
+  {
+    std::lock_guard<std::mutex> lock(send_queue_mutex_);
+    state.queued_bytes = queued_bytes_;
+    state.queued_message_count = (uint64_t)send_queue_.size();
+    state.writable = (writable_ ? mrsBool::kTrue : mrsBool::kFalse);
+  }
+  state.buffered_amount = data_channel_->buffered_amount();
+}
+
+void DataChannel::SetWritableCallback(WritableCallback callback) noexcept {
+  std::lock_guard<std::mutex> lock(mutex_);
+  writable_callback_ = callback;
+}
+
+void DataChannel::InvokeOnSignalingThread(
+    const std::function<void()>& func) const noexcept {
+  if (!signaling_thread_->IsCurrent()) {
+    signaling_thread_->Invoke<void>(RTC_FROM_HERE, func);
+  } else {
+    func();
+  }
+}
+
+bool DataChannel::IsSendQueueEnabled() const noexcept {
+  std::lock_guard<std::mutex> lock(send_queue_mutex_);
+  return (send_queue_config_.capacity > 0);
+}
+
+bool DataChannel::SendOrEnqueue(const webrtc::DataBuffer& buffer) noexcept {
+  if (data_channel_->state() != webrtc::DataChannelInterface::kOpen) {
     return false;
   }
+  {
+    std::lock_guard<std::mutex> lock(send_queue_mutex_);
+    const uint64_t size = buffer.size();
+    if (send_queue_config_.capacity == 0) {
+      if (data_channel_->buffered_amount() + size > GetMaxBufferingSize()) {
+        return false;
+      }
+    } else if (!send_queue_.empty() ||
+               !CanSendNow(size, data_channel_->buffered_amount())) {
+      if (queued_bytes_ + size > send_queue_config_.capacity) {
+        writable_ = false;
+        return false;
+      }
+      send_queue_.push_back(buffer);
+      queued_bytes_ += size;
+      writable_ = false;
+      return true;
+    }
+  }
+  in_send_ = true;
+  const bool sent = SendNow(buffer);
+  in_send_ = false;
+  return sent;
+}
+
+bool DataChannel::CanSendNow(uint64_t size, uint64_t buffered_amount) const
+    noexcept {
+  // Always accept a message when nothing is buffered, so that messages larger
+  // than the high watermark can still be sent.
+  return ((buffered_amount == 0) ||
+          (buffered_amount + size <= send_queue_config_.high_watermark));
+}
 
-  rtc::CopyOnWriteBuffer bufferStorage((const char*)data, size);
-  webrtc::DataBuffer buffer(bufferStorage, messageKind == mrsMessageKind::kBinary);
-  return data_channel_->Send(buffer);
+void DataChannel::DrainSendQueue() noexcept {
+  // Ignore re-entrant calls from |OnBufferedAmountChange()| while sending, as
+  // the outer call will continue draining.
+  if (in_send_) {
+    return;
+  }
+  bool became_writable = false;
+  {
+    std::unique_lock<std::mutex> lock(send_queue_mutex_);
+    if (send_queue_config_.capacity == 0) {
+      return;
+    }
+    while (!send_queue_.empty() &&
+           CanSendNow(send_queue_.front().size(),
+                      data_channel_->buffered_amount())) {
+      webrtc::DataBuffer buffer(std::move(send_queue_.front()));
+      send_queue_.pop_front();
+      queued_bytes_ -= buffer.size();
+      // Do not hold the lock while sending, as this may re-enter this object.
+      lock.unlock();
+      in_send_ = true;
+      const bool sent = SendNow(buffer);
+      in_send_ = false;
+      lock.lock();
+      if (!sent) {
+        // The channel is closing; nothing left can be sent anymore.
+        send_queue_.clear();
+        queued_bytes_ = 0;
+        break;
+      }
+    }
+    if (!writable_ && send_queue_.empty() &&
+        (data_channel_->buffered_amount() <=
+         send_queue_config_.low_watermark)) {
+      writable_ = true;
+      became_writable = true;
+    }
+  }
+  if (became_writable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (writable_callback_) {
+      writable_callback_();
+    }
+  }
 }
 
 void DataChannel::InvokeOnStateChange() const noexcept {
@@ -106,11 +527,62 @@ void DataChannel::InvokeOnStateChange() const noexcept {
 }
 
 void DataChannel::OnStateChange() noexcept {
+  const webrtc::DataChannelInterface::DataState state = data_channel_->state();
+  if ((state == webrtc::DataChannelInterface::kClosing) ||
+      (state == webrtc::DataChannelInterface::kClosed)) {
+    // Drop any queued message and stream, which cannot be sent anymore.
+    {
+      std::lock_guard<std::mutex> lock(send_queue_mutex_);
+      send_queue_.clear();
+      queued_bytes_ = 0;
+    }
+    if (stream_sender_) {
+      stream_sender_->Abort(nullptr);
+      stream_sender_.reset();
+    }
+    if (stream_receiver_) {
+      stream_receiver_->Abort();
+      stream_receiver_.reset();
+    }
+  }
   InvokeOnStateChange();
 }
 
 void DataChannel::OnMessage(const webrtc::DataBuffer& buffer) noexcept {
+  metrics_.messages_received.fetch_add(1, std::memory_order_relaxed);
+  metrics_.bytes_received.fetch_add(buffer.size(), std::memory_order_relaxed);
+  if (stream_receive_enabled_) {
+    StreamFrame::Type type;
+    uint32_t stream_id;
+    uint64_t offset;
+    if (StreamFrame::Parse(buffer, type, stream_id, offset)) {
+      if (stream_receiver_ &&
+          !stream_receiver_->OnFrame(type, stream_id, offset, buffer)) {
+        stream_receiver_.reset();
+      }
+      return;
+    }
+  }
+  if (polling_receive_.load(std::memory_order_acquire)) {
+    // Only take a reference to the received buffer, and let the application
+    // drain the queue at its own pace without blocking the signaling thread.
+    // SCTP offers no way to push back on the remote sender, so drop messages
+    // rather than grow the queue without bound if the application falls
+    // behind.
+    if (receive_queue_size_.load(std::memory_order_relaxed) >=
+        receive_queue_capacity_.load(std::memory_order_relaxed)) {
+      metrics_.receive_drops.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    receive_queue_size_.fetch_add(1, std::memory_order_relaxed);
+    receive_queue_.Push(new MpscQueue<webrtc::DataBuffer>::Node(buffer));
+    return;
+  }
   std::lock_guard<std::mutex> lock(mutex_);
+  if (!message_callback_ && !message_ex_callback_) {
+    return;
+  }
+  const int64_t start_us = rtc::TimeMicros();
   if (message_callback_) {
     message_callback_(buffer.data.data(), buffer.data.size());
   }
@@ -118,16 +590,31 @@ void DataChannel::OnMessage(const webrtc::DataBuffer& buffer) noexcept {
     mrsMessageKind kind = buffer.binary ? mrsMessageKind::kBinary : mrsMessageKind::kText;
     message_ex_callback_(kind, buffer.data.data(), buffer.data.size());
   }
+  const size_t bucket =
+      GetCallbackDurationBucket(rtc::TimeMicros() - start_us);
+  metrics_.callback_duration_histogram[bucket].fetch_add(
+      1, std::memory_order_relaxed);
 }
 
 void DataChannel::OnBufferedAmountChange(uint64_t previous_amount) noexcept {
-  std::lock_guard<std::mutex> lock(mutex_);
-  if (buffering_callback_) {
-    uint64_t current_amount = data_channel_->buffered_amount();
-    constexpr uint64_t max_capacity =
-        0x1000000;  // 16MB, see DataChannelInterface
-    buffering_callback_(previous_amount, current_amount, max_capacity);
+  // In M71 this is also notified when a message is queued, but with the amount
+  // from before that message was added, so this sample alone lags the peak by
+  // one message; |SendNow()| samples the amount after each send to cover it.
+  UpdateMax(metrics_.peak_buffered_amount, previous_amount);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffering_callback_) {
+      uint64_t current_amount = data_channel_->buffered_amount();
+      constexpr uint64_t max_capacity =
+          0x1000000;  // 16MB, see DataChannelInterface
+      buffering_callback_(previous_amount, current_amount, max_capacity);
+    }
   }
+
+  // Hand over queued messages and stream chunks to SCTP as the buffer drains.
+  DrainSendQueue();
+  PumpStream();
 }
 
 }  // namespace WebRTC
@@ -4,14 +4,22 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
 
 #include "api/datachannelinterface.h"
+#include "rtc_base/thread.h"
 
 #include "callback.h"
 #include "data_channel.h"
 #include "data_channel_interop.h"
+#include "data_channel_stream.h"
 #include "interop_api.h"
+#include "mpsc_queue.h"
+#include "mrs_errors.h"
 
 namespace Microsoft {
 namespace MixedReality {
@@ -51,8 +59,13 @@ class DataChannel : public webrtc::DataChannelObserver {
   /// Callback fired when the data channel state changed.
   using StateCallback = Callback<mrsDataChannelState, int>;
 
+  /// Callback fired when the managed send queue drained down to its low
+  /// watermark after having rejected or queued some messages.
+  using WritableCallback = Callback<>;
+
   DataChannel(
       PeerConnection* owner,
+      rtc::Thread* signaling_thread,
       rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel) noexcept;
 
   /// Remove the data channel from its parent PeerConnection and close it.
@@ -87,6 +100,7 @@ class DataChannel : public webrtc::DataChannelObserver {
   void SetMessageExCallback(MessageExCallback callback) noexcept;
   void SetBufferingCallback(BufferingCallback callback) noexcept;
   void SetStateCallback(StateCallback callback) noexcept;
+  void SetWritableCallback(WritableCallback callback) noexcept;
 
   /// Get the maximum buffering size, in bytes, before |Send()| stops accepting
   /// data.
@@ -98,6 +112,79 @@ class DataChannel : public webrtc::DataChannelObserver {
   /// Send a message through the data channel with the specified message kind.
   bool SendEx(mrsMessageKind messageKind, const void* data, size_t size) noexcept;
 
+  /// Send a batch of messages in order, with a single buffering check and a
+  /// single dispatch to the signaling thread. Sending stops at the first
+  /// message which cannot be sent. See |mrsDataChannelSendMessages()| for
+  /// details about |results| and the return value.
+  Result SendBatch(const mrsDataChannelMessage* messages,
+                   size_t count,
+                   mrsResult* results) noexcept;
+
+  /// Send the same message through several data channels, sharing a single
+  /// copy of its content. Null channels fail with
+  /// |Result::kInvalidNativeHandle|. See |mrsDataChannelBroadcast()| for
+  /// details about |results| and the return value.
+  static Result Broadcast(DataChannel* const* channels,
+                          size_t count,
+                          mrsMessageKind messageKind,
+                          const void* data,
+                          size_t size,
+                          mrsResult* results) noexcept;
+
+  /// Get a lock-free snapshot of the metrics of the channel.
+  void GetMetrics(mrsDataChannelMetrics& metrics) const noexcept;
+
+  /// Change the mode of delivery of received messages.
+  void SetReceiveMode(mrsDataChannelReceiveMode mode) noexcept;
+
+  /// Change the maximum number of messages waiting in the receive queue in
+  /// polling mode, beyond which received messages are dropped.
+  void SetReceiveQueueCapacity(uint32_t capacity) noexcept;
+
+  /// Pop up to |max_count| messages received in polling mode. The caller owns
+  /// the returned messages, and must release them with |ReleaseMessage()|.
+  /// Must only be called from a single thread at a time.
+  size_t Receive(mrsDataChannelReceivedMessage* messages,
+                 size_t max_count) noexcept;
+
+  /// Release a message returned by |Receive()|.
+  static void ReleaseMessage(mrsDataChannelMessageHandle handle) noexcept;
+
+  /// Enable, reconfigure, or disable the managed send queue of the channel.
+  /// See |mrsDataChannelConfigureSendQueue()| for details.
+  Result ConfigureSendQueue(
+      const mrsDataChannelSendQueueConfig& config) noexcept;
+
+  /// Get the current state of the managed send queue.
+  void GetSendQueueState(mrsDataChannelSendQueueState& state) const noexcept;
+
+  /// Start sending a stream transfer. See |mrsDataChannelSendStream()| for
+  /// details.
+  Result SendStream(const mrsDataChannelStreamSource& source,
+                    StreamProgressCallback callback,
+                    uint32_t& stream_id_out) noexcept;
+
+  /// Prepare to receive the next stream transfer. See
+  /// |mrsDataChannelReceiveStream()| for details.
+  Result ReceiveStream(const mrsDataChannelStreamDestination& destination,
+                       StreamProgressCallback callback) noexcept;
+
+  /// Abort the stream transfers in progress, in both directions.
+  void AbortStreams() noexcept;
+
+  /// Allocate a send buffer of |capacity| bytes that the caller can fill
+  /// directly before handing it to |SendBuffer()|, to avoid copying the
+  /// message content. Return |nullptr| if the capacity exceeds the maximum
+  /// buffering size.
+  MRS_NODISCARD std::unique_ptr<rtc::CopyOnWriteBuffer> LeaseSendBuffer(
+      size_t capacity) const noexcept;
+
+  /// Send a message through the data channel with the specified message kind,
+  /// sharing the storage of |buffer| with the SCTP send queue instead of
+  /// copying it.
+  bool SendBuffer(mrsMessageKind messageKind,
+                  rtc::CopyOnWriteBuffer buffer) noexcept;
+
   //
   // Advanced use
   //
@@ -106,6 +193,16 @@ class DataChannel : public webrtc::DataChannelObserver {
     return data_channel_.get();
   }
 
+  /// Hand |buffer| to the underlying data channel right away, bypassing the
+  /// managed send queue, and update the metrics. Only called on the signaling
+  /// thread.
+  bool SendNow(const webrtc::DataBuffer& buffer) noexcept;
+
+  /// Send |buffer| right away if the managed send queue is disabled, or if it
+  /// is empty and the SCTP buffering is below the high watermark. Otherwise
+  /// append it to the send queue. Only called on the signaling thread.
+  bool SendOrEnqueue(const webrtc::DataBuffer& buffer) noexcept;
+
   /// This is invoked automatically by PeerConnection::RemoveDataChannel().
   /// Do not call it manually.
   void OnRemovedFromPeerConnection() noexcept { owner_ = nullptr; }
@@ -124,12 +221,39 @@ class DataChannel : public webrtc::DataChannelObserver {
   void OnBufferedAmountChange(uint64_t previous_amount) noexcept override;
 
  private:
+  /// Run |func| synchronously on the WebRTC signaling thread, which the data
+  /// channel proxy dispatches all calls to.
+  void InvokeOnSignalingThread(const std::function<void()>& func) const
+      noexcept;
+
+  MRS_NODISCARD bool IsSendQueueEnabled() const noexcept;
+
+  /// Check if a message of |size| bytes can be handed to SCTP without
+  /// exceeding the high watermark. Must be called with |send_queue_mutex_|
+  /// held.
+  MRS_NODISCARD bool CanSendNow(uint64_t size, uint64_t buffered_amount) const
+      noexcept;
+
+  /// Hand queued messages to SCTP until the high watermark is reached, and
+  /// fire the writable event if the queue drained below the low watermark.
+  /// Only called on the signaling thread.
+  void DrainSendQueue() noexcept;
+
+  /// Send the next chunks of the stream being sent, if any. Only called on the
+  /// signaling thread.
+  void PumpStream() noexcept;
+
   /// PeerConnection object owning this data channel. This is only valid from
   /// creation until the data channel is removed from the peer connection with
   /// RemoveDataChannel(), at which point the data channel is removed from its
   /// parent's collection and |owner_| is set to nullptr.
   PeerConnection* owner_{};
 
+  /// WebRTC signaling thread of the owning peer connection, cached on creation
+  /// so that dispatching a send does not need to look up the global factory.
+  /// The global factory keeps it alive as long as the peer connection.
+  rtc::Thread* const signaling_thread_;
+
   /// Underlying core implementation.
   rtc::scoped_refptr<webrtc::DataChannelInterface> data_channel_;
 
@@ -137,8 +261,71 @@ class DataChannel : public webrtc::DataChannelObserver {
   MessageExCallback message_ex_callback_ RTC_GUARDED_BY(mutex_);
   BufferingCallback buffering_callback_ RTC_GUARDED_BY(mutex_);
   StateCallback state_callback_ RTC_GUARDED_BY(mutex_);
+  WritableCallback writable_callback_ RTC_GUARDED_BY(mutex_);
   mutable std::mutex mutex_;
 
+  /// Metrics counters, updated without lock from the threads sending and
+  /// receiving messages.
+  struct Metrics {
+    std::atomic<uint64_t> messages_sent{0};
+    std::atomic<uint64_t> bytes_sent{0};
+    std::atomic<uint64_t> messages_received{0};
+    std::atomic<uint64_t> bytes_received{0};
+    std::atomic<uint64_t> send_rejections{0};
+    std::atomic<uint64_t> receive_drops{0};
+    std::atomic<uint64_t> peak_buffered_amount{0};
+    std::atomic<uint64_t>
+        callback_duration_histogram[kMrsDataChannelHistogramSize]{};
+  };
+  Metrics metrics_;
+
+  /// Whether received messages are queued into |receive_queue_| instead of
+  /// being delivered to the message callbacks.
+  std::atomic_bool polling_receive_{false};
+
+  /// Messages received in polling mode. The buffers share the storage
+  /// allocated by the SCTP transport on reception, so are never copied.
+  MpscQueue<webrtc::DataBuffer> receive_queue_;
+
+  /// Number of messages in |receive_queue_|, and maximum number of messages
+  /// beyond which received messages are dropped. Messages are only pushed from
+  /// the signaling thread, so checking the size before pushing is not racy.
+  std::atomic<uint32_t> receive_queue_size_{0};
+  std::atomic<uint32_t> receive_queue_capacity_{
+      kMrsDataChannelDefaultReceiveQueueCapacity};
+
+  /// Configuration of the managed send queue, which is disabled if its
+  /// capacity is zero.
+  mrsDataChannelSendQueueConfig send_queue_config_
+      RTC_GUARDED_BY(send_queue_mutex_){0, 0, 0};
+
+  /// Messages waiting for the SCTP buffering to drain, in send order. Only
+  /// modified on the signaling thread.
+  std::deque<webrtc::DataBuffer> send_queue_ RTC_GUARDED_BY(send_queue_mutex_);
+
+  /// Total byte size of the messages in |send_queue_|.
+  uint64_t queued_bytes_ RTC_GUARDED_BY(send_queue_mutex_){0};
+
+  /// Whether the writable event is armed, that is whether no message was
+  /// queued or rejected since it last fired.
+  bool writable_ RTC_GUARDED_BY(send_queue_mutex_){true};
+  mutable std::mutex send_queue_mutex_;
+
+  /// Set while handing a message to SCTP, to detect re-entrant buffering
+  /// change notifications. Only accessed on the signaling thread.
+  bool in_send_{false};
+
+  /// Stream transfers in progress, if any. Only accessed on the signaling
+  /// thread.
+  std::unique_ptr<DataChannelStreamSender> stream_sender_;
+  std::unique_ptr<DataChannelStreamReceiver> stream_receiver_;
+  uint32_t next_stream_id_{1};
+
+  /// Whether the channel is dedicated to stream transfers, so that received
+  /// stream frames are not reported as messages. Only accessed on the
+  /// signaling thread.
+  bool stream_receive_enabled_{false};
+
   /// Opaque user data.
   void* user_data_{nullptr};
 };
@@ -0,0 +1,328 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "data_channel.h"
+#include "data_channel_stream.h"
+
+namespace {
+
+/// Magic number starting all stream frames ("MRST" in little endian).
+constexpr uint32_t kStreamFrameMagic = 0x5453524Du;
+
+/// SCTP buffering above which the sender stops sending chunks until it drains.
+constexpr uint64_t kStreamHighWatermark = 1024 * 1024;
+
+void WriteLE32(uint8_t* data, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    data[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+void WriteLE64(uint8_t* data, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    data[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+uint32_t ReadLE32(const uint8_t* data) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= (uint32_t)data[i] << (8 * i);
+  }
+  return value;
+}
+
+uint64_t ReadLE64(const uint8_t* data) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value |= (uint64_t)data[i] << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+constexpr size_t StreamFrame::kHeaderSize;
+constexpr size_t StreamFrame::kMaxChunkSize;
+
+bool StreamFrame::Parse(const webrtc::DataBuffer& buffer,
+                        Type& type,
+                        uint32_t& stream_id,
+                        uint64_t& offset) noexcept {
+  if (!buffer.binary || (buffer.size() < kHeaderSize)) {
+    return false;
+  }
+  const uint8_t* const data = buffer.data.data();
+  if (ReadLE32(data) != kStreamFrameMagic) {
+    return false;
+  }
+  type = (Type)data[4];
+  stream_id = ReadLE32(data + 8);
+  offset = ReadLE64(data + 12);
+  return true;
+}
+
+void StreamFrame::WriteHeader(uint8_t* data,
+                              Type type,
+                              uint32_t stream_id,
+                              uint64_t offset) noexcept {
+  WriteLE32(data, kStreamFrameMagic);
+  data[4] = (uint8_t)type;
+  data[5] = data[6] = data[7] = 0;
+  WriteLE32(data + 8, stream_id);
+  WriteLE64(data + 12, offset);
+}
+
+ErrorOr<std::unique_ptr<DataChannelStreamSender>>
+DataChannelStreamSender::Create(uint32_t stream_id,
+                                const mrsDataChannelStreamSource& source,
+                                StreamProgressCallback callback) noexcept {
+  if (source.file_path && source.file_path[0]) {
+    std::ifstream file(source.file_path, std::ios::binary | std::ios::ate);
+    if (!file) {
+      RTC_LOG(LS_ERROR) << "Cannot open stream source file '"
+                        << source.file_path << "'.";
+      return Error(Result::kNotFound);
+    }
+    const std::streamoff size = file.tellg();
+    if ((size < 0) || !file.seekg(0)) {
+      RTC_LOG(LS_ERROR) << "Cannot get the size of stream source file '"
+                        << source.file_path << "'.";
+      return Error(Result::kUnknownError);
+    }
+    std::unique_ptr<DataChannelStreamSender> sender(
+        new DataChannelStreamSender(stream_id, (uint64_t)size, callback));
+    sender->file_ = std::move(file);
+    return sender;
+  }
+  if (!source.data && (source.size > 0)) {
+    return Error(Result::kInvalidParameter);
+  }
+  std::unique_ptr<DataChannelStreamSender> sender(
+      new DataChannelStreamSender(stream_id, source.size, callback));
+  sender->data_ = (const uint8_t*)source.data;
+  return sender;
+}
+
+DataChannelStreamSender::DataChannelStreamSender(
+    uint32_t stream_id,
+    uint64_t total_size,
+    StreamProgressCallback callback) noexcept
+    : stream_id_(stream_id), total_size_(total_size), callback_(callback) {}
+
+bool DataChannelStreamSender::Pump(DataChannel& data_channel) noexcept {
+  if (finished_ || pumping_) {
+    return !finished_;
+  }
+  pumping_ = true;
+  const uint64_t sent_size_before = sent_size_;
+  if (!begin_sent_) {
+    rtc::CopyOnWriteBuffer buffer(StreamFrame::kHeaderSize);
+    StreamFrame::WriteHeader(buffer.data(), StreamFrame::Type::kBegin,
+                             stream_id_, total_size_);
+    if (!data_channel.SendOrEnqueue(
+            webrtc::DataBuffer(buffer, /* binary = */ true))) {
+      pumping_ = false;
+      Fail();
+      return false;
+    }
+    begin_sent_ = true;
+  }
+  // Chunks go through the managed send queue, if enabled, so that they stay
+  // ordered with the other messages of the channel. Stop while the queue holds
+  // some messages, and resume once it drained into SCTP.
+  mrsDataChannelSendQueueState state{};
+  data_channel.GetSendQueueState(state);
+  while ((sent_size_ < total_size_) && (state.queued_message_count == 0) &&
+         (state.buffered_amount < kStreamHighWatermark)) {
+    const size_t chunk_size = (size_t)std::min<uint64_t>(
+        total_size_ - sent_size_, StreamFrame::kMaxChunkSize);
+    // Read the payload directly into the message storage, which is shared
+    // with the SCTP send queue, to avoid any intermediate copy.
+    rtc::CopyOnWriteBuffer buffer(StreamFrame::kHeaderSize + chunk_size);
+    uint8_t* const data = buffer.data();
+    StreamFrame::WriteHeader(data, StreamFrame::Type::kChunk, stream_id_,
+                             sent_size_);
+    if (data_) {
+      memcpy(data + StreamFrame::kHeaderSize, data_ + sent_size_, chunk_size);
+    } else if (!file_.read((char*)data + StreamFrame::kHeaderSize,
+                           chunk_size)) {
+      RTC_LOG(LS_ERROR) << "Failed to read stream source file at offset "
+                        << sent_size_ << ".";
+      pumping_ = false;
+      Abort(&data_channel);
+      return false;
+    }
+    if (!data_channel.SendOrEnqueue(
+            webrtc::DataBuffer(buffer, /* binary = */ true))) {
+      pumping_ = false;
+      Fail();
+      return false;
+    }
+    sent_size_ += chunk_size;
+    data_channel.GetSendQueueState(state);
+  }
+  pumping_ = false;
+  if (sent_size_ == total_size_) {
+    finished_ = true;
+    if (callback_) {
+      callback_(stream_id_, mrsDataChannelStreamStatus::kCompleted,
+                sent_size_, total_size_);
+    }
+    return false;
+  }
+  if ((sent_size_ != sent_size_before) && callback_) {
+    callback_(stream_id_, mrsDataChannelStreamStatus::kInProgress, sent_size_,
+              total_size_);
+  }
+  return true;
+}
+
+void DataChannelStreamSender::Abort(DataChannel* data_channel) noexcept {
+  if (finished_) {
+    return;
+  }
+  finished_ = true;
+  if (data_channel && begin_sent_) {
+    rtc::CopyOnWriteBuffer buffer(StreamFrame::kHeaderSize);
+    StreamFrame::WriteHeader(buffer.data(), StreamFrame::Type::kAbort,
+                             stream_id_, sent_size_);
+    data_channel->SendOrEnqueue(
+        webrtc::DataBuffer(buffer, /* binary = */ true));
+  }
+  if (callback_) {
+    callback_(stream_id_, mrsDataChannelStreamStatus::kAborted, sent_size_,
+              total_size_);
+  }
+}
+
+void DataChannelStreamSender::Fail() noexcept {
+  finished_ = true;
+  if (callback_) {
+    callback_(stream_id_, mrsDataChannelStreamStatus::kFailed, sent_size_,
+              total_size_);
+  }
+}
+
+ErrorOr<std::unique_ptr<DataChannelStreamReceiver>>
+DataChannelStreamReceiver::Create(
+    const mrsDataChannelStreamDestination& destination,
+    StreamProgressCallback callback) noexcept {
+  std::unique_ptr<DataChannelStreamReceiver> receiver(
+      new DataChannelStreamReceiver(callback));
+  if (destination.file_path && destination.file_path[0]) {
+    receiver->file_.open(destination.file_path,
+                         std::ios::binary | std::ios::trunc);
+    if (!receiver->file_) {
+      RTC_LOG(LS_ERROR) << "Cannot open stream destination file '"
+                        << destination.file_path << "'.";
+      return Error(Result::kNotFound);
+    }
+    return receiver;
+  }
+  if (!destination.data && (destination.capacity > 0)) {
+    return Error(Result::kInvalidParameter);
+  }
+  receiver->data_ = (uint8_t*)destination.data;
+  receiver->capacity_ = destination.capacity;
+  return receiver;
+}
+
+DataChannelStreamReceiver::DataChannelStreamReceiver(
+    StreamProgressCallback callback) noexcept
+    : callback_(callback) {}
+
+bool DataChannelStreamReceiver::OnFrame(
+    StreamFrame::Type type,
+    uint32_t stream_id,
+    uint64_t offset,
+    const webrtc::DataBuffer& buffer) noexcept {
+  if (!begin_received_) {
+    if (type != StreamFrame::Type::kBegin) {
+      // Tail of a stream aborted locally; ignore.
+      return true;
+    }
+    begin_received_ = true;
+    stream_id_ = stream_id;
+    total_size_ = offset;
+    if (!file_.is_open() && (total_size_ > capacity_)) {
+      RTC_LOG(LS_ERROR) << "Stream of " << total_size_
+                        << " bytes exceeds the destination capacity of "
+                        << capacity_ << " bytes.";
+      Fail(mrsDataChannelStreamStatus::kFailed);
+      return false;
+    }
+    if (total_size_ == 0) {
+      if (callback_) {
+        callback_(stream_id_, mrsDataChannelStreamStatus::kCompleted, 0, 0);
+      }
+      return false;
+    }
+    return true;
+  }
+  if (stream_id != stream_id_) {
+    return true;
+  }
+  if (type == StreamFrame::Type::kAbort) {
+    Fail(mrsDataChannelStreamStatus::kAborted);
+    return false;
+  }
+  const size_t chunk_size = buffer.size() - StreamFrame::kHeaderSize;
+  if ((type != StreamFrame::Type::kChunk) || (offset != received_size_) ||
+      (chunk_size > total_size_ - received_size_)) {
+    RTC_LOG(LS_ERROR) << "Invalid stream frame for stream " << stream_id_
+                      << " at offset " << offset << ".";
+    Fail(mrsDataChannelStreamStatus::kFailed);
+    return false;
+  }
+  const char* const chunk =
+      (const char*)buffer.data.data() + StreamFrame::kHeaderSize;
+  if (data_) {
+    memcpy(data_ + received_size_, chunk, chunk_size);
+  } else if (!file_.write(chunk, chunk_size)) {
+    RTC_LOG(LS_ERROR) << "Failed to write stream destination file at offset "
+                      << received_size_ << ".";
+    Fail(mrsDataChannelStreamStatus::kFailed);
+    return false;
+  }
+  received_size_ += chunk_size;
+  if (received_size_ == total_size_) {
+    if (file_.is_open()) {
+      file_.close();
+    }
+    if (callback_) {
+      callback_(stream_id_, mrsDataChannelStreamStatus::kCompleted,
+                received_size_, total_size_);
+    }
+    return false;
+  }
+  if (callback_) {
+    callback_(stream_id_, mrsDataChannelStreamStatus::kInProgress,
+              received_size_, total_size_);
+  }
+  return true;
+}
+
+void DataChannelStreamReceiver::Abort() noexcept {
+  Fail(mrsDataChannelStreamStatus::kAborted);
+}
+
+void DataChannelStreamReceiver::Fail(
+    mrsDataChannelStreamStatus status) noexcept {
+  if (file_.is_open()) {
+    file_.close();
+  }
+  if (callback_) {
+    callback_(stream_id_, status, received_size_, total_size_);
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
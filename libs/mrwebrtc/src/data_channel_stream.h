@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+
+#include "api/datachannelinterface.h"
+
+#include "callback.h"
+#include "data_channel_interop.h"
+#include "mrs_errors.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class DataChannel;
+
+/// Callback fired to report the progress of a stream transfer.
+using StreamProgressCallback = Callback<const uint32_t,
+                                        const mrsDataChannelStreamStatus,
+                                        const uint64_t,
+                                        const uint64_t>;
+
+/// Framing of the messages exchanged by stream transfers. Each message starts
+/// with a fixed-size header identifying the stream, followed for chunks by a
+/// slice of the payload. Streams require a reliable and ordered data channel,
+/// so chunks are received in the order they were sent.
+struct StreamFrame {
+  enum class Type : uint8_t {
+    /// Start of a stream; the header offset holds the total payload size.
+    kBegin = 1,
+    /// Payload chunk; the header offset is the position of the chunk.
+    kChunk = 2,
+    /// The sender aborted the stream.
+    kAbort = 3,
+  };
+
+  /// Byte size of the frame header.
+  static constexpr size_t kHeaderSize = 20;
+
+  /// Maximum byte size of the payload of a chunk. Messages of 16 KiB are the
+  /// most interoperable across SCTP implementations, and keep the latency of
+  /// other channels sharing the SCTP association low.
+  static constexpr size_t kMaxChunkSize = 16 * 1024 - kHeaderSize;
+
+  /// Check if |buffer| is a stream frame, and decode its header if so.
+  static bool Parse(const webrtc::DataBuffer& buffer,
+                    Type& type,
+                    uint32_t& stream_id,
+                    uint64_t& offset) noexcept;
+
+  /// Write a frame header into the first |kHeaderSize| bytes of |data|.
+  static void WriteHeader(uint8_t* data,
+                          Type type,
+                          uint32_t stream_id,
+                          uint64_t offset) noexcept;
+};
+
+/// Sending side of a stream transfer, reading the payload from memory or
+/// incrementally from a file so that it is never entirely loaded in memory.
+/// Only accessed from the signaling thread.
+class DataChannelStreamSender {
+ public:
+  static ErrorOr<std::unique_ptr<DataChannelStreamSender>> Create(
+      uint32_t stream_id,
+      const mrsDataChannelStreamSource& source,
+      StreamProgressCallback callback) noexcept;
+
+  MRS_NODISCARD uint32_t stream_id() const noexcept { return stream_id_; }
+
+  /// Send chunks until the SCTP buffering reaches the stream high watermark or
+  /// the entire payload was sent. Return |true| while the transfer is not
+  /// finished.
+  bool Pump(DataChannel& data_channel) noexcept;
+
+  /// Abort the transfer, notifying the remote peer if |data_channel| is not
+  /// null.
+  void Abort(DataChannel* data_channel) noexcept;
+
+ protected:
+  DataChannelStreamSender(uint32_t stream_id,
+                          uint64_t total_size,
+                          StreamProgressCallback callback) noexcept;
+
+  /// Fail the transfer and report it.
+  void Fail() noexcept;
+
+  const uint32_t stream_id_;
+  const uint64_t total_size_;
+  StreamProgressCallback callback_;
+
+  /// Payload in memory, or null if read from |file_|.
+  const uint8_t* data_{nullptr};
+  std::ifstream file_;
+
+  /// Number of payload bytes sent so far.
+  uint64_t sent_size_{0};
+  bool begin_sent_{false};
+  bool finished_{false};
+
+  /// Set while pumping, to ignore re-entrant calls from buffering changes.
+  bool pumping_{false};
+};
+
+/// Receiving side of a stream transfer, reassembling the payload into a
+/// preallocated memory buffer or incrementally into a file. Only accessed from
+/// the signaling thread.
+class DataChannelStreamReceiver {
+ public:
+  static ErrorOr<std::unique_ptr<DataChannelStreamReceiver>> Create(
+      const mrsDataChannelStreamDestination& destination,
+      StreamProgressCallback callback) noexcept;
+
+  /// Process a received stream frame. Return |true| while the transfer is not
+  /// finished.
+  bool OnFrame(StreamFrame::Type type,
+               uint32_t stream_id,
+               uint64_t offset,
+               const webrtc::DataBuffer& buffer) noexcept;
+
+  /// Abort the transfer locally.
+  void Abort() noexcept;
+
+ protected:
+  DataChannelStreamReceiver(StreamProgressCallback callback) noexcept;
+
+  /// Fail the transfer and report it.
+  void Fail(mrsDataChannelStreamStatus status) noexcept;
+
+  StreamProgressCallback callback_;
+
+  /// Destination in memory, or null if written to |file_|.
+  uint8_t* data_{nullptr};
+  uint64_t capacity_{0};
+  std::ofstream file_;
+
+  /// Identifier of the stream being received, once its first frame arrived.
+  uint32_t stream_id_{0};
+  bool begin_received_{false};
+  uint64_t total_size_{0};
+  uint64_t received_size_{0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
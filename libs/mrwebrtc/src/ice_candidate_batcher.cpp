@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "ice_candidate_batcher.h"
+
+namespace {
+
+/// Message ID of the delay timer.
+constexpr uint32_t kFlushMessageId = 1;
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+IceCandidateBatcher::IceCandidateBatcher(
+    rtc::Thread* signaling_thread) noexcept
+    : signaling_thread_(signaling_thread) {}
+
+IceCandidateBatcher::~IceCandidateBatcher() {
+  signaling_thread_->Clear(this);
+}
+
+void IceCandidateBatcher::Configure(const mrsIceCandidateBatchConfig& config,
+                                    BatchCallback callback) noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  RTC_DCHECK_GT(config.max_count, 0u);
+  config_ = config;
+  callback_ = callback;
+  pending_.clear();
+  if (timer_posted_) {
+    signaling_thread_->Clear(this, kFlushMessageId);
+    timer_posted_ = false;
+  }
+}
+
+void IceCandidateBatcher::Add(
+    const webrtc::IceCandidateInterface& candidate) noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  if (!callback_) {
+    return;
+  }
+  PendingCandidate pending{};
+  if (!candidate.ToString(&pending.content)) {
+    RTC_LOG(LS_ERROR) << "Failed to stringify ICE candidate into SDP format.";
+    return;
+  }
+  pending.sdp_mid = candidate.sdp_mid();
+  pending.sdp_mline_index = candidate.sdp_mline_index();
+  pending_.push_back(std::move(pending));
+  if (pending_.size() >= config_.max_count) {
+    Flush();
+  } else if (!timer_posted_) {
+    signaling_thread_->PostDelayed(RTC_FROM_HERE, (int)config_.max_delay_ms,
+                                   this, kFlushMessageId);
+    timer_posted_ = true;
+  }
+}
+
+void IceCandidateBatcher::Flush() noexcept {
+  RTC_DCHECK(signaling_thread_->IsCurrent());
+  if (timer_posted_) {
+    signaling_thread_->Clear(this, kFlushMessageId);
+    timer_posted_ = false;
+  }
+  if (pending_.empty()) {
+    return;
+  }
+  // Move the batch out before invoking the callback, which may re-enter and
+  // reconfigure the batcher.
+  std::vector<PendingCandidate> batch;
+  batch.swap(pending_);
+  std::vector<mrsIceCandidate> candidates(batch.size());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    candidates[i].sdp_mid = batch[i].sdp_mid.c_str();
+    candidates[i].content = batch[i].content.c_str();
+    candidates[i].sdp_mline_index = batch[i].sdp_mline_index;
+  }
+  const BatchCallback callback = callback_;
+  callback(candidates.data(), (uint32_t)candidates.size());
+}
+
+void IceCandidateBatcher::OnMessage(rtc::Message* message) {
+  if (message->message_id == kFlushMessageId) {
+    timer_posted_ = false;
+    Flush();
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
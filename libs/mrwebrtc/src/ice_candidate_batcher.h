@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "api/jsep.h"
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/thread.h"
+
+#include "callback.h"
+#include "interop_api.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Accumulator of local ICE candidates, delivering them in batches to reduce
+/// the number of messages the signaling solution has to send.
+///
+/// Candidates are delivered once the batch is full, once the oldest candidate
+/// of the batch waited for the configured delay, or once ICE gathering is
+/// complete, whichever comes first. Only accessed from the signaling thread,
+/// on which the delay timer also runs.
+class IceCandidateBatcher : public rtc::MessageHandler {
+ public:
+  /// Callback invoked with a batch of candidates.
+  using BatchCallback = Callback<const mrsIceCandidate*, uint32_t>;
+
+  explicit IceCandidateBatcher(rtc::Thread* signaling_thread) noexcept;
+  ~IceCandidateBatcher() override;
+
+  /// Change the batching parameters and the callback receiving the batches.
+  /// Candidates pending for the previous callback are dropped.
+  void Configure(const mrsIceCandidateBatchConfig& config,
+                 BatchCallback callback) noexcept;
+
+  /// Add a newly gathered candidate to the current batch.
+  void Add(const webrtc::IceCandidateInterface& candidate) noexcept;
+
+  /// Deliver the current batch immediately, if not empty.
+  void Flush() noexcept;
+
+ protected:
+  struct PendingCandidate {
+    std::string sdp_mid;
+    std::string content;
+    int sdp_mline_index;
+  };
+
+  void OnMessage(rtc::Message* message) override;
+
+  rtc::Thread* const signaling_thread_;
+  mrsIceCandidateBatchConfig config_;
+  BatchCallback callback_;
+  std::vector<PendingCandidate> pending_;
+
+  /// Whether the delay timer is running for the current batch.
+  bool timer_posted_{false};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
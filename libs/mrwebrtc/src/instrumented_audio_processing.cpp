@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "instrumented_audio_processing.h"
+
+#include "rtc_base/timeutils.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+rtc::scoped_refptr<InstrumentedAudioProcessing>
+InstrumentedAudioProcessing::Create(bool bypass) {
+  rtc::scoped_refptr<InstrumentedAudioProcessing> apm =
+      new rtc::RefCountedObject<InstrumentedAudioProcessing>(bypass);
+  if (apm->Initialize() != webrtc::AudioProcessing::kNoError) {
+    RTC_LOG(LS_ERROR) << "Failed to initialize audio processing module.";
+    return nullptr;
+  }
+  return apm;
+}
+
+InstrumentedAudioProcessing::InstrumentedAudioProcessing(bool bypass)
+    : webrtc::AudioProcessingImpl(webrtc::Config()), bypass_(bypass) {}
+
+void InstrumentedAudioProcessing::Timings::Add(int64_t time_us) noexcept {
+  frame_count.fetch_add(1, std::memory_order_relaxed);
+  total_time_us.fetch_add((uint64_t)time_us, std::memory_order_relaxed);
+  const uint32_t time = (uint32_t)std::min<int64_t>(time_us, UINT32_MAX);
+  uint32_t max_time = max_time_us.load(std::memory_order_relaxed);
+  while ((time > max_time) && !max_time_us.compare_exchange_weak(
+                                  max_time, time, std::memory_order_relaxed)) {
+  }
+}
+
+void InstrumentedAudioProcessing::AccumulateStats(
+    mrsAudioProcessingStats& stats) const noexcept {
+  stats.bypassed = (bypass_ ? mrsBool::kTrue : mrsBool::kFalse);
+  stats.capture_frame_count +=
+      capture_timings_.frame_count.load(std::memory_order_relaxed);
+  stats.capture_total_time_us +=
+      capture_timings_.total_time_us.load(std::memory_order_relaxed);
+  stats.capture_max_time_us =
+      std::max(stats.capture_max_time_us,
+               capture_timings_.max_time_us.load(std::memory_order_relaxed));
+  stats.render_frame_count +=
+      render_timings_.frame_count.load(std::memory_order_relaxed);
+  stats.render_total_time_us +=
+      render_timings_.total_time_us.load(std::memory_order_relaxed);
+  stats.render_max_time_us =
+      std::max(stats.render_max_time_us,
+               render_timings_.max_time_us.load(std::memory_order_relaxed));
+}
+
+int InstrumentedAudioProcessing::ProcessStream(webrtc::AudioFrame* frame) {
+  if (bypass_) {
+    return kNoError;
+  }
+  const int64_t start_us = rtc::TimeMicros();
+  const int ret = webrtc::AudioProcessingImpl::ProcessStream(frame);
+  capture_timings_.Add(rtc::TimeMicros() - start_us);
+  return ret;
+}
+
+int InstrumentedAudioProcessing::ProcessReverseStream(
+    webrtc::AudioFrame* frame) {
+  if (bypass_) {
+    return kNoError;
+  }
+  const int64_t start_us = rtc::TimeMicros();
+  const int ret = webrtc::AudioProcessingImpl::ProcessReverseStream(frame);
+  render_timings_.Add(rtc::TimeMicros() - start_us);
+  return ret;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+
+#include "interop_api.h"
+
+#include "modules/audio_processing/audio_processing_impl.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Audio processing module (APM) measuring the time spent processing each
+/// 10 ms frame, and optionally bypassing all processing.
+///
+/// The audio engine calls |ProcessStream()| for each captured frame and
+/// |ProcessReverseStream()| for each played out frame, from the audio device
+/// threads. When bypassed, those calls return immediately and leave the frame
+/// untouched, so no audio processing submodule runs at all, whatever the
+/// options the audio engine applied.
+class InstrumentedAudioProcessing : public webrtc::AudioProcessingImpl {
+ public:
+  /// Create and initialize a new instance, or return NULL on error.
+  static rtc::scoped_refptr<InstrumentedAudioProcessing> Create(bool bypass);
+
+  /// Add the processing statistics accumulated since the creation of the
+  /// module to |stats|, keeping the largest of the maximum times, so that the
+  /// statistics of several modules can be aggregated. This is
+  /// multithread-safe.
+  void AccumulateStats(mrsAudioProcessingStats& stats) const noexcept;
+
+  bool IsBypassed() const noexcept { return bypass_; }
+
+  using webrtc::AudioProcessingImpl::ProcessReverseStream;
+  using webrtc::AudioProcessingImpl::ProcessStream;
+  int ProcessStream(webrtc::AudioFrame* frame) override;
+  int ProcessReverseStream(webrtc::AudioFrame* frame) override;
+
+ protected:
+  explicit InstrumentedAudioProcessing(bool bypass);
+
+  /// Timing statistics for one direction of the audio processing.
+  struct Timings {
+    std::atomic<uint64_t> frame_count{0};
+    std::atomic<uint64_t> total_time_us{0};
+    std::atomic<uint32_t> max_time_us{0};
+
+    void Add(int64_t time_us) noexcept;
+  };
+
+  const bool bypass_;
+  Timings capture_timings_;
+  Timings render_timings_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -66,3 +66,240 @@ mrsDataChannelSendMessageEx(mrsDataChannelHandle dataChannelHandle,
   return (data_channel->SendEx(messageKind, data, (size_t)size) ? Result::kSuccess
                                                                 : Result::kUnknownError);
 }
+
+mrsResult MRS_CALL
+mrsDataChannelBroadcast(const mrsDataChannelHandle* data_channel_handles,
+                        uint32_t count,
+                        mrsMessageKind message_kind,
+                        const void* data,
+                        uint64_t size,
+                        mrsResult* results) noexcept {
+  if ((!data_channel_handles && (count > 0)) || (!data && (size > 0))) {
+    return Result::kInvalidParameter;
+  }
+  std::vector<DataChannel*> data_channels(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    data_channels[i] = static_cast<DataChannel*>(data_channel_handles[i]);
+  }
+  return DataChannel::Broadcast(data_channels.data(), count, message_kind, data,
+                                (size_t)size, results);
+}
+
+mrsResult MRS_CALL
+mrsDataChannelGetMetrics(mrsDataChannelHandle dataChannelHandle,
+                         mrsDataChannelMetrics* metrics_out) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!metrics_out) {
+    return Result::kInvalidParameter;
+  }
+  data_channel->GetMetrics(*metrics_out);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelSetReceiveMode(mrsDataChannelHandle dataChannelHandle,
+                             mrsDataChannelReceiveMode mode) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if ((mode != mrsDataChannelReceiveMode::kCallback) &&
+      (mode != mrsDataChannelReceiveMode::kPolling)) {
+    return Result::kInvalidParameter;
+  }
+  data_channel->SetReceiveMode(mode);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelSetReceiveQueueCapacity(mrsDataChannelHandle dataChannelHandle,
+                                      uint32_t capacity) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (capacity == 0) {
+    return Result::kInvalidParameter;
+  }
+  data_channel->SetReceiveQueueCapacity(capacity);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelReceive(mrsDataChannelHandle dataChannelHandle,
+                      mrsDataChannelReceivedMessage* messages,
+                      uint32_t max_count,
+                      uint32_t* count_out) noexcept {
+  if (!count_out) {
+    return Result::kInvalidParameter;
+  }
+  *count_out = 0;
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!messages && (max_count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  *count_out = (uint32_t)data_channel->Receive(messages, max_count);
+  return Result::kSuccess;
+}
+
+void MRS_CALL
+mrsDataChannelReleaseMessages(const mrsDataChannelReceivedMessage* messages,
+                              uint32_t count) noexcept {
+  if (messages) {
+    for (uint32_t i = 0; i < count; ++i) {
+      DataChannel::ReleaseMessage(messages[i].handle);
+    }
+  }
+}
+
+mrsResult MRS_CALL mrsDataChannelConfigureSendQueue(
+    mrsDataChannelHandle dataChannelHandle,
+    const mrsDataChannelSendQueueConfig* config) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  return data_channel->ConfigureSendQueue(*config);
+}
+
+mrsResult MRS_CALL mrsDataChannelGetSendQueueState(
+    mrsDataChannelHandle dataChannelHandle,
+    mrsDataChannelSendQueueState* state_out) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!state_out) {
+    return Result::kInvalidParameter;
+  }
+  data_channel->GetSendQueueState(*state_out);
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsDataChannelRegisterWritableCallback(
+    mrsDataChannelHandle dataChannelHandle,
+    mrsDataChannelWritableCallback callback,
+    void* user_data) noexcept {
+  if (auto data_channel = static_cast<DataChannel*>(dataChannelHandle)) {
+    data_channel->SetWritableCallback({callback, user_data});
+  }
+}
+
+mrsResult MRS_CALL
+mrsDataChannelSendMessages(mrsDataChannelHandle dataChannelHandle,
+                           const mrsDataChannelMessage* messages,
+                           uint32_t count,
+                           mrsResult* results) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!messages && (count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  return data_channel->SendBatch(messages, count, results);
+}
+
+mrsResult MRS_CALL
+mrsDataChannelSendStream(mrsDataChannelHandle dataChannelHandle,
+                         const mrsDataChannelStreamSource* source,
+                         mrsDataChannelStreamProgressCallback callback,
+                         void* user_data,
+                         uint32_t* stream_id_out) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!source || !stream_id_out) {
+    return Result::kInvalidParameter;
+  }
+  return data_channel->SendStream(*source, {callback, user_data},
+                                  *stream_id_out);
+}
+
+mrsResult MRS_CALL
+mrsDataChannelReceiveStream(mrsDataChannelHandle dataChannelHandle,
+                            const mrsDataChannelStreamDestination* destination,
+                            mrsDataChannelStreamProgressCallback callback,
+                            void* user_data) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!destination) {
+    return Result::kInvalidParameter;
+  }
+  return data_channel->ReceiveStream(*destination, {callback, user_data});
+}
+
+mrsResult MRS_CALL
+mrsDataChannelAbortStreams(mrsDataChannelHandle dataChannelHandle) noexcept {
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  data_channel->AbortStreams();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelLeaseSendBuffer(mrsDataChannelHandle dataChannelHandle,
+                              uint64_t capacity,
+                              mrsDataChannelSendBufferHandle* buffer_handle_out,
+                              void** data_out) noexcept {
+  if (!buffer_handle_out || !data_out) {
+    return Result::kInvalidParameter;
+  }
+  *buffer_handle_out = nullptr;
+  *data_out = nullptr;
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  std::unique_ptr<rtc::CopyOnWriteBuffer> buffer =
+      data_channel->LeaseSendBuffer((size_t)capacity);
+  if (!buffer) {
+    return Result::kInvalidParameter;
+  }
+  *data_out = buffer->data();
+  *buffer_handle_out = buffer.release();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsDataChannelSendLeasedBuffer(mrsDataChannelHandle dataChannelHandle,
+                               mrsDataChannelSendBufferHandle buffer_handle,
+                               mrsMessageKind message_kind,
+                               uint64_t size) noexcept {
+  // Take back ownership first, so that the buffer is released on error.
+  std::unique_ptr<rtc::CopyOnWriteBuffer> buffer(
+      static_cast<rtc::CopyOnWriteBuffer*>(buffer_handle));
+  if (!buffer) {
+    return Result::kInvalidParameter;
+  }
+  auto data_channel = static_cast<DataChannel*>(dataChannelHandle);
+  if (!data_channel) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (size > buffer->size()) {
+    return Result::kInvalidParameter;
+  }
+  buffer->SetSize((size_t)size);
+  return (data_channel->SendBuffer(message_kind, std::move(*buffer))
+              ? Result::kSuccess
+              : Result::kUnknownError);
+}
+
+void MRS_CALL mrsDataChannelReleaseSendBuffer(
+    mrsDataChannelSendBufferHandle buffer_handle) noexcept {
+  delete static_cast<rtc::CopyOnWriteBuffer*>(buffer_handle);
+}
@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// This is a precompiled header, it must be on its own, followed by a blank
+// line, to prevent clang-format from reordering it with other headers.
+#include "pch.h"
+
+#include "external_audio_track_source_interop.h"
+#include "interop/global_factory.h"
+#include "media/external_audio_track_source.h"
+
+using namespace Microsoft::MixedReality::WebRTC;
+
+mrsResult MRS_CALL mrsExternalAudioTrackSourceCreate(
+    const mrsExternalAudioTrackSourceConfig* config,
+    mrsExternalAudioTrackSourceHandle* source_handle_out) noexcept {
+  if (!source_handle_out) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL source_handle_out.";
+    return Result::kInvalidParameter;
+  }
+  *source_handle_out = nullptr;
+  if (!config) {
+    RTC_LOG(LS_ERROR) << "Invalid NULL external audio track source config.";
+    return Result::kInvalidParameter;
+  }
+
+  ErrorOr<RefPtr<ExternalAudioTrackSource>> result =
+      ExternalAudioTrackSource::Create(*config);
+  if (!result.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to create external audio track source.";
+    return result.error().result();
+  }
+  *source_handle_out = result.value().release();
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL mrsExternalAudioTrackSourcePushFrame(
+    mrsExternalAudioTrackSourceHandle source_handle,
+    const mrsAudioFrame* frame) noexcept {
+  auto source = static_cast<ExternalAudioTrackSource*>(source_handle);
+  if (!source) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!frame || (frame->sample_count_ > 0 && !frame->data_)) {
+    return Result::kInvalidParameter;
+  }
+  return source->PushFrame(*frame);
+}
+
+void MRS_CALL mrsExternalAudioTrackSourceShutdown(
+    mrsExternalAudioTrackSourceHandle source_handle) noexcept {
+  if (auto source = static_cast<ExternalAudioTrackSource*>(source_handle)) {
+    source->Shutdown();
+  }
+}
@@ -5,7 +5,10 @@
 // line, to prevent clang-format from reordering it with other headers.
 #include "pch.h"
 
+#include "instrumented_audio_processing.h"
 #include "interop/global_factory.h"
+#include "media/application_audio_device_module.h"
+#include "media/headless_audio_device_module.h"
 #include "media/local_video_track.h"
 #include "peer_connection.h"
 #include "rtc_base/refcountedobject.h"
@@ -27,6 +30,15 @@ namespace WebRTC {
 mrsAudioDeviceModule GlobalFactory::s_audioDeviceModule =
     mrsAudioDeviceModule::kDefault;
 
+std::unique_ptr<HeadlessAudioDeviceOptions>
+    GlobalFactory::s_headlessAudioOptions;
+
+mrsApplicationAudioDeviceConfig GlobalFactory::s_applicationAudioConfig{};
+
+mrsAudioProcessingConfig GlobalFactory::s_audioProcessingConfig{};
+
+uint32_t GlobalFactory::s_threadGroupCount = 1;
+
 uint32_t GlobalFactory::StaticReportLiveObjects() noexcept {
   // Lock the instance to prevent shutdown if it already exists, while
   // enumerating live objects.
@@ -44,6 +56,14 @@ mrsResult GlobalFactory::UseAudioDeviceModule(
         << "Cannot enable or disable ADM2 after the library is initialized.";
     return mrsResult::kInvalidOperation;
   }
+#if defined(WINUWP)
+  if ((adm == mrsAudioDeviceModule::kHeadless) ||
+      (adm == mrsAudioDeviceModule::kApplication)) {
+    RTC_LOG(LS_ERROR) << "The headless and application-driven ADMs are not "
+                         "supported on UWP.";
+    return mrsResult::kUnsupported;
+  }
+#endif  // defined(WINUWP)
   s_audioDeviceModule = adm;
   return mrsResult::kSuccess;
 }
@@ -52,6 +72,88 @@ mrsAudioDeviceModule GlobalFactory::GetAudioDeviceModule() noexcept {
   return s_audioDeviceModule;
 }
 
+mrsResult GlobalFactory::SetHeadlessAudioDeviceConfig(
+    const mrsHeadlessAudioDeviceConfig& config) noexcept {
+  if (GetInstancePtrImpl(/* ensure_initialized = */ false)) {
+    RTC_LOG(LS_ERROR) << "Cannot configure the headless audio device module "
+                         "after the library is initialized.";
+    return mrsResult::kInvalidOperation;
+  }
+  ErrorOr<HeadlessAudioDeviceOptions> options =
+      HeadlessAudioDeviceOptions::FromConfig(config);
+  if (!options.ok()) {
+    return options.error().result();
+  }
+  s_headlessAudioOptions =
+      std::make_unique<HeadlessAudioDeviceOptions>(options.MoveValue());
+  return mrsResult::kSuccess;
+}
+
+mrsResult GlobalFactory::SetApplicationAudioDeviceConfig(
+    const mrsApplicationAudioDeviceConfig& config) noexcept {
+  if (GetInstancePtrImpl(/* ensure_initialized = */ false)) {
+    RTC_LOG(LS_ERROR) << "Cannot configure the application-driven audio "
+                         "device module after the library is initialized.";
+    return mrsResult::kInvalidOperation;
+  }
+  // The 10 ms frame must contain an integral number of samples.
+  if ((config.sample_rate < 100) || (config.sample_rate % 100 != 0)) {
+    RTC_LOG(LS_ERROR) << "Invalid sample rate " << config.sample_rate
+                      << " for application-driven audio device module.";
+    return mrsResult::kInvalidParameter;
+  }
+  if ((config.channel_count != 1) && (config.channel_count != 2)) {
+    RTC_LOG(LS_ERROR) << "Invalid channel count " << config.channel_count
+                      << " for application-driven audio device module.";
+    return mrsResult::kInvalidParameter;
+  }
+  s_applicationAudioConfig = config;
+  return mrsResult::kSuccess;
+}
+
+mrsApplicationAudioDeviceConfig
+GlobalFactory::GetApplicationAudioDeviceConfig() noexcept {
+  return s_applicationAudioConfig;
+}
+
+mrsResult GlobalFactory::SetAudioProcessingConfig(
+    const mrsAudioProcessingConfig& config) noexcept {
+  if (GetInstancePtrImpl(/* ensure_initialized = */ false)) {
+    RTC_LOG(LS_ERROR) << "Cannot configure the audio processing module after "
+                         "the library is initialized.";
+    return mrsResult::kInvalidOperation;
+  }
+  s_audioProcessingConfig = config;
+  return mrsResult::kSuccess;
+}
+
+mrsAudioProcessingConfig GlobalFactory::GetAudioProcessingConfig() noexcept {
+  return s_audioProcessingConfig;
+}
+
+mrsResult GlobalFactory::SetThreadGroupCount(uint32_t count) noexcept {
+  if (GetInstancePtrImpl(/* ensure_initialized = */ false)) {
+    RTC_LOG(LS_ERROR) << "Cannot change the number of thread groups after the "
+                         "library is initialized.";
+    return mrsResult::kInvalidOperation;
+  }
+  if (count == 0) {
+    return mrsResult::kInvalidParameter;
+  }
+#if defined(WINUWP)
+  if (count > 1) {
+    RTC_LOG(LS_ERROR) << "Multiple thread groups are not supported on UWP.";
+    return mrsResult::kUnsupported;
+  }
+#endif  // defined(WINUWP)
+  s_threadGroupCount = count;
+  return mrsResult::kSuccess;
+}
+
+uint32_t GlobalFactory::GetThreadGroupCount() noexcept {
+  return s_threadGroupCount;
+}
+
 mrsShutdownOptions GlobalFactory::GetShutdownOptions() noexcept {
   GlobalFactory* const factory = GetInstance();
   std::lock_guard<std::recursive_mutex> lock(factory->mutex_);
@@ -143,6 +245,55 @@ GlobalFactory::GetPeerConnectionFactory() noexcept {
   return peer_factory_;
 }
 
+ErrorOr<GlobalFactory::ThreadGroupFactory>
+GlobalFactory::GetThreadGroupFactory(int32_t index) noexcept {
+  // This only requires init_mutex_ read lock, which must be acquired to access
+  // the singleton instance.
+#if defined(WINUWP)
+  const uint32_t group_count = 1;
+#else   // defined(WINUWP)
+  const uint32_t group_count = 1 + (uint32_t)extra_thread_groups_.size();
+#endif  // defined(WINUWP)
+  if ((index >= (int32_t)group_count) ||
+      ((index < 0) && (index != kMrsThreadGroupRoundRobin))) {
+    RTC_LOG(LS_ERROR) << "Invalid thread group #" << index << ", the library "
+                      << "was initialized with " << group_count
+                      << " thread group(s).";
+    return Error(Result::kInvalidParameter);
+  }
+  if (index == kMrsThreadGroupRoundRobin) {
+    const uint32_t next =
+        next_thread_group_.fetch_add(1, std::memory_order_relaxed);
+    index = (int32_t)(next % group_count);
+  }
+  if (index == 0) {
+    return ThreadGroupFactory{peer_factory_, custom_audio_mixer_, 0};
+  }
+#if defined(WINUWP)
+  RTC_NOTREACHED();
+  return Error(Result::kUnknownError);
+#else   // defined(WINUWP)
+  return extra_thread_groups_[index - 1].factory;
+#endif  // defined(WINUWP)
+}
+
+mrsResult GlobalFactory::GetAudioProcessingStats(
+    mrsAudioProcessingStats& stats) const noexcept {
+  // This only requires init_mutex_ read lock, which must be acquired to access
+  // the singleton instance.
+  if (!audio_processing_) {
+    return Result::kUnsupported;
+  }
+  stats = {};
+  audio_processing_->AccumulateStats(stats);
+#if !defined(WINUWP)
+  for (const ThreadGroup& group : extra_thread_groups_) {
+    group.audio_processing->AccumulateStats(stats);
+  }
+#endif  // !defined(WINUWP)
+  return Result::kSuccess;
+}
+
 rtc::Thread* GlobalFactory::GetWorkerThread() const noexcept {
   // This only requires init_mutex_ read lock, which must be acquired to access
   // the singleton instance.
@@ -283,8 +434,23 @@ mrsResult GlobalFactory::InitializeImplNoLock() {
 
   // Use a null value to use the default platform implementation
   rtc::scoped_refptr<webrtc::AudioDeviceModule> adm{nullptr};
+  if (s_audioDeviceModule == mrsAudioDeviceModule::kHeadless) {
+    // The headless module does not use any system audio API, so unlike the
+    // CoreAudio module below it can be created from any thread.
+    adm = HeadlessAudioDeviceModule::Create(s_headlessAudioOptions
+                                                ? *s_headlessAudioOptions
+                                                : HeadlessAudioDeviceOptions{});
+    RTC_LOG(LS_INFO) << "Using headless ADM for audio capture and playback.";
+  } else if (s_audioDeviceModule == mrsAudioDeviceModule::kApplication) {
+    application_adm_ = ApplicationAudioDeviceModule::Create(
+        (int)s_applicationAudioConfig.sample_rate,
+        s_applicationAudioConfig.channel_count);
+    adm = application_adm_;
+    RTC_LOG(LS_INFO) << "Using application-driven ADM for audio capture and "
+                        "playback.";
+  }
 #if defined(MR_SHARING_WIN)
-  if (s_audioDeviceModule == mrsAudioDeviceModule::kDefault) {
+  else if (s_audioDeviceModule == mrsAudioDeviceModule::kDefault) {
     // Default to use the CoreAudio 2 ADM, which supports more devices like
     // Azure Kinect DK. The ADM needs to be created on the worker thread where
     // it will be used, and requires COM to be initialized.
@@ -314,6 +480,16 @@ mrsResult GlobalFactory::InitializeImplNoLock() {
   }
 #endif  // !defined(MR_SHARING_WIN)
 
+  const bool bypass_apm =
+      (s_audioProcessingConfig.enabled == mrsBool::kFalse);
+  audio_processing_ = InstrumentedAudioProcessing::Create(bypass_apm);
+  if (!audio_processing_) {
+    return Result::kUnknownError;
+  }
+  if (bypass_apm) {
+    RTC_LOG(LS_INFO) << "Bypassing audio processing module.";
+  }
+
   peer_factory_ = webrtc::CreatePeerConnectionFactory(
       network_thread_.get(), worker_thread_.get(), signaling_thread_.get(),
       std::move(adm), webrtc::CreateBuiltinAudioEncoderFactory(),
@@ -324,12 +500,83 @@ mrsResult GlobalFactory::InitializeImplNoLock() {
       std::unique_ptr<webrtc::VideoDecoderFactory>(
           new webrtc::MultiplexDecoderFactory(
               absl::make_unique<webrtc::InternalDecoderFactory>())),
-      custom_audio_mixer_, nullptr);
+      custom_audio_mixer_, audio_processing_);
+  if (!peer_factory_) {
+    return Result::kUnknownError;
+  }
+  if (application_adm_) {
+    // Let the application drive the module without acquiring the factory.
+    ApplicationAudioDeviceModule::SetCurrent(application_adm_.get());
+  }
+
+  // Create the additional thread groups, if any.
+  extra_thread_groups_.resize(s_threadGroupCount - 1);
+  for (uint32_t i = 0; i < extra_thread_groups_.size(); ++i) {
+    mrsResult result = CreateThreadGroupNoLock(i + 1, extra_thread_groups_[i]);
+    if (result != Result::kSuccess) {
+      ShutdownImplNoLock(ShutdownAction::kForceShutdown);
+      return result;
+    }
+  }
 #endif  // defined(WINUWP)
   return (peer_factory_.get() != nullptr ? Result::kSuccess
                                          : Result::kUnknownError);
 }
 
+#if !defined(WINUWP)
+
+mrsResult GlobalFactory::CreateThreadGroupNoLock(uint32_t index,
+                                                 ThreadGroup& group) {
+  const std::string suffix = " #" + std::to_string(index);
+  group.network_thread = rtc::Thread::CreateWithSocketServer();
+  RTC_CHECK(group.network_thread.get());
+  group.network_thread->SetName("WebRTC network thread" + suffix,
+                                group.network_thread.get());
+  group.network_thread->Start();
+  group.worker_thread = rtc::Thread::Create();
+  RTC_CHECK(group.worker_thread.get());
+  group.worker_thread->SetName("WebRTC worker thread" + suffix,
+                               group.worker_thread.get());
+  group.worker_thread->Start();
+
+  // Each peer connection factory owns a voice engine which registers itself as
+  // the sole audio callback of its audio device module, so the module cannot
+  // be shared with the first thread group. Use a headless module instead,
+  // which pulls the remote audio at the same pace without any system device.
+  rtc::scoped_refptr<webrtc::AudioDeviceModule> adm =
+      HeadlessAudioDeviceModule::Create(s_headlessAudioOptions
+                                            ? *s_headlessAudioOptions
+                                            : HeadlessAudioDeviceOptions{});
+  group.audio_processing =
+      InstrumentedAudioProcessing::Create(audio_processing_->IsBypassed());
+  if (!group.audio_processing) {
+    return Result::kUnknownError;
+  }
+  group.factory.index = (int32_t)index;
+  group.factory.audio_mixer = new rtc::RefCountedObject<ToggleAudioMixer>();
+  group.factory.peer_factory = webrtc::CreatePeerConnectionFactory(
+      group.network_thread.get(), group.worker_thread.get(),
+      signaling_thread_.get(), std::move(adm),
+      webrtc::CreateBuiltinAudioEncoderFactory(),
+      webrtc::CreateBuiltinAudioDecoderFactory(),
+      std::unique_ptr<webrtc::VideoEncoderFactory>(
+          new webrtc::MultiplexEncoderFactory(
+              absl::make_unique<webrtc::InternalEncoderFactory>())),
+      std::unique_ptr<webrtc::VideoDecoderFactory>(
+          new webrtc::MultiplexDecoderFactory(
+              absl::make_unique<webrtc::InternalDecoderFactory>())),
+      group.factory.audio_mixer, group.audio_processing);
+  if (!group.factory.peer_factory) {
+    RTC_LOG(LS_ERROR) << "Failed to create the peer connection factory of "
+                         "thread group #"
+                      << index << ".";
+    return Result::kUnknownError;
+  }
+  return Result::kSuccess;
+}
+
+#endif  // !defined(WINUWP)
+
 bool GlobalFactory::ShutdownImplNoLock(ShutdownAction shutdown_action) {
   if (!peer_factory_) {
     return true;  // already shut down
@@ -370,7 +617,18 @@ bool GlobalFactory::ShutdownImplNoLock(ShutdownAction shutdown_action) {
   }
 
   // Shutdown
+  if (application_adm_) {
+    // Wait for the application to stop using the module before releasing it.
+    ApplicationAudioDeviceModule::SetCurrent(nullptr);
+  }
+#if !defined(WINUWP)
+  // The additional factories share the signaling thread, so must be destroyed
+  // before it.
+  extra_thread_groups_.clear();
+#endif  // !defined(WINUWP)
   peer_factory_ = nullptr;
+  application_adm_ = nullptr;
+  audio_processing_ = nullptr;
 #if defined(WINUWP)
   impl_ = nullptr;
 #else   // defined(WINUWP)
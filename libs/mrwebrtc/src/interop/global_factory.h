@@ -15,6 +15,10 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+class ApplicationAudioDeviceModule;
+struct HeadlessAudioDeviceOptions;
+class InstrumentedAudioProcessing;
+
 /// The global factory is a helper class used to initialize and shutdown the
 /// internal WebRTC library, which adds extra functionalities over a classical
 /// init/shutdown pair of functions:
@@ -39,6 +43,29 @@ class GlobalFactory {
   static mrsResult UseAudioDeviceModule(mrsAudioDeviceModule adm) noexcept;
   static mrsAudioDeviceModule GetAudioDeviceModule() noexcept;
 
+  /// Configure the headless audio device module. See
+  /// |mrsLibrarySetHeadlessAudioDeviceConfig()| for details.
+  static mrsResult SetHeadlessAudioDeviceConfig(
+      const mrsHeadlessAudioDeviceConfig& config) noexcept;
+
+  /// Configure the application-driven audio device module. See
+  /// |mrsLibrarySetApplicationAudioDeviceConfig()| for details.
+  static mrsResult SetApplicationAudioDeviceConfig(
+      const mrsApplicationAudioDeviceConfig& config) noexcept;
+  static mrsApplicationAudioDeviceConfig
+  GetApplicationAudioDeviceConfig() noexcept;
+
+  /// Configure the audio processing module. See
+  /// |mrsLibrarySetAudioProcessingConfig()| for details.
+  static mrsResult SetAudioProcessingConfig(
+      const mrsAudioProcessingConfig& config) noexcept;
+  static mrsAudioProcessingConfig GetAudioProcessingConfig() noexcept;
+
+  /// Configure the number of thread groups. See
+  /// |mrsLibrarySetThreadGroupCount()| for details.
+  static mrsResult SetThreadGroupCount(uint32_t count) noexcept;
+  static uint32_t GetThreadGroupCount() noexcept;
+
   /// Get the library shutdown options. This function does not initialize the
   /// library, but will store the options for a future initializing. Conversely,
   /// if the library is already initialized then the options are set
@@ -115,6 +142,26 @@ class GlobalFactory {
   rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface>
   GetPeerConnectionFactory() noexcept;
 
+  /// Peer connection factory of a thread group, and the audio mixer of the
+  /// audio device module it was created with.
+  struct ThreadGroupFactory {
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> peer_factory;
+    rtc::scoped_refptr<ToggleAudioMixer> audio_mixer;
+    /// Index of the thread group, resolved if round-robin was requested.
+    int32_t index{0};
+  };
+
+  /// Get the peer connection factory of the thread group with the given index,
+  /// or of the next thread group in round-robin order if |index| is
+  /// |kMrsThreadGroupRoundRobin|. The factory of the first thread group is
+  /// |GetPeerConnectionFactory()|.
+  ErrorOr<ThreadGroupFactory> GetThreadGroupFactory(int32_t index) noexcept;
+
+  /// Get the processing statistics aggregated over the audio processing
+  /// modules of all thread groups. This returns |Result::kUnsupported| on UWP.
+  mrsResult GetAudioProcessingStats(mrsAudioProcessingStats& stats) const
+      noexcept;
+
   /// Get the WebRTC background worker thread, or NULL if the library is not
   /// initialized.
   rtc::Thread* GetWorkerThread() const noexcept;
@@ -169,6 +216,14 @@ class GlobalFactory {
 
   mrsResult InitializeImplNoLock();
 
+#if !defined(WINUWP)
+  struct ThreadGroup;
+
+  /// Create the threads and peer connection factory of an additional thread
+  /// group, after the first one was created.
+  mrsResult CreateThreadGroupNoLock(uint32_t index, ThreadGroup& group);
+#endif  // !defined(WINUWP)
+
   enum class ShutdownAction {
     /// Try to safely shutdown, only if no tracked object is alive.
     kTryShutdownIfSafe,
@@ -222,12 +277,40 @@ class GlobalFactory {
   /// require |mutex_| for access, but |init_mutex_| instead.
   std::unique_ptr<rtc::Thread> signaling_thread_ RTC_GUARDED_BY(init_mutex_);
 
+  /// Additional thread group, with its own networking and worker threads, peer
+  /// connection factory, and headless audio device module. The signaling
+  /// thread is shared by all groups.
+  struct ThreadGroup {
+    std::unique_ptr<rtc::Thread> network_thread;
+    std::unique_ptr<rtc::Thread> worker_thread;
+    /// Audio processing module of the factory, for statistics.
+    rtc::scoped_refptr<InstrumentedAudioProcessing> audio_processing;
+    /// Destroyed first, while its threads are still running.
+    ThreadGroupFactory factory;
+  };
+
+  /// Thread groups other than the first one, whose threads and factory are the
+  /// members above. This is initialized only while the library is initialized,
+  /// and is immutable between init and shutdown, so do not require |mutex_|
+  /// for access, but |init_mutex_| instead.
+  std::vector<ThreadGroup> extra_thread_groups_ RTC_GUARDED_BY(init_mutex_);
+
 #if defined(MR_SHARING_WIN)
   /// COM initializer for worker thread (for ADM2).
   std::unique_ptr<webrtc::ScopedCOMInitializer> worker_com_initializer_;
 #endif  // defined(MR_SHARING_WIN)
 #endif  // defined(WINUWP)
 
+  /// Application-driven audio device module, if in use. This is initialized
+  /// only while the library is initialized, and is immutable between init and
+  /// shutdown, so do not require |mutex_| for access.
+  rtc::scoped_refptr<ApplicationAudioDeviceModule> application_adm_;
+
+  /// Audio processing module. This is initialized only while the library is
+  /// initialized, and is immutable between init and shutdown, so do not
+  /// require |mutex_| for access.
+  rtc::scoped_refptr<InstrumentedAudioProcessing> audio_processing_;
+
   /// Reference count to the library, for automated shutdown.
   mutable std::atomic_uint32_t ref_count_{0};
 
@@ -246,11 +329,29 @@ class GlobalFactory {
 
   rtc::scoped_refptr<ToggleAudioMixer> custom_audio_mixer_;
 
+  /// Index of the thread group assigned to the next peer connection requesting
+  /// round-robin assignment.
+  std::atomic_uint32_t next_thread_group_{0};
+
  private:
   /// On Windows Desktop, configure the Audio Device Module (ADM) to use. This
   /// defaults to |mrsAudioDeviceModule::kADM2|.
   /// https://bugs.chromium.org/p/webrtc/issues/detail?id=11081
   static mrsAudioDeviceModule s_audioDeviceModule;
+
+  /// Options of the headless audio device module, used if
+  /// |s_audioDeviceModule| is |mrsAudioDeviceModule::kHeadless|.
+  static std::unique_ptr<HeadlessAudioDeviceOptions> s_headlessAudioOptions;
+
+  /// Configuration of the application-driven audio device module, used if
+  /// |s_audioDeviceModule| is |mrsAudioDeviceModule::kApplication|.
+  static mrsApplicationAudioDeviceConfig s_applicationAudioConfig;
+
+  /// Configuration of the audio processing module.
+  static mrsAudioProcessingConfig s_audioProcessingConfig;
+
+  /// Number of thread groups to create when initializing the library.
+  static uint32_t s_threadGroupCount;
 };
 
 }  // namespace WebRTC
@@ -23,6 +23,7 @@
 #include "interop_api.h"
 #include "local_audio_track_interop.h"
 #include "local_video_track_interop.h"
+#include "media/application_audio_device_module.h"
 #include "media/audio_track_source.h"
 #include "media/device_video_track_source.h"
 #include "media/external_video_track_source.h"
@@ -82,6 +83,85 @@ mrsAudioDeviceModule MRS_CALL mrsLibraryGetAudioDeviceModule() noexcept {
   return GlobalFactory::GetAudioDeviceModule();
 }
 
+mrsResult MRS_CALL mrsLibrarySetHeadlessAudioDeviceConfig(
+    const mrsHeadlessAudioDeviceConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  return GlobalFactory::SetHeadlessAudioDeviceConfig(*config);
+}
+
+mrsResult MRS_CALL mrsLibrarySetApplicationAudioDeviceConfig(
+    const mrsApplicationAudioDeviceConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  return GlobalFactory::SetApplicationAudioDeviceConfig(*config);
+}
+
+mrsResult MRS_CALL mrsLibrarySetAudioProcessingConfig(
+    const mrsAudioProcessingConfig* config) noexcept {
+  if (!config) {
+    return Result::kInvalidParameter;
+  }
+  return GlobalFactory::SetAudioProcessingConfig(*config);
+}
+
+mrsResult MRS_CALL mrsLibrarySetThreadGroupCount(uint32_t count) noexcept {
+  return GlobalFactory::SetThreadGroupCount(count);
+}
+
+mrsResult MRS_CALL
+mrsLibraryGetAudioProcessingStats(mrsAudioProcessingStats* stats) noexcept {
+  if (!stats) {
+    return Result::kInvalidParameter;
+  }
+  *stats = {};
+  RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtrIfExist());
+  if (!global_factory) {
+    return Result::kNotInitialized;
+  }
+  return global_factory->GetAudioProcessingStats(*stats);
+}
+
+mrsResult MRS_CALL mrsAudioDevicePullPlayout(float* data,
+                                             uint32_t frame_count) noexcept {
+  if (!data && (frame_count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  // Do not acquire the global factory from the audio thread of the
+  // application, which would lock the init mutex on each call, and could make
+  // that thread shut down the library if releasing the last reference.
+  const Result result =
+      ApplicationAudioDeviceModule::PullPlayoutCurrent(data, frame_count);
+  if (result == Result::kNotInitialized) {
+    const uint32_t channel_count =
+        GlobalFactory::GetApplicationAudioDeviceConfig().channel_count;
+    std::fill_n(data, (size_t)frame_count * channel_count, 0.0f);
+    if (GlobalFactory::GetAudioDeviceModule() !=
+        mrsAudioDeviceModule::kApplication) {
+      return Result::kInvalidOperation;
+    }
+  }
+  return result;
+}
+
+mrsResult MRS_CALL mrsAudioDevicePushCapture(const float* data,
+                                             uint32_t frame_count) noexcept {
+  if (!data && (frame_count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  // Like above, do not acquire the global factory.
+  const Result result =
+      ApplicationAudioDeviceModule::PushCaptureCurrent(data, frame_count);
+  if ((result == Result::kNotInitialized) &&
+      (GlobalFactory::GetAudioDeviceModule() !=
+       mrsAudioDeviceModule::kApplication)) {
+    return Result::kInvalidOperation;
+  }
+  return result;
+}
+
 mrsShutdownOptions MRS_CALL mrsGetShutdownOptions() noexcept {
   return GlobalFactory::GetShutdownOptions();
 }
@@ -223,6 +303,21 @@ void MRS_CALL mrsPeerConnectionRegisterIceCandidateReadytoSendCallback(
   }
 }
 
+mrsResult MRS_CALL mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(
+    mrsPeerConnectionHandle peer_handle,
+    const mrsIceCandidateBatchConfig* config,
+    mrsPeerConnectionIceCandidatesReadytoSendCallback callback,
+    void* user_data) noexcept {
+  auto const peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  const mrsIceCandidateBatchConfig default_config{};
+  return peer->RegisterIceCandidatesReadytoSendCallback(
+      config ? *config : default_config,
+      IceCandidateBatcher::BatchCallback{callback, user_data});
+}
+
 void MRS_CALL mrsPeerConnectionRegisterIceStateChangedCallback(
     mrsPeerConnectionHandle peer_handle,
     mrsPeerConnectionIceStateChangedCallback callback,
@@ -322,7 +417,9 @@ mrsResult MRS_CALL mrsPeerConnectionAddDataChannel(
   const bool reliable = (config->flags & mrsDataChannelConfigFlags::kReliable);
   const absl::string_view label = (config->label ? config->label : "");
   ErrorOr<std::shared_ptr<DataChannel>> data_channel =
-      peer->AddDataChannel(config->id, label, ordered, reliable);
+      peer->AddDataChannel(config->id, label, ordered, reliable,
+                           config->max_retransmits,
+                           config->max_packet_life_time_ms);
   if (data_channel.ok()) {
     *data_channel_handle_out = data_channel.value().operator->();
   }
@@ -363,6 +460,29 @@ mrsPeerConnectionAddIceCandidate(mrsPeerConnectionHandle peer_handle,
   return result.result();
 }
 
+mrsResult MRS_CALL
+mrsPeerConnectionAddIceCandidates(mrsPeerConnectionHandle peer_handle,
+                                  const mrsIceCandidate* candidates,
+                                  uint32_t count,
+                                  mrsResult* results) noexcept {
+  auto const peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!candidates && (count > 0)) {
+    return Result::kInvalidParameter;
+  }
+  return peer->AddIceCandidates(candidates, count, results);
+}
+
+mrsResult MRS_CALL mrsPeerConnectionPrewarm(mrsPeerConnectionHandle peer_handle,
+                                            int32_t pool_size) noexcept {
+  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+    return peer->Prewarm(pool_size);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
 mrsResult MRS_CALL
 mrsPeerConnectionCreateOffer(mrsPeerConnectionHandle peer_handle) noexcept {
   if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
@@ -431,6 +551,34 @@ mrsPeerConnectionClose(mrsPeerConnectionHandle peer_handle) noexcept {
   return Result::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL mrsPeerConnectionGetConnectionMilestones(
+    mrsPeerConnectionHandle peer_handle,
+    mrsConnectionMilestones* milestones_out) noexcept {
+  if (!milestones_out) {
+    return Result::kInvalidParameter;
+  }
+  auto const peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  peer->milestones()->Get(*milestones_out);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsPeerConnectionGetThreadGroup(mrsPeerConnectionHandle peer_handle,
+                                int32_t* thread_group_out) noexcept {
+  if (!thread_group_out) {
+    return Result::kInvalidParameter;
+  }
+  auto const peer = static_cast<PeerConnection*>(peer_handle);
+  if (!peer) {
+    return Result::kInvalidNativeHandle;
+  }
+  *thread_group_out = peer->thread_group();
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL mrsSdpForceCodecs(const char* message,
                                      SdpFilter audio_filter,
                                      SdpFilter video_filter,
@@ -749,6 +897,30 @@ mrsResult MRS_CALL mrsStatsReportRemoveRef(mrsStatsReportHandle stats_report) {
   return Result::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL mrsPeerConnectionRegisterBandwidthEstimateCallback(
+    mrsPeerConnectionHandle peer_handle,
+    uint32_t interval_ms,
+    mrsPeerConnectionBandwidthEstimateCallback callback,
+    void* user_data) noexcept {
+  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+    return peer->RegisterBandwidthEstimateCallback(
+        interval_ms, Callback<const mrsBandwidthEstimate*>{callback, user_data});
+  }
+  return Result::kInvalidNativeHandle;
+}
+
+mrsResult MRS_CALL mrsPeerConnectionGetBandwidthEstimate(
+    mrsPeerConnectionHandle peer_handle,
+    mrsBandwidthEstimate* estimate_out) noexcept {
+  if (!estimate_out) {
+    return Result::kInvalidParameter;
+  }
+  if (auto peer = static_cast<PeerConnection*>(peer_handle)) {
+    return peer->GetBandwidthEstimate(*estimate_out);
+  }
+  return Result::kInvalidNativeHandle;
+}
+
 mrsResult MRS_CALL mrsSetH264Config(const mrsH264Config* config) {
 #if defined(WINUWP)
 #define CHECK_ENUM_VALUE(NAME)                                        \
@@ -52,9 +52,14 @@ mrsResult MRS_CALL mrsLocalAudioTrackCreateFromSource(
     return Result::kUnknownError;
   }
 
-  // Create the audio track wrapper
+  // Create the audio track wrapper. External audio track sources are paced by
+  // the audio device module of the first thread group, so their tracks cannot
+  // be sent by peer connections of other groups.
+  const bool first_thread_group_only =
+      (source->GetObjectType() == ObjectType::kExternalAudioTrackSource);
   RefPtr<LocalAudioTrack> track =
-      new LocalAudioTrack(std::move(global_factory), std::move(audio_track));
+      new LocalAudioTrack(std::move(global_factory), std::move(audio_track),
+                          first_thread_group_only);
   *track_handle_out = track.release();
   return Result::kSuccess;
 }
@@ -68,6 +73,28 @@ mrsLocalAudioTrackRegisterFrameCallback(mrsLocalAudioTrackHandle trackHandle,
   }
 }
 
+mrsResult MRS_CALL mrsLocalAudioTrackRegisterFrameBatchCallback(
+    mrsLocalAudioTrackHandle track_handle,
+    const mrsAudioFrameBatchConfig* config,
+    mrsAudioFrameBatchCallback callback,
+    void* user_data) noexcept {
+  auto track = static_cast<LocalAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    track->SetBatchCallback({}, 0, 0);
+    return Result::kSuccess;
+  }
+  if (!config || (config->duration_ms == 0 && config->sample_count == 0)) {
+    RTC_LOG(LS_ERROR) << "Invalid audio frame batch configuration.";
+    return Result::kInvalidParameter;
+  }
+  track->SetBatchCallback(AudioFrameBatchReadyCallback{callback, user_data},
+                          config->duration_ms, config->sample_count);
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL
 mrsLocalAudioTrackSetEnabled(mrsLocalAudioTrackHandle track_handle,
                              mrsBool enabled) noexcept {
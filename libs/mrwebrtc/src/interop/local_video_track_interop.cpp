@@ -37,8 +37,18 @@ mrsResult MRS_CALL mrsLocalVideoTrackCreateFromSource(
   }
   *track_handle_out = nullptr;
 
+  if (init_settings->thread_group < 0) {
+    RTC_LOG(LS_ERROR) << "Invalid thread group for local video track.";
+    return Result::kInvalidParameter;
+  }
+
   RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
-  auto pc_factory = global_factory->GetPeerConnectionFactory();
+  ErrorOr<GlobalFactory::ThreadGroupFactory> group_factory =
+      global_factory->GetThreadGroupFactory(init_settings->thread_group);
+  if (!group_factory.ok()) {
+    return group_factory.error().result();
+  }
+  auto pc_factory = group_factory.value().peer_factory;
   if (!pc_factory) {
     return Result::kInvalidOperation;
   }
@@ -55,7 +65,8 @@ mrsResult MRS_CALL mrsLocalVideoTrackCreateFromSource(
 
   // Create the audio track wrapper
   RefPtr<LocalVideoTrack> track =
-      new LocalVideoTrack(std::move(global_factory), std::move(video_track));
+      new LocalVideoTrack(std::move(global_factory), std::move(video_track),
+                          group_factory.value().index);
   *track_handle_out = track.release();
   return Result::kSuccess;
 }
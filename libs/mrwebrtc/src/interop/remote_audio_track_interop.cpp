@@ -7,6 +7,8 @@
 
 #include "media/remote_audio_track.h"
 #include "remote_audio_track_interop.h"
+#include "interop/global_factory.h"
+#include "media/audio_track_mixed_read_buffer.h"
 #include "media/audio_track_read_buffer.h"
 #include "utils.h"
 
@@ -21,6 +23,53 @@ mrsRemoteAudioTrackRegisterFrameCallback(mrsRemoteAudioTrackHandle trackHandle,
   }
 }
 
+mrsResult MRS_CALL mrsRemoteAudioTrackRegisterFrameBatchCallback(
+    mrsRemoteAudioTrackHandle track_handle,
+    const mrsAudioFrameBatchConfig* config,
+    mrsAudioFrameBatchCallback callback,
+    void* user_data) noexcept {
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!callback) {
+    track->SetBatchCallback({}, 0, 0);
+    return Result::kSuccess;
+  }
+  if (!config || (config->duration_ms == 0 && config->sample_count == 0)) {
+    RTC_LOG(LS_ERROR) << "Invalid audio frame batch configuration.";
+    return Result::kInvalidParameter;
+  }
+  track->SetBatchCallback(AudioFrameBatchReadyCallback{callback, user_data},
+                          config->duration_ms, config->sample_count);
+  return Result::kSuccess;
+}
+
+void MRS_CALL mrsRemoteAudioTrackRegisterAudioLevelCallback(
+    mrsRemoteAudioTrackHandle track_handle,
+    mrsAudioLevelCallback callback,
+    void* user_data,
+    int interval_ms) noexcept {
+  if (auto track = static_cast<RemoteAudioTrack*>(track_handle)) {
+    track->SetLevelCallback(AudioLevelCallback{callback, user_data},
+                            interval_ms);
+  }
+}
+
+mrsResult MRS_CALL
+mrsRemoteAudioTrackGetAudioLevel(mrsRemoteAudioTrackHandle track_handle,
+                                 mrsAudioLevel* level_out) noexcept {
+  if (!level_out) {
+    return Result::kInvalidParameter;
+  }
+  auto track = static_cast<const RemoteAudioTrack*>(track_handle);
+  if (!track) {
+    return Result::kInvalidNativeHandle;
+  }
+  *level_out = track->GetLevel();
+  return Result::kSuccess;
+}
+
 mrsResult MRS_CALL
 mrsRemoteAudioTrackSetEnabled(mrsRemoteAudioTrackHandle track_handle,
                               mrsBool enabled) noexcept {
@@ -130,3 +179,126 @@ mrsAudioTrackReadBufferDestroy(mrsAudioTrackReadBufferHandle buffer) {
     delete ars;
   }
 }
+
+mrsResult MRS_CALL mrsAudioTrackMixedReadBufferCreate(
+    int sample_rate,
+    int num_channels,
+    int buffer_ms,
+    mrsAudioTrackMixedReadBufferHandle* buffer_out) {
+  if (LOG_INVALID_ARG_IF(!buffer_out)) {
+    return Result::kInvalidParameter;
+  }
+  *buffer_out = nullptr;
+
+  if (LOG_INVALID_ARG_IF(sample_rate <= 0)) {
+    return Result::kInvalidParameter;
+  }
+
+  if (LOG_INVALID_ARG_IF(num_channels != 1 && num_channels != 2)) {
+    return Result::kInvalidParameter;
+  }
+
+  if (LOG_INVALID_ARG_IF(buffer_ms < 0)) {
+    return Result::kInvalidParameter;
+  }
+
+  *buffer_out = new AudioTrackMixedReadBuffer(
+      GlobalFactory::InstancePtr(), sample_rate, num_channels, buffer_ms);
+  return Result::kSuccess;
+}
+
+mrsResult MRS_CALL
+mrsAudioTrackMixedReadBufferAddTrack(mrsAudioTrackMixedReadBufferHandle buffer,
+                                     mrsRemoteAudioTrackHandle track_handle,
+                                     float gain) {
+  auto mixed_buffer = static_cast<AudioTrackMixedReadBuffer*>(buffer);
+  if (!mixed_buffer) {
+    return Result::kInvalidNativeHandle;
+  }
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (LOG_INVALID_ARG_IF(!track)) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (LOG_INVALID_ARG_IF(!(gain >= 0.0f))) {
+    return Result::kInvalidParameter;
+  }
+  return mixed_buffer->AddTrack(*track, gain);
+}
+
+mrsResult MRS_CALL mrsAudioTrackMixedReadBufferSetTrackGain(
+    mrsAudioTrackMixedReadBufferHandle buffer,
+    mrsRemoteAudioTrackHandle track_handle,
+    float gain) {
+  auto mixed_buffer = static_cast<AudioTrackMixedReadBuffer*>(buffer);
+  if (!mixed_buffer) {
+    return Result::kInvalidNativeHandle;
+  }
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (LOG_INVALID_ARG_IF(!track)) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (LOG_INVALID_ARG_IF(!(gain >= 0.0f))) {
+    return Result::kInvalidParameter;
+  }
+  return mixed_buffer->SetTrackGain(*track, gain);
+}
+
+mrsResult MRS_CALL mrsAudioTrackMixedReadBufferRemoveTrack(
+    mrsAudioTrackMixedReadBufferHandle buffer,
+    mrsRemoteAudioTrackHandle track_handle) {
+  auto mixed_buffer = static_cast<AudioTrackMixedReadBuffer*>(buffer);
+  if (!mixed_buffer) {
+    return Result::kInvalidNativeHandle;
+  }
+  auto track = static_cast<RemoteAudioTrack*>(track_handle);
+  if (LOG_INVALID_ARG_IF(!track)) {
+    return Result::kInvalidNativeHandle;
+  }
+  return mixed_buffer->RemoveTrack(*track);
+}
+
+mrsResult MRS_CALL
+mrsAudioTrackMixedReadBufferRead(mrsAudioTrackMixedReadBufferHandle buffer,
+                                 mrsAudioTrackReadBufferPadBehavior pad_behavior,
+                                 float* samples_out,
+                                 int num_samples_max,
+                                 int* num_samples_read_out,
+                                 mrsBool* has_overrun_out) {
+  if (!buffer) {
+    return Result::kInvalidNativeHandle;
+  }
+
+  if (LOG_INVALID_ARG_IF(!IsValidAudioTrackBufferPadBehavior(pad_behavior))) {
+    return Result::kInvalidParameter;
+  }
+
+  if (LOG_INVALID_ARG_IF(num_samples_max < 0)) {
+    return Result::kInvalidParameter;
+  }
+
+  if (LOG_INVALID_ARG_IF(num_samples_max > 0 && !samples_out)) {
+    return Result::kInvalidParameter;
+  }
+
+  if (LOG_INVALID_ARG_IF(!num_samples_read_out)) {
+    return Result::kInvalidParameter;
+  }
+
+  if (LOG_INVALID_ARG_IF(!has_overrun_out)) {
+    return Result::kInvalidParameter;
+  }
+
+  auto mixed_buffer = static_cast<AudioTrackMixedReadBuffer*>(buffer);
+  bool has_overrun;
+  Result res = mixed_buffer->Read(pad_behavior, samples_out, num_samples_max,
+                                  num_samples_read_out, &has_overrun);
+  *has_overrun_out = has_overrun ? mrsBool::kTrue : mrsBool::kFalse;
+  return res;
+}
+
+void MRS_CALL
+mrsAudioTrackMixedReadBufferDestroy(mrsAudioTrackMixedReadBufferHandle buffer) {
+  if (auto mixed_buffer = static_cast<AudioTrackMixedReadBuffer*>(buffer)) {
+    delete mixed_buffer;
+  }
+}
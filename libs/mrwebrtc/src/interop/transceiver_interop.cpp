@@ -43,6 +43,33 @@ mrsTransceiverSetDirection(mrsTransceiverHandle transceiver_handle,
   return Result::kInvalidNativeHandle;
 }
 
+mrsResult MRS_CALL mrsTransceiverSetAudioSendParameters(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsAudioSendParameters* params) noexcept {
+  auto transceiver = static_cast<Transceiver*>(transceiver_handle);
+  if (!transceiver) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!params) {
+    return Result::kInvalidParameter;
+  }
+  return transceiver->SetAudioSendParameters(*params);
+}
+
+mrsResult MRS_CALL mrsTransceiverSetVideoEncodingParameters(
+    mrsTransceiverHandle transceiver_handle,
+    const mrsVideoEncodingParameters* encodings,
+    uint32_t encoding_count) noexcept {
+  auto transceiver = static_cast<Transceiver*>(transceiver_handle);
+  if (!transceiver) {
+    return Result::kInvalidNativeHandle;
+  }
+  if (!encodings || (encoding_count == 0)) {
+    return Result::kInvalidParameter;
+  }
+  return transceiver->SetVideoEncodingParameters(encodings, encoding_count);
+}
+
 mrsResult MRS_CALL mrsTransceiverSetLocalAudioTrack(
     mrsTransceiverHandle transceiver_handle,
     mrsLocalAudioTrackHandle track_handle) noexcept {
@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "media/application_audio_device_module.h"
+
+#include <thread>
+
+namespace {
+
+inline int16_t FloatToS16(float value) {
+  const float scaled = value * 32768.0f;
+  if (scaled >= 32767.0f) {
+    return 32767;
+  }
+  if (scaled <= -32768.0f) {
+    return -32768;
+  }
+  return (int16_t)(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+}
+
+inline float S16ToFloat(int16_t value) {
+  return value * (1.0f / 32768.0f);
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+std::atomic<ApplicationAudioDeviceModule*>
+    ApplicationAudioDeviceModule::s_current{nullptr};
+std::atomic<int> ApplicationAudioDeviceModule::s_current_use_count{0};
+
+rtc::scoped_refptr<ApplicationAudioDeviceModule>
+ApplicationAudioDeviceModule::Create(int sample_rate, size_t channel_count) {
+  return new rtc::RefCountedObject<ApplicationAudioDeviceModule>(
+      sample_rate, channel_count);
+}
+
+ApplicationAudioDeviceModule::ApplicationAudioDeviceModule(int sample_rate,
+                                                           size_t channel_count)
+    : VirtualAudioDeviceModule("Application audio device",
+                               sample_rate,
+                               channel_count),
+      playout_data_(samples_per_frame_ * channel_count_),
+      playout_position_(playout_data_.size()),
+      record_data_(samples_per_frame_ * channel_count_) {}
+
+Result ApplicationAudioDeviceModule::PullPlayout(float* data,
+                                                 size_t frame_count) noexcept {
+  size_t sample_count = frame_count * channel_count_;
+  while (sample_count > 0) {
+    if (playout_position_ == playout_data_.size()) {
+      // Render the next frame directly from the audio engine. This fills the
+      // frame with silence if not playing.
+      PullPlayoutFrame(playout_data_.data());
+      playout_position_ = 0;
+    }
+    const size_t count =
+        std::min(sample_count, playout_data_.size() - playout_position_);
+    const int16_t* src = &playout_data_[playout_position_];
+    for (size_t i = 0; i < count; ++i) {
+      data[i] = S16ToFloat(src[i]);
+    }
+    data += count;
+    sample_count -= count;
+    playout_position_ += count;
+  }
+  return Result::kSuccess;
+}
+
+Result ApplicationAudioDeviceModule::PushCapture(const float* data,
+                                                 size_t frame_count) noexcept {
+  size_t sample_count = frame_count * channel_count_;
+  while (sample_count > 0) {
+    const size_t count =
+        std::min(sample_count, record_data_.size() - record_position_);
+    int16_t* dst = &record_data_[record_position_];
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] = FloatToS16(data[i]);
+    }
+    data += count;
+    sample_count -= count;
+    record_position_ += count;
+    if (record_position_ == record_data_.size()) {
+      DeliverRecordedFrame(record_data_.data());
+      record_position_ = 0;
+    }
+  }
+  return Result::kSuccess;
+}
+
+void ApplicationAudioDeviceModule::SetCurrent(
+    ApplicationAudioDeviceModule* adm) noexcept {
+  s_current.store(adm);
+  if (!adm) {
+    // The store and the loads below are sequentially consistent with the use
+    // count increment and the module load of |AcquireCurrent()|. So any call
+    // not counted yet sees the cleared module, and the counted ones only need
+    // to return. Audio calls are short, so spin instead of blocking.
+    while (s_current_use_count.load() > 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+ApplicationAudioDeviceModule*
+ApplicationAudioDeviceModule::AcquireCurrent() noexcept {
+  s_current_use_count.fetch_add(1);
+  ApplicationAudioDeviceModule* const adm = s_current.load();
+  if (!adm) {
+    s_current_use_count.fetch_sub(1);
+  }
+  return adm;
+}
+
+void ApplicationAudioDeviceModule::ReleaseCurrent() noexcept {
+  s_current_use_count.fetch_sub(1);
+}
+
+Result ApplicationAudioDeviceModule::PullPlayoutCurrent(
+    float* data,
+    size_t frame_count) noexcept {
+  ApplicationAudioDeviceModule* const adm = AcquireCurrent();
+  if (!adm) {
+    return Result::kNotInitialized;
+  }
+  const Result result = adm->PullPlayout(data, frame_count);
+  ReleaseCurrent();
+  return result;
+}
+
+Result ApplicationAudioDeviceModule::PushCaptureCurrent(
+    const float* data,
+    size_t frame_count) noexcept {
+  ApplicationAudioDeviceModule* const adm = AcquireCurrent();
+  if (!adm) {
+    return Result::kNotInitialized;
+  }
+  const Result result = adm->PushCapture(data, frame_count);
+  ReleaseCurrent();
+  return result;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "media/virtual_audio_device_module.h"
+#include "mrs_errors.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Audio device module driven synchronously by the application, for engines
+/// running their own real-time audio thread.
+///
+/// This module has no thread of its own. Instead, the application pulls the
+/// mixed playout audio and pushes the captured audio from its own audio
+/// callback, in chunks of any size. Chunks are split into the 10 ms frames the
+/// audio engine processes, and each frame is rendered or delivered directly
+/// from the calling thread, so the only buffering is the remainder of a single
+/// 10 ms frame between two calls.
+class ApplicationAudioDeviceModule : public VirtualAudioDeviceModule {
+ public:
+  static rtc::scoped_refptr<ApplicationAudioDeviceModule> Create(
+      int sample_rate,
+      size_t channel_count);
+
+  /// Render |frame_count| frames of interleaved playout audio into |data|.
+  /// See |mrsAudioDevicePullPlayout()| for details.
+  Result PullPlayout(float* data, size_t frame_count) noexcept;
+
+  /// Deliver |frame_count| frames of interleaved captured audio from |data|.
+  /// See |mrsAudioDevicePushCapture()| for details.
+  Result PushCapture(const float* data, size_t frame_count) noexcept;
+
+  /// Make |adm| the module driven by |mrsAudioDevicePullPlayout()| and
+  /// |mrsAudioDevicePushCapture()|, or clear it if |adm| is NULL. The global
+  /// factory sets the module once initialized, and clears it before shutting
+  /// down. When clearing, this waits for the calls still using the previous
+  /// module to return, so the caller can release it afterward.
+  static void SetCurrent(ApplicationAudioDeviceModule* adm) noexcept;
+
+  /// Call |PullPlayout()| on the current module, or return
+  /// |Result::kNotInitialized| if there is none. This neither acquires the
+  /// global factory nor takes any lock, so that it is safe to call from the
+  /// real-time audio thread of the application.
+  static Result PullPlayoutCurrent(float* data, size_t frame_count) noexcept;
+
+  /// Call |PushCapture()| on the current module, or return
+  /// |Result::kNotInitialized| if there is none. Like |PullPlayoutCurrent()|
+  /// this does not acquire the global factory.
+  static Result PushCaptureCurrent(const float* data,
+                                   size_t frame_count) noexcept;
+
+ protected:
+  ApplicationAudioDeviceModule(int sample_rate, size_t channel_count);
+
+  /// Last 10 ms frame pulled from the audio engine, and read position in it,
+  /// in samples. Only accessed from the thread calling |PullPlayout()|.
+  std::vector<int16_t> playout_data_;
+  size_t playout_position_;
+
+  /// 10 ms frame being filled with captured audio, and write position in it,
+  /// in samples. Only accessed from the thread calling |PushCapture()|.
+  std::vector<int16_t> record_data_;
+  size_t record_position_{0};
+
+ private:
+  /// Get the current module, registering the caller as using it, or return
+  /// NULL. A non-NULL module must be released with |ReleaseCurrent()|.
+  static ApplicationAudioDeviceModule* AcquireCurrent() noexcept;
+  static void ReleaseCurrent() noexcept;
+
+  /// Module driven by the application, if any.
+  static std::atomic<ApplicationAudioDeviceModule*> s_current;
+
+  /// Number of calls in progress which acquired |s_current|.
+  static std::atomic<int> s_current_use_count;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,324 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "audio_track_mixed_read_buffer.h"
+#include "interop/global_factory.h"
+#include "media/remote_audio_track.h"
+#include "remote_audio_track_interop.h"
+
+namespace {
+
+/// Maximum number of 10 ms slots a track can be ahead of the slowest track
+/// before the oldest slot is completed anyway. This bounds the latency added
+/// by a track which stopped delivering frames, e.g. because its remote peer
+/// stopped sending or the SSRC changed.
+constexpr size_t kMaxPendingSlots = 5;
+
+/// Scale factor from S16 samples to normalized float samples.
+constexpr float kS16ToFloat = 1.0f / 32768.0f;
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+AudioTrackMixedReadBuffer::Input::Input(
+    AudioTrackMixedReadBuffer& owner,
+    rtc::scoped_refptr<webrtc::AudioTrackInterface> track,
+    float gain)
+    : owner_(owner), track_(std::move(track)), gain_(gain) {}
+
+void AudioTrackMixedReadBuffer::Input::OnData(const void* audio_data,
+                                              int bits_per_sample,
+                                              int sample_rate,
+                                              size_t number_of_channels,
+                                              size_t number_of_frames) {
+  owner_.MixInput(*this, audio_data, bits_per_sample, sample_rate,
+                  number_of_channels, number_of_frames);
+}
+
+AudioTrackMixedReadBuffer::AudioTrackMixedReadBuffer(
+    RefPtr<GlobalFactory> global_factory,
+    int sample_rate,
+    int num_channels,
+    int buffer_ms)
+    : TrackedObject(std::move(global_factory),
+                    ObjectType::kAudioTrackMixedReadBuffer),
+      sample_rate_(sample_rate),
+      num_channels_(num_channels),
+      frame_size_((size_t)(sample_rate / 100) * num_channels),
+      max_ready_frames_(std::max((buffer_ms >= 10 ? buffer_ms : 500) / 10, 1)) {
+  RTC_DCHECK(sample_rate_ > 0);
+  RTC_DCHECK(num_channels_ == 1 || num_channels_ == 2);
+}
+
+AudioTrackMixedReadBuffer::~AudioTrackMixedReadBuffer() {
+  std::lock_guard<std::mutex> control_lock(control_mutex_);
+  std::unordered_map<RemoteAudioTrack*, std::unique_ptr<Input>> inputs;
+  {
+    std::lock_guard<std::mutex> lock(mix_mutex_);
+    inputs.swap(inputs_);
+  }
+  // Unregister outside the lock, as the track holds its own sink lock while
+  // delivering a frame, which in turn needs |mix_mutex_|.
+  for (auto&& pair : inputs) {
+    pair.second->track_->RemoveSink(pair.second.get());
+  }
+}
+
+Result AudioTrackMixedReadBuffer::AddTrack(RemoteAudioTrack& track,
+                                           float gain) noexcept {
+  auto input = std::make_unique<Input>(*this, track.impl(), gain);
+  Input* const sink = input.get();
+  // Hold the control lock until the sink is registered, so that a concurrent
+  // |RemoveTrack()| cannot destroy the input in the meantime.
+  std::lock_guard<std::mutex> control_lock(control_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mix_mutex_);
+    // Start contributing to the oldest open slot, so that the new track is
+    // aligned with the others.
+    input->next_tick_ = head_tick_;
+    auto result = inputs_.emplace(&track, std::move(input));
+    if (!result.second) {
+      return Result::kInvalidOperation;
+    }
+  }
+  track.impl()->AddSink(sink);
+  return Result::kSuccess;
+}
+
+Result AudioTrackMixedReadBuffer::SetTrackGain(RemoteAudioTrack& track,
+                                               float gain) noexcept {
+  std::lock_guard<std::mutex> lock(mix_mutex_);
+  auto it = inputs_.find(&track);
+  if (it == inputs_.end()) {
+    return Result::kNotFound;
+  }
+  it->second->gain_.store(gain, std::memory_order_relaxed);
+  return Result::kSuccess;
+}
+
+Result AudioTrackMixedReadBuffer::RemoveTrack(
+    RemoteAudioTrack& track) noexcept {
+  std::lock_guard<std::mutex> control_lock(control_mutex_);
+  std::unique_ptr<Input> input;
+  {
+    std::lock_guard<std::mutex> lock(mix_mutex_);
+    auto it = inputs_.find(&track);
+    if (it == inputs_.end()) {
+      return Result::kNotFound;
+    }
+    input = std::move(it->second);
+    inputs_.erase(it);
+
+    // Slots waiting for this track only can now be completed.
+    FinalizeSlotsNoLock();
+  }
+  // Once this returns the track doesn't call the sink anymore, so it is safe
+  // to destroy it.
+  input->track_->RemoveSink(input.get());
+  return Result::kSuccess;
+}
+
+void AudioTrackMixedReadBuffer::MixInput(Input& input,
+                                         const void* audio_data,
+                                         int bits_per_sample,
+                                         int sample_rate,
+                                         size_t number_of_channels,
+                                         size_t number_of_frames) {
+  if (bits_per_sample != 16) {
+    RTC_LOG(LS_ERROR) << "Unsupported audio bit size (not 16-bit). Dropping "
+                         "audio frame.";
+    return;
+  }
+  if (number_of_channels != 1 && number_of_channels != 2) {
+    RTC_LOG(LS_ERROR) << "Unsupported audio channel count "
+                      << number_of_channels << ". Dropping audio frame.";
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mix_mutex_);
+
+  // Stereo -> Mono
+  const int16_t* curr_data = static_cast<const int16_t*>(audio_data);
+  size_t curr_count = number_of_frames * number_of_channels;
+  size_t curr_channels = number_of_channels;
+  if (curr_channels == 2 && num_channels_ == 1) {
+    input.downmix_.resize(number_of_frames);
+    int16_t* data = input.downmix_.data();
+    for (size_t i = 0; i < number_of_frames; ++i) {
+      data[i] = (int16_t)(((int)curr_data[2 * i] + curr_data[2 * i + 1]) / 2);
+    }
+    curr_data = data;
+    curr_count = number_of_frames;
+    curr_channels = 1;
+  }
+
+  // Resample
+  if (sample_rate != sample_rate_) {
+    if (input.resampler_.ResetIfNeeded(sample_rate, sample_rate_,
+                                       curr_channels) != 0) {
+      RTC_LOG(LS_ERROR)
+          << "Resampler does not implement conversion of sample rate "
+          << sample_rate << " -> " << sample_rate_
+          << ". Dropping audio frame.";
+      return;
+    }
+    input.resampled_.resize((curr_count * sample_rate_ / sample_rate) + 1);
+    size_t count = 0;
+    if (input.resampler_.Push(curr_data, curr_count, input.resampled_.data(),
+                              input.resampled_.size(), count) != 0) {
+      RTC_LOG(LS_ERROR) << "Resampler failed to adjust for sample rate ("
+                        << sample_rate << " -> " << sample_rate_
+                        << "). Dropping audio frame.";
+      return;
+    }
+    curr_data = input.resampled_.data();
+    curr_count = count;
+  }
+
+  // Find the grid slot for this frame. A track lagging behind the head of the
+  // grid lost its slots to the skew limit, so realign it.
+  const int64_t tick = std::max(input.next_tick_, head_tick_);
+  input.next_tick_ = tick + 1;
+  while (head_tick_ + (int64_t)pending_slots_.size() <= tick) {
+    pending_slots_.push_back(Slot{AcquireFrameNoLock(), 0});
+  }
+  Slot& slot = pending_slots_[(size_t)(tick - head_tick_)];
+
+  // Accumulate with gain. The sum is saturated once when the slot completes,
+  // which keeps this loop branch-free so that it gets vectorized.
+  const float scale = input.gain_.load(std::memory_order_relaxed) * kS16ToFloat;
+  float* const dst = slot.data_.data();
+  if ((int)curr_channels == num_channels_) {
+    const size_t count = std::min(curr_count, frame_size_);
+    for (size_t i = 0; i < count; ++i) {
+      dst[i] += scale * curr_data[i];
+    }
+  } else {
+    // Mono -> Stereo
+    const size_t count = std::min(curr_count, frame_size_ / 2);
+    for (size_t i = 0; i < count; ++i) {
+      const float val = scale * curr_data[i];
+      dst[2 * i + 0] += val;
+      dst[2 * i + 1] += val;
+    }
+  }
+  ++slot.contributions_;
+
+  FinalizeSlotsNoLock();
+}
+
+void AudioTrackMixedReadBuffer::FinalizeSlotsNoLock() {
+  while (!pending_slots_.empty()) {
+    Slot& slot = pending_slots_.front();
+    if ((slot.contributions_ < inputs_.size()) &&
+        (pending_slots_.size() <= kMaxPendingSlots)) {
+      break;
+    }
+
+    // Saturate the mix into the normalized range.
+    for (float& sample : slot.data_) {
+      sample = std::min(std::max(sample, -1.0f), 1.0f);
+    }
+    ready_frames_.push_back(std::move(slot.data_));
+    pending_slots_.pop_front();
+    ++head_tick_;
+
+    // Maintain buffering limits.
+    while (ready_frames_.size() > max_ready_frames_) {
+      frame_pool_.push_back(std::move(ready_frames_.front()));
+      ready_frames_.pop_front();
+      has_overrun_ = true;
+    }
+  }
+}
+
+std::vector<float> AudioTrackMixedReadBuffer::AcquireFrameNoLock() {
+  std::vector<float> frame;
+  if (!frame_pool_.empty()) {
+    frame = std::move(frame_pool_.back());
+    frame_pool_.pop_back();
+  }
+  frame.assign(frame_size_, 0.0f);
+  return frame;
+}
+
+Result AudioTrackMixedReadBuffer::Read(
+    mrsAudioTrackReadBufferPadBehavior pad_behavior,
+    float* samples_out,
+    int num_samples_max,
+    int* num_samples_read_out,
+    bool* has_overrun_out) noexcept {
+  float* dst = samples_out;
+  size_t dst_len = (size_t)num_samples_max;  // number of points remaining
+
+  *has_overrun_out = false;
+
+  while (dst_len > 0) {
+    if (read_pos_ < read_frame_.size()) {
+      // There is still data in the current frame, read some.
+      const size_t len = std::min(read_frame_.size() - read_pos_, dst_len);
+      memcpy(dst, read_frame_.data() + read_pos_, len * sizeof(float));
+      read_pos_ += len;
+      dst += len;
+      dst_len -= len;
+      continue;
+    }
+
+    // Current frame is exhausted, recycle it and pop the next one.
+    bool has_frame = false;
+    {
+      std::lock_guard<std::mutex> lock(mix_mutex_);
+
+      // Read and reset the overrun flag.
+      *has_overrun_out = *has_overrun_out || has_overrun_;
+      has_overrun_ = false;
+
+      if (!read_frame_.empty()) {
+        frame_pool_.push_back(std::move(read_frame_));
+      }
+      read_frame_.clear();
+      read_pos_ = 0;
+      if (!ready_frames_.empty()) {
+        read_frame_ = std::move(ready_frames_.front());
+        ready_frames_.pop_front();
+        has_frame = true;
+      }
+    }
+
+    if (!has_frame) {
+      // No more input.
+      // Pad output buffer if requested by caller.
+      constexpr float freq = 2 * 222 * float(M_PI);
+      switch (pad_behavior) {
+        case mrsAudioTrackReadBufferPadBehavior::kDoNotPad:
+          break;
+        case mrsAudioTrackReadBufferPadBehavior::kPadWithZero:
+          std::memset(dst, 0, dst_len * sizeof(float));
+          break;
+        case mrsAudioTrackReadBufferPadBehavior::kPadWithSine:
+          for (size_t i = 0; i < dst_len; ++i) {
+            dst[i] = 0.15f * sinf((freq * (sinwave_iter_ + i)) /
+                                  (sample_rate_ * num_channels_));
+          }
+          sinwave_iter_ = (sinwave_iter_ + (int)dst_len) % 628318530 /*twopi*/;
+          break;
+        default:
+          RTC_NOTREACHED();
+          break;
+      }
+      *num_samples_read_out = num_samples_max - (int)dst_len;
+      return Result::kSuccess;
+    }
+  }
+  *num_samples_read_out = num_samples_max;
+  return Result::kSuccess;
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,162 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "api/call/audio_sink.h"
+#include "common_audio/resampler/include/resampler.h"
+
+#include "export.h"
+#include "refptr.h"
+#include "result.h"
+#include "tracked_object.h"
+
+enum class mrsAudioTrackReadBufferPadBehavior;
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+class RemoteAudioTrack;
+
+/// Implementation of |mrsAudioTrackMixedReadBufferHandle|.
+///
+/// Buffer mixing the audio of several remote audio tracks into a single stream
+/// of a fixed format. Each track frame is converted once on arrival to the
+/// output format, scaled by the per-track gain, and accumulated into a 10 ms
+/// slot of the mixing grid. A slot is complete once all tracks contributed to
+/// it, or when the fastest track gets too far ahead of the slowest one, at
+/// which point it is clamped and made available to |Read()|.
+///
+/// Remote audio frames are delivered by the audio thread of the audio device
+/// module while it pumps the sources of the |ToggleAudioMixer|, so tracks which
+/// are not output to the audio device are mixed by this buffer without any
+/// additional copy or interop call per track.
+class AudioTrackMixedReadBuffer : public TrackedObject {
+ public:
+  /// Create a new buffer producing interleaved audio with |num_channels|
+  /// channels at |sample_rate| Hz, and which buffers at most |buffer_ms|
+  /// milliseconds of mixed audio.
+  AudioTrackMixedReadBuffer(RefPtr<GlobalFactory> global_factory,
+                            int sample_rate,
+                            int num_channels,
+                            int buffer_ms = 500);
+
+  /// Destructs the buffer, removing all tracks.
+  ~AudioTrackMixedReadBuffer() override;
+
+  /// See |mrsAudioTrackMixedReadBufferAddTrack|.
+  Result AddTrack(RemoteAudioTrack& track, float gain) noexcept;
+
+  /// See |mrsAudioTrackMixedReadBufferSetTrackGain|.
+  Result SetTrackGain(RemoteAudioTrack& track, float gain) noexcept;
+
+  /// See |mrsAudioTrackMixedReadBufferRemoveTrack|.
+  Result RemoveTrack(RemoteAudioTrack& track) noexcept;
+
+  /// See |mrsAudioTrackMixedReadBufferRead|.
+  Result Read(mrsAudioTrackReadBufferPadBehavior pad_behavior,
+              float* samples_out,
+              int num_samples_max,
+              int* num_samples_read_out,
+              bool* has_overrun_out) noexcept;
+
+  MRS_NODISCARD int sample_rate() const noexcept { return sample_rate_; }
+  MRS_NODISCARD int num_channels() const noexcept { return num_channels_; }
+
+ private:
+  /// Sink registered on a single remote audio track.
+  class Input : public webrtc::AudioTrackSinkInterface {
+   public:
+    Input(AudioTrackMixedReadBuffer& owner,
+          rtc::scoped_refptr<webrtc::AudioTrackInterface> track,
+          float gain);
+
+    void OnData(const void* audio_data,
+                int bits_per_sample,
+                int sample_rate,
+                size_t number_of_channels,
+                size_t number_of_frames) override;
+
+    AudioTrackMixedReadBuffer& owner_;
+    const rtc::scoped_refptr<webrtc::AudioTrackInterface> track_;
+    std::atomic<float> gain_;
+
+    // The fields below are only accessed with |owner_.mix_mutex_| held.
+
+    /// Tick of the grid slot the next frame of this input will be mixed into.
+    int64_t next_tick_{0};
+    webrtc::Resampler resampler_;
+    std::vector<int16_t> downmix_;
+    std::vector<int16_t> resampled_;
+  };
+
+  /// Single 10 ms slot of the mixing grid.
+  struct Slot {
+    std::vector<float> data_;
+    size_t contributions_{0};
+  };
+
+  /// Convert and accumulate a frame of |input| into the mixing grid.
+  void MixInput(Input& input,
+                const void* audio_data,
+                int bits_per_sample,
+                int sample_rate,
+                size_t number_of_channels,
+                size_t number_of_frames);
+
+  /// Move the completed slots at the front of the grid to |ready_frames_|.
+  void FinalizeSlotsNoLock();
+
+  /// Get a zeroed frame of |frame_size_| samples, reusing a pooled one if any.
+  std::vector<float> AcquireFrameNoLock();
+
+  const int sample_rate_;
+  const int num_channels_;
+
+  /// Number of samples (all channels) in a 10 ms frame of the output format.
+  const size_t frame_size_;
+
+  /// Maximum number of 10 ms frames buffered for |Read()|.
+  const size_t max_ready_frames_;
+
+  /// Serializes adding and removing tracks, including the registration of the
+  /// input sinks on the tracks, so that an input is never destroyed while its
+  /// sink is being registered. This is never taken by the audio thread, so it
+  /// can be held while calling into a track, unlike |mix_mutex_|.
+  std::mutex control_mutex_;
+
+  /// Protects the mixing grid, the ready queue, and the inputs.
+  std::mutex mix_mutex_;
+
+  std::unordered_map<RemoteAudioTrack*, std::unique_ptr<Input>> inputs_
+      RTC_GUARDED_BY(mix_mutex_);
+
+  /// Open slots of the mixing grid, starting at |head_tick_|.
+  std::deque<Slot> pending_slots_ RTC_GUARDED_BY(mix_mutex_);
+  int64_t head_tick_ RTC_GUARDED_BY(mix_mutex_){0};
+
+  /// Mixed 10 ms frames ready to be read.
+  std::deque<std::vector<float>> ready_frames_ RTC_GUARDED_BY(mix_mutex_);
+
+  /// Recycled frame buffers, to avoid allocating in steady state.
+  std::vector<std::vector<float>> frame_pool_ RTC_GUARDED_BY(mix_mutex_);
+
+  /// Have frames been dropped due to overrun after last call to Read()?
+  bool has_overrun_ RTC_GUARDED_BY(mix_mutex_){false};
+
+  // Only accessed from callers of Read - no locking needed.
+  std::vector<float> read_frame_;
+  size_t read_pos_{0};
+  int sinwave_iter_{0};
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
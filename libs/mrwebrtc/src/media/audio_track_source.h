@@ -81,20 +81,6 @@ class AudioTrackSource : public TrackedObject {
   std::mutex observer_mutex_;
 };
 
-namespace detail {
-
-//
-// Helpers
-//
-
-///// Create a custom audio track source wrapping the given interop callback.
-// RefPtr<AudioTrackSource> AudioTrackSourceCreateFromCustom(
-//    RefPtr<GlobalFactory> global_factory,
-//    mrsRequestCustomAudioFrameCallback callback,
-//    void* user_data);
-
-}  // namespace detail
-
 }  // namespace WebRTC
 }  // namespace MixedReality
 }  // namespace Microsoft
@@ -19,9 +19,29 @@ ErrorOr<RefPtr<DeviceAudioTrackSource>> DeviceAudioTrackSource::Create(
     return Error(Result::kInvalidOperation);
   }
 
-  // Create the audio track source
+  // Create the audio track source. The audio processing options default to
+  // the library-level ones, and are all disabled if the audio processing
+  // module is bypassed, to avoid any useless work in the audio engine.
+  const mrsAudioProcessingConfig apm_config =
+      GlobalFactory::GetAudioProcessingConfig();
+  const bool apm_enabled = (apm_config.enabled != mrsBool::kFalse);
+  auto resolve = [apm_enabled](mrsOptBool source_value,
+                               mrsOptBool library_value) {
+    if (!apm_enabled) {
+      return absl::optional<bool>(false);
+    }
+    return ToOptional(source_value != mrsOptBool::kUnset ? source_value
+                                                         : library_value);
+  };
   cricket::AudioOptions options{};
-  options.auto_gain_control = ToOptional(init_config.auto_gain_control_);
+  options.echo_cancellation = resolve(init_config.echo_cancellation_,
+                                      apm_config.echo_cancellation);
+  options.auto_gain_control = resolve(init_config.auto_gain_control_,
+                                      apm_config.auto_gain_control);
+  options.noise_suppression = resolve(init_config.noise_suppression_,
+                                      apm_config.noise_suppression);
+  options.highpass_filter =
+      resolve(init_config.highpass_filter_, apm_config.highpass_filter);
   rtc::scoped_refptr<webrtc::AudioSourceInterface> audio_source =
       pc_factory->CreateAudioSource(options);
   if (!audio_source) {
@@ -0,0 +1,244 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "interop/global_factory.h"
+#include "media/external_audio_track_source.h"
+
+namespace {
+
+enum {
+  /// Deliver the next 10 ms audio frame to the audio tracks.
+  MSG_DELIVER_FRAME
+};
+
+/// Maximum delay after which the capture thread stops trying to catch up on
+/// the frames it missed, and resynchronizes on the current time instead.
+constexpr int64_t kMaxCatchUpDelayMs = 100;
+
+/// Delay without any tick of the audio device clock after which the capture
+/// thread takes over the delivery of frames.
+constexpr int64_t kAudioClockTimeoutMs = 50;
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace detail {
+
+AudioSampleRingBuffer::AudioSampleRingBuffer(size_t capacity)
+    : buffer_(new int16_t[capacity]), capacity_(capacity) {}
+
+bool AudioSampleRingBuffer::TryWrite(const int16_t* data,
+                                     size_t count) noexcept {
+  const size_t write_count = write_count_.load(std::memory_order_relaxed);
+  const size_t read_count = read_count_.load(std::memory_order_acquire);
+  if (capacity_ - (write_count - read_count) < count) {
+    return false;
+  }
+  const size_t offset = write_count % capacity_;
+  const size_t first = std::min(count, capacity_ - offset);
+  memcpy(&buffer_[offset], data, first * sizeof(int16_t));
+  memcpy(&buffer_[0], data + first, (count - first) * sizeof(int16_t));
+  write_count_.store(write_count + count, std::memory_order_release);
+  return true;
+}
+
+size_t AudioSampleRingBuffer::Read(int16_t* data, size_t count) noexcept {
+  const size_t read_count = read_count_.load(std::memory_order_relaxed);
+  const size_t write_count = write_count_.load(std::memory_order_acquire);
+  count = std::min(count, write_count - read_count);
+  const size_t offset = read_count % capacity_;
+  const size_t first = std::min(count, capacity_ - offset);
+  memcpy(data, &buffer_[offset], first * sizeof(int16_t));
+  memcpy(data + first, &buffer_[0], (count - first) * sizeof(int16_t));
+  read_count_.store(read_count + count, std::memory_order_release);
+  return count;
+}
+
+void CustomAudioSourceAdapter::DispatchFrame(const int16_t* data,
+                                             int sample_rate,
+                                             size_t number_of_channels,
+                                             size_t number_of_frames) {
+  rtc::CritScope lock(&sinks_lock_);
+  for (webrtc::AudioTrackSinkInterface* sink : sinks_) {
+    sink->OnData(data, 16, sample_rate, number_of_channels, number_of_frames);
+  }
+}
+
+void CustomAudioSourceAdapter::AddSink(webrtc::AudioTrackSinkInterface* sink) {
+  rtc::CritScope lock(&sinks_lock_);
+  sinks_.push_back(sink);
+}
+
+void CustomAudioSourceAdapter::RemoveSink(
+    webrtc::AudioTrackSinkInterface* sink) {
+  rtc::CritScope lock(&sinks_lock_);
+  auto it = std::find(sinks_.begin(), sinks_.end(), sink);
+  if (it != sinks_.end()) {
+    sinks_.erase(it);
+  }
+}
+
+}  // namespace detail
+
+ErrorOr<RefPtr<ExternalAudioTrackSource>> ExternalAudioTrackSource::Create(
+    const mrsExternalAudioTrackSourceConfig& config) noexcept {
+  // The 10 ms frame must contain an integral number of samples.
+  if ((config.sample_rate < 100) || (config.sample_rate % 100 != 0)) {
+    RTC_LOG(LS_ERROR) << "Invalid sample rate " << config.sample_rate
+                      << " for external audio track source.";
+    return Error(Result::kInvalidParameter);
+  }
+  if ((config.channel_count != 1) && (config.channel_count != 2)) {
+    RTC_LOG(LS_ERROR) << "Invalid channel count " << config.channel_count
+                      << " for external audio track source.";
+    return Error(Result::kInvalidParameter);
+  }
+  if (config.buffer_ms < 10) {
+    RTC_LOG(LS_ERROR) << "Invalid buffer size " << config.buffer_ms
+                      << " ms for external audio track source.";
+    return Error(Result::kInvalidParameter);
+  }
+
+  RefPtr<ExternalAudioTrackSource> source = new ExternalAudioTrackSource(
+      GlobalFactory::InstancePtr(), config,
+      new rtc::RefCountedObject<detail::CustomAudioSourceAdapter>());
+  // Unlike external video track sources, there is no callback into the
+  // wrapper, so the source can start delivering frames immediately.
+  source->StartCapture();
+  return source;
+}
+
+ExternalAudioTrackSource::ExternalAudioTrackSource(
+    RefPtr<GlobalFactory> global_factory,
+    const mrsExternalAudioTrackSourceConfig& config,
+    rtc::scoped_refptr<detail::CustomAudioSourceAdapter> source)
+    : AudioTrackSource(std::move(global_factory),
+                       ObjectType::kExternalAudioTrackSource,
+                       std::move(source)),
+      sample_rate_((int)config.sample_rate),
+      channel_count_(config.channel_count),
+      samples_per_frame_(config.sample_rate / 100),
+      ring_buffer_((size_t)config.sample_rate * config.channel_count *
+                   config.buffer_ms / 1000),
+      frame_data_(samples_per_frame_ * channel_count_),
+      audio_clock_(global_factory_->audio_mixer()),
+      capture_thread_(rtc::Thread::Create()) {
+  capture_thread_->SetName("ExternalAudioTrackSource capture thread", this);
+}
+
+ExternalAudioTrackSource::~ExternalAudioTrackSource() {
+  Shutdown();
+}
+
+void ExternalAudioTrackSource::StartCapture() {
+  RTC_LOG(LS_INFO) << "Starting capture for external audio track source "
+                   << GetName().c_str();
+  GetSourceImpl()->state_ = SourceState::kLive;
+  if (audio_clock_) {
+    audio_clock_->AddClockObserver(this);
+  }
+  capture_thread_->Start();
+
+  // Schedule first frame delivery for 10ms from now
+  next_frame_time_ms_ = rtc::TimeMillis() + 10;
+  capture_thread_->PostAt(RTC_FROM_HERE, next_frame_time_ms_, this,
+                          MSG_DELIVER_FRAME);
+}
+
+Result ExternalAudioTrackSource::PushFrame(const AudioFrame& frame) noexcept {
+  if (GetSourceImpl()->state_ != SourceState::kLive) {
+    return Result::kInvalidOperation;
+  }
+  if ((frame.bits_per_sample_ != 16) ||
+      ((int)frame.sampling_rate_hz_ != sample_rate_) ||
+      (frame.channel_count_ != channel_count_)) {
+    RTC_LOG(LS_ERROR) << "Audio frame format (" << frame.bits_per_sample_
+                      << " bits, " << frame.sampling_rate_hz_ << " Hz, "
+                      << frame.channel_count_
+                      << " channels) does not match the format of the external "
+                         "audio track source.";
+    return Result::kInvalidParameter;
+  }
+  const size_t count = (size_t)frame.sample_count_ * channel_count_;
+  if (!ring_buffer_.TryWrite(static_cast<const int16_t*>(frame.data_),
+                             count)) {
+    return Result::kBufferTooSmall;
+  }
+  return Result::kSuccess;
+}
+
+void ExternalAudioTrackSource::Shutdown() noexcept {
+  detail::CustomAudioSourceAdapter* const src = GetSourceImpl();
+  if (src->state_ != SourceState::kEnded) {
+    RTC_LOG(LS_INFO) << "Stopping capture for external audio track source "
+                     << GetName().c_str();
+    if (audio_clock_) {
+      audio_clock_->RemoveClockObserver(this);
+    }
+    capture_thread_->Stop();
+    src->state_ = SourceState::kEnded;
+  }
+}
+
+void ExternalAudioTrackSource::DeliverFrame() {
+  // Frames are always delivered at the nominal rate even if the application
+  // does not push enough audio, by padding with silence, so that the timeline
+  // of the encoder stays continuous.
+  rtc::CritScope lock(&deliver_lock_);
+  const size_t read = ring_buffer_.Read(frame_data_.data(), frame_data_.size());
+  std::fill(frame_data_.begin() + read, frame_data_.end(), (int16_t)0);
+  GetSourceImpl()->DispatchFrame(frame_data_.data(), sample_rate_,
+                                 channel_count_, samples_per_frame_);
+}
+
+// Note - This is called on the audio device thread only.
+void ExternalAudioTrackSource::OnAudioClockTick() {
+  last_clock_tick_ms_.store(rtc::TimeMillis(), std::memory_order_relaxed);
+  DeliverFrame();
+}
+
+// Note - This is called on the capture thread only.
+void ExternalAudioTrackSource::OnMessage(rtc::Message* message) {
+  switch (message->message_id) {
+    case MSG_DELIVER_FRAME: {
+      const int64_t now = rtc::TimeMillis();
+      const int64_t last_tick =
+          last_clock_tick_ms_.load(std::memory_order_relaxed);
+      if ((last_tick != 0) && (now - last_tick <= kAudioClockTimeoutMs)) {
+        // The audio device clock paces the frames; stay in sync with the
+        // current time, to resume without a burst if the device stops.
+        next_frame_time_ms_ = now + 10;
+        capture_thread_->PostAt(RTC_FROM_HERE, next_frame_time_ms_, this,
+                                MSG_DELIVER_FRAME);
+        break;
+      }
+
+      // Deliver all frames due, in case the thread was delayed.
+      if (now - next_frame_time_ms_ > kMaxCatchUpDelayMs) {
+        RTC_LOG(LS_WARNING) << "External audio track source capture thread "
+                               "stalled for "
+                            << (now - next_frame_time_ms_)
+                            << " ms; skipping missed audio frames.";
+        next_frame_time_ms_ = now;
+      }
+      while (next_frame_time_ms_ <= now) {
+        DeliverFrame();
+        next_frame_time_ms_ += 10;
+      }
+
+      // Schedule the next frame on an absolute deadline, to avoid drifting.
+      capture_thread_->PostAt(RTC_FROM_HERE, next_frame_time_ms_, this,
+                              MSG_DELIVER_FRAME);
+      break;
+    }
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
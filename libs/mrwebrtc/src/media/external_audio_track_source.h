@@ -0,0 +1,176 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "audio_frame.h"
+#include "audio_track_source.h"
+#include "external_audio_track_source_interop.h"
+#include "mrs_errors.h"
+#include "refptr.h"
+#include "toggle_audio_mixer.h"
+#include "tracked_object.h"
+
+#include "api/mediastreaminterface.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+namespace detail {
+
+/// Lock-free single-producer single-consumer ring buffer of audio samples.
+class AudioSampleRingBuffer {
+ public:
+  /// Create a ring buffer holding up to |capacity| samples.
+  explicit AudioSampleRingBuffer(size_t capacity);
+
+  /// Write |count| samples if there is enough space available, and return
+  /// |true|, or write nothing and return |false| otherwise. This must only be
+  /// called from the producer thread.
+  bool TryWrite(const int16_t* data, size_t count) noexcept;
+
+  /// Read up to |count| samples, and return the number of samples read. This
+  /// must only be called by the consumer, which may switch threads as long as
+  /// calls are serialized.
+  size_t Read(int16_t* data, size_t count) noexcept;
+
+ private:
+  const std::unique_ptr<int16_t[]> buffer_;
+  const size_t capacity_;
+
+  /// Total number of samples written and read since creation. The difference
+  /// is the number of samples available for reading.
+  std::atomic<size_t> write_count_{0};
+  std::atomic<size_t> read_count_{0};
+};
+
+/// Adapter to bridge an audio track source to the underlying core
+/// implementation, dispatching the frames produced by the source to the sinks
+/// registered by the audio tracks using it.
+class CustomAudioSourceAdapter : public webrtc::AudioSourceInterface {
+ public:
+  void DispatchFrame(const int16_t* data,
+                     int sample_rate,
+                     size_t number_of_channels,
+                     size_t number_of_frames);
+
+  //
+  // NotifierInterface
+  //
+
+  void RegisterObserver(webrtc::ObserverInterface* /*observer*/) override {}
+  void UnregisterObserver(webrtc::ObserverInterface* /*observer*/) override {}
+
+  //
+  // MediaSourceInterface
+  //
+
+  SourceState state() const override { return state_; }
+  bool remote() const override { return false; }
+
+  //
+  // AudioSourceInterface
+  //
+
+  void AddSink(webrtc::AudioTrackSinkInterface* sink) override;
+  void RemoveSink(webrtc::AudioTrackSinkInterface* sink) override;
+
+  std::atomic<SourceState> state_{SourceState::kInitializing};
+
+ private:
+  rtc::CriticalSection sinks_lock_;
+  std::vector<webrtc::AudioTrackSinkInterface*> sinks_
+      RTC_GUARDED_BY(sinks_lock_);
+};
+
+}  // namespace detail
+
+/// Audio track source acting as an adapter for an external source of raw
+/// audio samples pushed by the application.
+///
+/// The samples are buffered in a lock-free ring buffer, and delivered to the
+/// audio tracks in 10 ms frames paced on the clock of the audio device module,
+/// that is each time the audio device pulls a frame to play out. This keeps
+/// the source in lockstep with the audio device, including the headless and
+/// application-driven ones which do not run in real time, and prevents jitter
+/// in the pace at which the application pushes audio from propagating to the
+/// encoder. While the audio device is not playing out, for example in a
+/// send-only session, a dedicated capture thread paces the frames on the
+/// monotonic system clock instead.
+///
+/// The audio device module is the one of the first thread group, so the audio
+/// tracks of the source can only be sent by peer connections of that group.
+class ExternalAudioTrackSource : public AudioTrackSource,
+                                 public ToggleAudioMixer::ClockObserver,
+                                 public rtc::MessageHandler {
+ public:
+  static ErrorOr<RefPtr<ExternalAudioTrackSource>> Create(
+      const mrsExternalAudioTrackSourceConfig& config) noexcept;
+
+  ~ExternalAudioTrackSource() override;
+
+  /// Push some audio samples into the source.
+  /// See |mrsExternalAudioTrackSourcePushFrame()| for details.
+  Result PushFrame(const AudioFrame& frame) noexcept;
+
+  /// Shutdown the source and stop delivering frames.
+  void Shutdown() noexcept;
+
+ protected:
+  ExternalAudioTrackSource(
+      RefPtr<GlobalFactory> global_factory,
+      const mrsExternalAudioTrackSourceConfig& config,
+      rtc::scoped_refptr<detail::CustomAudioSourceAdapter> source);
+
+  /// Start the capture thread delivering audio frames.
+  void StartCapture();
+
+  /// Read the next 10 ms frame from the ring buffer, padding with silence,
+  /// and deliver it to the audio tracks.
+  void DeliverFrame();
+
+  void OnAudioClockTick() override;
+  void OnMessage(rtc::Message* message) override;
+
+  detail::CustomAudioSourceAdapter* GetSourceImpl() const {
+    return (detail::CustomAudioSourceAdapter*)source_.get();
+  }
+
+  const int sample_rate_;
+  const size_t channel_count_;
+
+  /// Number of samples per channel in a 10 ms frame.
+  const size_t samples_per_frame_;
+
+  detail::AudioSampleRingBuffer ring_buffer_;
+
+  /// Serialize frame delivery between the audio device thread and the capture
+  /// thread, which both consume the ring buffer.
+  rtc::CriticalSection deliver_lock_;
+
+  /// Scratch buffer for the frame being delivered.
+  std::vector<int16_t> frame_data_ RTC_GUARDED_BY(deliver_lock_);
+
+  /// Mixer of the audio device module of the first thread group, whose clock
+  /// paces the frames.
+  rtc::scoped_refptr<ToggleAudioMixer> audio_clock_;
+
+  /// Time of the last tick of the audio device clock, in milliseconds, or zero
+  /// if it never ticked.
+  std::atomic<int64_t> last_clock_tick_ms_{0};
+
+  /// Time at which the next frame is due when paced by the capture thread, in
+  /// milliseconds. Only accessed from the capture thread.
+  int64_t next_frame_time_ms_{0};
+
+  std::unique_ptr<rtc::Thread> capture_thread_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,240 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "media/headless_audio_device_module.h"
+
+#include <cctype>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+enum {
+  /// Process the next 10 ms tick of the virtual clock.
+  MSG_TICK
+};
+
+/// Maximum delay after which the processing thread stops trying to catch up
+/// with the real time, and moves the origin of the virtual clock instead. This
+/// skips real time but never virtual time, so no audio frame is lost.
+constexpr int64_t kMaxCatchUpDelayMs = 100;
+
+/// Check if |str| ends with the lowercase |suffix|, ignoring case.
+bool EndsWithNoCase(const std::string& str, const char* suffix) {
+  const size_t len = strlen(suffix);
+  if (str.size() < len) {
+    return false;
+  }
+  return std::equal(str.end() - len, str.end(), suffix, [](char a, char b) {
+    return (std::tolower((unsigned char)a) == b);
+  });
+}
+
+uint32_t ReadLE32(const char* data) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+  return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+         ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+uint16_t ReadLE16(const char* data) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+  return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+/// Parse a 16-bit PCM WAV file from memory. This only supports the canonical
+/// uncompressed format, which is what audio tools produce by default.
+bool ParseWavFile(const std::vector<char>& content,
+                  Microsoft::MixedReality::WebRTC::HeadlessAudioDeviceOptions&
+                      options) {
+  if ((content.size() < 12) || (memcmp(content.data(), "RIFF", 4) != 0) ||
+      (memcmp(content.data() + 8, "WAVE", 4) != 0)) {
+    return false;
+  }
+  bool has_format = false;
+  size_t offset = 12;
+  while (offset + 8 <= content.size()) {
+    const char* const chunk = content.data() + offset;
+    const size_t chunk_size =
+        std::min<size_t>(ReadLE32(chunk + 4), content.size() - offset - 8);
+    if (memcmp(chunk, "fmt ", 4) == 0) {
+      if ((chunk_size < 16) || (ReadLE16(chunk + 8) != 1 /* PCM */) ||
+          (ReadLE16(chunk + 22) != 16 /* bits per sample */)) {
+        return false;
+      }
+      options.channel_count = ReadLE16(chunk + 10);
+      options.sample_rate = (int)ReadLE32(chunk + 12);
+      has_format = true;
+    } else if ((memcmp(chunk, "data", 4) == 0) && has_format) {
+      options.capture_samples.resize(chunk_size / sizeof(int16_t));
+      memcpy(options.capture_samples.data(), chunk + 8,
+             options.capture_samples.size() * sizeof(int16_t));
+      return true;
+    }
+    // Chunks are padded to an even size
+    offset += 8 + chunk_size + (chunk_size & 1);
+  }
+  return false;
+}
+
+}  // namespace
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+ErrorOr<HeadlessAudioDeviceOptions> HeadlessAudioDeviceOptions::FromConfig(
+    const mrsHeadlessAudioDeviceConfig& config) noexcept {
+  HeadlessAudioDeviceOptions options;
+  options.sample_rate = (int)config.sample_rate;
+  options.channel_count = config.channel_count;
+  options.clock_rate = config.clock_rate;
+  if (!(config.clock_rate > 0.0f)) {
+    RTC_LOG(LS_ERROR) << "Invalid clock rate " << config.clock_rate
+                      << " for headless audio device module.";
+    return Error(Result::kInvalidParameter);
+  }
+
+  if (config.capture_samples) {
+    options.capture_samples.assign(
+        config.capture_samples,
+        config.capture_samples + config.capture_sample_count);
+  } else if (config.capture_file_path && config.capture_file_path[0]) {
+    const std::string path = config.capture_file_path;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      RTC_LOG(LS_ERROR) << "Cannot open audio capture file '" << path
+                        << "' for headless audio device module.";
+      return Error(Result::kNotFound);
+    }
+    std::vector<char> content{std::istreambuf_iterator<char>(file),
+                              std::istreambuf_iterator<char>()};
+    if (EndsWithNoCase(path, ".wav")) {
+      if (!ParseWavFile(content, options)) {
+        RTC_LOG(LS_ERROR) << "Audio capture file '" << path
+                          << "' is not a valid 16-bit PCM WAV file.";
+        return Error(Result::kInvalidParameter);
+      }
+    } else {
+      options.capture_samples.resize(content.size() / sizeof(int16_t));
+      memcpy(options.capture_samples.data(), content.data(),
+             options.capture_samples.size() * sizeof(int16_t));
+    }
+  }
+
+  // The 10 ms frame must contain an integral number of samples.
+  if ((options.sample_rate < 100) || (options.sample_rate % 100 != 0)) {
+    RTC_LOG(LS_ERROR) << "Invalid sample rate " << options.sample_rate
+                      << " for headless audio device module.";
+    return Error(Result::kInvalidParameter);
+  }
+  if ((options.channel_count != 1) && (options.channel_count != 2)) {
+    RTC_LOG(LS_ERROR) << "Invalid channel count " << options.channel_count
+                      << " for headless audio device module.";
+    return Error(Result::kInvalidParameter);
+  }
+  // Only keep entire multi-channel samples, to keep the channels aligned when
+  // looping.
+  options.capture_samples.resize(options.capture_samples.size() -
+                                 options.capture_samples.size() %
+                                     options.channel_count);
+  return std::move(options);
+}
+
+rtc::scoped_refptr<webrtc::AudioDeviceModule> HeadlessAudioDeviceModule::Create(
+    HeadlessAudioDeviceOptions options) {
+  return new rtc::RefCountedObject<HeadlessAudioDeviceModule>(
+      std::move(options));
+}
+
+HeadlessAudioDeviceModule::HeadlessAudioDeviceModule(
+    HeadlessAudioDeviceOptions options)
+    : VirtualAudioDeviceModule("Headless audio device",
+                               options.sample_rate,
+                               options.channel_count),
+      options_(std::move(options)),
+      record_data_(samples_per_frame_ * channel_count_),
+      playout_data_(samples_per_frame_ * channel_count_),
+      process_thread_(rtc::Thread::Create()) {
+  process_thread_->SetName("Headless audio device thread", this);
+}
+
+HeadlessAudioDeviceModule::~HeadlessAudioDeviceModule() {
+  Terminate();
+}
+
+void HeadlessAudioDeviceModule::OnInitialized() {
+  process_thread_->Start();
+  start_time_ms_ = rtc::TimeMillis();
+  tick_count_ = 0;
+  process_thread_->PostAt(RTC_FROM_HERE, start_time_ms_, this, MSG_TICK);
+}
+
+void HeadlessAudioDeviceModule::OnTerminating() {
+  process_thread_->Stop();
+}
+
+void HeadlessAudioDeviceModule::ProcessTick() {
+  if (recording_) {
+    // Fill the frame from the looped capture samples, or with silence.
+    const std::vector<int16_t>& samples = options_.capture_samples;
+    if (samples.empty()) {
+      std::fill(record_data_.begin(), record_data_.end(), (int16_t)0);
+    } else {
+      size_t written = 0;
+      while (written < record_data_.size()) {
+        const size_t count = std::min(record_data_.size() - written,
+                                      samples.size() - capture_position_);
+        memcpy(&record_data_[written], &samples[capture_position_],
+               count * sizeof(int16_t));
+        written += count;
+        capture_position_ = (capture_position_ + count) % samples.size();
+      }
+    }
+    DeliverRecordedFrame(record_data_.data());
+  }
+
+  // Pull the mixed audio to run the receive pipeline, and discard it.
+  if (playing_) {
+    PullPlayoutFrame(playout_data_.data());
+  }
+}
+
+// Note - This is called on the processing thread only.
+void HeadlessAudioDeviceModule::OnMessage(rtc::Message* message) {
+  switch (message->message_id) {
+    case MSG_TICK: {
+      // Process all ticks due, in case the thread was delayed. The real time
+      // of tick N is derived from the origin of the virtual clock rather than
+      // accumulated from the previous tick, to avoid drifting.
+      const double tick_interval_ms = 10.0 / options_.clock_rate;
+      const int64_t now = rtc::TimeMillis();
+      int64_t next_tick_time_ms =
+          start_time_ms_ + (int64_t)(tick_count_ * tick_interval_ms);
+      if (now - next_tick_time_ms > kMaxCatchUpDelayMs) {
+        RTC_LOG(LS_WARNING) << "Headless audio device thread stalled for "
+                            << (now - next_tick_time_ms)
+                            << " ms; resynchronizing virtual clock.";
+        start_time_ms_ = now;
+        tick_count_ = 0;
+        next_tick_time_ms = now;
+      }
+      while (next_tick_time_ms <= now) {
+        ProcessTick();
+        ++tick_count_;
+        next_tick_time_ms =
+            start_time_ms_ + (int64_t)(tick_count_ * tick_interval_ms);
+      }
+
+      // Schedule the next tick on an absolute deadline
+      process_thread_->PostAt(RTC_FROM_HERE, next_tick_time_ms, this,
+                              MSG_TICK);
+      break;
+    }
+  }
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
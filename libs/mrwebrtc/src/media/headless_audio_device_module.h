@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "interop_api.h"
+#include "media/virtual_audio_device_module.h"
+#include "mrs_errors.h"
+
+#include "rtc_base/messagehandler.h"
+#include "rtc_base/thread.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Options of the headless audio device module, resolved from the interop
+/// configuration |mrsHeadlessAudioDeviceConfig|.
+struct HeadlessAudioDeviceOptions {
+  /// Create the options from the given interop configuration, loading the
+  /// capture file if any.
+  static ErrorOr<HeadlessAudioDeviceOptions> FromConfig(
+      const mrsHeadlessAudioDeviceConfig& config) noexcept;
+
+  int sample_rate = 48000;
+  size_t channel_count = 1;
+  float clock_rate = 1.0f;
+
+  /// Interleaved samples recorded in loop, or empty to record silence.
+  std::vector<int16_t> capture_samples;
+};
+
+/// Audio device module not using any actual audio device, for headless servers
+/// and automated testing.
+///
+/// Recording and playout are driven by a dedicated thread ticking every 10 ms
+/// on an absolute schedule. Each tick advances a virtual clock by exactly
+/// 10 ms and processes one recorded frame and one played out frame, so the
+/// audio produced is deterministic and does not depend on the scheduling
+/// jitter of the thread. The virtual clock can run faster than real time for
+/// benchmarks. Recorded audio is read in loop from memory, or is silence, and
+/// played out audio is pulled from the mixer and discarded.
+class HeadlessAudioDeviceModule : public VirtualAudioDeviceModule,
+                                  public rtc::MessageHandler {
+ public:
+  static rtc::scoped_refptr<webrtc::AudioDeviceModule> Create(
+      HeadlessAudioDeviceOptions options);
+
+  ~HeadlessAudioDeviceModule() override;
+
+ protected:
+  explicit HeadlessAudioDeviceModule(HeadlessAudioDeviceOptions options);
+
+  void OnInitialized() override;
+  void OnTerminating() override;
+
+  /// Process a single 10 ms tick of the virtual clock. Only called from the
+  /// processing thread.
+  void ProcessTick();
+
+  void OnMessage(rtc::Message* message) override;
+
+  const HeadlessAudioDeviceOptions options_;
+
+  /// Read position in |options_.capture_samples|. Only accessed from the
+  /// processing thread.
+  size_t capture_position_{0};
+
+  /// Scratch buffers for the recorded and played out frames. Only accessed
+  /// from the processing thread.
+  std::vector<int16_t> record_data_;
+  std::vector<int16_t> playout_data_;
+
+  /// Real time, in milliseconds, corresponding to the origin of the virtual
+  /// clock, and number of ticks elapsed since that origin. Only accessed from
+  /// the processing thread.
+  int64_t start_time_ms_{0};
+  int64_t tick_count_{0};
+
+  std::unique_ptr<rtc::Thread> process_thread_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
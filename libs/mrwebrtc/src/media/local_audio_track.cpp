@@ -13,9 +13,11 @@ namespace WebRTC {
 
 LocalAudioTrack::LocalAudioTrack(
     RefPtr<GlobalFactory> global_factory,
-    rtc::scoped_refptr<webrtc::AudioTrackInterface> track) noexcept
+    rtc::scoped_refptr<webrtc::AudioTrackInterface> track,
+    bool first_thread_group_only) noexcept
     : MediaTrack(std::move(global_factory), ObjectType::kLocalAudioTrack),
-      track_(std::move(track)) {
+      track_(std::move(track)),
+      first_thread_group_only_(first_thread_group_only) {
   RTC_CHECK(track_);
   name_ = track_->id();
   kind_ = mrsTrackKind::kAudioTrack;
@@ -41,10 +41,12 @@ class Transceiver;
 /// has no knowledge about how the source produces the frames.
 class LocalAudioTrack : public MediaTrack, public AudioFrameObserver {
  public:
-  /// Constructor for a track not added to any peer connection.
-  LocalAudioTrack(
-      RefPtr<GlobalFactory> global_factory,
-      rtc::scoped_refptr<webrtc::AudioTrackInterface> track) noexcept;
+  /// Constructor for a track not added to any peer connection. If
+  /// |first_thread_group_only| is |true|, the track can only be sent by peer
+  /// connections of the first thread group.
+  LocalAudioTrack(RefPtr<GlobalFactory> global_factory,
+                  rtc::scoped_refptr<webrtc::AudioTrackInterface> track,
+                  bool first_thread_group_only = false) noexcept;
 
   /// Constructor for a track added to a peer connection.
   LocalAudioTrack(
@@ -69,6 +71,14 @@ class LocalAudioTrack : public MediaTrack, public AudioFrameObserver {
     return transceiver_;
   }
 
+  /// Check if the track can only be sent by peer connections of the first
+  /// thread group, because its source is paced by the audio device module of
+  /// that group. This is the case of tracks created from an external audio
+  /// track source.
+  MRS_NODISCARD bool IsFirstThreadGroupOnly() const noexcept {
+    return first_thread_group_only_;
+  }
+
   //
   // Advanced use
   //
@@ -107,6 +117,9 @@ class LocalAudioTrack : public MediaTrack, public AudioFrameObserver {
   /// Weak back-pointer to the Transceiver this track is associated with, if
   /// any. This avoids a circular reference with the transceiver itself.
   Transceiver* transceiver_{nullptr};
+
+  /// See |IsFirstThreadGroupOnly()|.
+  const bool first_thread_group_only_{false};
 };
 
 }  // namespace WebRTC
@@ -13,9 +13,11 @@ namespace WebRTC {
 
 LocalVideoTrack::LocalVideoTrack(
     RefPtr<GlobalFactory> global_factory,
-    rtc::scoped_refptr<webrtc::VideoTrackInterface> track) noexcept
+    rtc::scoped_refptr<webrtc::VideoTrackInterface> track,
+    int32_t thread_group) noexcept
     : MediaTrack(std::move(global_factory), ObjectType::kLocalVideoTrack),
-      track_(std::move(track)) {
+      track_(std::move(track)),
+      thread_group_(thread_group) {
   RTC_CHECK(track_);
   name_ = track_->id();
   kind_ = mrsTrackKind::kVideoTrack;
@@ -35,7 +37,8 @@ LocalVideoTrack::LocalVideoTrack(
                  owner),
       track_(std::move(track)),
       sender_(std::move(sender)),
-      transceiver_(transceiver) {
+      transceiver_(transceiver),
+      thread_group_(owner.thread_group()) {
   RTC_CHECK(owner_);
   RTC_CHECK(transceiver_);
   RTC_CHECK(transceiver_->GetMediaKind() == mrsMediaKind::kVideo);
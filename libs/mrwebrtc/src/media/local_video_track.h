@@ -41,9 +41,11 @@ class Transceiver;
 /// has no knowledge about how the source produces the frames.
 class LocalVideoTrack : public MediaTrack, public VideoFrameObserver {
  public:
-  /// Constructor for a track not added to any peer connection.
+  /// Constructor for a track not added to any peer connection, created by the
+  /// peer connection factory of the given thread group.
   LocalVideoTrack(RefPtr<GlobalFactory> global_factory,
-                  rtc::scoped_refptr<webrtc::VideoTrackInterface> track) noexcept;
+                  rtc::scoped_refptr<webrtc::VideoTrackInterface> track,
+                  int32_t thread_group) noexcept;
 
   /// Constructor for a track added to a peer connection.
   LocalVideoTrack(RefPtr<GlobalFactory> global_factory,
@@ -67,6 +69,9 @@ class LocalVideoTrack : public MediaTrack, public VideoFrameObserver {
     return transceiver_;
   }
 
+  /// Index of the thread group whose threads the track is bound to.
+  MRS_NODISCARD int32_t thread_group() const noexcept { return thread_group_; }
+
   //
   // Advanced use
   //
@@ -105,6 +110,9 @@ class LocalVideoTrack : public MediaTrack, public VideoFrameObserver {
   /// Weak back-pointer to the Transceiver this track is associated with, if
   /// any. This avoids a circular reference with the transceiver itself.
   Transceiver* transceiver_{nullptr};
+
+  /// Index of the thread group whose threads the track is bound to.
+  const int32_t thread_group_;
 };
 
 }  // namespace WebRTC
@@ -24,7 +24,9 @@ RemoteAudioTrack::RemoteAudioTrack(
                  owner),
       track_(std::move(track)),
       receiver_(std::move(receiver)),
-      transceiver_(transceiver) {
+      transceiver_(transceiver),
+      milestones_(owner.milestones()),
+      audio_mixer_(owner.audio_mixer()) {
   RTC_CHECK(owner_);
   RTC_CHECK(track_);
   RTC_CHECK(receiver_);
@@ -49,6 +51,16 @@ webrtc::RtpReceiverInterface* RemoteAudioTrack::receiver() const {
   return receiver_.get();
 }
 
+void RemoteAudioTrack::OnData(const void* audio_data,
+                              int bits_per_sample,
+                              int sample_rate,
+                              size_t number_of_channels,
+                              size_t number_of_frames) noexcept {
+  milestones_->Record(mrsConnectionMilestone::kFirstAudioFrameDecoded);
+  AudioFrameObserver::OnData(audio_data, bits_per_sample, sample_rate,
+                             number_of_channels, number_of_frames);
+}
+
 void RemoteAudioTrack::OnTrackRemoved(PeerConnection& owner) {
   RTC_DCHECK(owner_ == &owner);
   RTC_DCHECK(receiver_ != nullptr);
@@ -62,7 +74,7 @@ void RemoteAudioTrack::OnTrackRemoved(PeerConnection& owner) {
 void RemoteAudioTrack::OutputToDevice(bool output) noexcept {
   output_to_device_ = output;
   if (ssrc_) {
-    global_factory_->audio_mixer()->OutputSource(*ssrc_, output);
+    audio_mixer_->OutputSource(*ssrc_, output);
   }
   // else SSRC is unknown and we can't change the output state now. InitSsrc
   // will do it when called.
@@ -75,7 +87,7 @@ void RemoteAudioTrack::InitSsrc(int ssrc) {
   // Now that we know the SSRC id, we can initialize the output state.
   // Note that the value is true by default but might have been changed
   // if OutputToDevice has been called in the track creation callback.
-  global_factory_->audio_mixer()->OutputSource(ssrc, output_to_device_);
+  audio_mixer_->OutputSource(ssrc, output_to_device_);
 }
 
 std::unique_ptr<AudioTrackReadBuffer> RemoteAudioTrack::CreateReadBuffer() const
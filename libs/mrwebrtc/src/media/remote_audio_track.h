@@ -26,6 +26,7 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+class ConnectionMilestones;
 class PeerConnection;
 class Transceiver;
 
@@ -94,6 +95,14 @@ class RemoteAudioTrack : public MediaTrack, public AudioFrameObserver {
   /// Automatically called - do not use.
   void InitSsrc(int ssrc);
 
+ protected:
+  // AudioFrameObserver interface
+  void OnData(const void* audio_data,
+              int bits_per_sample,
+              int sample_rate,
+              size_t number_of_channels,
+              size_t number_of_frames) noexcept override;
+
  private:
   /// Underlying core implementation.
   rtc::scoped_refptr<webrtc::AudioTrackInterface> track_;
@@ -107,6 +116,14 @@ class RemoteAudioTrack : public MediaTrack, public AudioFrameObserver {
   /// gets destroyed when detached from the transceiver.
   Transceiver* transceiver_{nullptr};
 
+  /// Recorder of the milestones of the owner peer connection, to record the
+  /// first frame decoded.
+  std::shared_ptr<ConnectionMilestones> milestones_;
+
+  /// Audio mixer of the thread group of the owner peer connection, which
+  /// outputs this track to the audio device.
+  rtc::scoped_refptr<ToggleAudioMixer> audio_mixer_;
+
   /// SSRC id of the corresponding RtpReceiver.
   absl::optional<int> ssrc_;
 
@@ -22,7 +22,8 @@ RemoteVideoTrack::RemoteVideoTrack(
                  owner),
       track_(std::move(track)),
       receiver_(std::move(receiver)),
-      transceiver_(transceiver) {
+      transceiver_(transceiver),
+      milestones_(owner.milestones()) {
   RTC_CHECK(owner_);
   RTC_CHECK(track_);
   RTC_CHECK(receiver_);
@@ -57,6 +58,11 @@ webrtc::RtpReceiverInterface* RemoteVideoTrack::receiver() const {
   return receiver_.get();
 }
 
+void RemoteVideoTrack::OnFrame(const webrtc::VideoFrame& frame) noexcept {
+  milestones_->Record(mrsConnectionMilestone::kFirstVideoFrameDecoded);
+  VideoFrameObserver::OnFrame(frame);
+}
+
 void RemoteVideoTrack::OnTrackRemoved(PeerConnection& owner) {
   RTC_DCHECK(owner_ == &owner);
   RTC_DCHECK(receiver_ != nullptr);
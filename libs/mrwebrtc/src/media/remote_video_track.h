@@ -24,6 +24,7 @@ namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
+class ConnectionMilestones;
 class PeerConnection;
 class Transceiver;
 
@@ -78,6 +79,10 @@ class RemoteVideoTrack : public MediaTrack, public VideoFrameObserver {
   // Automatically called - do not use.
   void OnTrackRemoved(PeerConnection& owner);
 
+ protected:
+  // VideoFrameObserver interface
+  void OnFrame(const webrtc::VideoFrame& frame) noexcept override;
+
  private:
   /// Underlying core implementation.
   rtc::scoped_refptr<webrtc::VideoTrackInterface> track_;
@@ -90,6 +95,10 @@ class RemoteVideoTrack : public MediaTrack, public VideoFrameObserver {
   /// Note that unlike local tracks, this is never NULL since the remote track
   /// gets destroyed when detached from the transceiver.
   Transceiver* transceiver_{nullptr};
+
+  /// Recorder of the milestones of the owner peer connection, to record the
+  /// first frame decoded.
+  std::shared_ptr<ConnectionMilestones> milestones_;
 };
 
 }  // namespace WebRTC
@@ -5,6 +5,7 @@
 
 #include "interop/global_factory.h"
 #include "peer_connection.h"
+#include "sdp_utils.h"
 #include "transceiver.h"
 #include "utils.h"
 
@@ -175,6 +176,104 @@ Result Transceiver::SetDirection(Direction new_direction) noexcept {
   return Result::kSuccess;
 }
 
+Result Transceiver::SetAudioSendParameters(
+    const mrsAudioSendParameters& params) noexcept {
+  if (kind_ != MediaKind::kAudio) {
+    return Result::kInvalidMediaKind;
+  }
+  switch (params.frame_duration_ms) {
+    case 0:
+    case 10:
+    case 20:
+    case 40:
+    case 60:
+      break;
+    default:
+      RTC_LOG(LS_ERROR) << "Invalid Opus frame duration "
+                        << params.frame_duration_ms << " ms.";
+      return Result::kInvalidParameter;
+  }
+  if ((params.max_average_bitrate_bps != 0) &&
+      ((params.max_average_bitrate_bps < 6000) ||
+       (params.max_average_bitrate_bps > 510000))) {
+    RTC_LOG(LS_ERROR) << "Invalid Opus maximum average bitrate "
+                      << params.max_average_bitrate_bps << " bps.";
+    return Result::kInvalidParameter;
+  }
+  {
+    std::lock_guard<std::mutex> lock(audio_send_params_mutex_);
+    audio_send_params_ = params;
+  }
+
+  // Apply the bitrate limit to the current encoding without renegotiating.
+  // Other parameters can only be changed by negotiating new format parameters.
+  rtc::scoped_refptr<webrtc::RtpSenderInterface> sender =
+      (transceiver_ ? transceiver_->sender() : plan_b_->rtp_sender_);
+  if (sender) {
+    webrtc::RtpParameters parameters = sender->GetParameters();
+    if (!parameters.encodings.empty()) {
+      for (auto&& encoding : parameters.encodings) {
+        if (params.max_average_bitrate_bps != 0) {
+          encoding.max_bitrate_bps = (int)params.max_average_bitrate_bps;
+        } else {
+          encoding.max_bitrate_bps.reset();
+        }
+      }
+      webrtc::RTCError error = sender->SetParameters(parameters);
+      if (!error.ok()) {
+        RTC_LOG(LS_ERROR) << "Failed to set RTP sender parameters: "
+                          << error.message();
+        return ResultFromRTCErrorType(error.type());
+      }
+    }
+  }
+  return Result::kSuccess;
+}
+
+absl::optional<mrsAudioSendParameters> Transceiver::GetAudioSendParameters()
+    const noexcept {
+  std::lock_guard<std::mutex> lock(audio_send_params_mutex_);
+  return audio_send_params_;
+}
+
+Result Transceiver::SetVideoEncodingParameters(
+    const mrsVideoEncodingParameters* encodings,
+    uint32_t encoding_count) noexcept {
+  if (kind_ != MediaKind::kVideo) {
+    return Result::kInvalidMediaKind;
+  }
+  rtc::scoped_refptr<webrtc::RtpSenderInterface> sender =
+      (transceiver_ ? transceiver_->sender() : plan_b_->rtp_sender_);
+  if (!sender) {
+    RTC_LOG(LS_ERROR) << "Cannot set the encoding parameters of video "
+                         "transceiver "
+                      << GetName() << " without an RTP sender.";
+    return Result::kInvalidOperation;
+  }
+  webrtc::RtpParameters parameters = sender->GetParameters();
+  if (parameters.encodings.size() != encoding_count) {
+    RTC_LOG(LS_ERROR) << "Cannot change the number of encodings of video "
+                         "transceiver "
+                      << GetName() << " from " << parameters.encodings.size()
+                      << " to " << encoding_count << " without renegotiating.";
+    return Result::kInvalidParameter;
+  }
+  for (uint32_t i = 0; i < encoding_count; ++i) {
+    const Result result = ApplyVideoEncodingParameters(
+        encodings[i], parameters.encodings[i], /* apply_rid = */ false);
+    if (result != Result::kSuccess) {
+      return result;
+    }
+  }
+  webrtc::RTCError error = sender->SetParameters(parameters);
+  if (!error.ok()) {
+    RTC_LOG(LS_ERROR) << "Failed to set RTP sender parameters: "
+                      << error.message();
+    return ResultFromRTCErrorType(error.type());
+  }
+  return Result::kSuccess;
+}
+
 bool Transceiver::HasSender(webrtc::RtpSenderInterface* sender) const {
   if (transceiver_) {
     return (transceiver_->sender() == sender);
@@ -191,6 +290,33 @@ bool Transceiver::HasReceiver(webrtc::RtpReceiverInterface* receiver) const {
   }
 }
 
+Result Transceiver::SetLocalTrack(RefPtr<LocalAudioTrack> local_track) noexcept {
+  if (local_track && local_track->IsFirstThreadGroupOnly() &&
+      (owner_->thread_group() != 0)) {
+    RTC_LOG(LS_ERROR) << "Cannot set local audio track "
+                      << local_track->GetName()
+                      << " of an external audio track source on transceiver "
+                      << GetName() << " of a peer connection of thread group #"
+                      << owner_->thread_group()
+                      << ". External audio track sources are paced by the "
+                         "audio device module of thread group #0.";
+    return Result::kInvalidOperation;
+  }
+  return SetLocalTrackImpl(std::move(local_track));
+}
+
+Result Transceiver::SetLocalTrack(RefPtr<LocalVideoTrack> local_track) noexcept {
+  if (local_track && (local_track->thread_group() != owner_->thread_group())) {
+    RTC_LOG(LS_ERROR) << "Cannot set local video track "
+                      << local_track->GetName() << " of thread group #"
+                      << local_track->thread_group() << " on transceiver "
+                      << GetName() << " of a peer connection of thread group #"
+                      << owner_->thread_group() << ".";
+    return Result::kInvalidOperation;
+  }
+  return SetLocalTrackImpl(std::move(local_track));
+}
+
 Result Transceiver::SetLocalTrackImpl(RefPtr<MediaTrack> local_track) noexcept {
   if (local_track_ == local_track) {
     return Result::kSuccess;
@@ -356,6 +482,44 @@ Transceiver::OptDirection Transceiver::OptFromSendRecv(bool send, bool recv) {
   }
 }
 
+Result Transceiver::ApplyVideoEncodingParameters(
+    const mrsVideoEncodingParameters& params,
+    webrtc::RtpEncodingParameters& encoding,
+    bool apply_rid) {
+  if ((params.scale_resolution_down_by != 0.0) &&
+      !(params.scale_resolution_down_by >= 1.0)) {
+    RTC_LOG(LS_ERROR) << "Invalid video encoding resolution scale-down factor "
+                      << params.scale_resolution_down_by << ".";
+    return Result::kInvalidParameter;
+  }
+  if (apply_rid) {
+    const absl::string_view rid = (params.rid ? params.rid : "");
+    if (!rid.empty() && !SdpIsValidToken(rid)) {
+      RTC_LOG(LS_ERROR) << "Invalid video encoding RID '" << params.rid
+                        << "', which is not a valid SDP token.";
+      return Result::kInvalidParameter;
+    }
+    encoding.rid = std::string(rid);
+  }
+  encoding.active = (params.active != mrsBool::kFalse);
+  if (params.scale_resolution_down_by != 0.0) {
+    encoding.scale_resolution_down_by = params.scale_resolution_down_by;
+  } else {
+    encoding.scale_resolution_down_by.reset();
+  }
+  if (params.max_bitrate_bps != 0) {
+    encoding.max_bitrate_bps = (int)params.max_bitrate_bps;
+  } else {
+    encoding.max_bitrate_bps.reset();
+  }
+  if (params.max_framerate != 0) {
+    encoding.max_framerate = (int)params.max_framerate;
+  } else {
+    encoding.max_framerate.reset();
+  }
+  return Result::kSuccess;
+}
+
 std::vector<std::string> Transceiver::DecodeStreamIDs(
     const char* encoded_stream_ids) {
   if (IsStringNullOrEmpty(encoded_stream_ids)) {
@@ -10,6 +10,7 @@
 #include "media/remote_audio_track.h"
 #include "media/remote_video_track.h"
 #include "tracked_object.h"
+#include "transceiver_interop.h"
 
 namespace rtc {
 template <typename T>
@@ -83,6 +84,20 @@ class Transceiver : public TrackedObject {
   /// offers/answers.
   Result SetDirection(Direction new_direction) noexcept;
 
+  /// Set the parameters of the Opus encoder of an audio transceiver. See
+  /// |mrsTransceiverSetAudioSendParameters()| for details.
+  Result SetAudioSendParameters(const mrsAudioSendParameters& params) noexcept;
+
+  /// Get the parameters of the Opus encoder of an audio transceiver, if any
+  /// were set with |SetAudioSendParameters()|.
+  MRS_NODISCARD absl::optional<mrsAudioSendParameters> GetAudioSendParameters()
+      const noexcept;
+
+  /// Change the parameters of the encodings sent by a video transceiver. See
+  /// |mrsTransceiverSetVideoEncodingParameters()| for details.
+  Result SetVideoEncodingParameters(const mrsVideoEncodingParameters* encodings,
+                                    uint32_t encoding_count) noexcept;
+
   MRS_NODISCARD bool IsUnifiedPlan() const {
     RTC_DCHECK(!plan_b_ != !transceiver_);
     return (transceiver_ != nullptr);
@@ -97,13 +112,16 @@ class Transceiver : public TrackedObject {
     return SetLocalTrackImpl(nullptr);
   }
 
-  Result SetLocalTrack(RefPtr<LocalAudioTrack> local_track) noexcept {
-    return SetLocalTrackImpl(std::move(local_track));
-  }
+  /// Set the local audio track sent by the transceiver. If the track can only
+  /// be sent by peer connections of the first thread group and the owner peer
+  /// connection belongs to another group, this returns
+  /// |Result::kInvalidOperation|.
+  Result SetLocalTrack(RefPtr<LocalAudioTrack> local_track) noexcept;
 
-  Result SetLocalTrack(RefPtr<LocalVideoTrack> local_track) noexcept {
-    return SetLocalTrackImpl(std::move(local_track));
-  }
+  /// Set the local video track sent by the transceiver. The track must have
+  /// been created for the thread group of the owner peer connection, otherwise
+  /// this returns |Result::kInvalidOperation|.
+  Result SetLocalTrack(RefPtr<LocalVideoTrack> local_track) noexcept;
 
   RefPtr<LocalAudioTrack> GetLocalAudioTrack() const {
     if (GetMediaKind() != MediaKind::kAudio) {
@@ -239,6 +257,15 @@ class Transceiver : public TrackedObject {
   MRS_NODISCARD static std::string EncodeStreamIDs(
       const std::vector<std::string>& stream_ids);
 
+  /// Validate the interop parameters of a video encoding and apply them to an
+  /// RTP encoding, leaving the fields not exposed by the interop untouched.
+  /// The RID is only applied if |apply_rid| is set, since it cannot be changed
+  /// once the encoding was created.
+  MRS_NODISCARD static Result ApplyVideoEncodingParameters(
+      const mrsVideoEncodingParameters& params,
+      webrtc::RtpEncodingParameters& encoding,
+      bool apply_rid);
+
   /// Build the encoded string used as the (single) stream ID of a Plan B
   /// track, which contains the media line index of the emulated transceiver
   /// as well as a list of stream IDs, to emulate the properties of Unified
@@ -338,6 +365,12 @@ class Transceiver : public TrackedObject {
   StateUpdatedCallback state_updated_callback_ RTC_GUARDED_BY(cb_mutex_);
 
   std::mutex cb_mutex_;
+
+  /// Parameters of the Opus encoder of an audio transceiver, if any.
+  absl::optional<mrsAudioSendParameters> audio_send_params_
+      RTC_GUARDED_BY(audio_send_params_mutex_);
+
+  mutable std::mutex audio_send_params_mutex_;
 };
 
 }  // namespace WebRTC
@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include "media/virtual_audio_device_module.h"
+
+#include "rtc_base/stringutils.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+VirtualAudioDeviceModule::VirtualAudioDeviceModule(const char* device_name,
+                                                   int sample_rate,
+                                                   size_t channel_count)
+    : device_name_(device_name),
+      sample_rate_(sample_rate),
+      channel_count_(channel_count),
+      samples_per_frame_(sample_rate / 100) {}
+
+int32_t VirtualAudioDeviceModule::RegisterAudioCallback(
+    webrtc::AudioTransport* callback) {
+  rtc::CritScope lock(&crit_);
+  audio_callback_ = callback;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::Init() {
+  if (!initialized_.exchange(true)) {
+    RTC_LOG(LS_INFO) << "Initializing " << device_name_ << " (" << sample_rate_
+                     << " Hz, " << channel_count_ << " channels).";
+    OnInitialized();
+  }
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::Terminate() {
+  if (initialized_) {
+    RTC_LOG(LS_INFO) << "Terminating " << device_name_ << ".";
+    playing_ = false;
+    recording_ = false;
+    OnTerminating();
+    initialized_ = false;
+  }
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::Initialized() const {
+  return initialized_;
+}
+
+int32_t VirtualAudioDeviceModule::PlayoutDeviceName(
+    uint16_t index,
+    char name[webrtc::kAdmMaxDeviceNameSize],
+    char guid[webrtc::kAdmMaxGuidSize]) {
+  if (index != 0) {
+    return -1;
+  }
+  rtc::strcpyn(name, webrtc::kAdmMaxDeviceNameSize, device_name_);
+  if (guid) {
+    rtc::strcpyn(guid, webrtc::kAdmMaxGuidSize, device_name_);
+  }
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::RecordingDeviceName(
+    uint16_t index,
+    char name[webrtc::kAdmMaxDeviceNameSize],
+    char guid[webrtc::kAdmMaxGuidSize]) {
+  return PlayoutDeviceName(index, name, guid);
+}
+
+int32_t VirtualAudioDeviceModule::PlayoutIsAvailable(bool* available) {
+  *available = true;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::InitPlayout() {
+  playout_initialized_ = true;
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::PlayoutIsInitialized() const {
+  return playout_initialized_;
+}
+
+int32_t VirtualAudioDeviceModule::RecordingIsAvailable(bool* available) {
+  *available = true;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::InitRecording() {
+  recording_initialized_ = true;
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::RecordingIsInitialized() const {
+  return recording_initialized_;
+}
+
+int32_t VirtualAudioDeviceModule::StartPlayout() {
+  if (!playout_initialized_) {
+    return -1;
+  }
+  playing_ = true;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::StopPlayout() {
+  playing_ = false;
+  playout_initialized_ = false;
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::Playing() const {
+  return playing_;
+}
+
+int32_t VirtualAudioDeviceModule::StartRecording() {
+  if (!recording_initialized_) {
+    return -1;
+  }
+  recording_ = true;
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::StopRecording() {
+  recording_ = false;
+  recording_initialized_ = false;
+  return 0;
+}
+
+bool VirtualAudioDeviceModule::Recording() const {
+  return recording_;
+}
+
+int32_t VirtualAudioDeviceModule::StereoPlayoutIsAvailable(
+    bool* available) const {
+  *available = (channel_count_ == 2);
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::SetStereoPlayout(bool enable) {
+  return (enable == (channel_count_ == 2) ? 0 : -1);
+}
+
+int32_t VirtualAudioDeviceModule::StereoPlayout(bool* enabled) const {
+  *enabled = (channel_count_ == 2);
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::StereoRecordingIsAvailable(
+    bool* available) const {
+  *available = (channel_count_ == 2);
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::SetStereoRecording(bool enable) {
+  return (enable == (channel_count_ == 2) ? 0 : -1);
+}
+
+int32_t VirtualAudioDeviceModule::StereoRecording(bool* enabled) const {
+  *enabled = (channel_count_ == 2);
+  return 0;
+}
+
+int32_t VirtualAudioDeviceModule::PlayoutDelay(uint16_t* delay_ms) const {
+  *delay_ms = 0;
+  return 0;
+}
+
+void VirtualAudioDeviceModule::DeliverRecordedFrame(const int16_t* data) {
+  if (!recording_) {
+    return;
+  }
+  rtc::CritScope lock(&crit_);
+  if (audio_callback_) {
+    uint32_t new_mic_level = 0;
+    audio_callback_->RecordedDataIsAvailable(
+        data, samples_per_frame_, sizeof(int16_t) * channel_count_,
+        channel_count_, (uint32_t)sample_rate_, /* totalDelayMS = */ 0,
+        /* clockDrift = */ 0, /* currentMicLevel = */ 0,
+        /* keyPressed = */ false, new_mic_level);
+  }
+}
+
+void VirtualAudioDeviceModule::PullPlayoutFrame(int16_t* data) {
+  if (playing_) {
+    rtc::CritScope lock(&crit_);
+    if (audio_callback_) {
+      size_t samples_out = 0;
+      int64_t elapsed_time_ms = -1;
+      int64_t ntp_time_ms = -1;
+      audio_callback_->NeedMorePlayData(
+          samples_per_frame_, sizeof(int16_t) * channel_count_, channel_count_,
+          (uint32_t)sample_rate_, data, samples_out, &elapsed_time_ms,
+          &ntp_time_ms);
+      if (samples_out == samples_per_frame_) {
+        return;
+      }
+    }
+  }
+  memset(data, 0, samples_per_frame_ * channel_count_ * sizeof(int16_t));
+}
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+
+#include "modules/audio_device/include/fake_audio_device.h"
+#include "rtc_base/criticalsection.h"
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Base class for audio device modules not backed by any actual audio device,
+/// exposing a single recording device and a single playout device with a fixed
+/// audio format. Derived classes are responsible for driving the audio
+/// transport registered by the audio engine, in 10 ms frames.
+class VirtualAudioDeviceModule : public webrtc::FakeAudioDeviceModule {
+ public:
+  //
+  // AudioDeviceModule
+  //
+
+  int32_t RegisterAudioCallback(webrtc::AudioTransport* callback) override;
+  int32_t Init() override;
+  int32_t Terminate() override;
+  bool Initialized() const override;
+  int16_t PlayoutDevices() override { return 1; }
+  int16_t RecordingDevices() override { return 1; }
+  int32_t PlayoutDeviceName(uint16_t index,
+                            char name[webrtc::kAdmMaxDeviceNameSize],
+                            char guid[webrtc::kAdmMaxGuidSize]) override;
+  int32_t RecordingDeviceName(uint16_t index,
+                              char name[webrtc::kAdmMaxDeviceNameSize],
+                              char guid[webrtc::kAdmMaxGuidSize]) override;
+  int32_t PlayoutIsAvailable(bool* available) override;
+  int32_t InitPlayout() override;
+  bool PlayoutIsInitialized() const override;
+  int32_t RecordingIsAvailable(bool* available) override;
+  int32_t InitRecording() override;
+  bool RecordingIsInitialized() const override;
+  int32_t StartPlayout() override;
+  int32_t StopPlayout() override;
+  bool Playing() const override;
+  int32_t StartRecording() override;
+  int32_t StopRecording() override;
+  bool Recording() const override;
+  int32_t StereoPlayoutIsAvailable(bool* available) const override;
+  int32_t SetStereoPlayout(bool enable) override;
+  int32_t StereoPlayout(bool* enabled) const override;
+  int32_t StereoRecordingIsAvailable(bool* available) const override;
+  int32_t SetStereoRecording(bool enable) override;
+  int32_t StereoRecording(bool* enabled) const override;
+  int32_t PlayoutDelay(uint16_t* delay_ms) const override;
+
+ protected:
+  VirtualAudioDeviceModule(const char* device_name,
+                           int sample_rate,
+                           size_t channel_count);
+
+  /// Called by |Init()| when the module becomes initialized.
+  virtual void OnInitialized() {}
+
+  /// Called by |Terminate()| before the module stops being initialized.
+  virtual void OnTerminating() {}
+
+  /// Deliver a 10 ms frame of recorded audio to the audio transport, if
+  /// recording. |data| contains |samples_per_frame_| interleaved samples for
+  /// each channel.
+  void DeliverRecordedFrame(const int16_t* data);
+
+  /// Pull a 10 ms frame of audio to play out from the audio transport into
+  /// |data|, if playing, or fill |data| with silence otherwise.
+  void PullPlayoutFrame(int16_t* data);
+
+  const char* const device_name_;
+  const int sample_rate_;
+  const size_t channel_count_;
+
+  /// Number of samples per channel in a 10 ms frame.
+  const size_t samples_per_frame_;
+
+  std::atomic_bool initialized_{false};
+  std::atomic_bool playout_initialized_{false};
+  std::atomic_bool recording_initialized_{false};
+  std::atomic_bool playing_{false};
+  std::atomic_bool recording_{false};
+
+ private:
+  rtc::CriticalSection crit_;
+  webrtc::AudioTransport* audio_callback_ RTC_GUARDED_BY(crit_) = nullptr;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
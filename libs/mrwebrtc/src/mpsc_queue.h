@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace Microsoft {
+namespace MixedReality {
+namespace WebRTC {
+
+/// Unbounded lock-free multi-producer single-consumer intrusive queue.
+///
+/// Producers push heap-allocated nodes without blocking, and the single
+/// consumer pops them in push order, taking ownership of them. This is the
+/// intrusive MPSC queue design by Dmitry Vyukov, with a stub node: pushing is a
+/// single atomic exchange, and popping never blocks, though it can transiently
+/// report the queue as empty while a producer is in the middle of a push.
+template <typename T>
+class MpscQueue {
+ public:
+  struct NodeBase {
+    std::atomic<NodeBase*> next{nullptr};
+  };
+
+  /// Node holding a queued value.
+  struct Node : NodeBase {
+    template <typename... Args>
+    explicit Node(Args&&... args) : value(std::forward<Args>(args)...) {}
+    T value;
+  };
+
+  MpscQueue() noexcept : head_(&stub_), tail_(&stub_) {}
+
+  ~MpscQueue() noexcept {
+    while (Node* node = Pop()) {
+      delete node;
+    }
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  /// Push a node at the back of the queue, transferring its ownership to the
+  /// queue. Can be called concurrently from any number of threads.
+  void Push(Node* node) noexcept { PushBase(node); }
+
+  /// Pop the node at the front of the queue, transferring its ownership to
+  /// the caller, or return |nullptr| if the queue is empty. Must only be
+  /// called from a single thread at a time.
+  Node* Pop() noexcept {
+    NodeBase* tail = tail_;
+    NodeBase* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+      tail_ = next;
+      return static_cast<Node*>(tail);
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // A producer exchanged the head but did not link it yet.
+      return nullptr;
+    }
+    // Push the stub back to be able to pop the last node.
+    PushBase(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return static_cast<Node*>(tail);
+    }
+    return nullptr;
+  }
+
+ private:
+  void PushBase(NodeBase* node) noexcept {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    NodeBase* const prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  /// Last node pushed, exchanged by producers.
+  std::atomic<NodeBase*> head_;
+
+  /// Next node to pop, only accessed by the consumer.
+  NodeBase* tail_;
+
+  NodeBase stub_;
+};
+
+}  // namespace WebRTC
+}  // namespace MixedReality
+}  // namespace Microsoft
@@ -21,6 +21,8 @@
 
 #include <functional>
 
+#include "pc/sessiondescription.h"
+
 // Include implementation because we cannot access the mline index from the
 // RtpTransceiverInterface. This is a not-so-clean workaround.
 // See PeerConnection::ExtractMlineIndexFromRtpTransceiver() for details.
@@ -278,6 +280,16 @@ webrtc::PeerConnectionInterface::BundlePolicy BundlePolicyToNative(
   return static_cast<Native>(value);
 }
 
+webrtc::PeerConnectionInterface::ContinualGatheringPolicy
+ContinualGatheringPolicyToNative(mrsContinualGatheringPolicy value) {
+  using Native = webrtc::PeerConnectionInterface::ContinualGatheringPolicy;
+  using Impl = mrsContinualGatheringPolicy;
+  static_assert((int)Native::GATHER_ONCE == (int)Impl::kGatherOnce, "");
+  static_assert(
+      (int)Native::GATHER_CONTINUALLY == (int)Impl::kGatherContinually, "");
+  return static_cast<Native>(value);
+}
+
 }  // namespace
 
 namespace Microsoft {
@@ -288,10 +300,27 @@ ErrorOr<std::shared_ptr<DataChannel>> PeerConnection::AddDataChannel(
     int id,
     absl::string_view label,
     bool ordered,
-    bool reliable) noexcept {
+    bool reliable,
+    int max_retransmits,
+    int max_packet_life_time_ms) noexcept {
   if (IsClosed()) {
     return Error(Result::kPeerConnectionClosed);
   }
+  if ((max_retransmits < -1) || (max_packet_life_time_ms < -1)) {
+    return Error(Result::kOutOfRange);
+  }
+  const bool partially_reliable =
+      ((max_retransmits >= 0) || (max_packet_life_time_ms >= 0));
+  if (partially_reliable && reliable) {
+    RTC_LOG(LS_ERROR) << "Data channel cannot be both reliable and have a "
+                         "retransmit limit.";
+    return Error(Result::kInvalidParameter);
+  }
+  if ((max_retransmits >= 0) && (max_packet_life_time_ms >= 0)) {
+    RTC_LOG(LS_ERROR) << "Data channel cannot have both a maximum number of "
+                         "retransmits and a maximum packet lifetime.";
+    return Error(Result::kInvalidParameter);
+  }
   if (!sctp_negotiated_) {
     // Don't try to create a data channel without SCTP negotiation, it will get
     // stuck in the kConnecting state forever.
@@ -300,6 +329,8 @@ ErrorOr<std::shared_ptr<DataChannel>> PeerConnection::AddDataChannel(
   webrtc::DataChannelInit config{};
   config.ordered = ordered;
   config.reliable = reliable;
+  config.maxRetransmits = max_retransmits;
+  config.maxRetransmitTime = max_packet_life_time_ms;
   if (id < 0) {
     // In-band data channel with automatic ID assignment
     config.id = -1;
@@ -316,7 +347,8 @@ ErrorOr<std::shared_ptr<DataChannel>> PeerConnection::AddDataChannel(
   if (rtc::scoped_refptr<webrtc::DataChannelInterface> impl =
           peer_->CreateDataChannel(labelString, &config)) {
     // Create the native object
-    auto data_channel = std::make_shared<DataChannel>(this, std::move(impl));
+    auto data_channel = std::make_shared<DataChannel>(
+        this, global_factory_->GetSignalingThread(), std::move(impl));
     {
       std::lock_guard<std::mutex> lock(data_channel_mutex_);
       data_channels_.push_back(data_channel);
@@ -388,13 +420,9 @@ void PeerConnection::RemoveDataChannel(
   impl->Close();
 
   // Invoke the DataChannelRemoved callback
-  {
-    std::lock_guard<std::mutex> lock(data_channel_removed_callback_mutex_);
-    auto removed_cb = data_channel_removed_callback_;
-    if (removed_cb) {
-      mrsDataChannelHandle data_native_handle = (void*)&data_channel;
-      removed_cb(data_native_handle);
-    }
+  if (auto removed_cb = data_channel_removed_callback_.Load()) {
+    mrsDataChannelHandle data_native_handle = (void*)&data_channel;
+    removed_cb(data_native_handle);
   }
 
   // Clear the back pointer to the peer connection, and let the shared pointer
@@ -403,8 +431,7 @@ void PeerConnection::RemoveDataChannel(
 }
 
 void PeerConnection::RemoveAllDataChannels() noexcept {
-  std::lock_guard<std::mutex> lock_cb(data_channel_removed_callback_mutex_);
-  auto removed_cb = data_channel_removed_callback_;
+  auto removed_cb = data_channel_removed_callback_.Load();
   std::lock_guard<std::mutex> lock(data_channel_mutex_);
   for (auto&& data_channel : data_channels_) {
     // Close the WebRTC data channel
@@ -443,25 +470,21 @@ void PeerConnection::OnDataChannelAdded(
 #endif  // RTC_DCHECK_IS_ON
 
   // Invoke the DataChannelAdded callback
-  {
-    std::lock_guard<std::mutex> lock(data_channel_added_callback_mutex_);
-    auto added_cb = data_channel_added_callback_;
-    if (added_cb) {
-      mrsDataChannelAddedInfo info{};
-      info.handle = (void*)&data_channel;
-      info.id = data_channel.id();
-      info.flags = data_channel.flags();
-      std::string label_str = data_channel.label();  // keep alive
-      info.label = label_str.c_str();
-      added_cb(&info);
-
-      // The user assumes an initial state of kConnecting; if this has already
-      // changed, fire the event to notify any callback that has been
-      // registered.
-      if (data_channel.impl()->state() !=
-          webrtc::DataChannelInterface::kConnecting) {
-        data_channel.InvokeOnStateChange();
-      }
+  if (auto added_cb = data_channel_added_callback_.Load()) {
+    mrsDataChannelAddedInfo info{};
+    info.handle = (void*)&data_channel;
+    info.id = data_channel.id();
+    info.flags = data_channel.flags();
+    std::string label_str = data_channel.label();  // keep alive
+    info.label = label_str.c_str();
+    added_cb(&info);
+
+    // The user assumes an initial state of kConnecting; if this has already
+    // changed, fire the event to notify any callback that has been
+    // registered.
+    if (data_channel.impl()->state() !=
+        webrtc::DataChannelInterface::kConnecting) {
+      data_channel.InvokeOnStateChange();
     }
   }
 }
@@ -500,10 +523,144 @@ Error PeerConnection::AddIceCandidate(
   return Error(Result::kSuccess);
 }
 
+Result PeerConnection::AddIceCandidates(const mrsIceCandidate* candidates,
+                                        uint32_t count,
+                                        mrsResult* results) noexcept {
+  if (!peer_) {
+    return Result::kInvalidOperation;
+  }
+  std::vector<mrsResult> local_results;
+  if (!results) {
+    local_results.resize(count);
+    results = local_results.data();
+  }
+
+  // Parse all candidates on the caller thread, to only block the signaling
+  // thread for the time needed to apply them.
+  std::vector<std::unique_ptr<webrtc::IceCandidateInterface>> ice_candidates(
+      count);
+  for (uint32_t i = 0; i < count; ++i) {
+    const mrsIceCandidate& candidate = candidates[i];
+    results[i] = Result::kInvalidParameter;
+    if (IsStringNullOrEmpty(candidate.sdp_mid) ||
+        IsStringNullOrEmpty(candidate.content) ||
+        (candidate.sdp_mline_index < 0)) {
+      continue;
+    }
+    webrtc::SdpParseError error;
+    ice_candidates[i].reset(
+        webrtc::CreateIceCandidate(candidate.sdp_mid, candidate.sdp_mline_index,
+                                   candidate.content, &error));
+    if (!ice_candidates[i]) {
+      RTC_LOG(LS_ERROR) << "Invalid ICE candidate #" << i << ": "
+                        << error.description;
+    }
+  }
+
+  // Apply the batch in a single dispatch; the proxied calls to the peer
+  // connection are direct once on the signaling thread.
+  global_factory_->GetSignalingThread()->Invoke<void>(RTC_FROM_HERE, [&]() {
+    for (uint32_t i = 0; i < count; ++i) {
+      if (ice_candidates[i]) {
+        results[i] = (peer_->AddIceCandidate(ice_candidates[i].get())
+                          ? Result::kSuccess
+                          : Result::kUnknownError);
+      }
+    }
+  });
+
+  for (uint32_t i = 0; i < count; ++i) {
+    if (results[i] != Result::kSuccess) {
+      return results[i];
+    }
+  }
+  return Result::kSuccess;
+}
+
+Result PeerConnection::RegisterIceCandidatesReadytoSendCallback(
+    const mrsIceCandidateBatchConfig& config,
+    IceCandidateBatcher::BatchCallback callback) noexcept {
+  if (config.max_count == 0) {
+    return Result::kInvalidParameter;
+  }
+  if (!peer_) {
+    return Result::kInvalidOperation;
+  }
+  rtc::Thread* const signaling_thread = global_factory_->GetSignalingThread();
+  signaling_thread->Invoke<void>(RTC_FROM_HERE, [&]() {
+    if (!ice_candidate_batcher_) {
+      if (!callback) {
+        return;
+      }
+      ice_candidate_batcher_ =
+          std::make_unique<IceCandidateBatcher>(signaling_thread);
+    }
+    ice_candidate_batcher_->Configure(config, callback);
+  });
+  return Result::kSuccess;
+}
+
+Result PeerConnection::Prewarm(int32_t pool_size) noexcept {
+  if (pool_size <= 0) {
+    return Result::kInvalidParameter;
+  }
+  if (!peer_) {
+    return Result::kInvalidOperation;
+  }
+  // The pool is only used by the first local description, and WebRTC rejects
+  // changes to its size afterward.
+  if (peer_->local_description() != nullptr) {
+    RTC_LOG(LS_ERROR) << "Cannot pre-warm a peer connection after a local "
+                         "description was applied.";
+    return Result::kInvalidOperation;
+  }
+  webrtc::PeerConnectionInterface::RTCConfiguration config =
+      peer_->GetConfiguration();
+  if (config.ice_candidate_pool_size >= pool_size) {
+    return Result::kSuccess;
+  }
+  // Growing the pool immediately starts gathering the new candidate sets on
+  // the network thread.
+  config.ice_candidate_pool_size = pool_size;
+  webrtc::RTCError error;
+  if (!peer_->SetConfiguration(config, &error)) {
+    RTC_LOG(LS_ERROR) << "Failed to grow the ICE candidate pool: "
+                      << error.message();
+    return (error.type() == webrtc::RTCErrorType::INVALID_MODIFICATION
+                ? Result::kInvalidOperation
+                : ResultFromRTCErrorType(error.type()));
+  }
+  return Result::kSuccess;
+}
+
+Result PeerConnection::RegisterBandwidthEstimateCallback(
+    uint32_t interval_ms,
+    BandwidthEstimateMonitor::EstimateCallback callback) noexcept {
+  if (!bandwidth_monitor_) {
+    return Result::kInvalidOperation;
+  }
+  // The monitor is stopped by |Close()| on the signaling thread, so this is
+  // serialized with closing the connection.
+  const bool configured = global_factory_->GetSignalingThread()->Invoke<bool>(
+      RTC_FROM_HERE,
+      [&]() { return bandwidth_monitor_->Configure(interval_ms, callback); });
+  return (configured ? Result::kSuccess : Result::kInvalidOperation);
+}
+
+Result PeerConnection::GetBandwidthEstimate(
+    mrsBandwidthEstimate& estimate) const noexcept {
+  if (!bandwidth_monitor_) {
+    return Result::kInvalidOperation;
+  }
+  return (bandwidth_monitor_->GetLatest(estimate) ? Result::kSuccess
+                                                  : Result::kNotFound);
+}
+
 bool PeerConnection::CreateOffer() noexcept {
   if (!peer_) {
     return false;
   }
+  milestones_->Record(mrsConnectionMilestone::kCreateOfferStarted);
   {
     std::lock_guard<std::mutex> lock(data_channel_mutex_);
     if (data_channels_.empty()) {
@@ -522,7 +679,7 @@ bool PeerConnection::CreateOffer() noexcept {
     offer_options.offer_to_receive_audio = false;
     offer_options.offer_to_receive_video = false;
     int mline_index = 0;
-    for (auto&& tr : transceivers_) {
+    for (auto&& tr : *GetTransceiversSnapshot()) {
       std::string encoded_stream_id =
           tr->BuildEncodedStreamIDForPlanB(mline_index);
       const char* media_kind_str = nullptr;
@@ -561,6 +718,7 @@ bool PeerConnection::CreateAnswer() noexcept {
   if (!peer_) {
     return false;
   }
+  milestones_->Record(mrsConnectionMilestone::kCreateAnswerStarted);
   webrtc::PeerConnectionInterface::RTCOfferAnswerOptions options{};
   auto observer =
       new rtc::RefCountedObject<CreateSessionDescObserver>(this);  // 0 ref
@@ -577,6 +735,18 @@ void PeerConnection::Close() noexcept {
   // Close the connection
   peer_->Close();
 
+  // Destroy the ICE candidate batcher and stop the bandwidth estimate monitor
+  // on the signaling thread where their timers run, dropping any pending
+  // candidate or stats request. The monitor itself is kept alive until the
+  // connection is destroyed, since its latest sample can be read concurrently
+  // from any thread.
+  global_factory_->GetSignalingThread()->Invoke<void>(RTC_FROM_HERE, [this]() {
+    ice_candidate_batcher_.reset();
+    if (bandwidth_monitor_) {
+      bandwidth_monitor_->Stop();
+    }
+  });
+
   // At this point no callbacks should be called anymore, so it's safe to reset
   // the transceiver/track data.
 
@@ -585,9 +755,8 @@ void PeerConnection::Close() noexcept {
 
     // Force-remove remote tracks. It doesn't look like the TrackRemoved
     // callback is called when Close() is used, so force it here.
-    std::lock_guard<std::mutex> cb_lock{media_track_callback_mutex_};
-    auto audio_cb = audio_track_removed_callback_;
-    auto video_cb = video_track_removed_callback_;
+    auto audio_cb = audio_track_removed_callback_.Load();
+    auto video_cb = video_track_removed_callback_.Load();
     for (auto&& transceiver : transceivers_) {
       if (auto remote_track = transceiver->GetRemoteTrack()) {
         if (remote_track->GetKind() == mrsTrackKind::kAudioTrack) {
@@ -611,6 +780,9 @@ void PeerConnection::Close() noexcept {
     // Clear and destroy transceivers (unless some implementation somewhere has
     // a reference, which should not happen).
     transceivers_.clear();
+    transceivers_by_rtp_.clear();
+    transceivers_by_receiver_.clear();
+    transceivers_snapshot_ = nullptr;
   }
 
   remote_streams_.clear();
@@ -648,11 +820,57 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
   }
   std::vector<std::string> stream_ids =
       Transceiver::DecodeStreamIDs(config.stream_ids);
+  std::vector<webrtc::RtpEncodingParameters> send_encodings;
+  if (config.send_encoding_count > 0) {
+    if (!config.send_encodings) {
+      return Error(Result::kInvalidParameter, "Invalid null send encodings.");
+    }
+    if (config.media_kind != mrsMediaKind::kVideo) {
+      return Error(Result::kInvalidMediaKind,
+                   "Send encodings can only be set on video transceivers.");
+    }
+    send_encodings.resize(config.send_encoding_count);
+    for (uint32_t i = 0; i < config.send_encoding_count; ++i) {
+      const Result result = Transceiver::ApplyVideoEncodingParameters(
+          config.send_encodings[i], send_encodings[i], /* apply_rid = */ true);
+      if (result != Result::kSuccess) {
+        return Error(result, "Invalid send encoding parameters.");
+      }
+    }
+    // Simulcast encodings are identified by their RID in the SDP.
+    if (send_encodings.size() > 1) {
+      for (size_t i = 0; i < send_encodings.size(); ++i) {
+        if (send_encodings[i].rid.empty()) {
+          return Error(Result::kInvalidParameter,
+                       "Simulcast send encodings require a RID.");
+        }
+        for (size_t j = 0; j < i; ++j) {
+          if (send_encodings[j].rid == send_encodings[i].rid) {
+            rtc::StringBuilder str("Duplicate send encoding RID: ");
+            str << send_encodings[i].rid;
+            return Error(Result::kInvalidParameter, str.Release());
+          }
+        }
+      }
+      // WebRTC M71 cannot negotiate RIDs (a=rid and a=simulcast lines), so it
+      // has no way to send more than one encoding per media line.
+      return Error(Result::kUnsupported,
+                   "Simulcast is not supported by this WebRTC version.");
+    }
+  }
 
   RefPtr<Transceiver> transceiver;
+  rtc::scoped_refptr<webrtc::RtpTransceiverInterface> rtp_transceiver;
+  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver;
   const int mline_index = -1;  // just created, so not associated yet
   switch (peer_->GetConfiguration().sdp_semantics) {
     case webrtc::SdpSemantics::kPlanB: {
+      // Plan B doesn't have transceivers, and its senders are only created
+      // once a track is attached, so encodings cannot be set on creation.
+      if (!send_encodings.empty()) {
+        return Error(Result::kUnsupported,
+                     "Send encodings cannot be set on creation with Plan B.");
+      }
       // Plan B doesn't have transceivers; just create a wrapper.
       transceiver = Transceiver::CreateForPlanB(
           global_factory_, config.media_kind, *this, mline_index, name,
@@ -666,6 +884,7 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
       webrtc::RtpTransceiverInit init{};
       init.direction = Transceiver::ToRtp(config.desired_direction);
       init.stream_ids = stream_ids;
+      init.send_encodings = std::move(send_encodings);
       const cricket::MediaType rtc_media_type =
           MediaKindToRtc(config.media_kind);
       webrtc::RTCErrorOr<rtc::scoped_refptr<webrtc::RtpTransceiverInterface>>
@@ -673,35 +892,30 @@ ErrorOr<Transceiver*> PeerConnection::AddTransceiver(
       if (!ret.ok()) {
         return ErrorFromRTCError(ret.MoveError());
       }
-      rtc::scoped_refptr<webrtc::RtpTransceiverInterface> impl(ret.MoveValue());
+      rtp_transceiver = ret.MoveValue();
+      receiver = rtp_transceiver->receiver();
 
       // Create the transceiver wrapper
       transceiver = Transceiver::CreateForUnifiedPlan(
           global_factory_, config.media_kind, *this, mline_index, name,
-          std::move(stream_ids), std::move(impl), config.desired_direction);
+          std::move(stream_ids), rtp_transceiver, config.desired_direction);
     } break;
     default:
       return Error(Result::kUnknownError, "Unknown SDP semantic.");
   }
   RTC_DCHECK(transceiver);
-  {
-    rtc::CritScope lock(&transceivers_mutex_);
-    transceivers_.push_back(transceiver);
-  }
+  InsertTransceiver(transceiver, rtp_transceiver.get(), receiver.get());
 
   // Invoke the TransceiverAdded callback
-  {
-    std::lock_guard<std::mutex> lock(callbacks_mutex_);
-    if (auto cb = transceiver_added_callback_) {
-      mrsTransceiverAddedInfo info{};
-      info.transceiver_handle = transceiver.get();
-      info.transceiver_name = name.c_str();
-      info.media_kind = config.media_kind;
-      info.mline_index = mline_index;
-      info.encoded_stream_ids_ = config.stream_ids;
-      info.desired_direction = config.desired_direction;
-      cb(&info);
-    }
+  if (auto cb = transceiver_added_callback_.Load()) {
+    mrsTransceiverAddedInfo info{};
+    info.transceiver_handle = transceiver.get();
+    info.transceiver_name = name.c_str();
+    info.media_kind = config.media_kind;
+    info.mline_index = mline_index;
+    info.encoded_stream_ids_ = config.stream_ids;
+    info.desired_direction = config.desired_direction;
+    cb(&info);
   }
 
   return transceiver.get();
@@ -728,10 +942,13 @@ Error PeerConnection::SetRemoteDescriptionAsync(
   if (!session_description) {
     return Error(mrsResult::kInvalidParameter, error.description.c_str());
   }
+  ApplyAudioSendParameters(*session_description);
   rtc::scoped_refptr<webrtc::SetRemoteDescriptionObserverInterface> observer =
       new rtc::RefCountedObject<SetRemoteSessionDescObserver>(
           [this, callback](mrsResult result, const char* error_message) {
             if (result == Result::kSuccess) {
+              milestones_->Record(
+                  mrsConnectionMilestone::kRemoteDescriptionApplied);
               if (IsUnifiedPlan()) {
                 SynchronizeTransceiversUnifiedPlan(/*remote=*/true);
               } else {
@@ -744,7 +961,7 @@ Error PeerConnection::SetRemoteDescriptionAsync(
                 // TODO - Clarify if this is really needed (and if we really
                 // need to force the update) for parity with Unified Plan and to
                 // get the transceiver update event fired once and once only.
-                for (auto&& tr : transceivers_) {
+                for (auto&& tr : *GetTransceiversSnapshot()) {
                   tr->OnSessionDescUpdated(/*remote=*/true, /*forced=*/true);
                 }
               }
@@ -766,10 +983,7 @@ void PeerConnection::OnSignalingChange(
       // Otherwise the only possible way to be in the stable state is at start,
       // but this callback would not be invoked then because there's no
       // transition.
-      {
-        std::lock_guard<std::mutex> lock(connected_callback_mutex_);
-        connected_callback_();
-      }
+      connected_callback_();
       break;
     case webrtc::PeerConnectionInterface::kHaveLocalOffer:
       break;
@@ -835,7 +1049,8 @@ void PeerConnection::OnDataChannel(
   }
 
   // Create a new native object
-  auto data_channel = std::make_shared<DataChannel>(this, impl);
+  auto data_channel = std::make_shared<DataChannel>(
+      this, global_factory_->GetSignalingThread(), impl);
   {
     std::lock_guard<std::mutex> lock(data_channel_mutex_);
     data_channels_.push_back(data_channel);
@@ -852,51 +1067,56 @@ void PeerConnection::OnDataChannel(
   }
 
   // Invoke the DataChannelAdded callback
-  {
-    std::lock_guard<std::mutex> lock(data_channel_added_callback_mutex_);
-    auto added_cb = data_channel_added_callback_;
-    if (added_cb) {
-      mrsDataChannelAddedInfo info{};
-      info.handle = data_channel.get();
-      info.id = config.id;
-      info.flags = config.flags;
-      info.label = config.label;
-      added_cb(&info);
-    }
+  if (auto added_cb = data_channel_added_callback_.Load()) {
+    mrsDataChannelAddedInfo info{};
+    info.handle = data_channel.get();
+    info.id = config.id;
+    info.flags = config.flags;
+    info.label = config.label;
+    added_cb(&info);
   }
 }
 
 void PeerConnection::OnRenegotiationNeeded() noexcept {
-  std::lock_guard<std::mutex> lock(renegotiation_needed_callback_mutex_);
-  auto cb = renegotiation_needed_callback_;
-  if (cb) {
-    cb();
-  }
+  renegotiation_needed_callback_();
 }
 
 void PeerConnection::OnIceConnectionChange(
     webrtc::PeerConnectionInterface::IceConnectionState new_state) noexcept {
-  std::lock_guard<std::mutex> lock(ice_state_changed_callback_mutex_);
-  auto cb = ice_state_changed_callback_;
-  if (cb) {
-    cb(IceStateFromImpl(new_state));
+  switch (new_state) {
+    case webrtc::PeerConnectionInterface::kIceConnectionChecking:
+      milestones_->Record(mrsConnectionMilestone::kIceChecking);
+      break;
+    case webrtc::PeerConnectionInterface::kIceConnectionConnected:
+    case webrtc::PeerConnectionInterface::kIceConnectionCompleted:
+      milestones_->Record(mrsConnectionMilestone::kIceConnected);
+      break;
+    default:
+      break;
   }
+  ice_state_changed_callback_(IceStateFromImpl(new_state));
 }
 
 void PeerConnection::OnIceGatheringChange(
     webrtc::PeerConnectionInterface::IceGatheringState new_state) noexcept {
-  std::lock_guard<std::mutex> lock(ice_gathering_state_changed_callback_mutex_);
-  auto cb = ice_gathering_state_changed_callback_;
-  if (cb) {
-    cb(IceGatheringStateFromImpl(new_state));
+  if (new_state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+    milestones_->Record(mrsConnectionMilestone::kIceGatheringCompleted);
+    // Deliver the last candidates without waiting for the batch delay.
+    if (ice_candidate_batcher_) {
+      ice_candidate_batcher_->Flush();
+    }
   }
+  ice_gathering_state_changed_callback_(IceGatheringStateFromImpl(new_state));
 }
 
 void PeerConnection::OnIceCandidate(
     const webrtc::IceCandidateInterface* candidate) noexcept {
-  std::lock_guard<std::mutex> lock(ice_candidate_ready_to_send_callback_mutex_);
-  auto cb = ice_candidate_ready_to_send_callback_;
-  if (cb) {
+  milestones_->Record(mrsConnectionMilestone::kFirstIceCandidateGathered);
+  milestones_->RecordLatest(mrsConnectionMilestone::kLastIceCandidateGathered);
+  if (ice_candidate_batcher_) {
+    ice_candidate_batcher_->Add(*candidate);
+  }
+  if (auto cb = ice_candidate_ready_to_send_callback_.Load()) {
     std::string sdp;
     if (!candidate->ToString(&sdp)) {
       RTC_LOG(LS_ERROR) << "Failed to stringify ICE candidate into SDP format.";
@@ -921,13 +1141,14 @@ void PeerConnection::OnAddTrack(
     RTC_LOG(LS_INFO) << "+ Track #" << receiver->track()->id()
                      << " with stream #" << stream->id();
   }
+  receiver->SetObserver(milestones_.get());
   rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track =
       receiver->track();
   const std::string& track_kind_str = track->kind();
   if (track_kind_str == webrtc::MediaStreamTrackInterface::kAudioKind) {
     RefPtr<RemoteAudioTrack> track_wrapper =
         AddRemoteMediaTrack<mrsMediaKind::kAudio>(
-            std::move(track), receiver.get(), &audio_track_added_callback_);
+            std::move(track), receiver.get(), audio_track_added_callback_);
     if (audio_mixer_) {
       // The track won't be output by the mixer until OutputSource is called.
       // We need to get the ssrc of the receiver in order to match the track to
@@ -957,7 +1178,7 @@ void PeerConnection::OnAddTrack(
     }
   } else if (track_kind_str == webrtc::MediaStreamTrackInterface::kVideoKind) {
     AddRemoteMediaTrack<mrsMediaKind::kVideo>(std::move(track), receiver.get(),
-                                              &video_track_added_callback_);
+                                              video_track_added_callback_);
   }
 }
 
@@ -1002,18 +1223,20 @@ void PeerConnection::OnRemoveTrack(
   const std::string& track_kind_str = track->kind();
   if (track_kind_str == webrtc::MediaStreamTrackInterface::kAudioKind) {
     RemoveRemoteMediaTrack<mrsMediaKind::kAudio>(
-        receiver.get(), &audio_track_removed_callback_);
+        receiver.get(), audio_track_removed_callback_);
   } else if (track_kind_str == webrtc::MediaStreamTrackInterface::kVideoKind) {
     RemoveRemoteMediaTrack<mrsMediaKind::kVideo>(
-        receiver.get(), &video_track_removed_callback_);
+        receiver.get(), video_track_removed_callback_);
   }
 }
 
 void PeerConnection::OnLocalDescCreated(
     webrtc::SessionDescriptionInterface* desc) noexcept {
   RTC_DCHECK(peer_);
+  milestones_->Record(mrsConnectionMilestone::kLocalDescriptionCreated);
   rtc::scoped_refptr<webrtc::SetSessionDescriptionObserver> observer =
       new rtc::RefCountedObject<SessionDescObserver>([this] {
+        milestones_->Record(mrsConnectionMilestone::kLocalDescriptionApplied);
         if (IsUnifiedPlan()) {
           SynchronizeTransceiversUnifiedPlan(/*remote=*/false);
         } else {
@@ -1024,15 +1247,12 @@ void PeerConnection::OnLocalDescCreated(
         }
 
         // Fire interop callback, if any
-        {
-          std::lock_guard<std::mutex> lock(local_sdp_ready_to_send_callback_mutex_);
-          if (auto cb = local_sdp_ready_to_send_callback_) {
-            auto desc = peer_->local_description();
-            const mrsSdpMessageType type = ApiTypeFromSdpType(desc->GetType());
-            std::string sdp;
-            desc->ToString(&sdp);
-            cb(type, sdp.c_str());
-          }
+        if (auto cb = local_sdp_ready_to_send_callback_.Load()) {
+          auto desc = peer_->local_description();
+          const mrsSdpMessageType type = ApiTypeFromSdpType(desc->GetType());
+          std::string sdp;
+          desc->ToString(&sdp);
+          cb(type, sdp.c_str());
         }
       });
   // SetLocalDescription will invoke observer.OnSuccess() once done, which
@@ -1045,16 +1265,51 @@ RefPtr<Transceiver> PeerConnection::FindWrapperFromRtpTransceiver(
     webrtc::RtpTransceiverInterface* rtp_tr) const {
   RTC_DCHECK(rtp_tr);
   rtc::CritScope lock(&transceivers_mutex_);
-  auto it = std::find_if(transceivers_.begin(), transceivers_.end(),
-                         [&rtp_tr](const RefPtr<Transceiver>& tr) {
-                           return (tr->impl() == rtp_tr);
-                         });
-  if (it != transceivers_.end()) {
-    return *it;
+  auto it = transceivers_by_rtp_.find(rtp_tr);
+  if (it != transceivers_by_rtp_.end()) {
+    return it->second;
+  }
+  return nullptr;
+}
+
+RefPtr<Transceiver> PeerConnection::FindWrapperFromRtpReceiver(
+    webrtc::RtpReceiverInterface* receiver) const {
+  RTC_DCHECK(receiver);
+  rtc::CritScope lock(&transceivers_mutex_);
+  auto it = transceivers_by_receiver_.find(receiver);
+  if (it != transceivers_by_receiver_.end()) {
+    RTC_DCHECK(it->second->HasReceiver(receiver));
+    return it->second;
   }
   return nullptr;
 }
 
+void PeerConnection::InsertTransceiver(
+    RefPtr<Transceiver> transceiver,
+    webrtc::RtpTransceiverInterface* rtp_transceiver,
+    webrtc::RtpReceiverInterface* receiver) {
+  rtc::CritScope lock(&transceivers_mutex_);
+  if (rtp_transceiver) {
+    transceivers_by_rtp_.emplace(rtp_transceiver, transceiver.get());
+  }
+  if (receiver) {
+    transceivers_by_receiver_.emplace(receiver, transceiver.get());
+  }
+  transceivers_.push_back(std::move(transceiver));
+  transceivers_snapshot_ = nullptr;
+}
+
+std::shared_ptr<const std::vector<RefPtr<Transceiver>>>
+PeerConnection::GetTransceiversSnapshot() const {
+  rtc::CritScope lock(&transceivers_mutex_);
+  if (!transceivers_snapshot_) {
+    transceivers_snapshot_ =
+        std::make_shared<const std::vector<RefPtr<Transceiver>>>(
+            transceivers_);
+  }
+  return transceivers_snapshot_;
+}
+
 int PeerConnection::ExtractMlineIndexFromRtpTransceiver(
     webrtc::RtpTransceiverInterface* tr) {
   RTC_DCHECK(tr);
@@ -1084,16 +1339,9 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
 
   // Try to find an existing |Transceiver| instance for the given RTP receiver
   // of the remote track.
-  {
-    auto it_tr = std::find_if(transceivers_.begin(), transceivers_.end(),
-                              [receiver](const RefPtr<Transceiver>& tr) {
-                                return tr->HasReceiver(receiver);
-                              });
-    if (it_tr != transceivers_.end()) {
-      RTC_DCHECK(media_kind == (*it_tr)->GetMediaKind());
-      Transceiver* transceiver = static_cast<Transceiver*>(it_tr->get());
-      return transceiver;
-    }
+  if (RefPtr<Transceiver> transceiver = FindWrapperFromRtpReceiver(receiver)) {
+    RTC_DCHECK(media_kind == transceiver->GetMediaKind());
+    return transceiver.get();
   }
 
   if (IsUnifiedPlan()) {
@@ -1148,59 +1396,98 @@ ErrorOr<Transceiver*> PeerConnection::GetOrCreateTransceiverForNewRemoteTrack(
         global_factory_, media_kind, *this, mline_index, name,
         std::move(stream_ids), desired_direction);
     transceiver->SetReceiverPlanB(receiver);
-    {
-      rtc::CritScope lock(&transceivers_mutex_);
-      transceivers_.push_back(transceiver);
-    }
+    InsertTransceiver(transceiver, nullptr, receiver);
 
     // Invoke the TransceiverAdded callback
-    {
-      std::lock_guard<std::mutex> lock(callbacks_mutex_);
-      if (auto cb = transceiver_added_callback_) {
-        mrsTransceiverAddedInfo info{};
-        info.transceiver_handle = transceiver.get();
-        info.transceiver_name = name.c_str();
-        info.media_kind = media_kind;
-        info.mline_index = mline_index;
-        info.encoded_stream_ids_ = encoded_stream_ids.c_str();
-        info.desired_direction = desired_direction;
-        cb(&info);
-      }
+    if (auto cb = transceiver_added_callback_.Load()) {
+      mrsTransceiverAddedInfo info{};
+      info.transceiver_handle = transceiver.get();
+      info.transceiver_name = name.c_str();
+      info.media_kind = media_kind;
+      info.mline_index = mline_index;
+      info.encoded_stream_ids_ = encoded_stream_ids.c_str();
+      info.desired_direction = desired_direction;
+      cb(&info);
     }
 
     return transceiver.get();
   }
 }
 
-void PeerConnection::SynchronizeTransceiversUnifiedPlan(bool remote) {
-  // Get RTP transceivers sorted by address in memory
-  auto rtp_transceivers = peer_->GetTransceivers();
-  std::sort(
-      rtp_transceivers.begin(), rtp_transceivers.end(),
-      [](auto const& t1, auto const& t2) { return (t1.get() < t2.get()); });
-  // Get transceiver wrappers sorted by RTP transceiver address in memory
-  std::vector<RefPtr<Transceiver>> wrappers;
-  {
+void PeerConnection::ApplyAudioSendParameters(
+    webrtc::SessionDescriptionInterface& desc) {
+  cricket::SessionDescription* const session_desc = desc.description();
+  if (!session_desc) {
+    return;
+  }
+  auto apply = [](const cricket::ContentInfo& content,
+                  const mrsAudioSendParameters& params) {
+    cricket::MediaContentDescription* const media_desc = content.description;
+    if (media_desc &&
+        (media_desc->type() == cricket::MediaType::MEDIA_TYPE_AUDIO)) {
+      SdpSetOpusSendParameters(*media_desc->as_audio(), params);
+    }
+  };
+  const cricket::ContentInfos& contents = session_desc->contents();
+  if (IsPlanB()) {
+    // All audio transceivers share the first audio media line, which uses the
+    // parameters of the first audio transceiver having some.
+    auto content = std::find_if(
+        contents.begin(), contents.end(),
+        [](const cricket::ContentInfo& info) {
+          return (info.description && (info.description->type() ==
+                                       cricket::MediaType::MEDIA_TYPE_AUDIO));
+        });
+    if (content == contents.end()) {
+      return;
+    }
     rtc::CritScope lock(&transceivers_mutex_);
-    wrappers = transceivers_;
-  }
-  std::sort(wrappers.begin(), wrappers.end(),
-            [](auto const& t1, auto const& t2) {
-              return (t1->impl().get() < t2->impl().get());
-            });
-  // Match transceiver wrappers with their implementation, and create wrappers
-  // for the ones without one yet.
-  RTC_DCHECK_GE(rtp_transceivers.size(), wrappers.size());
-  auto it_wrapper = wrappers.begin();
+    for (auto&& tr : transceivers_) {
+      if (tr->GetMediaKind() != mrsMediaKind::kAudio) {
+        continue;
+      }
+      if (const absl::optional<mrsAudioSendParameters> params =
+              tr->GetAudioSendParameters()) {
+        apply(*content, *params);
+        return;
+      }
+    }
+    return;
+  }
+
+  // Match the media lines to the RTP transceivers by MID. In a remote answer
+  // all the transceivers offered have one. In a remote offer, the transceivers
+  // not associated yet are either added by this offer, and have no wrapper
+  // nor parameters yet, or left unassociated until the next local offer.
+  for (auto&& rtp_tr : peer_->GetTransceivers()) {
+    if ((rtp_tr->media_type() != cricket::MediaType::MEDIA_TYPE_AUDIO) ||
+        !rtp_tr->mid().has_value()) {
+      continue;
+    }
+    const cricket::ContentInfo* const content =
+        session_desc->GetContentByName(rtp_tr->mid().value());
+    if (!content) {
+      continue;
+    }
+    if (RefPtr<Transceiver> tr = FindWrapperFromRtpTransceiver(rtp_tr.get())) {
+      if (const absl::optional<mrsAudioSendParameters> params =
+              tr->GetAudioSendParameters()) {
+        apply(*content, *params);
+      }
+    }
+  }
+}
+
+void PeerConnection::SynchronizeTransceiversUnifiedPlan(bool remote) {
+  const auto rtp_transceivers = peer_->GetTransceivers();
   RTC_LOG(LS_INFO) << "Synchronizing " << rtp_transceivers.size()
-                   << " RTP transceivers with " << wrappers.size()
-                   << " transceiver wrappers (remote = " << remote << ").";
+                   << " RTP transceivers (remote = " << remote << ").";
+  // Match each RTP transceiver with its wrapper through the index, and create
+  // wrappers for the ones without one yet.
   for (auto&& rtp_tr : rtp_transceivers) {
     const int mline_index = ExtractMlineIndexFromRtpTransceiver(rtp_tr);
-    // Compare the current item on the sorted arrays of RTP transceiver and
-    // transceiver wrappers; if the current items don't match, this means
-    // there's a missing wrapper for an existing RTP transceiver, so create it.
-    if ((it_wrapper == wrappers.end()) || ((*it_wrapper)->impl() != rtp_tr)) {
+    RefPtr<Transceiver> wrapper = FindWrapperFromRtpTransceiver(rtp_tr);
+    if (!wrapper) {
       std::string name = rtp_tr->mid().value_or(std::string{});
       RTC_LOG(LS_INFO) << "Creating new wrapper for RTP transceiver mid='"
                        << name.c_str() << "' (#" << mline_index << ")";
@@ -1214,18 +1501,16 @@ void PeerConnection::SynchronizeTransceiversUnifiedPlan(bool remote) {
                              "new RTP transceiver.";
         continue;
       }
-      it_wrapper = wrappers.insert(it_wrapper, err.MoveValue());
+      wrapper = err.MoveValue();
     }
-    RTC_DCHECK(it_wrapper != wrappers.end());
     // Ensure the Transceiver object is in sync with its RTP counterpart
-    (*it_wrapper)->OnSessionDescUpdated(remote);
+    wrapper->OnSessionDescUpdated(remote);
     // Check if newly associated
-    if ((*it_wrapper)->GetMlineIndex() != mline_index) {
+    if (wrapper->GetMlineIndex() != mline_index) {
       RTC_DCHECK(mline_index >= 0);
       RTC_DCHECK(!remote);  // already created associated with remote
-      (*it_wrapper)->OnAssociated(mline_index);
+      wrapper->OnAssociated(mline_index);
     }
-    ++it_wrapper;
   }
 }
 
@@ -1237,26 +1522,23 @@ ErrorOr<Transceiver*> PeerConnection::CreateTransceiverUnifiedPlan(
     rtc::scoped_refptr<webrtc::RtpTransceiverInterface> rtp_transceiver) {
   const Transceiver::Direction desired_direction =
       Transceiver::FromRtp(rtp_transceiver->direction());
+  webrtc::RtpTransceiverInterface* const rtp_tr = rtp_transceiver.get();
+  rtc::scoped_refptr<webrtc::RtpReceiverInterface> receiver =
+      rtp_transceiver->receiver();
   RefPtr<Transceiver> transceiver = Transceiver::CreateForUnifiedPlan(
       global_factory_, media_kind, *this, mline_index, std::move(name),
       stream_ids, std::move(rtp_transceiver), desired_direction);
-  {
-    rtc::CritScope lock(&transceivers_mutex_);
-    transceivers_.push_back(transceiver);
-  }
-  {
-    std::lock_guard<std::mutex> lock(callbacks_mutex_);
-    if (auto cb = transceiver_added_callback_) {
-      std::string encoded_stream_ids = Transceiver::EncodeStreamIDs(stream_ids);
-      mrsTransceiverAddedInfo info{};
-      info.transceiver_handle = transceiver.get();
-      info.transceiver_name = name.c_str();
-      info.media_kind = media_kind;
-      info.mline_index = mline_index;
-      info.encoded_stream_ids_ = encoded_stream_ids.c_str();
-      info.desired_direction = desired_direction;
-      cb(&info);
-    }
+  InsertTransceiver(transceiver, rtp_tr, receiver.get());
+  if (auto cb = transceiver_added_callback_.Load()) {
+    std::string encoded_stream_ids = Transceiver::EncodeStreamIDs(stream_ids);
+    mrsTransceiverAddedInfo info{};
+    info.transceiver_handle = transceiver.get();
+    info.transceiver_name = name.c_str();
+    info.media_kind = media_kind;
+    info.mline_index = mline_index;
+    info.encoded_stream_ids_ = encoded_stream_ids.c_str();
+    info.desired_direction = desired_direction;
+    cb(&info);
   }
   return transceiver.get();
 }
@@ -1328,8 +1610,18 @@ ErrorOr<RefPtr<PeerConnection>> PeerConnection::create(
 
   // Ensure the factory exists
   RefPtr<GlobalFactory> global_factory(GlobalFactory::InstancePtr());
+  if (!global_factory) {
+    return Error(Result::kUnknownError);
+  }
+
+  // Assign the connection to a thread group
+  ErrorOr<GlobalFactory::ThreadGroupFactory> group_factory =
+      global_factory->GetThreadGroupFactory(config.thread_group);
+  if (!group_factory.ok()) {
+    return group_factory.MoveError();
+  }
   rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> pc_factory =
-      global_factory->GetPeerConnectionFactory();
+      group_factory.value().peer_factory;
   if (!pc_factory) {
     return Error(Result::kUnknownError);
   }
@@ -1348,7 +1640,15 @@ ErrorOr<RefPtr<PeerConnection>> PeerConnection::create(
       (config.sdp_semantic == mrsSdpSemantic::kUnifiedPlan
            ? webrtc::SdpSemantics::kUnifiedPlan
            : webrtc::SdpSemantics::kPlanB);
-  auto peer = new PeerConnection(std::move(global_factory));
+  if (config.ice_candidate_pool_size < 0) {
+    return Error(Result::kInvalidParameter);
+  }
+  rtc_config.ice_candidate_pool_size = config.ice_candidate_pool_size;
+  rtc_config.continual_gathering_policy =
+      ContinualGatheringPolicyToNative(config.continual_gathering_policy);
+  auto peer = new PeerConnection(std::move(global_factory),
+                                 group_factory.value().audio_mixer,
+                                 group_factory.value().index);
   webrtc::PeerConnectionDependencies dependencies(peer);
   rtc::scoped_refptr<webrtc::PeerConnectionInterface> impl =
       pc_factory->CreatePeerConnection(rtc_config, std::move(dependencies));
@@ -1356,6 +1656,8 @@ ErrorOr<RefPtr<PeerConnection>> PeerConnection::create(
     return Error(Result::kUnknownError);
   }
   peer->peer_ = std::move(impl);
+  peer->bandwidth_monitor_ = std::make_unique<BandwidthEstimateMonitor>(
+      peer->global_factory_->GetSignalingThread(), peer->peer_.get());
   return RefPtr<PeerConnection>(peer);
 }
 
@@ -1367,9 +1669,14 @@ void PeerConnection::InvokeRenegotiationNeeded() {
   OnRenegotiationNeeded();
 }
 
-PeerConnection::PeerConnection(RefPtr<GlobalFactory> global_factory)
+PeerConnection::PeerConnection(
+    RefPtr<GlobalFactory> global_factory,
+    rtc::scoped_refptr<ToggleAudioMixer> audio_mixer,
+    int32_t thread_group)
     : TrackedObject(std::move(global_factory), ObjectType::kPeerConnection),
-      audio_mixer_(global_factory_->audio_mixer()) {}
+      audio_mixer_(std::move(audio_mixer)),
+      thread_group_(thread_group),
+      milestones_(std::make_shared<ConnectionMilestones>(this)) {}
 
 }  // namespace WebRTC
 }  // namespace MixedReality
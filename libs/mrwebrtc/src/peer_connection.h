@@ -4,8 +4,11 @@
 #pragma once
 
 #include "audio_frame_observer.h"
+#include "bandwidth_estimate_monitor.h"
 #include "callback.h"
+#include "connection_milestones.h"
 #include "data_channel.h"
+#include "ice_candidate_batcher.h"
 #include "media/transceiver.h"
 #include "mrs_errors.h"
 #include "peer_connection_interop.h"
@@ -100,8 +103,7 @@ class PeerConnection : public TrackedObject,
   /// Only one callback can be registered at a time.
   void RegisterLocalSdpReadytoSendCallback(
       LocalSdpReadytoSendCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(local_sdp_ready_to_send_callback_mutex_);
-    local_sdp_ready_to_send_callback_ = std::move(callback);
+    local_sdp_ready_to_send_callback_.Store(callback);
   }
 
   /// Callback invoked when a local ICE candidate message is ready to be sent to
@@ -116,11 +118,16 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterIceCandidateReadytoSendCallback(
       IceCandidateReadytoSendCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(
-        ice_candidate_ready_to_send_callback_mutex_);
-    ice_candidate_ready_to_send_callback_ = std::move(callback);
+    ice_candidate_ready_to_send_callback_.Store(callback);
   }
 
+  /// Register a custom |IceCandidateBatcher::BatchCallback| invoked with
+  /// batches of local ICE candidates ready to be sent to the remote peer. See
+  /// |mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback()|.
+  Result RegisterIceCandidatesReadytoSendCallback(
+      const mrsIceCandidateBatchConfig& config,
+      IceCandidateBatcher::BatchCallback callback) noexcept;
+
   /// Callback invoked when the state of the ICE connection changed.
   /// Note that the current implementation (M71) mixes the state of ICE and
   /// DTLS, so this does not correspond exactly to the ICE connection state of
@@ -131,8 +138,7 @@ class PeerConnection : public TrackedObject,
   /// ICE connection changed. Only one callback can be registered at a time.
   void RegisterIceStateChangedCallback(
       IceStateChangedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(ice_state_changed_callback_mutex_);
-    ice_state_changed_callback_ = std::move(callback);
+    ice_state_changed_callback_.Store(callback);
   }
 
   /// Callback invoked when the state of the ICE gathering changed.
@@ -143,9 +149,7 @@ class PeerConnection : public TrackedObject,
   /// time.
   void RegisterIceGatheringStateChangedCallback(
       IceGatheringStateChangedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(
-        ice_gathering_state_changed_callback_mutex_);
-    ice_gathering_state_changed_callback_ = std::move(callback);
+    ice_gathering_state_changed_callback_.Store(callback);
   }
 
   /// Callback invoked when some SDP negotiation needs to be initiated, often
@@ -163,8 +167,7 @@ class PeerConnection : public TrackedObject,
   /// renegotiation is needed. Only one callback can be registered at a time.
   void RegisterRenegotiationNeededCallback(
       RenegotiationNeededCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(renegotiation_needed_callback_mutex_);
-    renegotiation_needed_callback_ = std::move(callback);
+    renegotiation_needed_callback_.Store(callback);
   }
 
   /// Notify the WebRTC engine that an ICE candidate has been received from the
@@ -173,6 +176,30 @@ class PeerConnection : public TrackedObject,
   /// other peer.
   Error AddIceCandidate(const mrsIceCandidate& candidate) noexcept;
 
+  /// Notify the WebRTC engine of a batch of |count| ICE candidates, in a
+  /// single dispatch to the signaling thread. If not null, |results| receives
+  /// the result of each candidate. See |mrsPeerConnectionAddIceCandidates()|.
+  Result AddIceCandidates(const mrsIceCandidate* candidates,
+                          uint32_t count,
+                          mrsResult* results) noexcept;
+
+  /// Get the recorder of the connection milestones of this peer connection.
+  /// See |mrsPeerConnectionGetConnectionMilestones()|.
+  MRS_NODISCARD const std::shared_ptr<ConnectionMilestones>& milestones()
+      const noexcept {
+    return milestones_;
+  }
+
+  /// Audio mixer of the thread group the connection was assigned to, which
+  /// outputs its remote audio tracks.
+  MRS_NODISCARD const rtc::scoped_refptr<ToggleAudioMixer>& audio_mixer() const
+      noexcept {
+    return audio_mixer_;
+  }
+
+  /// Index of the thread group the connection was assigned to when created.
+  MRS_NODISCARD int32_t thread_group() const noexcept { return thread_group_; }
+
   /// Callback invoked when |SetRemoteDescriptionAsync()| finished applying a
   /// remote description, successfully or not. The first parameter is the result
   /// of the operation, and the second one contains the error message if the
@@ -200,8 +227,7 @@ class PeerConnection : public TrackedObject,
   /// Register a custom |ConnectedCallback| invoked when the connection is
   /// established. Only one callback can be registered at a time.
   void RegisterConnectedCallback(ConnectedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(connected_callback_mutex_);
-    connected_callback_ = std::move(callback);
+    connected_callback_.Store(callback);
   }
 
   /// Set the connection bitrate limits. These settings limit the network
@@ -214,6 +240,23 @@ class PeerConnection : public TrackedObject,
     return ResultFromRTCErrorType(peer_->SetBitrate(bitrate).type());
   }
 
+  /// Start or stop sampling the bandwidth estimate of the connection, and
+  /// register a callback invoked with each sample. See
+  /// |mrsPeerConnectionRegisterBandwidthEstimateCallback()|.
+  Result RegisterBandwidthEstimateCallback(
+      uint32_t interval_ms,
+      BandwidthEstimateMonitor::EstimateCallback callback) noexcept;
+
+  /// Get the latest bandwidth estimate sample. See
+  /// |mrsPeerConnectionGetBandwidthEstimate()|.
+  Result GetBandwidthEstimate(mrsBandwidthEstimate& estimate) const noexcept;
+
+  /// Grow the ICE candidate pool to at least |pool_size| sets of candidates,
+  /// starting to gather them immediately ahead of the first local description.
+  /// This fails with |Result::kInvalidOperation| once a local description was
+  /// applied, since the pool is only used by the first description.
+  Result Prewarm(int32_t pool_size) noexcept;
+
   /// Create an SDP offer to attempt to establish a connection with the remote
   /// peer. Once the offer message is ready, the |LocalSdpReadytoSendCallback|
   /// callback is invoked to deliver the message.
@@ -245,8 +288,7 @@ class PeerConnection : public TrackedObject,
   /// time.
   void RegisterTransceiverAddedCallback(
       TransceiverAddedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(callbacks_mutex_);
-    transceiver_added_callback_ = std::move(callback);
+    transceiver_added_callback_.Store(callback);
   }
 
   /// Add a new audio or video transceiver to the peer connection.
@@ -268,8 +310,7 @@ class PeerConnection : public TrackedObject,
   /// at a time.
   void RegisterVideoTrackAddedCallback(
       VideoTrackAddedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-    video_track_added_callback_ = std::move(callback);
+    video_track_added_callback_.Store(callback);
   }
 
   /// Callback invoked when a remote video track is removed from the peer
@@ -282,8 +323,7 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterVideoTrackRemovedCallback(
       VideoTrackRemovedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-    video_track_removed_callback_ = std::move(callback);
+    video_track_removed_callback_.Store(callback);
   }
 
   /// [HoloLens 1 only]
@@ -308,8 +348,7 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterAudioTrackAddedCallback(
       AudioTrackAddedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-    audio_track_added_callback_ = std::move(callback);
+    audio_track_added_callback_.Store(callback);
   }
 
   /// Callback invoked when a remote audio track is removed from the peer
@@ -322,8 +361,7 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterAudioTrackRemovedCallback(
       AudioTrackRemovedCallback&& callback) noexcept {
-    std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-    audio_track_removed_callback_ = std::move(callback);
+    audio_track_removed_callback_.Store(callback);
   }
 
   //
@@ -343,8 +381,7 @@ class PeerConnection : public TrackedObject,
   /// registered at a time.
   void RegisterDataChannelAddedCallback(
       DataChannelAddedCallback callback) noexcept {
-    std::lock_guard<std::mutex> lock(data_channel_added_callback_mutex_);
-    data_channel_added_callback_ = std::move(callback);
+    data_channel_added_callback_.Store(callback);
   }
 
   /// Register a custom callback invoked when a data channel is removed by the
@@ -352,16 +389,20 @@ class PeerConnection : public TrackedObject,
   /// time.
   void RegisterDataChannelRemovedCallback(
       DataChannelRemovedCallback callback) noexcept {
-    std::lock_guard<std::mutex> lock(data_channel_removed_callback_mutex_);
-    data_channel_removed_callback_ = std::move(callback);
+    data_channel_removed_callback_.Store(callback);
   }
 
   /// Create a new data channel and add it to the peer connection.
-  /// This invokes the DataChannelAdded callback.
-  ErrorOr<std::shared_ptr<DataChannel>> AddDataChannel(int id,
-                                                       absl::string_view label,
-                                                       bool ordered,
-                                                       bool reliable) noexcept;
+  /// This invokes the DataChannelAdded callback. A non-negative
+  /// |max_retransmits| or |max_packet_life_time_ms| makes the channel
+  /// partially reliable, and is exclusive with |reliable|.
+  ErrorOr<std::shared_ptr<DataChannel>> AddDataChannel(
+      int id,
+      absl::string_view label,
+      bool ordered,
+      bool reliable,
+      int max_retransmits = -1,
+      int max_packet_life_time_ms = -1) noexcept;
 
   /// Close a given data channel and remove it from the peer connection.
   /// This invokes the DataChannelRemoved callback.
@@ -451,73 +492,65 @@ class PeerConnection : public TrackedObject,
  protected:
   /// User callback invoked when the peer connection received a new data channel
   /// from the remote peer and added it locally.
-  DataChannelAddedCallback data_channel_added_callback_
-      RTC_GUARDED_BY(data_channel_added_callback_mutex_);
+  CallbackSlot<DataChannelAddedCallback> data_channel_added_callback_;
 
   /// User callback invoked when the peer connection received a data channel
   /// remove message from the remote peer and removed it locally.
-  DataChannelRemovedCallback data_channel_removed_callback_
-      RTC_GUARDED_BY(data_channel_removed_callback_mutex_);
+  CallbackSlot<DataChannelRemovedCallback> data_channel_removed_callback_;
 
   /// User callback invoked when a transceiver is added to the peer connection,
   /// whether manually with |AddTransceiver()| or automatically during
   /// |SetRemoteDescription()|.
-  TransceiverAddedCallback transceiver_added_callback_
-      RTC_GUARDED_BY(callbacks_mutex_);
+  CallbackSlot<TransceiverAddedCallback> transceiver_added_callback_;
 
   /// User callback invoked when the peer connection is established.
   /// This is generally invoked even if ICE didn't finish.
-  ConnectedCallback connected_callback_
-      RTC_GUARDED_BY(connected_callback_mutex_);
+  CallbackSlot<ConnectedCallback> connected_callback_;
 
   /// User callback invoked when a local SDP message has been crafted by the
   /// core engine and is ready to be sent by the signaling solution.
-  LocalSdpReadytoSendCallback local_sdp_ready_to_send_callback_
-      RTC_GUARDED_BY(local_sdp_ready_to_send_callback_mutex_);
+  CallbackSlot<LocalSdpReadytoSendCallback> local_sdp_ready_to_send_callback_;
 
   /// User callback invoked when a local ICE message has been crafted by the
   /// core engine and is ready to be sent by the signaling solution.
-  IceCandidateReadytoSendCallback ice_candidate_ready_to_send_callback_
-      RTC_GUARDED_BY(ice_candidate_ready_to_send_callback_mutex_);
+  CallbackSlot<IceCandidateReadytoSendCallback>
+      ice_candidate_ready_to_send_callback_;
+
+  /// Batcher of the local ICE candidates, created when a batch callback is
+  /// first registered. Only accessed from the signaling thread.
+  std::unique_ptr<IceCandidateBatcher> ice_candidate_batcher_;
+
+  /// Sampler of the bandwidth estimate, created with the connection, stopped
+  /// when closed, and destroyed with the connection. Configured and stopped on
+  /// the signaling thread, but its latest sample can be read from any thread.
+  std::unique_ptr<BandwidthEstimateMonitor> bandwidth_monitor_;
+
+  /// Recorder of the connection milestones, shared with the remote tracks. It
+  /// also observes the RTP receivers, which never outlive it while receiving
+  /// since they are closed with |peer_|.
+  std::shared_ptr<ConnectionMilestones> milestones_;
 
   /// User callback invoked when the ICE connection state changed.
-  IceStateChangedCallback ice_state_changed_callback_
-      RTC_GUARDED_BY(ice_state_changed_callback_mutex_);
+  CallbackSlot<IceStateChangedCallback> ice_state_changed_callback_;
 
   /// User callback invoked when the ICE gathering state changed.
-  IceGatheringStateChangedCallback ice_gathering_state_changed_callback_
-      RTC_GUARDED_BY(ice_gathering_state_changed_callback_mutex_);
+  CallbackSlot<IceGatheringStateChangedCallback>
+      ice_gathering_state_changed_callback_;
 
   /// User callback invoked when SDP renegotiation is needed.
-  RenegotiationNeededCallback renegotiation_needed_callback_
-      RTC_GUARDED_BY(renegotiation_needed_callback_mutex_);
+  CallbackSlot<RenegotiationNeededCallback> renegotiation_needed_callback_;
 
   /// User callback invoked when a remote audio track is added.
-  AudioTrackAddedCallback audio_track_added_callback_
-      RTC_GUARDED_BY(media_track_callback_mutex_);
+  CallbackSlot<AudioTrackAddedCallback> audio_track_added_callback_;
 
   /// User callback invoked when a remote audio track is removed.
-  AudioTrackRemovedCallback audio_track_removed_callback_
-      RTC_GUARDED_BY(media_track_callback_mutex_);
+  CallbackSlot<AudioTrackRemovedCallback> audio_track_removed_callback_;
 
   /// User callback invoked when a remote video track is added.
-  VideoTrackAddedCallback video_track_added_callback_
-      RTC_GUARDED_BY(media_track_callback_mutex_);
+  CallbackSlot<VideoTrackAddedCallback> video_track_added_callback_;
 
   /// User callback invoked when a remote video track is removed.
-  VideoTrackRemovedCallback video_track_removed_callback_
-      RTC_GUARDED_BY(media_track_callback_mutex_);
-
-  std::mutex data_channel_added_callback_mutex_;
-  std::mutex data_channel_removed_callback_mutex_;
-  std::mutex callbacks_mutex_;
-  std::mutex connected_callback_mutex_;
-  std::mutex local_sdp_ready_to_send_callback_mutex_;
-  std::mutex ice_candidate_ready_to_send_callback_mutex_;
-  std::mutex ice_state_changed_callback_mutex_;
-  std::mutex ice_gathering_state_changed_callback_mutex_;
-  std::mutex renegotiation_needed_callback_mutex_;
-  std::mutex media_track_callback_mutex_;
+  CallbackSlot<VideoTrackRemovedCallback> video_track_removed_callback_;
 
   class StreamObserver : public webrtc::ObserverInterface {
    public:
@@ -544,6 +577,22 @@ class PeerConnection : public TrackedObject,
   std::vector<RefPtr<Transceiver>> transceivers_
       RTC_GUARDED_BY(transceivers_mutex_);
 
+  /// Index of the transceivers of |transceivers_| from their RTP transceiver,
+  /// for Unified Plan only.
+  std::unordered_map<webrtc::RtpTransceiverInterface*, Transceiver*>
+      transceivers_by_rtp_ RTC_GUARDED_BY(transceivers_mutex_);
+
+  /// Index of the transceivers of |transceivers_| from their RTP receiver, if
+  /// they have one.
+  std::unordered_map<webrtc::RtpReceiverInterface*, Transceiver*>
+      transceivers_by_receiver_ RTC_GUARDED_BY(transceivers_mutex_);
+
+  /// Immutable copy of |transceivers_| shared with readers iterating over the
+  /// transceivers without holding |transceivers_mutex_|. Reset each time the
+  /// collection changes, and lazily rebuilt by |GetTransceiversSnapshot()|.
+  mutable std::shared_ptr<const std::vector<RefPtr<Transceiver>>>
+      transceivers_snapshot_ RTC_GUARDED_BY(transceivers_mutex_);
+
   /// Mutex for the collections of transceivers.
   rtc::CriticalSection transceivers_mutex_;
 
@@ -579,8 +628,13 @@ class PeerConnection : public TrackedObject,
 
   rtc::scoped_refptr<ToggleAudioMixer> audio_mixer_;
 
+  /// Index of the thread group the connection was assigned to.
+  const int32_t thread_group_;
+
  private:
-  PeerConnection(RefPtr<GlobalFactory> global_factory);
+  PeerConnection(RefPtr<GlobalFactory> global_factory,
+                 rtc::scoped_refptr<ToggleAudioMixer> audio_mixer,
+                 int32_t thread_group);
   PeerConnection(const PeerConnection&) = delete;
   ~PeerConnection() noexcept { Close(); }
   PeerConnection& operator=(const PeerConnection&) = delete;
@@ -599,6 +653,24 @@ class PeerConnection : public TrackedObject,
   RefPtr<Transceiver> FindWrapperFromRtpTransceiver(
       webrtc::RtpTransceiverInterface* tr) const;
 
+  /// Find the |Transceiver| wrapper owning an RTP receiver, or |nullptr| if
+  /// none does.
+  RefPtr<Transceiver> FindWrapperFromRtpReceiver(
+      webrtc::RtpReceiverInterface* receiver) const;
+
+  /// Insert a new transceiver into the collection of transceivers and its
+  /// indexes. |rtp_transceiver| is the RTP transceiver wrapped in Unified Plan,
+  /// and |receiver| the RTP receiver of the transceiver, if any.
+  void InsertTransceiver(RefPtr<Transceiver> transceiver,
+                         webrtc::RtpTransceiverInterface* rtp_transceiver,
+                         webrtc::RtpReceiverInterface* receiver);
+
+  /// Get a snapshot of the collection of transceivers, to iterate over it
+  /// without holding |transceivers_mutex_|. Transceivers added after the call
+  /// are not part of the snapshot.
+  std::shared_ptr<const std::vector<RefPtr<Transceiver>>>
+  GetTransceiversSnapshot() const;
+
   /// Extract the media line index from an RTP transceiver, or -1 if not
   /// associated.
   static int ExtractMlineIndexFromRtpTransceiver(
@@ -621,6 +693,12 @@ class PeerConnection : public TrackedObject,
   /// was just applied on the local peer.
   void SynchronizeTransceiversUnifiedPlan(bool remote);
 
+  /// Apply the Opus encoder parameters of the audio transceivers to the format
+  /// parameters of their media line in a remote description about to be
+  /// applied, which configure the local encoder. See
+  /// |Transceiver::SetAudioSendParameters()|.
+  void ApplyAudioSendParameters(webrtc::SessionDescriptionInterface& desc);
+
   /// Create a new |Transceiver| instance for an exist RTP transceiver not
   /// associated with any. This automatically inserts the transceiver into the
   /// peer connection, and return a raw pointer to it valid until the peer
@@ -705,7 +783,8 @@ class PeerConnection : public TrackedObject,
   AddRemoteMediaTrack(
       rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> track,
       webrtc::RtpReceiverInterface* receiver,
-      typename MediaTrait<MEDIA_KIND>::MediaTrackAddedCallbackT*
+      const CallbackSlot<
+          typename MediaTrait<MEDIA_KIND>::MediaTrackAddedCallbackT>&
           track_added_cb) {
     using Media = MediaTrait<MEDIA_KIND>;
 
@@ -734,14 +813,9 @@ class PeerConnection : public TrackedObject,
 
     // Invoke the TrackAdded callback, which will set the native handle on the
     // interop wrapper (if created above)
-    {
-      std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-      // Read the function pointer inside the lock to avoid race condition
-      auto cb = *track_added_cb;
-      if (cb) {
-        Media::ExecTrackAdded(remote_media_track.get(), transceiver,
-                              remote_media_track->GetName().c_str(), cb);
-      }
+    if (auto cb = track_added_cb.Load()) {
+      Media::ExecTrackAdded(remote_media_track.get(), transceiver,
+                            remote_media_track->GetName().c_str(), cb);
     }
     return remote_media_track;
   }
@@ -752,23 +826,20 @@ class PeerConnection : public TrackedObject,
   template <mrsMediaKind MEDIA_KIND>
   void RemoveRemoteMediaTrack(
       webrtc::RtpReceiverInterface* receiver,
-      typename MediaTrait<MEDIA_KIND>::MediaTrackRemovedCallbackT*
+      const CallbackSlot<
+          typename MediaTrait<MEDIA_KIND>::MediaTrackRemovedCallbackT>&
           track_removed_cb) {
     using Media = MediaTrait<MEDIA_KIND>;
 
     rtc::CritScope tracks_lock(&transceivers_mutex_);
-    auto it = std::find_if(transceivers_.begin(), transceivers_.end(),
-                           [receiver](const RefPtr<Transceiver>& tr) {
-                             return tr->HasReceiver(receiver);
-                           });
-    if (it == transceivers_.end()) {
+    RefPtr<Transceiver> transceiver = FindWrapperFromRtpReceiver(receiver);
+    if (!transceiver) {
       RTC_LOG(LS_ERROR)
           << "Trying to remove receiver " << receiver->id().c_str()
           << " from peer connection " << GetName()
           << " but no transceiver was found which owns such receiver.";
       return;
     }
-    RefPtr<Transceiver> transceiver = *it;
     RTC_DCHECK(transceiver->GetMediaKind() == MEDIA_KIND);
     RefPtr<typename Media::RemoteMediaTrackT> media_track(
         static_cast<typename Media::RemoteMediaTrackT*>(
@@ -776,14 +847,7 @@ class PeerConnection : public TrackedObject,
     media_track->OnTrackRemoved(*this);
 
     // Invoke the TrackRemoved callback
-    {
-      std::lock_guard<std::mutex> lock(media_track_callback_mutex_);
-      // Read the function pointer inside the lock to avoid race condition
-      auto cb = *track_removed_cb;
-      if (cb) {
-        cb(media_track.get(), transceiver.get());
-      }
-    }
+    track_removed_cb(media_track.get(), transceiver.get());
     // |media_track| goes out of scope and destroys the C++ instance
   }
 };
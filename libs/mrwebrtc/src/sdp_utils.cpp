@@ -6,7 +6,9 @@
 
 #include "sdp_utils.h"
 
+#include "absl/strings/match.h"
 #include "api/jsepsessiondescription.h"
+#include "media/base/mediaconstants.h"
 #include "pc/sessiondescription.h"
 #include "pc/webrtcsdp.h"
 
@@ -94,6 +96,44 @@ void SdpParseCodecParameters(const std::string& param_string,
   }
 }
 
+bool SdpSetOpusSendParameters(cricket::AudioContentDescription& audio_desc,
+                              const mrsAudioSendParameters& params) {
+  std::vector<cricket::AudioCodec> codecs = audio_desc.codecs();
+  auto it = std::find_if(codecs.begin(), codecs.end(),
+                         [](const cricket::AudioCodec& codec) {
+                           return absl::EqualsIgnoreCase(
+                               codec.name, cricket::kOpusCodecName);
+                         });
+  if (it == codecs.end()) {
+    return false;
+  }
+  cricket::AudioCodec& opus = *it;
+  auto set_bool_param = [&opus](const char* name, mrsOptBool value) {
+    if (value != mrsOptBool::kUnset) {
+      opus.SetParam(name, (value == mrsOptBool::kFalse) ? 0 : 1);
+    }
+  };
+  set_bool_param(cricket::kCodecParamUseDtx, params.dtx);
+  set_bool_param(cricket::kCodecParamUseInbandFec, params.inband_fec);
+  set_bool_param(cricket::kCodecParamStereo, params.stereo);
+  if (params.frame_duration_ms != 0) {
+    const int ptime = (int)params.frame_duration_ms;
+    opus.SetParam(cricket::kCodecParamPTime, ptime);
+    // The encoder never uses frames longer than the maximum packet time.
+    int max_ptime = 0;
+    if (opus.GetParam(cricket::kCodecParamMaxPTime, &max_ptime) &&
+        (max_ptime < ptime)) {
+      opus.SetParam(cricket::kCodecParamMaxPTime, ptime);
+    }
+  }
+  if (params.max_average_bitrate_bps != 0) {
+    opus.SetParam(cricket::kCodecParamMaxAverageBitrate,
+                  (int)params.max_average_bitrate_bps);
+  }
+  audio_desc.set_codecs(codecs);
+  return true;
+}
+
 std::string SdpForceCodecs(
     const std::string& message,
     const std::string& audio_codec_name,
@@ -8,6 +8,11 @@
 
 #include "callback.h"
 #include "interop_api.h"
+#include "transceiver_interop.h"
+
+namespace cricket {
+class AudioContentDescription;
+}
 
 namespace Microsoft {
 namespace MixedReality {
@@ -43,6 +48,14 @@ std::string SdpForceCodecs(
     const std::string& video_codec_name,
     const std::map<std::string, std::string>& extra_video_codec_params);
 
+/// Apply the Opus encoder parameters of an audio transceiver to the format
+/// parameters of the Opus codec of the given audio media description, if it
+/// supports Opus. This is applied to the remote description, whose format
+/// parameters configure the local encoder. Returns |true| if the description
+/// was modified.
+bool SdpSetOpusSendParameters(cricket::AudioContentDescription& audio_desc,
+                              const mrsAudioSendParameters& params);
+
 /// Decode a marshalled ICE server string.
 /// Syntax is:
 ///   string = blocks
@@ -7,16 +7,28 @@
 
 #include "toggle_audio_mixer.h"
 
+#include <algorithm>
+#include <thread>
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
 ToggleAudioMixer::ToggleAudioMixer()
-    : base_impl_(webrtc::AudioMixerImpl::Create()) {}
+    : base_impl_(webrtc::AudioMixerImpl::Create()),
+      snapshot_(new MixSnapshot()) {}
+
+ToggleAudioMixer::~ToggleAudioMixer() {
+  // The audio device stopped mixing before releasing the mixer, so all
+  // snapshots can be freed.
+  RTC_DCHECK((mix_epoch_.load() & 1) == 0);
+  delete snapshot_.load();
+}
 
 bool ToggleAudioMixer::AddSource(Source* audio_source) {
   RTC_DCHECK(audio_source);
 
+  std::vector<std::unique_ptr<const MixSnapshot>> freed;
   rtc::CritScope lock(&crit_);
   // By default add the source as not output.
   auto result =
@@ -35,6 +47,8 @@ bool ToggleAudioMixer::AddSource(Source* audio_source) {
     }
   }
 
+  PublishSnapshotNoLock();
+  CollectRetiredNoLock(freed);
   return true;
 }
 
@@ -50,51 +64,103 @@ void ToggleAudioMixer::TryAddToBaseImpl(KnownSource& known_source) {
 void ToggleAudioMixer::RemoveSource(Source* audio_source) {
   RTC_DCHECK(audio_source);
 
-  rtc::CritScope lock(&crit_);
-  // Check if the source is being played.
-  const auto iter = source_from_id_.find(audio_source->Ssrc());
-  RTC_DCHECK(iter != source_from_id_.end())
-      << "Cannot find source " << audio_source->Ssrc();
-
-  if (iter->second.is_output) {
-    // Stop mixing the source.
-    base_impl_->RemoveSource(audio_source);
+  std::vector<std::unique_ptr<const MixSnapshot>> freed;
+  uint64_t epoch;
+  {
+    rtc::CritScope lock(&crit_);
+    // Check if the source is being played.
+    const auto iter = source_from_id_.find(audio_source->Ssrc());
+    RTC_DCHECK(iter != source_from_id_.end())
+        << "Cannot find source " << audio_source->Ssrc();
+
+    if (iter->second.is_output) {
+      // Stop mixing the source.
+      base_impl_->RemoveSource(audio_source);
+    }
+    // Forget the source.
+    source_from_id_.erase(iter);
+
+    epoch = PublishSnapshotNoLock();
+    CollectRetiredNoLock(freed);
+  }
+
+  // Wait for the mixer to stop using the source before returning, as the
+  // caller is allowed to destroy it immediately after this call. This waits
+  // outside of the lock, so that the mixing pass never contends with it.
+  WaitForMixPass(epoch);
+}
+
+uint64_t ToggleAudioMixer::PublishSnapshotNoLock() {
+  // Build the new snapshot on the control thread; this is the only place
+  // where the source list is allocated.
+  auto snapshot = std::make_unique<MixSnapshot>();
+  snapshot->redirected_sources.reserve(source_from_id_.size());
+  for (auto&& pair : source_from_id_) {
+    if (pair.second.source && !pair.second.is_output) {
+      snapshot->redirected_sources.push_back(pair.second.source);
+    } else {
+      snapshot->some_source_is_output = true;
+    }
+  }
+  snapshot->clock_observers = clock_observers_;
+
+  // The exchange and the epoch read are sequentially consistent with the
+  // epoch increment and snapshot load of |Mix()|. So if the epoch read is
+  // even, any later mixing pass loads the new snapshot; if it is odd, only
+  // the pass in progress can still access the previous one.
+  std::unique_ptr<const MixSnapshot> previous(
+      snapshot_.exchange(snapshot.release()));
+  const uint64_t epoch = mix_epoch_.load();
+  retired_.push_back({std::move(previous), epoch});
+  return epoch;
+}
+
+void ToggleAudioMixer::CollectRetiredNoLock(
+    std::vector<std::unique_ptr<const MixSnapshot>>& freed) {
+  const uint64_t epoch = mix_epoch_.load();
+  auto it = std::remove_if(
+      retired_.begin(), retired_.end(), [&](RetiredSnapshot& retired) {
+        if (((retired.epoch & 1) == 0) || (retired.epoch != epoch)) {
+          freed.push_back(std::move(retired.snapshot));
+          return true;
+        }
+        return false;
+      });
+  retired_.erase(it, retired_.end());
+}
+
+void ToggleAudioMixer::WaitForMixPass(uint64_t epoch) const {
+  if ((epoch & 1) == 0) {
+    return;
+  }
+  // A mixing pass lasts a few milliseconds at most.
+  while (mix_epoch_.load() == epoch) {
+    std::this_thread::yield();
   }
-  // Forget the source.
-  source_from_id_.erase(iter);
 }
 
 static const int16_t zerobuf[200]{};
 
 void ToggleAudioMixer::Mix(size_t number_of_channels,
                            webrtc::AudioFrame* audio_frame_for_mixing) {
-  std::vector<Source*> redirected_sources;
-  bool some_source_is_output = false;
-  {
-    rtc::CritScope lock(&crit_);
-
-    // Collect the redirected sources.
-    for (auto&& pair : source_from_id_) {
-      if (pair.second.source && !pair.second.is_output) {
-        redirected_sources.push_back(pair.second.source);
-      } else {
-        some_source_is_output = true;
-      }
-    }
-
-    if (some_source_is_output) {
-      // Mix output sources using the base impl. Do inside the lock in case
-      // sources are added/removed by OutputSource on a different thread.
-      base_impl_->Mix(number_of_channels, audio_frame_for_mixing);
-    }
+  // Enter the mixing pass, then grab the current snapshot without taking the
+  // control lock, so that a concurrent |OutputSource()| call from the app
+  // thread never stalls the audio device thread.
+  mix_epoch_.fetch_add(1);
+  const MixSnapshot* const snapshot = snapshot_.load();
+
+  if (snapshot->some_source_is_output) {
+    // Mix output sources using the base impl. This is safe outside of |crit_|
+    // since the base impl guards its own source list against concurrent
+    // add/remove.
+    base_impl_->Mix(number_of_channels, audio_frame_for_mixing);
   }
 
-  for (auto& source : redirected_sources) {
+  for (Source* source : snapshot->redirected_sources) {
     // This pumps the source and fires the frame observer callbacks
     // which in turn fill the AudioTrackReadBuffer buffers
-    webrtc::AudioFrame unused;
     const auto audio_frame_info = source->GetAudioFrameWithInfo(
-        source->PreferredSampleRate(), &unused);
+        source->PreferredSampleRate(), &pump_frame_);
 
     if (audio_frame_info == Source::AudioFrameInfo::kError) {
       RTC_LOG_F(LS_WARNING) << "failed to GetAudioFrameWithInfo() from source";
@@ -102,15 +168,25 @@ void ToggleAudioMixer::Mix(size_t number_of_channels,
     }
   }
 
-  if (!some_source_is_output) {
+  if (!snapshot->some_source_is_output) {
     // Return an empty frame.
     audio_frame_for_mixing->UpdateFrame(
         0, zerobuf, 80, 8000, webrtc::AudioFrame::kNormalSpeech,
         webrtc::AudioFrame::kVadUnknown, number_of_channels);
   }
+
+  // The audio device pulls exactly one frame per mixing pass, so this is a
+  // tick of its clock.
+  for (ClockObserver* observer : snapshot->clock_observers) {
+    observer->OnAudioClockTick();
+  }
+
+  // Leave the mixing pass; |snapshot| must not be accessed anymore.
+  mix_epoch_.fetch_add(1);
 }
 
 void ToggleAudioMixer::OutputSource(int ssrc, bool output) {
+  std::vector<std::unique_ptr<const MixSnapshot>> freed;
   rtc::CritScope lock(&crit_);
 
   // If the source is unknown add a KnownSource with null Source* to remember
@@ -130,6 +206,40 @@ void ToggleAudioMixer::OutputSource(int ssrc, bool output) {
     // else the state of the source is unchanged.
     known_source.is_output = output;
   }
+
+  PublishSnapshotNoLock();
+  CollectRetiredNoLock(freed);
+}
+
+void ToggleAudioMixer::AddClockObserver(ClockObserver* observer) {
+  RTC_DCHECK(observer);
+
+  std::vector<std::unique_ptr<const MixSnapshot>> freed;
+  rtc::CritScope lock(&crit_);
+  clock_observers_.push_back(observer);
+  PublishSnapshotNoLock();
+  CollectRetiredNoLock(freed);
+}
+
+void ToggleAudioMixer::RemoveClockObserver(ClockObserver* observer) {
+  std::vector<std::unique_ptr<const MixSnapshot>> freed;
+  uint64_t epoch;
+  {
+    rtc::CritScope lock(&crit_);
+    auto it =
+        std::find(clock_observers_.begin(), clock_observers_.end(), observer);
+    if (it == clock_observers_.end()) {
+      return;
+    }
+    clock_observers_.erase(it);
+
+    epoch = PublishSnapshotNoLock();
+    CollectRetiredNoLock(freed);
+  }
+
+  // Like for |RemoveSource()|, the caller may destroy the observer as soon as
+  // this returns, so wait for the pass which may still be notifying it.
+  WaitForMixPass(epoch);
 }
 
 }  // namespace WebRTC
@@ -3,14 +3,47 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 namespace Microsoft {
 namespace MixedReality {
 namespace WebRTC {
 
 /// Can mix selected audio sources only.
+///
+/// The mixing thread never takes the control lock. Instead, every change made
+/// through |AddSource()|, |RemoveSource()| or |OutputSource()| rebuilds an
+/// immutable snapshot of the sources to pump, which is published with an
+/// atomic pointer exchange and read by |Mix()| with a single atomic load.
+///
+/// Snapshots are reclaimed with a simple epoch scheme. |Mix()| increments
+/// |mix_epoch_| when starting and when finishing a mixing pass, so an odd
+/// epoch means a pass is in progress. A replaced snapshot is retired with the
+/// epoch observed after the exchange, and freed on the control thread, outside
+/// of the control lock, once the mixer was seen outside of that pass. So
+/// |Mix()| never allocates nor frees any memory, and a frame callback fired
+/// while pumping a source can safely re-enter |OutputSource()|.
+///
+/// Since the audio device calls |Mix()| each time it pulls a 10 ms frame to
+/// play out, the mixer also acts as the audio device clock, which its clock
+/// observers use to produce audio in lockstep with the device.
 class ToggleAudioMixer : public webrtc::AudioMixer {
  public:
+  /// Observer of the audio device clock.
+  class ClockObserver {
+   public:
+    virtual ~ClockObserver() = default;
+
+    /// Called on the audio device thread at the end of each mixing pass, that
+    /// is every 10 ms of audio device time. This must not add nor remove any
+    /// clock observer.
+    virtual void OnAudioClockTick() = 0;
+  };
+
   ToggleAudioMixer();
+  ~ToggleAudioMixer() override;
 
   // AudioMixer implementation.
   bool AddSource(Source* audio_source) override;
@@ -21,17 +54,74 @@ class ToggleAudioMixer : public webrtc::AudioMixer {
   // Select if the source with the given id must be output to the audio device.
   void OutputSource(int ssrc, bool output);
 
+  /// Start notifying |observer| of the ticks of the audio device clock.
+  void AddClockObserver(ClockObserver* observer);
+
+  /// Stop notifying |observer|. Once this returns the observer is not called
+  /// anymore, and can be destroyed.
+  void RemoveClockObserver(ClockObserver* observer);
+
  private:
   struct KnownSource {
     Source* source;
     bool is_output;
   };
 
+  /// Immutable view of the mixer sources, as consumed by |Mix()|.
+  struct MixSnapshot {
+    /// Sources not output to the audio device, which still need to be pumped
+    /// to fire their frame observer callbacks.
+    std::vector<Source*> redirected_sources;
+
+    /// Is any source mixed by the base implementation?
+    bool some_source_is_output = false;
+
+    /// Observers to notify at the end of the mixing pass.
+    std::vector<ClockObserver*> clock_observers;
+  };
+
+  /// Snapshot replaced by a newer one, waiting for |Mix()| to release it.
+  struct RetiredSnapshot {
+    std::unique_ptr<const MixSnapshot> snapshot;
+
+    /// Value of |mix_epoch_| right after the snapshot was replaced.
+    uint64_t epoch;
+  };
+
   void TryAddToBaseImpl(KnownSource& audio_source);
 
+  /// Rebuild the snapshot from |source_from_id_| and |clock_observers_|,
+  /// publish it to the mixing thread, and retire the previous one. Return the
+  /// epoch at which the previous snapshot was retired.
+  uint64_t PublishSnapshotNoLock();
+
+  /// Move the retired snapshots which |Mix()| can no longer access into
+  /// |freed|, to be destroyed by the caller after releasing |crit_|.
+  void CollectRetiredNoLock(
+      std::vector<std::unique_ptr<const MixSnapshot>>& freed);
+
+  /// Block until |Mix()| finished any mixing pass in progress at |epoch|.
+  /// This must not be called with |crit_| held, nor from |Mix()|.
+  void WaitForMixPass(uint64_t epoch) const;
+
   rtc::CriticalSection crit_;
   rtc::scoped_refptr<webrtc::AudioMixerImpl> base_impl_;
-  std::map<int, KnownSource> source_from_id_;
+  std::map<int, KnownSource> source_from_id_ RTC_GUARDED_BY(crit_);
+  std::vector<ClockObserver*> clock_observers_ RTC_GUARDED_BY(crit_);
+
+  /// Snapshot currently used by |Mix()|, owned by the mixer.
+  std::atomic<const MixSnapshot*> snapshot_;
+
+  /// Snapshots replaced but possibly still accessed by |Mix()|.
+  std::vector<RetiredSnapshot> retired_ RTC_GUARDED_BY(crit_);
+
+  /// Mixing pass counter, odd while |Mix()| is executing.
+  std::atomic<uint64_t> mix_epoch_{0};
+
+  /// Scratch frame into which redirected sources are pumped. This is only
+  /// accessed from |Mix()|, which the audio device calls from a single thread,
+  /// and is kept as a member to avoid a large stack allocation per source.
+  webrtc::AudioFrame pump_frame_;
 };
 
 }  // namespace WebRTC
@@ -31,7 +31,9 @@ enum class ObjectType : int {
   kDeviceAudioTrackSource,
   kDeviceVideoTrackSource,
   kExternalVideoTrackSource,
+  kExternalAudioTrackSource,
   kAudioTrackReadBuffer,
+  kAudioTrackMixedReadBuffer,
 };
 
 /// Object tracked for interop, exposing helper methods for debugging purpose.
@@ -128,6 +128,12 @@ absl::string_view ObjectTypeToString(ObjectType type) {
       return "DeviceVideoTrackSource";
     case ObjectType::kExternalVideoTrackSource:
       return "ExternalVideoTrackSource";
+    case ObjectType::kExternalAudioTrackSource:
+      return "ExternalAudioTrackSource";
+    case ObjectType::kAudioTrackReadBuffer:
+      return "AudioTrackReadBuffer";
+    case ObjectType::kAudioTrackMixedReadBuffer:
+      return "AudioTrackMixedReadBuffer";
     default:
       RTC_NOTREACHED();
       return "<UnknownObjectType>";
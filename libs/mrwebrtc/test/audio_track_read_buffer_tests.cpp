@@ -3,6 +3,9 @@
 
 #include "pch.h"
 
+#include <cmath>
+#include <thread>
+
 #include "audio_frame.h"
 #include "device_audio_track_source_interop.h"
 #include "interop_api.h"
@@ -18,15 +21,206 @@ class AudioTrackReadBufferTests
     : public TestUtils::TestBase,
       public testing::WithParamInterface<mrsSdpSemantic> {};
 
+class AudioTrackMixedReadBufferTests : public TestUtils::TestBase {};
+
+// PeerConnectionAudioTrackAddedCallback
+using AudioTrackAddedCallback =
+    InteropCallback<const mrsRemoteAudioTrackAddedInfo*>;
+
 }  // namespace
 
-#if !defined(MRSW_EXCLUDE_DEVICE_TESTS)
+TEST_F(AudioTrackMixedReadBufferTests, InvalidParams) {
+  mrsAudioTrackMixedReadBufferHandle mixed_buffer{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackMixedReadBufferCreate(48000, 2, 0, nullptr));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackMixedReadBufferCreate(0, 2, 0, &mixed_buffer));
+  ASSERT_EQ(nullptr, mixed_buffer);
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackMixedReadBufferCreate(48000, 3, 0, &mixed_buffer));
+  ASSERT_EQ(nullptr, mixed_buffer);
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsAudioTrackMixedReadBufferCreate(48000, 2, -10, &mixed_buffer));
+  ASSERT_EQ(nullptr, mixed_buffer);
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsAudioTrackMixedReadBufferAddTrack(nullptr, nullptr, 1.0f));
+}
+
+TEST_F(AudioTrackMixedReadBufferTests, ReadEmpty) {
+  mrsAudioTrackMixedReadBufferHandle mixed_buffer{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackMixedReadBufferCreate(48000, 2, 0, &mixed_buffer));
+  ASSERT_NE(nullptr, mixed_buffer);
+
+  // Without any track, reading pads the output as requested.
+  std::vector<float> buffer(960, 1.0f);
+  int num_samples_read = -1;
+  mrsBool has_overrun = mrsBool::kTrue;
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackMixedReadBufferRead(
+                mixed_buffer, mrsAudioTrackReadBufferPadBehavior::kDoNotPad,
+                buffer.data(), (int)buffer.size(), &num_samples_read,
+                &has_overrun));
+  ASSERT_EQ(0, num_samples_read);
+  ASSERT_EQ(mrsBool::kFalse, has_overrun);
+  ASSERT_EQ(Result::kSuccess,
+            mrsAudioTrackMixedReadBufferRead(
+                mixed_buffer, mrsAudioTrackReadBufferPadBehavior::kPadWithZero,
+                buffer.data(), (int)buffer.size(), &num_samples_read,
+                &has_overrun));
+  ASSERT_EQ(0, num_samples_read);
+  for (float sample : buffer) {
+    ASSERT_EQ(0.0f, sample);
+  }
+
+  mrsAudioTrackMixedReadBufferDestroy(mixed_buffer);
+}
+
+#if !defined(WINUWP)
 
 namespace {
 
-// PeerConnectionAudioTrackAddedCallback
-using AudioTrackAddedCallback =
-    InteropCallback<const mrsRemoteAudioTrackAddedInfo*>;
+// Read everything currently buffered, and return the number of samples read,
+// the largest absolute sample value, and whether some frames were dropped
+// because the buffer overflowed.
+int DrainMixedBuffer(mrsAudioTrackMixedReadBufferHandle mixed_buffer,
+                     std::vector<float>& buffer,
+                     float& max_abs,
+                     bool& overrun) {
+  int total_read = 0;
+  max_abs = 0.0f;
+  overrun = false;
+  for (;;) {
+    int num_samples_read = 0;
+    mrsBool has_overrun = mrsBool::kFalse;
+    EXPECT_EQ(Result::kSuccess,
+              mrsAudioTrackMixedReadBufferRead(
+                  mixed_buffer, mrsAudioTrackReadBufferPadBehavior::kDoNotPad,
+                  buffer.data(), (int)buffer.size(), &num_samples_read,
+                  &has_overrun));
+    overrun = overrun || (has_overrun != mrsBool::kFalse);
+    if (num_samples_read <= 0) {
+      return total_read;
+    }
+    for (int i = 0; i < num_samples_read; ++i) {
+      max_abs = std::max(max_abs, std::abs(buffer[i]));
+    }
+    total_read += num_samples_read;
+  }
+}
+
+}  // namespace
+
+TEST_F(AudioTrackMixedReadBufferTests, MixTwoTracks) {
+  // Record a 1 kHz square wave instead of a microphone, so that the remote
+  // tracks carry some known non-silent audio.
+  std::vector<int16_t> tone(480);
+  for (size_t i = 0; i < tone.size(); ++i) {
+    tone[i] = ((i / 24) % 2) ? 8000 : -8000;
+  }
+  mrsHeadlessAudioDeviceConfig adm_config{};
+  adm_config.capture_samples = tone.data();
+  adm_config.capture_sample_count = (uint32_t)tone.size();
+  TestUtils::HeadlessAudioDeviceRaii adm(adm_config);
+
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = mrsSdpSemantic::kUnifiedPlan;
+  LocalPeerPairRaii pair(pc_config);
+
+  // Collect the two remote tracks of #2.
+  std::vector<mrsRemoteAudioTrackHandle> remote_tracks;
+  Semaphore track_added2_sem;
+  AudioTrackAddedCallback track_added2_cb =
+      [&remote_tracks,
+       &track_added2_sem](const mrsRemoteAudioTrackAddedInfo* info) {
+        remote_tracks.push_back(info->track_handle);
+        track_added2_sem.Release();
+      };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+
+  {
+    TestUtils::LocalAudioSenderRaii sender1(pair.pc1(), "track1");
+    TestUtils::LocalAudioSenderRaii sender2(pair.pc1(), "track2");
+    pair.ConnectAndWait();
+    ASSERT_TRUE(track_added2_sem.TryAcquireFor(5s, 2));
+    ASSERT_EQ(2u, remote_tracks.size());
+    for (auto track : remote_tracks) {
+      ASSERT_EQ(Result::kSuccess,
+                mrsRemoteAudioTrackOutputToDevice(track, false));
+    }
+
+    constexpr int kSampleRate = 48000;
+    mrsAudioTrackMixedReadBufferHandle mixed_buffer{};
+    // Buffer more than the longest wait below, so that no frame is dropped.
+    ASSERT_EQ(Result::kSuccess, mrsAudioTrackMixedReadBufferCreate(
+                                    kSampleRate, 1, 3000, &mixed_buffer));
+    ASSERT_EQ(Result::kSuccess, mrsAudioTrackMixedReadBufferAddTrack(
+                                    mixed_buffer, remote_tracks[0], 0.0f));
+    ASSERT_EQ(Result::kSuccess, mrsAudioTrackMixedReadBufferAddTrack(
+                                    mixed_buffer, remote_tracks[1], 0.0f));
+    ASSERT_EQ(Result::kInvalidOperation,
+              mrsAudioTrackMixedReadBufferAddTrack(mixed_buffer,
+                                                   remote_tracks[0], 1.0f));
+
+    std::vector<float> buffer(kSampleRate);
+    float max_abs = 0.0f;
+    bool overrun = false;
+    DrainMixedBuffer(mixed_buffer, buffer, max_abs, overrun);
+
+    // Both tracks are aligned on the same grid, so mixing them produces a
+    // single stream of audio at the real-time rate, and not one per track.
+    // With a zero gain the mix is exactly silent.
+    std::this_thread::sleep_for(2s);
+    int total_read = DrainMixedBuffer(mixed_buffer, buffer, max_abs, overrun);
+    ASSERT_FALSE(overrun);
+    ASSERT_GT(total_read, kSampleRate * 2 / 2);
+    ASSERT_LT(total_read, kSampleRate * 2 * 3 / 2);
+    ASSERT_EQ(0.0f, max_abs);
+
+    // A unit gain on one track lets its audio through, within range.
+    ASSERT_EQ(Result::kSuccess, mrsAudioTrackMixedReadBufferSetTrackGain(
+                                    mixed_buffer, remote_tracks[0], 1.0f));
+    DrainMixedBuffer(mixed_buffer, buffer, max_abs, overrun);
+    std::this_thread::sleep_for(500ms);
+    ASSERT_GT(DrainMixedBuffer(mixed_buffer, buffer, max_abs, overrun), 0);
+    ASSERT_FALSE(overrun);
+    ASSERT_GT(max_abs, 0.01f);
+    ASSERT_LE(max_abs, 1.0f);
+
+    // A large gain on both tracks saturates the mix.
+    ASSERT_EQ(Result::kSuccess, mrsAudioTrackMixedReadBufferSetTrackGain(
+                                    mixed_buffer, remote_tracks[0], 100.0f));
+    ASSERT_EQ(Result::kSuccess, mrsAudioTrackMixedReadBufferSetTrackGain(
+                                    mixed_buffer, remote_tracks[1], 100.0f));
+    DrainMixedBuffer(mixed_buffer, buffer, max_abs, overrun);
+    std::this_thread::sleep_for(500ms);
+    ASSERT_GT(DrainMixedBuffer(mixed_buffer, buffer, max_abs, overrun), 0);
+    ASSERT_FALSE(overrun);
+    ASSERT_EQ(1.0f, max_abs);
+
+    // Removing a track keeps the other one mixing.
+    ASSERT_EQ(Result::kSuccess, mrsAudioTrackMixedReadBufferRemoveTrack(
+                                    mixed_buffer, remote_tracks[1]));
+    ASSERT_EQ(Result::kNotFound, mrsAudioTrackMixedReadBufferRemoveTrack(
+                                     mixed_buffer, remote_tracks[1]));
+    ASSERT_EQ(Result::kNotFound, mrsAudioTrackMixedReadBufferSetTrackGain(
+                                     mixed_buffer, remote_tracks[1], 1.0f));
+    DrainMixedBuffer(mixed_buffer, buffer, max_abs, overrun);
+    std::this_thread::sleep_for(500ms);
+    ASSERT_GT(DrainMixedBuffer(mixed_buffer, buffer, max_abs, overrun), 0);
+    ASSERT_FALSE(overrun);
+
+    mrsAudioTrackMixedReadBufferDestroy(mixed_buffer);
+  }
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+}
+
+#endif  // !defined(WINUWP)
+
+#if !defined(MRSW_EXCLUDE_DEVICE_TESTS)
+
+namespace {
 
 // PeerConnectionAudioFrameCallback
 using AudioFrameCallback = InteropCallback<const AudioFrame&>;
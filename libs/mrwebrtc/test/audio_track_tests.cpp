@@ -3,8 +3,11 @@
 
 #include "pch.h"
 
+#include <thread>
+
 #include "audio_frame.h"
 #include "device_audio_track_source_interop.h"
+#include "external_audio_track_source_interop.h"
 #include "interop_api.h"
 #include "local_audio_track_interop.h"
 #include "remote_audio_track_interop.h"
@@ -17,8 +20,99 @@ namespace {
 class AudioTrackTests : public TestUtils::TestBase,
                         public testing::WithParamInterface<mrsSdpSemantic> {};
 
+class AudioTrackFrameBatchTests : public TestUtils::TestBase {};
+
+// PeerConnectionAudioFrameCallback
+using AudioFrameCallback = InteropCallback<const AudioFrame&>;
+
+// mrsAudioFrameBatchCallback
+using AudioFrameBatchCallback =
+    InteropCallback<const mrsAudioFrame&, int64_t>;
+
 }  // namespace
 
+TEST_F(AudioTrackFrameBatchTests, LocalTrack) {
+  // Use an external source, which delivers frames without any audio device.
+  mrsExternalAudioTrackSourceConfig config{};
+  config.sample_rate = 16000;
+  config.channel_count = 2;
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsExternalAudioTrackSourceCreate(&config, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "external_audio_track";
+  mrsLocalAudioTrackHandle track_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, source_handle,
+                                               &track_handle));
+  ASSERT_NE(nullptr, track_handle);
+
+  // Invalid batch configuration
+  mrsAudioFrameBatchConfig batch_config{};
+  batch_config.duration_ms = 0;
+  batch_config.sample_count = 0;
+  AudioFrameBatchCallback batch_cb = [](const mrsAudioFrame&, int64_t) {};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsLocalAudioTrackRegisterFrameBatchCallback(
+                track_handle, &batch_config, CB(batch_cb)));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsLocalAudioTrackRegisterFrameBatchCallback(
+                nullptr, &batch_config, CB(batch_cb)));
+
+  // Batches of 40 ms, each delivered as a single contiguous buffer with
+  // increasing timestamps. Unregistering flushes the pending partial batch, if
+  // any, synchronously on the unregistering thread; only that last batch may
+  // be shorter.
+  batch_config.duration_ms = 40;
+  const std::thread::id test_thread_id = std::this_thread::get_id();
+  std::atomic_bool unregistering{false};
+  uint32_t batch_count = 0;
+  uint32_t partial_batch_count = 0;
+  int64_t last_timestamp_ms = -1;
+  Event batches_received;
+  batch_cb = [&](const mrsAudioFrame& frame, int64_t timestamp_ms) {
+    ASSERT_NE(nullptr, frame.data_);
+    ASSERT_EQ(16u, frame.bits_per_sample_);
+    ASSERT_EQ(16000u, frame.sampling_rate_hz_);
+    ASSERT_EQ(2u, frame.channel_count_);
+    if (frame.sample_count_ != 640u) {
+      ASSERT_TRUE(unregistering.load());
+      ASSERT_EQ(test_thread_id, std::this_thread::get_id());
+      ASSERT_LT(frame.sample_count_, 640u);
+      ASSERT_EQ(0u, frame.sample_count_ % 160u);
+      ++partial_batch_count;
+    }
+    ASSERT_LT(last_timestamp_ms, timestamp_ms);
+    last_timestamp_ms = timestamp_ms;
+    if (++batch_count == 10) {
+      batches_received.Set();
+    }
+  };
+  ASSERT_EQ(Result::kSuccess, mrsLocalAudioTrackRegisterFrameBatchCallback(
+                                  track_handle, &batch_config, CB(batch_cb)));
+  ASSERT_TRUE(batches_received.WaitFor(5s));
+  unregistering = true;
+  ASSERT_EQ(Result::kSuccess, mrsLocalAudioTrackRegisterFrameBatchCallback(
+                                  track_handle, nullptr, nullptr, nullptr));
+  ASSERT_LE(partial_batch_count, 1u);
+
+  // Nothing is delivered once unregistered.
+  const uint32_t final_count = batch_count;
+  Event frame_received;
+  AudioFrameCallback frame_cb = [&frame_received](const mrsAudioFrame&) {
+    frame_received.Set();
+  };
+  mrsLocalAudioTrackRegisterFrameCallback(track_handle, CB(frame_cb));
+  ASSERT_TRUE(frame_received.WaitFor(5s));
+  mrsLocalAudioTrackRegisterFrameCallback(track_handle, nullptr, nullptr);
+  ASSERT_EQ(final_count, batch_count);
+
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
 #if !defined(MRSW_EXCLUDE_DEVICE_TESTS)
 
 namespace {
@@ -27,8 +121,8 @@ namespace {
 using AudioTrackAddedCallback =
     InteropCallback<const mrsRemoteAudioTrackAddedInfo*>;
 
-// PeerConnectionAudioFrameCallback
-using AudioFrameCallback = InteropCallback<const AudioFrame&>;
+// RemoteAudioTrackAudioLevelCallback
+using AudioLevelCallback = InteropCallback<const mrsAudioLevel&>;
 
 bool IsSilent_uint8(const uint8_t* data,
                     uint32_t size,
@@ -227,6 +321,19 @@ TEST_P(AudioTrackTests, Simple) {
   };
   mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, CB(audio2_cb));
 
+  // Register a level callback on the remote track of #2
+  uint32_t level_call_count = 0;
+  AudioLevelCallback level2_cb = [&level_call_count](
+                                     const mrsAudioLevel& level) {
+    ASSERT_LE(0.0f, level.rms_);
+    ASSERT_GE(1.0f, level.rms_);
+    ASSERT_LE(level.rms_, level.peak_);
+    ASSERT_GE(1.0f, level.peak_);
+    ++level_call_count;
+  };
+  mrsRemoteAudioTrackRegisterAudioLevelCallback(audio_track2, CB(level2_cb),
+                                                100);
+
   // Check several times this, because the audio "mute" is flaky, does not
   // really mute the audio, so check that the reported status is still
   // correct.
@@ -236,6 +343,17 @@ TEST_P(AudioTrackTests, Simple) {
   Event ev;
   ev.WaitFor(3s);
   ASSERT_LT(30u, call_count) << "Expected at least 10 CPS";
+  ASSERT_LT(10u, level_call_count) << "Expected at least one call per 100ms";
+
+  // Poll the level
+  mrsAudioLevel level{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackGetAudioLevel(audio_track2, &level));
+  ASSERT_LE(level.rms_, level.peak_);
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsRemoteAudioTrackGetAudioLevel(nullptr, &level));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsRemoteAudioTrackGetAudioLevel(audio_track2, nullptr));
 
   // Same as above
   ASSERT_NE(mrsBool::kFalse, mrsLocalAudioTrackIsEnabled(audio_track1));
@@ -243,6 +361,8 @@ TEST_P(AudioTrackTests, Simple) {
   ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
 
   // Clean-up
+  mrsRemoteAudioTrackRegisterAudioLevelCallback(audio_track2, nullptr,
+                                                nullptr, 0);
   mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, nullptr, nullptr);
   mrsRefCountedObjectRemoveRef(audio_track1);
   mrsRefCountedObjectRemoveRef(audio_source1);
@@ -3,6 +3,15 @@
 
 #include "pch.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "data_channel_interop.h"
 #include "interop_api.h"
 
@@ -32,6 +41,153 @@ void MRS_CALL StaticStateCallback(void* user_data,
   func(state, id);
 }
 
+/// Message recorded by |DataChannelPairRaii|.
+struct ReceivedMessage {
+  mrsMessageKind kind;
+  std::string data;
+};
+
+/// Pair of local peer connections, each with an out-of-band, reliable, and
+/// ordered "data" channel negotiated with the other one. The channels open
+/// once the peers are connected with |Open()|, so tests can also use them
+/// before that. Messages delivered to the message callback of each channel are
+/// recorded in reception order.
+class DataChannelPairRaii {
+ public:
+  class Peer {
+   public:
+    mrsDataChannelHandle handle() const { return handle_; }
+
+    /// Wait until |count| more messages were delivered to the callback.
+    bool WaitMessagesFor(std::chrono::seconds timeout, int64_t count) {
+      return received_.TryAcquireFor(timeout, count);
+    }
+
+    /// Get a copy of all the messages delivered so far, in order.
+    std::vector<ReceivedMessage> messages() const {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return messages_;
+    }
+
+   private:
+    friend class DataChannelPairRaii;
+    static void MRS_CALL OnMessage(void* user_data,
+                                   const mrsMessageKind kind,
+                                   const void* data,
+                                   const uint64_t size) noexcept {
+      auto peer = static_cast<Peer*>(user_data);
+      {
+        std::lock_guard<std::mutex> lock(peer->mutex_);
+        peer->messages_.push_back(
+            {kind, std::string((const char*)data, (size_t)size)});
+      }
+      peer->received_.Release();
+    }
+    static void MRS_CALL OnStateChanged(void* user_data,
+                                        mrsDataChannelState state,
+                                        int32_t /*id*/) noexcept {
+      if (state == mrsDataChannelState::kOpen) {
+        static_cast<Peer*>(user_data)->opened_.Set();
+      }
+    }
+    mrsDataChannelHandle handle_{};
+    Event opened_;
+    Semaphore received_;
+    mutable std::mutex mutex_;
+    std::vector<ReceivedMessage> messages_;
+  };
+
+  DataChannelPairRaii(mrsSdpSemantic sdp_semantic)
+      : pair_(MakeConfig(sdp_semantic)) {
+    mrsDataChannelConfig config{};
+    config.id = 42;
+    config.label = "data";
+    config.flags = mrsDataChannelConfigFlags::kOrdered |
+                   mrsDataChannelConfigFlags::kReliable;
+    AddChannel(pair_.pc1(), config, peer1_);
+    AddChannel(pair_.pc2(), config, peer2_);
+  }
+
+  mrsPeerConnectionHandle pc1() const { return pair_.pc1(); }
+  mrsPeerConnectionHandle pc2() const { return pair_.pc2(); }
+  Peer& peer1() { return peer1_; }
+  Peer& peer2() { return peer2_; }
+
+  /// Connect the peers and wait for both channels to be open.
+  void Open() {
+    pair_.ConnectAndWait();
+    ASSERT_TRUE(peer1_.opened_.WaitFor(60s));
+    ASSERT_TRUE(peer2_.opened_.WaitFor(60s));
+  }
+
+ private:
+  static mrsPeerConnectionConfiguration MakeConfig(
+      mrsSdpSemantic sdp_semantic) {
+    mrsPeerConnectionConfiguration pc_config{};
+    pc_config.sdp_semantic = sdp_semantic;
+    return pc_config;
+  }
+  static void AddChannel(mrsPeerConnectionHandle pc,
+                         const mrsDataChannelConfig& config,
+                         Peer& peer) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddDataChannel(pc, &config, &peer.handle_));
+    ASSERT_NE(nullptr, peer.handle_);
+    mrsDataChannelCallbacks callbacks{};
+    callbacks.message_ex_callback = &Peer::OnMessage;
+    callbacks.message_ex_user_data = &peer;
+    callbacks.state_callback = &Peer::OnStateChanged;
+    callbacks.state_user_data = &peer;
+    mrsDataChannelRegisterCallbacks(peer.handle_, &callbacks);
+  }
+
+  // The peers are declared before the peer connections, so that they outlive
+  // the channels and their callbacks.
+  Peer peer1_;
+  Peer peer2_;
+  LocalPeerPairRaii pair_;
+};
+
+/// Build the content of the message #|index| of a sequence, to check the
+/// reception order.
+std::string MakeMessage(int index) {
+  return "message #" + std::to_string(index);
+}
+
+/// Progress of a stream transfer, as reported by its progress callback.
+struct StreamProgress {
+  using CallbackType = InteropCallback<uint32_t,
+                                       mrsDataChannelStreamStatus,
+                                       uint64_t,
+                                       uint64_t>;
+  StreamProgress()
+      : callback([this](uint32_t /*stream_id*/,
+                        mrsDataChannelStreamStatus status,
+                        uint64_t transferred_bytes, uint64_t total_bytes) {
+          ASSERT_LE(transferred_bytes, total_bytes);
+          if (status != mrsDataChannelStreamStatus::kInProgress) {
+            final_status = status;
+            final_bytes = transferred_bytes;
+            finished.Set();
+          }
+        }) {}
+  CallbackType callback;
+  std::atomic<mrsDataChannelStreamStatus> final_status{
+      mrsDataChannelStreamStatus::kInProgress};
+  std::atomic<uint64_t> final_bytes{0};
+  Event finished;
+};
+
+/// Build a payload of |size| bytes which is not a repetition of the chunk
+/// size, to detect misplaced chunks.
+std::vector<char> MakeStreamPayload(size_t size) {
+  std::vector<char> payload(size);
+  for (size_t i = 0; i < size; ++i) {
+    payload[i] = (char)((i * 7 + i / 251) & 0xFF);
+  }
+  return payload;
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_CASE_P(,
@@ -53,6 +209,636 @@ TEST_P(DataChannelTests, AddChannelBeforeInit) {
             mrsPeerConnectionAddDataChannel(pc.handle(), &config, &handle));
 }
 
+TEST_P(DataChannelTests, Metrics) {
+  DataChannelPairRaii channels(GetParam());
+  const mrsDataChannelHandle handle1 = channels.peer1().handle();
+  const mrsDataChannelHandle handle2 = channels.peer2().handle();
+
+  mrsDataChannelMetrics metrics{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelGetMetrics(nullptr, &metrics));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelGetMetrics(handle1, nullptr));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetMetrics(handle1, &metrics));
+  ASSERT_EQ(0u, metrics.messages_sent);
+  ASSERT_EQ(0u, metrics.messages_received);
+  ASSERT_EQ(0u, metrics.send_rejections);
+
+  // The channel is not open, so sending is rejected.
+  const char payload[] = "message";
+  ASSERT_EQ(Result::kUnknownError,
+            mrsDataChannelSendMessage(handle1, payload, sizeof(payload)));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetMetrics(handle1, &metrics));
+  ASSERT_EQ(0u, metrics.messages_sent);
+  ASSERT_EQ(0u, metrics.bytes_sent);
+  ASSERT_EQ(1u, metrics.send_rejections);
+
+  // Real traffic is counted on both ends.
+  channels.Open();
+  constexpr int kCount = 16;
+  uint64_t total_size = 0;
+  for (int i = 0; i < kCount; ++i) {
+    const std::string message = MakeMessage(i);
+    ASSERT_EQ(Result::kSuccess, mrsDataChannelSendMessage(
+                                    handle1, message.data(), message.size()));
+    total_size += message.size();
+  }
+  ASSERT_TRUE(channels.peer2().WaitMessagesFor(60s, kCount));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetMetrics(handle1, &metrics));
+  ASSERT_EQ((uint64_t)kCount, metrics.messages_sent);
+  ASSERT_EQ(total_size, metrics.bytes_sent);
+  ASSERT_EQ(1u, metrics.send_rejections);
+  ASSERT_LE(metrics.peak_buffered_amount, total_size);
+
+  // The callback duration is recorded once the callback returned, so shortly
+  // after the message was delivered.
+  uint64_t callback_count = 0;
+  for (int retry = 0; retry < 100; ++retry) {
+    ASSERT_EQ(Result::kSuccess, mrsDataChannelGetMetrics(handle2, &metrics));
+    callback_count = 0;
+    for (uint64_t count : metrics.callback_duration_histogram) {
+      callback_count += count;
+    }
+    if (callback_count == (uint64_t)kCount) {
+      break;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  ASSERT_EQ((uint64_t)kCount, callback_count);
+  ASSERT_EQ((uint64_t)kCount, metrics.messages_received);
+  ASSERT_EQ(total_size, metrics.bytes_received);
+  ASSERT_EQ(0u, metrics.messages_sent);
+}
+
+TEST_P(DataChannelTests, PollingReceive) {
+  DataChannelPairRaii channels(GetParam());
+  const mrsDataChannelHandle handle = channels.peer2().handle();
+
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelSetReceiveMode(nullptr,
+                                         mrsDataChannelReceiveMode::kPolling));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSetReceiveMode(handle,
+                                         (mrsDataChannelReceiveMode)42));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelSetReceiveMode(
+                                  handle, mrsDataChannelReceiveMode::kPolling));
+
+  mrsDataChannelReceivedMessage messages[8]{};
+  uint32_t count = 42;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelReceive(handle, nullptr, 8, &count));
+  ASSERT_EQ(0u, count);
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelReceive(handle, messages, 8, nullptr));
+
+  // Nothing received yet
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelReceive(handle, messages, 8, &count));
+  ASSERT_EQ(0u, count);
+  mrsDataChannelReleaseMessages(messages, count);
+
+  // Messages are delivered through the queue, in order, and not to the
+  // message callback.
+  channels.Open();
+  constexpr int kCount = 100;
+  for (int i = 0; i < kCount; ++i) {
+    const std::string message = MakeMessage(i);
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendMessageEx(channels.peer1().handle(),
+                                          mrsMessageKind::kText,
+                                          message.data(), message.size()));
+  }
+  int received_count = 0;
+  const auto deadline = std::chrono::steady_clock::now() + 60s;
+  while ((received_count < kCount) &&
+         (std::chrono::steady_clock::now() < deadline)) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelReceive(handle, messages, 8, &count));
+    for (uint32_t i = 0; i < count; ++i) {
+      ASSERT_EQ(mrsMessageKind::kText, messages[i].kind);
+      ASSERT_EQ(MakeMessage(received_count++),
+                std::string((const char*)messages[i].data,
+                            (size_t)messages[i].size));
+    }
+    mrsDataChannelReleaseMessages(messages, count);
+    if (count == 0) {
+      std::this_thread::sleep_for(1ms);
+    }
+  }
+  ASSERT_EQ(kCount, received_count);
+  ASSERT_TRUE(channels.peer2().messages().empty());
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetReceiveMode(handle,
+                                         mrsDataChannelReceiveMode::kCallback));
+}
+
+// Messages received while the polling receive queue is full are dropped and
+// counted, and the queue accepts messages again once drained.
+TEST_P(DataChannelTests, PollingReceiveCapacity) {
+  DataChannelPairRaii channels(GetParam());
+  const mrsDataChannelHandle handle = channels.peer2().handle();
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelSetReceiveQueueCapacity(nullptr, 10));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSetReceiveQueueCapacity(handle, 0));
+  constexpr uint32_t kCapacity = 10;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSetReceiveQueueCapacity(handle, kCapacity));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelSetReceiveMode(
+                                  handle, mrsDataChannelReceiveMode::kPolling));
+  channels.Open();
+
+  // Fill the queue past its capacity without draining it.
+  constexpr int kCount = 50;
+  for (int i = 0; i < kCount; ++i) {
+    const std::string message = MakeMessage(i);
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendMessage(channels.peer1().handle(),
+                                        message.data(), message.size()));
+  }
+  mrsDataChannelMetrics metrics{};
+  for (int retry = 0; retry < 6000; ++retry) {
+    ASSERT_EQ(Result::kSuccess, mrsDataChannelGetMetrics(handle, &metrics));
+    if (metrics.receive_drops == (uint64_t)(kCount - kCapacity)) {
+      break;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  ASSERT_EQ((uint64_t)(kCount - kCapacity), metrics.receive_drops);
+  ASSERT_EQ((uint64_t)kCount, metrics.messages_received);
+
+  // The oldest messages were kept, in order.
+  mrsDataChannelReceivedMessage messages[kCount]{};
+  uint32_t count = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelReceive(handle, messages, kCount, &count));
+  ASSERT_EQ(kCapacity, count);
+  for (uint32_t i = 0; i < count; ++i) {
+    ASSERT_EQ(MakeMessage(i), std::string((const char*)messages[i].data,
+                                          (size_t)messages[i].size));
+  }
+  mrsDataChannelReleaseMessages(messages, count);
+
+  // Once drained, the queue accepts messages again.
+  const std::string message = MakeMessage(kCount);
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSendMessage(channels.peer1().handle(),
+                                      message.data(), message.size()));
+  const auto deadline = std::chrono::steady_clock::now() + 60s;
+  do {
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelReceive(handle, messages, kCount, &count));
+    if (count == 0) {
+      std::this_thread::sleep_for(1ms);
+    }
+  } while ((count == 0) && (std::chrono::steady_clock::now() < deadline));
+  ASSERT_EQ(1u, count);
+  ASSERT_EQ(message, std::string((const char*)messages[0].data,
+                                 (size_t)messages[0].size));
+  mrsDataChannelReleaseMessages(messages, count);
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetMetrics(handle, &metrics));
+  ASSERT_EQ((uint64_t)(kCount - kCapacity), metrics.receive_drops);
+}
+
+TEST_P(DataChannelTests, SendQueue) {
+  DataChannelPairRaii channels(GetParam());
+  const mrsDataChannelHandle handle = channels.peer1().handle();
+
+  mrsDataChannelSendQueueState state{};
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetSendQueueState(handle, &state));
+  ASSERT_EQ(0u, state.queued_bytes);
+  ASSERT_EQ(0u, state.queued_message_count);
+  ASSERT_EQ(mrsBool::kTrue, state.writable);
+
+  // Invalid watermarks
+  mrsDataChannelSendQueueConfig queue_config{};
+  queue_config.capacity = 4 * 1024 * 1024;
+  queue_config.high_watermark = 1024;
+  queue_config.low_watermark = 2048;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelConfigureSendQueue(handle, &queue_config));
+  queue_config.high_watermark = 0x1000001uLL;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelConfigureSendQueue(handle, &queue_config));
+
+  // Enable, then disable
+  queue_config = {};
+  queue_config.capacity = 4 * 1024 * 1024;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelConfigureSendQueue(handle, &queue_config));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelConfigureSendQueue(nullptr, &queue_config));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelConfigureSendQueue(handle, nullptr));
+
+  // The channel is not open, so messages are rejected rather than queued.
+  const char payload[] = "message";
+  ASSERT_EQ(Result::kUnknownError,
+            mrsDataChannelSendMessage(handle, payload, sizeof(payload)));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetSendQueueState(handle, &state));
+  ASSERT_EQ(0u, state.queued_message_count);
+
+  queue_config.capacity = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelConfigureSendQueue(handle, &queue_config));
+}
+
+// A burst exceeding the high watermark is queued instead of rejected, then
+// handed to SCTP in order as it drains, which fires the writable event.
+TEST_P(DataChannelTests, SendQueueBurst) {
+  DataChannelPairRaii channels(GetParam());
+  const mrsDataChannelHandle handle = channels.peer1().handle();
+  mrsDataChannelSendQueueConfig queue_config{};
+  queue_config.capacity = 32 * 1024 * 1024;
+  queue_config.high_watermark = 64 * 1024;
+  queue_config.low_watermark = 16 * 1024;
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelConfigureSendQueue(handle, &queue_config));
+  Event writable_ev;
+  InteropCallback<> writable_cb([&writable_ev]() { writable_ev.Set(); });
+  mrsDataChannelRegisterWritableCallback(handle, CB(writable_cb));
+  writable_cb.is_registered_ = true;
+  channels.Open();
+
+  // Send much more than SCTP can buffer below the high watermark.
+  constexpr int kCount = 1024;
+  constexpr size_t kSize = 16 * 1024;
+  uint64_t max_queued_count = 0;
+  mrsDataChannelSendQueueState state{};
+  for (int i = 0; i < kCount; ++i) {
+    std::string message = MakeMessage(i);
+    message.resize(kSize, '.');
+    ASSERT_EQ(Result::kSuccess, mrsDataChannelSendMessage(
+                                    handle, message.data(), message.size()));
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelGetSendQueueState(handle, &state));
+    ASSERT_LE(state.queued_bytes, queue_config.capacity);
+    max_queued_count = std::max(max_queued_count, state.queued_message_count);
+  }
+  ASSERT_LT(0u, max_queued_count);
+
+  // All messages arrive in order, and the queue eventually drains.
+  ASSERT_TRUE(channels.peer2().WaitMessagesFor(60s, kCount));
+  const std::vector<ReceivedMessage> received = channels.peer2().messages();
+  ASSERT_EQ((size_t)kCount, received.size());
+  for (int i = 0; i < kCount; ++i) {
+    std::string expected = MakeMessage(i);
+    expected.resize(kSize, '.');
+    ASSERT_EQ(expected, received[i].data);
+  }
+  ASSERT_TRUE(writable_ev.WaitFor(60s));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetSendQueueState(handle, &state));
+  ASSERT_EQ(0u, state.queued_message_count);
+  ASSERT_EQ(0u, state.queued_bytes);
+  ASSERT_EQ(mrsBool::kTrue, state.writable);
+  mrsDataChannelMetrics metrics{};
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetMetrics(handle, &metrics));
+  ASSERT_EQ((uint64_t)kCount, metrics.messages_sent);
+  ASSERT_EQ(0u, metrics.send_rejections);
+
+  mrsDataChannelRegisterWritableCallback(handle, nullptr, nullptr);
+  writable_cb.is_registered_ = false;
+}
+
+TEST_P(DataChannelTests, StreamInvalidUsage) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+  mrsDataChannelConfig config{};
+  config.label = "stream";
+  config.flags = mrsDataChannelConfigFlags::kOrdered |
+                 mrsDataChannelConfigFlags::kReliable;
+  mrsDataChannelHandle handle;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pc.handle(), &config, &handle));
+  config.label = "unreliable";
+  config.flags = mrsDataChannelConfigFlags::kNone;
+  mrsDataChannelHandle unreliable_handle;
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionAddDataChannel(
+                                  pc.handle(), &config, &unreliable_handle));
+
+  const char payload[] = "payload";
+  mrsDataChannelStreamSource source{};
+  source.data = payload;
+  source.size = sizeof(payload);
+  uint32_t stream_id = 0;
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelSendStream(nullptr, &source, nullptr, nullptr,
+                                     &stream_id));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSendStream(handle, nullptr, nullptr, nullptr,
+                                     &stream_id));
+
+  // Streams require a reliable and ordered channel.
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsDataChannelSendStream(unreliable_handle, &source, nullptr,
+                                     nullptr, &stream_id));
+
+  // The channel is not open.
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsDataChannelSendStream(handle, &source, nullptr, nullptr,
+                                     &stream_id));
+
+  // Only a single stream can be received at a time.
+  char destination_data[64];
+  mrsDataChannelStreamDestination destination{};
+  destination.data = destination_data;
+  destination.capacity = sizeof(destination_data);
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelReceiveStream(
+                                  handle, &destination, nullptr, nullptr));
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsDataChannelReceiveStream(handle, &destination, nullptr,
+                                        nullptr));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelAbortStreams(handle));
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelReceiveStream(
+                                  handle, &destination, nullptr, nullptr));
+}
+
+// A payload spanning many chunks is reassembled by the remote peer, from
+// memory to memory, and from file to file.
+TEST_P(DataChannelTests, StreamTransfer) {
+  DataChannelPairRaii channels(GetParam());
+  const mrsDataChannelHandle handle1 = channels.peer1().handle();
+  const mrsDataChannelHandle handle2 = channels.peer2().handle();
+  channels.Open();
+
+  // Memory to memory, with more than the stream high watermark so that the
+  // sender has to wait for SCTP to drain.
+  {
+    const std::vector<char> payload = MakeStreamPayload(3 * 1024 * 1024 + 17);
+    std::vector<char> destination_data(payload.size());
+    StreamProgress receive_progress;
+    mrsDataChannelStreamDestination destination{};
+    destination.data = destination_data.data();
+    destination.capacity = destination_data.size();
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelReceiveStream(handle2, &destination,
+                                          CB(receive_progress.callback)));
+    StreamProgress send_progress;
+    mrsDataChannelStreamSource source{};
+    source.data = payload.data();
+    source.size = payload.size();
+    uint32_t stream_id = 0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendStream(handle1, &source,
+                                       CB(send_progress.callback),
+                                       &stream_id));
+    ASSERT_TRUE(send_progress.finished.WaitFor(60s));
+    ASSERT_EQ(mrsDataChannelStreamStatus::kCompleted,
+              send_progress.final_status.load());
+    ASSERT_TRUE(receive_progress.finished.WaitFor(60s));
+    ASSERT_EQ(mrsDataChannelStreamStatus::kCompleted,
+              receive_progress.final_status.load());
+    ASSERT_EQ(payload.size(), receive_progress.final_bytes.load());
+    ASSERT_TRUE(payload == destination_data);
+  }
+
+  // File to file, through the managed send queue of the sender.
+  {
+    mrsDataChannelSendQueueConfig queue_config{};
+    queue_config.capacity = 4 * 1024 * 1024;
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelConfigureSendQueue(handle1, &queue_config));
+    const std::vector<char> payload = MakeStreamPayload(1024 * 1024 + 5);
+    const char* const source_path = "mrwebrtc_stream_source.bin";
+    const char* const destination_path = "mrwebrtc_stream_destination.bin";
+    {
+      std::ofstream file(source_path, std::ios::binary | std::ios::trunc);
+      ASSERT_TRUE(file.write(payload.data(), payload.size()));
+    }
+    StreamProgress receive_progress;
+    mrsDataChannelStreamDestination destination{};
+    destination.file_path = destination_path;
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelReceiveStream(handle2, &destination,
+                                          CB(receive_progress.callback)));
+    StreamProgress send_progress;
+    mrsDataChannelStreamSource source{};
+    source.file_path = source_path;
+    uint32_t stream_id = 0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsDataChannelSendStream(handle1, &source,
+                                       CB(send_progress.callback),
+                                       &stream_id));
+    ASSERT_TRUE(send_progress.finished.WaitFor(60s));
+    ASSERT_EQ(mrsDataChannelStreamStatus::kCompleted,
+              send_progress.final_status.load());
+    ASSERT_TRUE(receive_progress.finished.WaitFor(60s));
+    ASSERT_EQ(mrsDataChannelStreamStatus::kCompleted,
+              receive_progress.final_status.load());
+    {
+      std::ifstream file(destination_path, std::ios::binary);
+      const std::vector<char> received((std::istreambuf_iterator<char>(file)),
+                                       std::istreambuf_iterator<char>());
+      ASSERT_TRUE(payload == received);
+    }
+    std::remove(source_path);
+    std::remove(destination_path);
+
+    // A missing source file is reported on creation.
+    source.file_path = "mrwebrtc_stream_missing.bin";
+    ASSERT_EQ(Result::kNotFound,
+              mrsDataChannelSendStream(handle1, &source, nullptr, nullptr,
+                                       &stream_id));
+  }
+
+  // Stream frames are not reported as messages on the receiving channel.
+  ASSERT_TRUE(channels.peer2().messages().empty());
+}
+
+TEST_P(DataChannelTests, SendMessages) {
+  DataChannelPairRaii channels(GetParam());
+  const mrsDataChannelHandle handle = channels.peer1().handle();
+
+  const char payload[] = "message";
+  mrsDataChannelMessage messages[3]{};
+  for (auto&& message : messages) {
+    message.kind = mrsMessageKind::kText;
+    message.data = payload;
+    message.size = sizeof(payload);
+  }
+  mrsResult results[3]{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelSendMessages(nullptr, messages, 3, results));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSendMessages(handle, nullptr, 3, results));
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSendMessages(handle, messages, 0, results));
+
+  // The channel is not open, so sending stops at the first message.
+  ASSERT_EQ(Result::kUnknownError,
+            mrsDataChannelSendMessages(handle, messages, 3, results));
+  ASSERT_EQ(Result::kUnknownError, results[0]);
+  ASSERT_EQ(Result::kInvalidOperation, results[1]);
+  ASSERT_EQ(Result::kInvalidOperation, results[2]);
+  // Each message not sent counts as a rejection.
+  mrsDataChannelMetrics metrics{};
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelGetMetrics(handle, &metrics));
+  ASSERT_EQ(3u, metrics.send_rejections);
+
+  // Once open, the whole batch is received in order, with the message kinds.
+  channels.Open();
+  constexpr int kCount = 100;
+  std::vector<std::string> contents(kCount);
+  std::vector<mrsDataChannelMessage> batch(kCount);
+  std::vector<mrsResult> batch_results(kCount, Result::kUnknownError);
+  for (int i = 0; i < kCount; ++i) {
+    contents[i] = MakeMessage(i);
+    batch[i].kind = (i % 2 ? mrsMessageKind::kText : mrsMessageKind::kBinary);
+    batch[i].data = contents[i].data();
+    batch[i].size = contents[i].size();
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSendMessages(handle, batch.data(), kCount,
+                                       batch_results.data()));
+  for (mrsResult result : batch_results) {
+    ASSERT_EQ(Result::kSuccess, result);
+  }
+  ASSERT_TRUE(channels.peer2().WaitMessagesFor(60s, kCount));
+  const std::vector<ReceivedMessage> received = channels.peer2().messages();
+  ASSERT_EQ((size_t)kCount, received.size());
+  for (int i = 0; i < kCount; ++i) {
+    ASSERT_EQ(batch[i].kind, received[i].kind);
+    ASSERT_EQ(contents[i], received[i].data);
+  }
+}
+
+TEST_P(DataChannelTests, Broadcast) {
+  DataChannelPairRaii channels(GetParam());
+  mrsDataChannelHandle handles[3]{channels.peer1().handle(), nullptr,
+                                  channels.peer2().handle()};
+
+  const char payload[] = "state";
+  mrsResult results[3]{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelBroadcast(nullptr, 3, mrsMessageKind::kBinary,
+                                    payload, sizeof(payload), results));
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelBroadcast(handles, 0, mrsMessageKind::kBinary,
+                                    payload, sizeof(payload), results));
+
+  // The channels are not open, and the second handle is null.
+  ASSERT_EQ(Result::kUnknownError,
+            mrsDataChannelBroadcast(handles, 3, mrsMessageKind::kBinary,
+                                    payload, sizeof(payload), results));
+  ASSERT_EQ(Result::kUnknownError, results[0]);
+  ASSERT_EQ(Result::kInvalidNativeHandle, results[1]);
+  ASSERT_EQ(Result::kUnknownError, results[2]);
+
+  // Once open, each peer receives the message sent by the other one.
+  channels.Open();
+  handles[1] = handles[2];
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelBroadcast(handles, 2, mrsMessageKind::kText, payload,
+                                    sizeof(payload), results));
+  ASSERT_EQ(Result::kSuccess, results[0]);
+  ASSERT_EQ(Result::kSuccess, results[1]);
+  const std::string expected(payload, sizeof(payload));
+  for (DataChannelPairRaii::Peer* peer :
+       {&channels.peer1(), &channels.peer2()}) {
+    ASSERT_TRUE(peer->WaitMessagesFor(60s, 1));
+    const std::vector<ReceivedMessage> received = peer->messages();
+    ASSERT_EQ(1u, received.size());
+    ASSERT_EQ(mrsMessageKind::kText, received[0].kind);
+    ASSERT_EQ(expected, received[0].data);
+  }
+}
+
+TEST_P(DataChannelTests, LeaseSendBuffer) {
+  DataChannelPairRaii channels(GetParam());
+  const mrsDataChannelHandle handle = channels.peer1().handle();
+
+  mrsDataChannelSendBufferHandle buffer_handle{};
+  void* data{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsDataChannelLeaseSendBuffer(nullptr, 16, &buffer_handle, &data));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelLeaseSendBuffer(handle, 0x1000001uLL, &buffer_handle,
+                                          &data));
+  ASSERT_EQ(nullptr, buffer_handle);
+
+  // Lease, fill, and discard.
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelLeaseSendBuffer(
+                                  handle, 16, &buffer_handle, &data));
+  ASSERT_NE(nullptr, buffer_handle);
+  ASSERT_NE(nullptr, data);
+  memset(data, 0x42, 16);
+  mrsDataChannelReleaseSendBuffer(buffer_handle);
+
+  // Sending more than the capacity fails, and consumes the buffer.
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelLeaseSendBuffer(
+                                  handle, 16, &buffer_handle, &data));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsDataChannelSendLeasedBuffer(handle, buffer_handle,
+                                           mrsMessageKind::kBinary, 17));
+
+  // The channel is not open, so sending fails, and consumes the buffer.
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelLeaseSendBuffer(
+                                  handle, 16, &buffer_handle, &data));
+  ASSERT_EQ(Result::kUnknownError,
+            mrsDataChannelSendLeasedBuffer(handle, buffer_handle,
+                                           mrsMessageKind::kBinary, 8));
+
+  // Once open, the leased buffer is received as written, truncated to the
+  // size sent.
+  channels.Open();
+  ASSERT_EQ(Result::kSuccess, mrsDataChannelLeaseSendBuffer(
+                                  handle, 16, &buffer_handle, &data));
+  for (int i = 0; i < 16; ++i) {
+    static_cast<char*>(data)[i] = (char)('a' + i);
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsDataChannelSendLeasedBuffer(handle, buffer_handle,
+                                           mrsMessageKind::kText, 12));
+  ASSERT_TRUE(channels.peer2().WaitMessagesFor(60s, 1));
+  const std::vector<ReceivedMessage> received = channels.peer2().messages();
+  ASSERT_EQ(1u, received.size());
+  ASSERT_EQ(mrsMessageKind::kText, received[0].kind);
+  ASSERT_EQ("abcdefghijkl", received[0].data);
+}
+
+TEST_P(DataChannelTests, PartialReliability) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+  mrsDataChannelHandle handle;
+
+  // Unordered, no retransmit
+  mrsDataChannelConfig config{};
+  config.label = "pose";
+  config.max_retransmits = 0;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pc.handle(), &config, &handle));
+
+  // Unordered, bounded lifetime
+  config = {};
+  config.label = "input";
+  config.max_packet_life_time_ms = 100;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddDataChannel(pc.handle(), &config, &handle));
+
+  // Both limits at once
+  config.max_retransmits = 2;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddDataChannel(pc.handle(), &config, &handle));
+
+  // Reliable with a limit
+  config = {};
+  config.flags = mrsDataChannelConfigFlags::kReliable;
+  config.max_retransmits = 2;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddDataChannel(pc.handle(), &config, &handle));
+
+  // Invalid limit
+  config = {};
+  config.max_retransmits = -2;
+  ASSERT_EQ(Result::kOutOfRange,
+            mrsPeerConnectionAddDataChannel(pc.handle(), &config, &handle));
+}
+
 TEST_P(DataChannelTests, InBand) {
   // Create PC
   mrsPeerConnectionConfiguration pc_config{};  // local connection only
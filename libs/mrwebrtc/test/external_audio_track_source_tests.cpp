@@ -0,0 +1,334 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pch.h"
+
+#include <cmath>
+#include <thread>
+
+#include "audio_frame.h"
+#include "external_audio_track_source_interop.h"
+#include "interop_api.h"
+#include "local_audio_track_interop.h"
+#include "remote_audio_track_interop.h"
+#include "transceiver_interop.h"
+
+#include "test_utils.h"
+
+namespace {
+
+class ExternalAudioTrackSourceTests : public TestUtils::TestBase {};
+
+// mrsAudioFrameCallback
+using AudioFrameCallback = InteropCallback<const mrsAudioFrame&>;
+
+// PeerConnectionAudioTrackAddedCallback
+using AudioTrackAddedCallback =
+    InteropCallback<const mrsRemoteAudioTrackAddedInfo*>;
+
+}  // namespace
+
+TEST_F(ExternalAudioTrackSourceTests, InvalidParams) {
+  mrsExternalAudioTrackSourceConfig config{};
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsExternalAudioTrackSourceCreate(&config, nullptr));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsExternalAudioTrackSourceCreate(nullptr, &source_handle));
+  ASSERT_EQ(nullptr, source_handle);
+  config.sample_rate = 44101;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsExternalAudioTrackSourceCreate(&config, &source_handle));
+  ASSERT_EQ(nullptr, source_handle);
+  config.sample_rate = 48000;
+  config.channel_count = 3;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsExternalAudioTrackSourceCreate(&config, &source_handle));
+  ASSERT_EQ(nullptr, source_handle);
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsExternalAudioTrackSourcePushFrame(nullptr, nullptr));
+}
+
+TEST_F(ExternalAudioTrackSourceTests, PushAndRechunk) {
+  mrsExternalAudioTrackSourceConfig config{};
+  config.sample_rate = 16000;
+  config.channel_count = 1;
+  config.buffer_ms = 500;
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsExternalAudioTrackSourceCreate(&config, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  // Push 300 ms of audio in odd-sized chunks which do not align with the 10 ms
+  // frames delivered by the source.
+  std::vector<int16_t> samples(333, 1000);
+  mrsAudioFrame chunk{};
+  chunk.data_ = samples.data();
+  chunk.bits_per_sample_ = 16;
+  chunk.sampling_rate_hz_ = 16000;
+  chunk.channel_count_ = 1;
+  chunk.sample_count_ = (uint32_t)samples.size();
+  for (int i = 0; i < 14; ++i) {
+    ASSERT_EQ(Result::kSuccess,
+              mrsExternalAudioTrackSourcePushFrame(source_handle, &chunk));
+  }
+
+  // Mismatching format is rejected
+  chunk.sampling_rate_hz_ = 48000;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsExternalAudioTrackSourcePushFrame(source_handle, &chunk));
+  chunk.sampling_rate_hz_ = 16000;
+
+  // Overflowing the buffer is rejected
+  std::vector<int16_t> large_samples(16000);
+  mrsAudioFrame large_chunk = chunk;
+  large_chunk.data_ = large_samples.data();
+  large_chunk.sample_count_ = (uint32_t)large_samples.size();
+  ASSERT_EQ(Result::kBufferTooSmall,
+            mrsExternalAudioTrackSourcePushFrame(source_handle, &large_chunk));
+
+  // Create a local audio track from the source, and observe the frames it
+  // delivers.
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "external_audio_track";
+  mrsLocalAudioTrackHandle track_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, source_handle,
+                                               &track_handle));
+  ASSERT_NE(nullptr, track_handle);
+
+  std::atomic<uint32_t> frame_count{0};
+  std::atomic<uint32_t> non_silent_count{0};
+  Event frames_received;
+  AudioFrameCallback frame_cb = [&](const mrsAudioFrame& frame) {
+    ASSERT_EQ(16u, frame.bits_per_sample_);
+    ASSERT_EQ(16000u, frame.sampling_rate_hz_);
+    ASSERT_EQ(1u, frame.channel_count_);
+    ASSERT_EQ(160u, frame.sample_count_);
+    const int16_t* data = static_cast<const int16_t*>(frame.data_);
+    if (data[0] == 1000 && data[159] == 1000) {
+      ++non_silent_count;
+    }
+    if (++frame_count == 20) {
+      frames_received.Set();
+    }
+  };
+  mrsLocalAudioTrackRegisterFrameCallback(track_handle, CB(frame_cb));
+  ASSERT_TRUE(frames_received.WaitFor(5s));
+  mrsLocalAudioTrackRegisterFrameCallback(track_handle, nullptr, nullptr);
+  ASSERT_LT(0u, non_silent_count.load());
+
+  mrsExternalAudioTrackSourceShutdown(source_handle);
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsExternalAudioTrackSourcePushFrame(source_handle, &chunk));
+
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+// Sustained voice is not absorbed into the noise floor estimate of the voice
+// activity detector, so the remote track keeps reporting it as active.
+TEST_F(ExternalAudioTrackSourceTests, SustainedVoiceActivity) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = mrsSdpSemantic::kUnifiedPlan;
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsExternalAudioTrackSourceConfig config{};
+  config.sample_rate = 48000;
+  config.channel_count = 1;
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsExternalAudioTrackSourceCreate(&config, &source_handle));
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "external_audio_track";
+  mrsLocalAudioTrackHandle track_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, source_handle,
+                                               &track_handle));
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "transceiver1";
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  mrsTransceiverHandle transceiver_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(transceiver_handle, track_handle));
+
+  Event track_added2_ev;
+  mrsRemoteAudioTrackHandle remote_track_handle{};
+  AudioTrackAddedCallback track_added2_cb =
+      [&](const mrsRemoteAudioTrackAddedInfo* info) {
+        remote_track_handle = info->track_handle;
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+
+  // Push 5 seconds of a loud 440 Hz tone in real time. Without freezing the
+  // noise floor during voice activity, the tone would be absorbed into it in
+  // about 2 seconds.
+  std::vector<int16_t> samples(480);
+  mrsAudioFrame frame{};
+  frame.data_ = samples.data();
+  frame.bits_per_sample_ = 16;
+  frame.sampling_rate_hz_ = 48000;
+  frame.channel_count_ = 1;
+  frame.sample_count_ = (uint32_t)samples.size();
+  uint32_t phase = 0;
+  auto next_push = std::chrono::steady_clock::now();
+  for (int i = 0; i < 500; ++i) {
+    for (int16_t& sample : samples) {
+      sample = (int16_t)(16000.0 * std::sin(2.0 * 3.14159265358979 * 440.0 *
+                                            (phase++) / 48000.0));
+    }
+    // Frames are rejected if the buffer is full; this only drops some audio.
+    mrsExternalAudioTrackSourcePushFrame(source_handle, &frame);
+    next_push += 10ms;
+    std::this_thread::sleep_until(next_push);
+  }
+
+  mrsAudioLevel level{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsRemoteAudioTrackGetAudioLevel(remote_track_handle, &level));
+  ASSERT_LT(0.1f, level.rms_);
+  ASSERT_LE(level.rms_, level.peak_);
+  ASSERT_TRUE(level.voice_active_);
+
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(), nullptr,
+                                                   nullptr);
+  mrsExternalAudioTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+#if !defined(WINUWP)
+
+TEST_F(ExternalAudioTrackSourceTests, PacedByAudioDevice) {
+  // Drive the audio device from the test, which can pull faster than real
+  // time.
+  TestUtils::ApplicationAudioDeviceRaii adm;
+
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = mrsSdpSemantic::kUnifiedPlan;
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsExternalAudioTrackSourceConfig config{};
+  config.sample_rate = 48000;
+  config.channel_count = 1;
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsExternalAudioTrackSourceCreate(&config, &source_handle));
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "external_audio_track";
+  mrsLocalAudioTrackHandle track_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, source_handle,
+                                               &track_handle));
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "transceiver1";
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  mrsTransceiverHandle transceiver_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(transceiver_handle, track_handle));
+
+  // Receiving the track on #2 starts the playout of the shared audio device.
+  Event track_added2_ev;
+  AudioTrackAddedCallback track_added2_cb =
+      [&track_added2_ev](const mrsRemoteAudioTrackAddedInfo*) {
+        track_added2_ev.Set();
+      };
+  mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                   CB(track_added2_cb));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+
+  std::atomic<uint32_t> frame_count{0};
+  std::atomic<uint32_t> target_count{UINT32_MAX};
+  Event frames_received;
+  AudioFrameCallback frame_cb = [&](const mrsAudioFrame&) {
+    if (++frame_count == target_count.load()) {
+      frames_received.Set();
+    }
+  };
+  mrsLocalAudioTrackRegisterFrameCallback(track_handle, CB(frame_cb));
+
+  // Each 10 ms frame pulled from the audio device delivers one frame of the
+  // source. Pull bursts of 1 second of audio, which the system clock would
+  // pace over 1 second, until one completes well within that time, which
+  // means the audio device clock paces the source.
+  constexpr uint32_t kBurstFrames = 100;
+  std::vector<float> playout(480);
+  bool paced_by_device = false;
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!paced_by_device && (std::chrono::steady_clock::now() < deadline)) {
+    const uint32_t start_count = frame_count.load();
+    const auto start_time = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < kBurstFrames; ++i) {
+      ASSERT_EQ(Result::kSuccess,
+                mrsAudioDevicePullPlayout(playout.data(), 480));
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start_time;
+    paced_by_device = (frame_count.load() - start_count >= kBurstFrames) &&
+                      (elapsed < 500ms);
+  }
+  ASSERT_TRUE(paced_by_device);
+
+  // Once the audio device stops pulling, the source keeps delivering frames
+  // on its own.
+  target_count = frame_count.load() + 10;
+  ASSERT_TRUE(frames_received.WaitFor(5s));
+  mrsLocalAudioTrackRegisterFrameCallback(track_handle, nullptr, nullptr);
+
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
+
+#endif  // !defined(WINUWP)
+
+TEST_F(ExternalAudioTrackSourceTests, FirstThreadGroupOnly) {
+  TestUtils::ThreadGroupCountRaii thread_groups(2);
+
+  mrsExternalAudioTrackSourceConfig config{};
+  config.sample_rate = 48000;
+  config.channel_count = 1;
+  mrsExternalAudioTrackSourceHandle source_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsExternalAudioTrackSourceCreate(&config, &source_handle));
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = "external_audio_track";
+  mrsLocalAudioTrackHandle track_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, source_handle,
+                                               &track_handle));
+
+  // The source is paced by the audio device module of the first group, so
+  // only connections of that group can send its tracks.
+  for (int32_t thread_group : {0, 1}) {
+    mrsPeerConnectionConfiguration pc_config{};
+    pc_config.thread_group = thread_group;
+    PCRaii pc(pc_config);
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "transceiver1";
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    mrsTransceiverHandle transceiver_handle{};
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceiver_handle));
+    const Result expected =
+        (thread_group == 0 ? Result::kSuccess : Result::kInvalidOperation);
+    ASSERT_EQ(expected, mrsTransceiverSetLocalAudioTrack(transceiver_handle,
+                                                         track_handle));
+    ASSERT_EQ(Result::kSuccess,
+              mrsTransceiverSetLocalAudioTrack(transceiver_handle, nullptr));
+  }
+
+  mrsExternalAudioTrackSourceShutdown(source_handle);
+  mrsRefCountedObjectRemoveRef(track_handle);
+  mrsRefCountedObjectRemoveRef(source_handle);
+}
@@ -3,8 +3,16 @@
 
 #include "pch.h"
 
+#include <cmath>
+#include <thread>
+
+#include "device_audio_track_source_interop.h"
 #include "external_video_track_source_interop.h"
 #include "interop_api.h"
+#include "local_video_track_interop.h"
+#include "remote_audio_track_interop.h"
+#include "test_utils.h"
+#include "transceiver_interop.h"
 #include "video_test_utils.h"
 
 TEST(LibraryTests, SetShutdownOptions) {
@@ -44,3 +52,401 @@ TEST(LibraryTests, ForceShutdown) {
   mrsForceShutdown();
   ASSERT_EQ(0u, mrsReportLiveObjects());
 }
+
+TEST(LibraryTests, HeadlessAudioDeviceModule) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  const mrsAudioDeviceModule initial_adm = mrsLibraryGetAudioDeviceModule();
+
+  // Restore the initial module and the default configuration on exit, even if
+  // the test fails.
+  TestUtils::HeadlessAudioDeviceRaii adm;
+  ASSERT_EQ(mrsAudioDeviceModule::kHeadless, mrsLibraryGetAudioDeviceModule());
+
+  // Invalid configurations
+  mrsHeadlessAudioDeviceConfig config{};
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLibrarySetHeadlessAudioDeviceConfig(nullptr));
+  config.sample_rate = 44101;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLibrarySetHeadlessAudioDeviceConfig(&config));
+  config.sample_rate = 16000;
+  config.clock_rate = 0.0f;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLibrarySetHeadlessAudioDeviceConfig(&config));
+  config.clock_rate = 1.0f;
+  config.capture_file_path = "this_file_does_not_exist.wav";
+  ASSERT_EQ(mrsResult::kNotFound,
+            mrsLibrarySetHeadlessAudioDeviceConfig(&config));
+
+  // Record a looped tone from memory
+  std::vector<int16_t> samples(160);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i] = (int16_t)((i % 16 < 8) ? 8000 : -8000);
+  }
+  config.capture_file_path = nullptr;
+  config.capture_samples = samples.data();
+  config.capture_sample_count = (uint32_t)samples.size();
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLibrarySetHeadlessAudioDeviceConfig(&config));
+
+  {
+    // Initialize the library with the headless ADM, which does not require any
+    // audio device to be present.
+    mrsPeerConnectionConfiguration pc_config{};
+    LocalPeerPairRaii pair(pc_config);
+
+    // The ADM cannot be changed or reconfigured once the library is
+    // initialized
+    ASSERT_EQ(mrsResult::kInvalidOperation,
+              mrsLibraryUseAudioDeviceModule(initial_adm));
+    ASSERT_EQ(mrsResult::kInvalidOperation,
+              mrsLibrarySetHeadlessAudioDeviceConfig(&config));
+
+    // The recorded tone is sent from #1 to #2, and played out on #2 where it is
+    // observed through the remote audio track.
+    mrsRemoteAudioTrackHandle audio_track2{};
+    Event track_added2_ev;
+    InteropCallback<const mrsRemoteAudioTrackAddedInfo*> track_added2_cb =
+        [&audio_track2,
+         &track_added2_ev](const mrsRemoteAudioTrackAddedInfo* info) {
+          audio_track2 = info->track_handle;
+          track_added2_ev.Set();
+        };
+    mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                     CB(track_added2_cb));
+    TestUtils::LocalAudioSenderRaii sender1(pair.pc1(), "headless_track");
+    pair.ConnectAndWait();
+    ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+    ASSERT_NE(nullptr, audio_track2);
+
+    Event tone_received2_ev;
+    InteropCallback<const mrsAudioFrame&> frame2_cb =
+        [&tone_received2_ev](const mrsAudioFrame& frame) {
+          if (frame.bits_per_sample_ != 16) {
+            return;
+          }
+          const int16_t* const data = static_cast<const int16_t*>(frame.data_);
+          const uint32_t count = frame.sample_count_ * frame.channel_count_;
+          for (uint32_t i = 0; i < count; ++i) {
+            if (std::abs(data[i]) > 1000) {
+              tone_received2_ev.Set();
+              return;
+            }
+          }
+        };
+    mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, CB(frame2_cb));
+    ASSERT_TRUE(tone_received2_ev.WaitFor(10s));
+    mrsRemoteAudioTrackRegisterFrameCallback(audio_track2, nullptr, nullptr);
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  }
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+}
+
+TEST(LibraryTests, ApplicationAudioDeviceModule) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  const mrsAudioDeviceModule initial_adm = mrsLibraryGetAudioDeviceModule();
+
+  // Invalid configurations
+  mrsApplicationAudioDeviceConfig config{};
+  config.sample_rate = 44101;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLibrarySetApplicationAudioDeviceConfig(&config));
+  config.sample_rate = 48000;
+  config.channel_count = 3;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLibrarySetApplicationAudioDeviceConfig(&config));
+  config.channel_count = 2;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLibrarySetApplicationAudioDeviceConfig(&config));
+  ASSERT_EQ(mrsResult::kSuccess, mrsLibraryUseAudioDeviceModule(
+                                     mrsAudioDeviceModule::kApplication));
+
+  // Pulling before the library is initialized produces silence
+  std::vector<float> playout(256 * 2, 1.0f);
+  ASSERT_EQ(mrsResult::kNotInitialized,
+            mrsAudioDevicePullPlayout(playout.data(), 256));
+  for (float sample : playout) {
+    ASSERT_EQ(0.0f, sample);
+  }
+  std::vector<float> capture(333 * 2, 0.25f);
+  ASSERT_EQ(mrsResult::kNotInitialized,
+            mrsAudioDevicePushCapture(capture.data(), 333));
+
+  // Initialize the library
+  mrsDeviceAudioTrackSourceHandle source_handle{};
+  mrsLocalAudioDeviceInitConfig device_config{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsDeviceAudioTrackSourceCreate(&device_config, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  // Chunks of any size can be pulled and pushed. Nothing is playing, so the
+  // playout audio is silent.
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsAudioDevicePullPlayout(nullptr, 256));
+  for (int i = 0; i < 10; ++i) {
+    std::fill(playout.begin(), playout.end(), 1.0f);
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsAudioDevicePullPlayout(playout.data(), 256));
+    for (float sample : playout) {
+      ASSERT_EQ(0.0f, sample);
+    }
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsAudioDevicePushCapture(capture.data(), 333));
+  }
+
+  mrsRefCountedObjectRemoveRef(source_handle);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  ASSERT_EQ(mrsResult::kSuccess, mrsLibraryUseAudioDeviceModule(initial_adm));
+}
+
+TEST(LibraryTests, ApplicationAudioDeviceRoundTrip) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  mrsApplicationAudioDeviceConfig config{};
+  config.sample_rate = 48000;
+  config.channel_count = 1;
+  TestUtils::ApplicationAudioDeviceRaii adm(config);
+  {
+    // Send the audio pushed into the module from #1 to #2, which plays it out
+    // through the same module.
+    mrsPeerConnectionConfiguration pc_config{};
+    LocalPeerPairRaii pair(pc_config);
+    Event track_added2_ev;
+    InteropCallback<const mrsRemoteAudioTrackAddedInfo*> track_added2_cb =
+        [&track_added2_ev](const mrsRemoteAudioTrackAddedInfo*) {
+          track_added2_ev.Set();
+        };
+    mrsPeerConnectionRegisterAudioTrackAddedCallback(pair.pc2(),
+                                                     CB(track_added2_cb));
+    TestUtils::LocalAudioSenderRaii sender1(pair.pc1(), "application_track");
+    pair.ConnectAndWait();
+    ASSERT_TRUE(track_added2_ev.WaitFor(5s));
+
+    // Drive the module like an audio callback would, in real time since the
+    // network and jitter buffer are, pushing a 1 kHz square wave until it
+    // comes back in the pulled playout audio.
+    std::vector<float> capture(480);
+    for (size_t i = 0; i < capture.size(); ++i) {
+      capture[i] = ((i / 24) % 2) ? 0.25f : -0.25f;
+    }
+    std::vector<float> playout(480);
+    bool tone_played_out = false;
+    auto next_time = std::chrono::steady_clock::now();
+    const auto deadline = next_time + 10s;
+    while (!tone_played_out && (next_time < deadline)) {
+      ASSERT_EQ(mrsResult::kSuccess,
+                mrsAudioDevicePushCapture(capture.data(), 480));
+      ASSERT_EQ(mrsResult::kSuccess,
+                mrsAudioDevicePullPlayout(playout.data(), 480));
+      for (float sample : playout) {
+        ASSERT_LE(std::abs(sample), 1.0f);
+        if (std::abs(sample) > 0.05f) {
+          tone_played_out = true;
+        }
+      }
+      next_time += 10ms;
+      std::this_thread::sleep_until(next_time);
+    }
+    ASSERT_TRUE(tone_played_out);
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  }
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Once the library shut down, the module is not driven anymore.
+  std::vector<float> playout(480, 1.0f);
+  ASSERT_EQ(mrsResult::kNotInitialized,
+            mrsAudioDevicePullPlayout(playout.data(), 480));
+  ASSERT_EQ(0.0f, playout[0]);
+}
+
+TEST(LibraryTests, AudioProcessing) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  mrsAudioProcessingStats stats{};
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLibraryGetAudioProcessingStats(nullptr));
+  ASSERT_EQ(mrsResult::kNotInitialized,
+            mrsLibraryGetAudioProcessingStats(&stats));
+
+  // Bypass the audio processing module entirely
+  mrsAudioProcessingConfig config{};
+  config.enabled = mrsBool::kFalse;
+  ASSERT_EQ(mrsResult::kInvalidParameter,
+            mrsLibrarySetAudioProcessingConfig(nullptr));
+  ASSERT_EQ(mrsResult::kSuccess, mrsLibrarySetAudioProcessingConfig(&config));
+
+  // Initialize the library
+  mrsDeviceAudioTrackSourceHandle source_handle{};
+  mrsLocalAudioDeviceInitConfig device_config{};
+  device_config.noise_suppression_ = mrsOptBool::kTrue;
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsDeviceAudioTrackSourceCreate(&device_config, &source_handle));
+  ASSERT_NE(nullptr, source_handle);
+
+  ASSERT_EQ(mrsResult::kInvalidOperation,
+            mrsLibrarySetAudioProcessingConfig(&config));
+#if defined(WINUWP)
+  ASSERT_EQ(mrsResult::kUnsupported, mrsLibraryGetAudioProcessingStats(&stats));
+#else
+  ASSERT_EQ(mrsResult::kSuccess, mrsLibraryGetAudioProcessingStats(&stats));
+  ASSERT_EQ(mrsBool::kTrue, stats.bypassed);
+  ASSERT_EQ(0u, stats.capture_frame_count);
+  ASSERT_EQ(0u, stats.render_frame_count);
+#endif
+
+  mrsRefCountedObjectRemoveRef(source_handle);
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+
+  // Restore the default configuration
+  const mrsAudioProcessingConfig default_config{};
+  ASSERT_EQ(mrsResult::kSuccess,
+            mrsLibrarySetAudioProcessingConfig(&default_config));
+}
+
+#if !defined(WINUWP)
+
+TEST(LibraryTests, ThreadGroups) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  ASSERT_EQ(mrsResult::kInvalidParameter, mrsLibrarySetThreadGroupCount(0));
+  TestUtils::ThreadGroupCountRaii thread_groups(2);
+
+  {
+    // Out of range group
+    mrsPeerConnectionConfiguration pc_config{};
+    pc_config.thread_group = 2;
+    mrsPeerConnectionHandle handle{};
+    ASSERT_EQ(mrsResult::kInvalidParameter,
+              mrsPeerConnectionCreate(&pc_config, &handle));
+    ASSERT_EQ(nullptr, handle);
+
+    // Negative groups other than round-robin
+    pc_config.thread_group = -1;
+    ASSERT_EQ(mrsResult::kInvalidParameter,
+              mrsPeerConnectionCreate(&pc_config, &handle));
+    ASSERT_EQ(nullptr, handle);
+  }
+
+  {
+    // Connections use the first group by default
+    mrsPeerConnectionConfiguration pc_config{};
+    PCRaii pc(pc_config);
+    int32_t thread_group = -1;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsPeerConnectionGetThreadGroup(pc.handle(), &thread_group));
+    ASSERT_EQ(0, thread_group);
+  }
+
+  {
+    // Connect two peers on the second group
+    mrsPeerConnectionConfiguration pc_config{};
+    pc_config.thread_group = 1;
+    LocalPeerPairRaii pair(pc_config);
+    ASSERT_EQ(mrsResult::kInvalidOperation, mrsLibrarySetThreadGroupCount(1));
+
+    int32_t thread_group = -1;
+    ASSERT_EQ(mrsResult::kInvalidNativeHandle,
+              mrsPeerConnectionGetThreadGroup(nullptr, &thread_group));
+    ASSERT_EQ(mrsResult::kInvalidParameter,
+              mrsPeerConnectionGetThreadGroup(pair.pc1(), nullptr));
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsPeerConnectionGetThreadGroup(pair.pc1(), &thread_group));
+    ASSERT_EQ(1, thread_group);
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsPeerConnectionGetThreadGroup(pair.pc2(), &thread_group));
+    ASSERT_EQ(1, thread_group);
+
+    // Local video tracks can only be sent by connections of their own group
+    mrsTransceiverHandle transceiver{};
+    {
+      mrsTransceiverInitConfig transceiver_config{};
+      transceiver_config.media_kind = mrsMediaKind::kVideo;
+      ASSERT_EQ(mrsResult::kSuccess,
+                mrsPeerConnectionAddTransceiver(
+                    pair.pc1(), &transceiver_config, &transceiver));
+    }
+    mrsExternalVideoTrackSourceHandle source{};
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                  &VideoTestUtils::MakeTestFrame, nullptr, &source));
+    mrsExternalVideoTrackSourceFinishCreation(source);
+    mrsLocalVideoTrackInitSettings settings{};
+    mrsLocalVideoTrackHandle track0{};
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source, &track0));
+    ASSERT_EQ(mrsResult::kInvalidOperation,
+              mrsTransceiverSetLocalVideoTrack(transceiver, track0));
+    settings.thread_group = 1;
+    mrsLocalVideoTrackHandle track1{};
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsLocalVideoTrackCreateFromSource(&settings, source, &track1));
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsTransceiverSetLocalVideoTrack(transceiver, track1));
+
+    pair.ConnectAndWait();
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(std::chrono::seconds(5)));
+
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsTransceiverSetLocalVideoTrack(transceiver, nullptr));
+    mrsRefCountedObjectRemoveRef(track1);
+    mrsRefCountedObjectRemoveRef(track0);
+    mrsExternalVideoTrackSourceShutdown(source);
+    mrsRefCountedObjectRemoveRef(source);
+  }
+
+  {
+    // Round-robin assignment across both groups
+    mrsPeerConnectionConfiguration pc_config{};
+    pc_config.thread_group = kMrsThreadGroupRoundRobin;
+    LocalPeerPairRaii pair(pc_config);
+    int32_t thread_group1 = -1;
+    int32_t thread_group2 = -1;
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsPeerConnectionGetThreadGroup(pair.pc1(), &thread_group1));
+    ASSERT_EQ(mrsResult::kSuccess,
+              mrsPeerConnectionGetThreadGroup(pair.pc2(), &thread_group2));
+    ASSERT_EQ((thread_group1 + 1) % 2, thread_group2);
+    pair.ConnectAndWait();
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(std::chrono::seconds(5)));
+  }
+
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+}
+
+TEST(LibraryTests, AudioProcessingThreadGroups) {
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+  // The audio processing module is enabled by default. Use the headless audio
+  // device module for the first group too, so that no device is needed.
+  TestUtils::HeadlessAudioDeviceRaii adm;
+  TestUtils::ThreadGroupCountRaii thread_groups(2);
+  {
+    // Stream audio on the second group only. The first group has no audio
+    // stream so does not process any frame, and the statistics can only be
+    // non-zero if they include the modules of the other groups.
+    mrsPeerConnectionConfiguration pc_config{};
+    pc_config.thread_group = 1;
+    LocalPeerPairRaii pair(pc_config);
+    TestUtils::LocalAudioSenderRaii sender1(pair.pc1(), "audio_track");
+    pair.ConnectAndWait();
+
+    // Wait for some captured and played out frames to be processed.
+    mrsAudioProcessingStats stats{};
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (std::chrono::steady_clock::now() < deadline) {
+      ASSERT_EQ(mrsResult::kSuccess, mrsLibraryGetAudioProcessingStats(&stats));
+      if ((stats.capture_frame_count >= 50) &&
+          (stats.render_frame_count >= 50)) {
+        break;
+      }
+      std::this_thread::sleep_for(100ms);
+    }
+    ASSERT_EQ(mrsBool::kFalse, stats.bypassed);
+    ASSERT_LE(50u, stats.capture_frame_count);
+    ASSERT_LT(0u, stats.capture_total_time_us);
+    ASSERT_LT(0u, stats.capture_max_time_us);
+    ASSERT_LE(stats.capture_max_time_us, stats.capture_total_time_us);
+    ASSERT_LE(50u, stats.render_frame_count);
+    ASSERT_LE(stats.render_max_time_us, stats.render_total_time_us);
+    ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+  }
+  ASSERT_EQ(0u, mrsReportLiveObjects());
+}
+
+#endif  // !defined(WINUWP)
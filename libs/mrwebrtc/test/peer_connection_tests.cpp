@@ -3,9 +3,17 @@
 
 #include "pch.h"
 
+#include <atomic>
+#include <thread>
+
+#include "callback.h"
+#include "external_video_track_source_interop.h"
 #include "interop_api.h"
+#include "local_video_track_interop.h"
+#include "transceiver_interop.h"
 
 #include "test_utils.h"
+#include "video_test_utils.h"
 
 namespace {
 
@@ -89,3 +97,468 @@ TEST_P(PeerConnectionTests, LocalIce) {
                                                              nullptr, nullptr);
   }
 }
+
+TEST_P(PeerConnectionTests, UnregisterCallbackFromCallback) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+
+  // Unregister the callback from inside itself, which must not deadlock.
+  std::atomic_int call_count{0};
+  Event ev;
+  InteropCallback<> renegotiation_needed_cb([&pc, &call_count, &ev]() {
+    ++call_count;
+    mrsPeerConnectionRegisterRenegotiationNeededCallback(pc.handle(), nullptr,
+                                                         nullptr);
+    ev.Set();
+  });
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(
+      pc.handle(), CB(renegotiation_needed_cb));
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  mrsTransceiverHandle transceiver_handle1{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle1));
+  ASSERT_TRUE(ev.WaitFor(5s));
+  ASSERT_EQ(1, call_count.load());
+
+  // The callback is not invoked anymore.
+  mrsTransceiverHandle transceiver_handle2{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                            &transceiver_handle2));
+  ASSERT_EQ(1, call_count.load());
+}
+
+TEST_P(PeerConnectionTests, IceCandidateBatching) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Invalid usage
+  mrsIceCandidateBatchConfig batch_config{};
+  InteropCallback<const mrsIceCandidate*, uint32_t> batch_cb;
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(
+                nullptr, &batch_config, CB(batch_cb)));
+  batch_config.max_count = 0;
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(
+                pair.pc1(), &batch_config, CB(batch_cb)));
+
+  // Batches are delivered in addition to single candidates, and the last one
+  // is flushed before the gathering completion is reported.
+  batch_config.max_count = 2;
+  batch_config.max_delay_ms = 20;
+  std::atomic_uint32_t batch_count{0};
+  std::atomic_uint32_t candidate_count{0};
+  std::atomic_uint32_t max_batch_size{0};
+  batch_cb = [&](const mrsIceCandidate* candidates, uint32_t count) {
+    ASSERT_NE(nullptr, candidates);
+    ASSERT_LT(0u, count);
+    ++batch_count;
+    candidate_count += count;
+    if (count > max_batch_size) {
+      max_batch_size = count;
+    }
+  };
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(
+                pair.pc1(), &batch_config, CB(batch_cb)));
+  Event gathering_completed_ev;
+  InteropCallback<mrsIceGatheringState> gathering_cb(
+      [&gathering_completed_ev](mrsIceGatheringState state) {
+        if (state == mrsIceGatheringState::kComplete) {
+          gathering_completed_ev.Set();
+        }
+      });
+  mrsPeerConnectionRegisterIceGatheringStateChangedCallback(pair.pc1(),
+                                                            CB(gathering_cb));
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  mrsTransceiverHandle transceiver_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &transceiver_handle));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(gathering_completed_ev.WaitFor(10s));
+  ASSERT_LT(0u, batch_count.load());
+  ASSERT_LE(batch_count.load(), candidate_count.load());
+  ASSERT_GE(batch_config.max_count, max_batch_size.load());
+
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRegisterIceCandidatesReadytoSendCallback(
+                pair.pc1(), nullptr, nullptr, nullptr));
+  mrsPeerConnectionRegisterIceGatheringStateChangedCallback(pair.pc1(),
+                                                            nullptr, nullptr);
+
+  // Adding invalid candidates reports each failure
+  mrsIceCandidate candidates[2]{};
+  candidates[1].sdp_mid = "0";
+  candidates[1].content = "not a candidate";
+  candidates[1].sdp_mline_index = 0;
+  mrsResult results[2]{Result::kSuccess, Result::kSuccess};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionAddIceCandidates(nullptr, candidates, 2, results));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddIceCandidates(pair.pc2(), nullptr, 2, results));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionAddIceCandidates(pair.pc2(), candidates, 2,
+                                              results));
+  ASSERT_EQ(Result::kInvalidParameter, results[0]);
+  ASSERT_EQ(Result::kInvalidParameter, results[1]);
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddIceCandidates(pair.pc2(), nullptr, 0, nullptr));
+}
+
+TEST_P(PeerConnectionTests, ConnectionMilestones) {
+  TestUtils::HeadlessAudioDeviceRaii adm;
+
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  mrsConnectionMilestones milestones{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionGetConnectionMilestones(nullptr, &milestones));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionGetConnectionMilestones(pair.pc1(), nullptr));
+
+  // Nothing happened yet
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetConnectionMilestones(pair.pc1(), &milestones));
+  for (size_t i = 0; i < kMrsConnectionMilestoneCount; ++i) {
+    ASSERT_EQ(-1, milestones.elapsed_us[i]);
+  }
+
+  // Send some audio and video from #1 to #2.
+  TestUtils::LocalAudioSenderRaii audio_sender(pair.pc1(), "audio");
+  mrsTransceiverHandle video_transceiver{};
+  {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.name = "video";
+    transceiver_config.media_kind = mrsMediaKind::kVideo;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &video_transceiver));
+  }
+  mrsExternalVideoTrackSourceHandle video_source{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsExternalVideoTrackSourceCreateFromI420ACallback(
+                &VideoTestUtils::MakeTestFrame, nullptr, &video_source));
+  mrsExternalVideoTrackSourceFinishCreation(video_source);
+  mrsLocalVideoTrackHandle video_track{};
+  {
+    mrsLocalVideoTrackInitSettings settings{};
+    settings.track_name = "video";
+    ASSERT_EQ(Result::kSuccess, mrsLocalVideoTrackCreateFromSource(
+                                    &settings, video_source, &video_track));
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetLocalVideoTrack(video_transceiver, video_track));
+
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  // The offering peer went through the offer, and both descriptions.
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetConnectionMilestones(pair.pc1(), &milestones));
+  auto elapsed_us = [&milestones](mrsConnectionMilestone milestone) {
+    return milestones.elapsed_us[(size_t)milestone];
+  };
+  ASSERT_LE(0, elapsed_us(mrsConnectionMilestone::kCreateOfferStarted));
+  ASSERT_EQ(-1, elapsed_us(mrsConnectionMilestone::kCreateAnswerStarted));
+  ASSERT_LE(elapsed_us(mrsConnectionMilestone::kCreateOfferStarted),
+            elapsed_us(mrsConnectionMilestone::kLocalDescriptionCreated));
+  ASSERT_LE(elapsed_us(mrsConnectionMilestone::kLocalDescriptionCreated),
+            elapsed_us(mrsConnectionMilestone::kLocalDescriptionApplied));
+  ASSERT_LE(elapsed_us(mrsConnectionMilestone::kLocalDescriptionApplied),
+            elapsed_us(mrsConnectionMilestone::kRemoteDescriptionApplied));
+
+  // The answering peer created an answer instead.
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetConnectionMilestones(pair.pc2(), &milestones));
+  ASSERT_EQ(-1, elapsed_us(mrsConnectionMilestone::kCreateOfferStarted));
+  ASSERT_LE(0, elapsed_us(mrsConnectionMilestone::kCreateAnswerStarted));
+  ASSERT_LE(elapsed_us(mrsConnectionMilestone::kRemoteDescriptionApplied),
+            elapsed_us(mrsConnectionMilestone::kCreateAnswerStarted));
+
+  // The ICE and media milestones are reached asynchronously.
+  auto wait_milestone = [&milestones, &elapsed_us](
+                            mrsPeerConnectionHandle pc,
+                            mrsConnectionMilestone milestone) {
+    for (int retry = 0; retry < 500; ++retry) {
+      if ((mrsPeerConnectionGetConnectionMilestones(pc, &milestones) ==
+           Result::kSuccess) &&
+          (elapsed_us(milestone) >= 0)) {
+        return true;
+      }
+      std::this_thread::sleep_for(10ms);
+    }
+    return false;
+  };
+  for (mrsPeerConnectionHandle pc : {pair.pc1(), pair.pc2()}) {
+    ASSERT_TRUE(wait_milestone(pc, mrsConnectionMilestone::kIceConnected));
+    ASSERT_LE(0,
+              elapsed_us(mrsConnectionMilestone::kFirstIceCandidateGathered));
+    ASSERT_LE(elapsed_us(mrsConnectionMilestone::kFirstIceCandidateGathered),
+              elapsed_us(mrsConnectionMilestone::kLastIceCandidateGathered));
+    ASSERT_LE(0, elapsed_us(mrsConnectionMilestone::kIceChecking));
+    ASSERT_LE(elapsed_us(mrsConnectionMilestone::kIceChecking),
+              elapsed_us(mrsConnectionMilestone::kIceConnected));
+  }
+
+  // #2 decodes the media it receives after the first packet arrived.
+  ASSERT_TRUE(wait_milestone(pair.pc2(),
+                             mrsConnectionMilestone::kFirstAudioFrameDecoded));
+  ASSERT_TRUE(wait_milestone(pair.pc2(),
+                             mrsConnectionMilestone::kFirstVideoFrameDecoded));
+  const int64_t first_packet_us =
+      elapsed_us(mrsConnectionMilestone::kFirstRtpPacketReceived);
+  ASSERT_LE(0, first_packet_us);
+  ASSERT_LE(first_packet_us,
+            elapsed_us(mrsConnectionMilestone::kFirstAudioFrameDecoded));
+  ASSERT_LE(first_packet_us,
+            elapsed_us(mrsConnectionMilestone::kFirstVideoFrameDecoded));
+
+  // #1 does not receive any media.
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetConnectionMilestones(pair.pc1(), &milestones));
+  ASSERT_EQ(-1, elapsed_us(mrsConnectionMilestone::kFirstAudioFrameDecoded));
+  ASSERT_EQ(-1, elapsed_us(mrsConnectionMilestone::kFirstVideoFrameDecoded));
+
+  mrsTransceiverSetLocalVideoTrack(video_transceiver, nullptr);
+  mrsRefCountedObjectRemoveRef(video_track);
+  mrsExternalVideoTrackSourceShutdown(video_source);
+  mrsRefCountedObjectRemoveRef(video_source);
+}
+
+TEST_P(PeerConnectionTests, Prewarm) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+
+  // Invalid pool size
+  {
+    pc_config.ice_candidate_pool_size = -1;
+    mrsPeerConnectionHandle handle{};
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionCreate(&pc_config, &handle));
+    ASSERT_EQ(nullptr, handle);
+  }
+
+  pc_config.ice_candidate_pool_size = 1;
+  pc_config.continual_gathering_policy =
+      mrsContinualGatheringPolicy::kGatherOnce;
+  LocalPeerPairRaii pair(pc_config);
+
+  ASSERT_EQ(Result::kInvalidNativeHandle, mrsPeerConnectionPrewarm(nullptr, 1));
+  ASSERT_EQ(Result::kInvalidParameter, mrsPeerConnectionPrewarm(pair.pc1(), 0));
+
+  // Already pre-gathering from the configuration
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionPrewarm(pair.pc1(), 1));
+
+  // Grow the pool
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionPrewarm(pair.pc1(), 2));
+  ASSERT_EQ(Result::kSuccess, mrsPeerConnectionPrewarm(pair.pc2(), 2));
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  mrsTransceiverHandle transceiver_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &transceiver_handle));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  // The pool is only used by the first local description.
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsPeerConnectionPrewarm(pair.pc1(), 4));
+}
+
+TEST_P(PeerConnectionTests, BandwidthEstimate) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  LocalPeerPairRaii pair(pc_config);
+
+  // Invalid usage
+  mrsBandwidthEstimate estimate{};
+  InteropCallback<const mrsBandwidthEstimate*> estimate_cb;
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionRegisterBandwidthEstimateCallback(
+                nullptr, 100, CB(estimate_cb)));
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsPeerConnectionGetBandwidthEstimate(nullptr, &estimate));
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsPeerConnectionGetBandwidthEstimate(pair.pc1(), nullptr));
+
+  // Not sampling yet
+  ASSERT_EQ(Result::kNotFound,
+            mrsPeerConnectionGetBandwidthEstimate(pair.pc1(), &estimate));
+
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  mrsTransceiverHandle transceiver_handle{};
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &transceiver_handle));
+  pair.ConnectAndWait();
+  ASSERT_TRUE(pair.WaitExchangeCompletedFor(5s));
+
+  // Wait for a few samples
+  std::atomic_uint32_t sample_count{0};
+  Event ev_samples;
+  estimate_cb = [&](const mrsBandwidthEstimate* sample) {
+    ASSERT_NE(nullptr, sample);
+    ASSERT_LE(0.0, sample->available_outgoing_bitrate_bps);
+    ASSERT_LE(0.0, sample->round_trip_time_ms);
+    if (++sample_count == 3) {
+      ev_samples.Set();
+    }
+  };
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRegisterBandwidthEstimateCallback(
+                pair.pc1(), 10, CB(estimate_cb)));
+  ASSERT_TRUE(ev_samples.WaitFor(5s));
+
+  // The latest sample is available synchronously
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetBandwidthEstimate(pair.pc1(), &estimate));
+  ASSERT_LT(0, estimate.timestamp_us);
+  ASSERT_LT(0u, estimate.bytes_sent);
+
+  // Stop sampling; the latest sample stays available
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRegisterBandwidthEstimateCallback(
+                pair.pc1(), 0, nullptr, nullptr));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetBandwidthEstimate(pair.pc1(), &estimate));
+
+  // Close while sampling and reading the estimate from another thread. The
+  // latest sample stays available, but sampling cannot be restarted.
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionRegisterBandwidthEstimateCallback(
+                pair.pc1(), 10, nullptr, nullptr));
+  std::atomic_bool closed{false};
+  std::thread reader_thread([&pair, &closed]() {
+    mrsBandwidthEstimate sample{};
+    while (!closed.load()) {
+      EXPECT_EQ(Result::kSuccess,
+                mrsPeerConnectionGetBandwidthEstimate(pair.pc1(), &sample));
+    }
+  });
+  EXPECT_EQ(Result::kSuccess, mrsPeerConnectionClose(pair.pc1()));
+  closed = true;
+  reader_thread.join();
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionGetBandwidthEstimate(pair.pc1(), &estimate));
+  ASSERT_EQ(Result::kInvalidOperation,
+            mrsPeerConnectionRegisterBandwidthEstimateCallback(
+                pair.pc1(), 10, nullptr, nullptr));
+}
+
+TEST_P(PeerConnectionTests, UnregisterCallbackWaitsForInvocation) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = GetParam();
+  PCRaii pc(pc_config);
+  ASSERT_NE(nullptr, pc.handle());
+
+  // Block the callback until told to return.
+  Event entered;
+  Event release;
+  InteropCallback<> renegotiation_needed_cb([&entered, &release]() {
+    entered.Set();
+    release.Wait();
+  });
+  mrsPeerConnectionRegisterRenegotiationNeededCallback(
+      pc.handle(), CB(renegotiation_needed_cb));
+
+  // Adding a transceiver synchronously fires the callback on the signaling
+  // thread, so do it from another thread.
+  std::thread add_thread([&pc]() {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    mrsTransceiverHandle transceiver_handle{};
+    mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                    &transceiver_handle);
+  });
+  ASSERT_TRUE(entered.WaitFor(5s));
+
+  // Unregistering does not return while the callback is running.
+  std::atomic_bool unregistered{false};
+  std::thread unregister_thread([&pc, &unregistered]() {
+    mrsPeerConnectionRegisterRenegotiationNeededCallback(pc.handle(), nullptr,
+                                                         nullptr);
+    unregistered = true;
+  });
+  std::this_thread::sleep_for(100ms);
+  EXPECT_FALSE(unregistered.load());
+  release.Set();
+  unregister_thread.join();
+  add_thread.join();
+  ASSERT_TRUE(unregistered.load());
+}
+
+namespace {
+
+void MRS_CALL NoOpCallback(void* /*user_data*/) {}
+
+}  // namespace
+
+// Replacing a callback only waits for the invocations of the previous one, and
+// not for the invocations of the new one started meanwhile.
+TEST(CallbackSlotTests, StoreIgnoresNewInvocations) {
+  using VoidCallback = Callback<>;
+  CallbackSlot<VoidCallback> slot;
+  int data1 = 1;
+  int data2 = 2;
+  slot.Store(VoidCallback{&NoOpCallback, &data1});
+
+  // Hold a lease on the first callback.
+  Event entered1;
+  Event release1;
+  std::thread thread1([&]() {
+    auto cb = slot.Load();
+    EXPECT_EQ(&data1, static_cast<const VoidCallback&>(cb).user_data_);
+    entered1.Set();
+    release1.Wait();
+  });
+  ASSERT_TRUE(entered1.WaitFor(5s));
+
+  // Replace it, which waits for the first lease.
+  Event stored;
+  std::thread store_thread([&]() {
+    slot.Store(VoidCallback{&NoOpCallback, &data2});
+    stored.Set();
+  });
+
+  // Hold a lease on the second callback once published.
+  Event entered2;
+  Event release2;
+  std::thread thread2([&]() {
+    for (;;) {
+      auto cb = slot.Load();
+      if (static_cast<const VoidCallback&>(cb).user_data_ == &data2) {
+        entered2.Set();
+        release2.Wait();
+        return;
+      }
+      std::this_thread::yield();
+    }
+  });
+  EXPECT_TRUE(entered2.WaitFor(5s));
+  std::this_thread::sleep_for(100ms);
+  EXPECT_FALSE(stored.IsSignaled());
+
+  // Releasing the first lease completes the store, while the second lease is
+  // still held.
+  release1.Set();
+  EXPECT_TRUE(stored.WaitFor(5s));
+  release2.Set();
+  thread1.join();
+  thread2.join();
+  store_thread.join();
+}
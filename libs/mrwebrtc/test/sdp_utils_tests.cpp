@@ -3,7 +3,11 @@
 
 #include "pch.h"
 
+#include <map>
+#include <string>
+
 #include "interop_api.h"
+#include "transceiver_interop.h"
 
 // Copied from webrtc\pc\webrtcsdp_unittest.cc
 static const char kSdpFullString[] =
@@ -206,3 +210,168 @@ TEST(SdpUtils, IsValidToken) {
     ASSERT_EQ(mrsBool::kTrue, mrsSdpIsValidToken(str));
   }
 }
+
+namespace {
+
+class SdpUtilsTests : public TestUtils::TestBase {};
+
+/// Get the Opus format parameters of the media line at the given index of an
+/// SDP message, as a map of (key, value) pairs, or an empty map if that media
+/// line has no Opus codec or no format parameters.
+std::map<std::string, std::string> GetOpusFormatParameters(
+    const std::string& sdp,
+    int mline_index) {
+  std::map<std::string, std::string> params;
+  size_t begin = 0;
+  for (int i = 0; i <= mline_index; ++i) {
+    begin = sdp.find("\r\nm=", begin);
+    if (begin == std::string::npos) {
+      return params;
+    }
+    begin += 2;
+  }
+  const std::string mline =
+      sdp.substr(begin, sdp.find("\r\nm=", begin) - begin);
+  const size_t rtpmap_end = mline.find(" opus/48000/2\r\n");
+  if (rtpmap_end == std::string::npos) {
+    return params;
+  }
+  const size_t payload_type_begin = mline.rfind(':', rtpmap_end) + 1;
+  const std::string fmtp = "a=fmtp:" +
+                           mline.substr(payload_type_begin,
+                                        rtpmap_end - payload_type_begin) +
+                           " ";
+  size_t pos = mline.find(fmtp);
+  if (pos == std::string::npos) {
+    return params;
+  }
+  pos += fmtp.size();
+  const size_t end = mline.find("\r\n", pos);
+  while (pos < end) {
+    size_t sep = mline.find(';', pos);
+    if ((sep == std::string::npos) || (sep > end)) {
+      sep = end;
+    }
+    const size_t eq = mline.find('=', pos);
+    if (eq < sep) {
+      params[mline.substr(pos, eq - pos)] =
+          mline.substr(eq + 1, sep - eq - 1);
+    }
+    pos = sep + 1;
+  }
+  return params;
+}
+
+/// Parameters exercising all fields, with values different from the WebRTC
+/// defaults.
+mrsAudioSendParameters MakeOpusParameters() {
+  mrsAudioSendParameters params{};
+  params.frame_duration_ms = 40;
+  params.dtx = mrsOptBool::kTrue;
+  params.inband_fec = mrsOptBool::kFalse;
+  params.stereo = mrsOptBool::kTrue;
+  params.max_average_bitrate_bps = 32000;
+  return params;
+}
+
+/// Check that none of the parameters of |MakeOpusParameters()| were written to
+/// some Opus format parameters.
+void CheckNoOpusParameters(const std::map<std::string, std::string>& params) {
+  ASSERT_EQ(0u, params.count("ptime"));
+  ASSERT_EQ(0u, params.count("usedtx"));
+  ASSERT_EQ(0u, params.count("stereo"));
+  ASSERT_EQ(0u, params.count("maxaveragebitrate"));
+  auto it = params.find("useinbandfec");
+  if (it != params.end()) {
+    ASSERT_NE("0", it->second);
+  }
+}
+
+/// Create a local offer or answer on the given peer connection, and return it
+/// without applying it to any remote peer.
+std::string CreateLocalDescription(mrsPeerConnectionHandle pc, bool offer) {
+  std::string sdp;
+  Event ev;
+  SdpCallback sdp_cb(pc, [&](mrsSdpMessageType /*type*/, const char* sdp_data) {
+    sdp = sdp_data;
+    ev.Set();
+  });
+  EXPECT_EQ(Result::kSuccess, offer ? mrsPeerConnectionCreateOffer(pc)
+                                    : mrsPeerConnectionCreateAnswer(pc));
+  EXPECT_TRUE(ev.WaitFor(60s));
+  return sdp;
+}
+
+}  // namespace
+
+// The Opus encoder parameters of an audio transceiver only apply to the remote
+// descriptions, and are never signaled to the remote peer in the local offer
+// or answer. Negotiating with them succeeds, and once the sender is
+// negotiated the maximum bitrate is applied to its encoding.
+TEST_F(SdpUtilsTests, OpusSendParametersNotSignaled) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = mrsSdpSemantic::kUnifiedPlan;
+  PCRaii pc1(pc_config);
+  PCRaii pc2(pc_config);
+  const mrsMediaKind kinds[] = {mrsMediaKind::kAudio, mrsMediaKind::kVideo,
+                                mrsMediaKind::kAudio};
+  mrsTransceiverHandle transceivers[3]{};
+  for (int i = 0; i < 3; ++i) {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.media_kind = kinds[i];
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pc1.handle(), &transceiver_config,
+                                              &transceivers[i]));
+  }
+  const mrsAudioSendParameters params = MakeOpusParameters();
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetAudioSendParameters(transceivers[2], &params));
+
+  const std::string offer = CreateLocalDescription(pc1.handle(), true);
+  ASSERT_FALSE(offer.empty());
+  CheckNoOpusParameters(GetOpusFormatParameters(offer, 0));
+  CheckNoOpusParameters(GetOpusFormatParameters(offer, 2));
+  Event ev;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionSetRemoteDescriptionAsync(
+                pc2.handle(), mrsSdpMessageType::kOffer, offer.c_str(),
+                &TestUtils::SetEventOnCompleted, &ev));
+  ASSERT_TRUE(ev.WaitFor(60s));
+  ev.Reset();
+  const std::string answer = CreateLocalDescription(pc2.handle(), false);
+  ASSERT_FALSE(answer.empty());
+  CheckNoOpusParameters(GetOpusFormatParameters(answer, 2));
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionSetRemoteDescriptionAsync(
+                pc1.handle(), mrsSdpMessageType::kAnswer, answer.c_str(),
+                &TestUtils::SetEventOnCompleted, &ev));
+  ASSERT_TRUE(ev.WaitFor(60s));
+
+  // The sender now has an encoding to apply the maximum bitrate to.
+  mrsAudioSendParameters other_params{};
+  other_params.max_average_bitrate_bps = 64000;
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetAudioSendParameters(
+                                  transceivers[2], &other_params));
+}
+
+// With Plan B the parameters are not signaled either.
+TEST_F(SdpUtilsTests, OpusSendParametersPlanB) {
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = mrsSdpSemantic::kPlanB;
+  PCRaii pc(pc_config);
+  mrsTransceiverHandle transceivers[3]{};
+  for (int i = 0; i < 3; ++i) {
+    mrsTransceiverInitConfig transceiver_config{};
+    transceiver_config.media_kind = mrsMediaKind::kAudio;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pc.handle(), &transceiver_config,
+                                              &transceivers[i]));
+  }
+  const mrsAudioSendParameters params = MakeOpusParameters();
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetAudioSendParameters(transceivers[1], &params));
+
+  const std::string sdp = CreateLocalDescription(pc.handle(), true);
+  ASSERT_FALSE(sdp.empty());
+  CheckNoOpusParameters(GetOpusFormatParameters(sdp, 0));
+}
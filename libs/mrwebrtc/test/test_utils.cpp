@@ -3,6 +3,10 @@
 
 #include "pch.h"
 
+#include "device_audio_track_source_interop.h"
+#include "local_audio_track_interop.h"
+#include "transceiver_interop.h"
+
 #include "test_utils.h"
 
 namespace TestUtils {
@@ -15,6 +19,76 @@ void MRS_CALL SetEventOnCompleted(void* user_data,
   ev->Set();
 }
 
+HeadlessAudioDeviceRaii::HeadlessAudioDeviceRaii(
+    const mrsHeadlessAudioDeviceConfig& config)
+    : previous_adm_(mrsLibraryGetAudioDeviceModule()) {
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsLibraryUseAudioDeviceModule(mrsAudioDeviceModule::kHeadless));
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsLibrarySetHeadlessAudioDeviceConfig(&config));
+}
+
+HeadlessAudioDeviceRaii::~HeadlessAudioDeviceRaii() {
+  // Reset the static configuration, which otherwise persists across tests.
+  const mrsHeadlessAudioDeviceConfig default_config{};
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsLibrarySetHeadlessAudioDeviceConfig(&default_config));
+  EXPECT_EQ(mrsResult::kSuccess, mrsLibraryUseAudioDeviceModule(previous_adm_));
+}
+
+ApplicationAudioDeviceRaii::ApplicationAudioDeviceRaii(
+    const mrsApplicationAudioDeviceConfig& config)
+    : previous_adm_(mrsLibraryGetAudioDeviceModule()) {
+  EXPECT_EQ(mrsResult::kSuccess, mrsLibraryUseAudioDeviceModule(
+                                     mrsAudioDeviceModule::kApplication));
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsLibrarySetApplicationAudioDeviceConfig(&config));
+}
+
+ApplicationAudioDeviceRaii::~ApplicationAudioDeviceRaii() {
+  const mrsApplicationAudioDeviceConfig default_config{};
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsLibrarySetApplicationAudioDeviceConfig(&default_config));
+  EXPECT_EQ(mrsResult::kSuccess, mrsLibraryUseAudioDeviceModule(previous_adm_));
+}
+
+ThreadGroupCountRaii::ThreadGroupCountRaii(uint32_t count) {
+  EXPECT_EQ(mrsResult::kSuccess, mrsLibrarySetThreadGroupCount(count));
+}
+
+ThreadGroupCountRaii::~ThreadGroupCountRaii() {
+  EXPECT_EQ(mrsResult::kSuccess, mrsLibrarySetThreadGroupCount(1));
+}
+
+LocalAudioSenderRaii::LocalAudioSenderRaii(mrsPeerConnectionHandle peer_handle,
+                                           const char* name) {
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = name;
+  transceiver_config.media_kind = mrsMediaKind::kAudio;
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsPeerConnectionAddTransceiver(peer_handle, &transceiver_config,
+                                            &transceiver_));
+  mrsLocalAudioDeviceInitConfig device_config{};
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsDeviceAudioTrackSourceCreate(&device_config, &source_));
+  mrsLocalAudioTrackInitSettings init_settings{};
+  init_settings.track_name = name;
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsLocalAudioTrackCreateFromSource(&init_settings, source_,
+                                               &track_));
+  EXPECT_EQ(mrsResult::kSuccess,
+            mrsTransceiverSetLocalAudioTrack(transceiver_, track_));
+}
+
+LocalAudioSenderRaii::~LocalAudioSenderRaii() {
+  if (track_) {
+    mrsRefCountedObjectRemoveRef(track_);
+  }
+  if (source_) {
+    mrsRefCountedObjectRemoveRef(source_);
+  }
+}
+
 std::string SdpSemanticToString(
     const testing::TestParamInfo<mrsSdpSemantic>& info) {
   switch (info.param) {
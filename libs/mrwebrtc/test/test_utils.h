@@ -25,6 +25,64 @@ void MRS_CALL SetEventOnCompleted(void* user_data,
                                   mrsResult result,
                                   const char* error_message);
 
+/// Select the headless audio device module with the given configuration for
+/// the lifetime of the object, so that audio flows through the library without
+/// any audio device, then restore the previously selected module and the
+/// default headless configuration. This must be created before the library is
+/// initialized, and destroyed after it shut down, that is before and after any
+/// other object of the test. The headless module is not available on UWP.
+class HeadlessAudioDeviceRaii {
+ public:
+  explicit HeadlessAudioDeviceRaii(
+      const mrsHeadlessAudioDeviceConfig& config = {});
+  ~HeadlessAudioDeviceRaii();
+
+ private:
+  mrsAudioDeviceModule previous_adm_;
+};
+
+/// Select the application-driven audio device module with the given
+/// configuration for the lifetime of the object, like
+/// |HeadlessAudioDeviceRaii|. The test drives the audio device by pulling and
+/// pushing audio with |mrsAudioDevicePullPlayout()| and
+/// |mrsAudioDevicePushCapture()|.
+class ApplicationAudioDeviceRaii {
+ public:
+  explicit ApplicationAudioDeviceRaii(
+      const mrsApplicationAudioDeviceConfig& config = {});
+  ~ApplicationAudioDeviceRaii();
+
+ private:
+  mrsAudioDeviceModule previous_adm_;
+};
+
+/// Set the number of thread groups of the library for the lifetime of the
+/// object, then restore a single group. Like the audio device module, this
+/// must be created before the library is initialized, and destroyed after it
+/// shut down.
+class ThreadGroupCountRaii {
+ public:
+  explicit ThreadGroupCountRaii(uint32_t count);
+  ~ThreadGroupCountRaii();
+};
+
+/// Audio transceiver added to a peer connection, and sending a local audio
+/// track captured from the audio device module. All objects are released on
+/// destruction.
+class LocalAudioSenderRaii {
+ public:
+  LocalAudioSenderRaii(mrsPeerConnectionHandle peer_handle, const char* name);
+  ~LocalAudioSenderRaii();
+
+  mrsTransceiverHandle transceiver() const { return transceiver_; }
+  mrsLocalAudioTrackHandle track() const { return track_; }
+
+ private:
+  mrsTransceiverHandle transceiver_{};
+  mrsDeviceAudioTrackSourceHandle source_{};
+  mrsLocalAudioTrackHandle track_{};
+};
+
 constexpr const mrsSdpSemantic TestSemantics[] = {mrsSdpSemantic::kUnifiedPlan,
                                                   mrsSdpSemantic::kPlanB};
 
@@ -532,14 +532,174 @@ TYPED_TEST_P(TransceiverTests, StreamIDs) {
   pair.WaitExchangeCompletedFor(60s);
 }
 
+TYPED_TEST_P(TransceiverTests, SetAudioSendParameters) {
+  mrsAudioSendParameters params{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSetAudioSendParameters(nullptr, &params));
+
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  LocalPeerPairRaii pair(pc_config);
+  mrsTransceiverHandle transceiver_handle{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "transceiver_1";
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_NE(nullptr, transceiver_handle);
+
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetAudioSendParameters(transceiver_handle, nullptr));
+
+  params.frame_duration_ms = 20;
+  params.dtx = mrsOptBool::kTrue;
+  params.inband_fec = mrsOptBool::kTrue;
+  params.max_average_bitrate_bps = 32000;
+  if (TypeParam::kMediaKind == mrsMediaKind::kVideo) {
+    ASSERT_EQ(Result::kInvalidMediaKind, mrsTransceiverSetAudioSendParameters(
+                                             transceiver_handle, &params));
+    return;
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetAudioSendParameters(transceiver_handle, &params));
+
+  // Opus does not support 30 ms frames, nor bitrates below 6 kbps.
+  mrsAudioSendParameters invalid_params = params;
+  invalid_params.frame_duration_ms = 30;
+  ASSERT_EQ(Result::kInvalidParameter, mrsTransceiverSetAudioSendParameters(
+                                           transceiver_handle, &invalid_params));
+  invalid_params = params;
+  invalid_params.max_average_bitrate_bps = 1000;
+  ASSERT_EQ(Result::kInvalidParameter, mrsTransceiverSetAudioSendParameters(
+                                           transceiver_handle, &invalid_params));
+
+  // Parameters set before connecting are applied during negotiation.
+  pair.ConnectAndWait();
+  ASSERT_EQ(Result::kSuccess,
+            mrsTransceiverSetAudioSendParameters(transceiver_handle, &params));
+}
+
+TYPED_TEST_P(TransceiverTests, SetVideoEncodingParameters) {
+  mrsVideoEncodingParameters encoding{};
+  ASSERT_EQ(Result::kInvalidNativeHandle,
+            mrsTransceiverSetVideoEncodingParameters(nullptr, &encoding, 1));
+
+  mrsPeerConnectionConfiguration pc_config{};
+  pc_config.sdp_semantic = TypeParam::kSdpSemantic;
+  LocalPeerPairRaii pair(pc_config);
+  mrsTransceiverHandle transceiver_handle{};
+  mrsTransceiverInitConfig transceiver_config{};
+  transceiver_config.name = "transceiver_1";
+  transceiver_config.media_kind = TypeParam::kMediaKind;
+
+  // Simulcast encodings must have distinct RIDs.
+  mrsVideoEncodingParameters simulcast[2]{};
+  simulcast[0].rid = "h";
+  simulcast[1].rid = "h";
+  simulcast[1].scale_resolution_down_by = 2.0;
+  transceiver_config.send_encodings = simulcast;
+  transceiver_config.send_encoding_count = 2;
+  if (TypeParam::kMediaKind == mrsMediaKind::kAudio) {
+    ASSERT_EQ(Result::kInvalidMediaKind,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+  } else {
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+    simulcast[1].rid = nullptr;
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+
+    // Valid simulcast encodings cannot be negotiated by WebRTC M71.
+    simulcast[1].rid = "l";
+    ASSERT_EQ(Result::kUnsupported,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+  }
+  ASSERT_EQ(nullptr, transceiver_handle);
+
+  // Scale-down factors cannot upscale.
+  encoding.scale_resolution_down_by = 0.5;
+  transceiver_config.send_encodings = &encoding;
+  transceiver_config.send_encoding_count = 1;
+  if (TypeParam::kMediaKind == mrsMediaKind::kVideo) {
+    ASSERT_EQ(Result::kInvalidParameter,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+    ASSERT_EQ(nullptr, transceiver_handle);
+  }
+  encoding.scale_resolution_down_by = 0.0;
+  encoding.max_bitrate_bps = 500000;
+
+  // Plan B senders only exist once a track is attached.
+  if ((TypeParam::kMediaKind == mrsMediaKind::kVideo) &&
+      (TypeParam::kSdpSemantic == mrsSdpSemantic::kPlanB)) {
+    ASSERT_EQ(Result::kUnsupported,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+    transceiver_config.send_encodings = nullptr;
+    transceiver_config.send_encoding_count = 0;
+    ASSERT_EQ(Result::kSuccess,
+              mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                              &transceiver_handle));
+    ASSERT_NE(nullptr, transceiver_handle);
+    ASSERT_EQ(Result::kInvalidOperation,
+              mrsTransceiverSetVideoEncodingParameters(transceiver_handle,
+                                                       &encoding, 1));
+    return;
+  }
+
+  transceiver_config.send_encodings = nullptr;
+  transceiver_config.send_encoding_count = 0;
+  if (TypeParam::kMediaKind == mrsMediaKind::kVideo) {
+    transceiver_config.send_encodings = &encoding;
+    transceiver_config.send_encoding_count = 1;
+  }
+  ASSERT_EQ(Result::kSuccess,
+            mrsPeerConnectionAddTransceiver(pair.pc1(), &transceiver_config,
+                                            &transceiver_handle));
+  ASSERT_NE(nullptr, transceiver_handle);
+
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetVideoEncodingParameters(transceiver_handle,
+                                                     nullptr, 1));
+  if (TypeParam::kMediaKind == mrsMediaKind::kAudio) {
+    ASSERT_EQ(Result::kInvalidMediaKind,
+              mrsTransceiverSetVideoEncodingParameters(transceiver_handle,
+                                                       &encoding, 1));
+    return;
+  }
+
+  // The number of encodings cannot change without renegotiating.
+  mrsVideoEncodingParameters encodings[2]{};
+  ASSERT_EQ(Result::kInvalidParameter,
+            mrsTransceiverSetVideoEncodingParameters(transceiver_handle,
+                                                     encodings, 2));
+
+  // Encodings can be deactivated and limited before and after connecting.
+  encoding.active = mrsBool::kFalse;
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetVideoEncodingParameters(
+                                  transceiver_handle, &encoding, 1));
+  pair.ConnectAndWait();
+  encoding.active = mrsBool::kTrue;
+  encoding.max_bitrate_bps = 250000;
+  ASSERT_EQ(Result::kSuccess, mrsTransceiverSetVideoEncodingParameters(
+                                  transceiver_handle, &encoding, 1));
+}
+
 // Note: All tests must be listed in this macro
 REGISTER_TYPED_TEST_CASE_P(TransceiverTests,
                            InvalidName,
+                           SetAudioSendParameters,
                            SetDirection,
                            SetDirection_InvalidHandle,
                            SetLocalTrack_InvalidHandle,
                            SetLocalTrackSendRecv,
                            SetLocalTrackRecvOnly,
+                           SetVideoEncodingParameters,
                            StreamIDs);
 
 using TestTypes = ::testing::Types<TestParams<AudioTest, SdpPlanB>,
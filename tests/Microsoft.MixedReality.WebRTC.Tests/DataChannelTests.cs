@@ -137,6 +137,25 @@ namespace Microsoft.MixedReality.WebRTC.Tests
             }
         }
 
+        [Test]
+        public async Task PartialReliability()
+        {
+            // Invalid limits are rejected before any native call
+            Assert.Throws<ArgumentOutOfRangeException>(() => pc1_.AddDataChannelAsync(42, "dummy", false, false, -2, null));
+            Assert.Throws<ArgumentOutOfRangeException>(() => pc1_.AddDataChannelAsync(42, "dummy", false, false, null, -2));
+            Assert.Throws<ArgumentException>(() => pc1_.AddDataChannelAsync(42, "dummy", false, false, 0, 100));
+            Assert.Throws<ArgumentException>(() => pc1_.AddDataChannelAsync(42, "dummy", false, true, 0, null));
+            Assert.Throws<ArgumentException>(() => pc1_.AddDataChannelAsync("dummy", false, true, null, 100));
+
+            // Partially reliable channels are unreliable
+            DataChannel data1 = await pc1_.AddDataChannelAsync(42, "rtx", ordered: false, reliable: false, maxRetransmits: 0, maxPacketLifeTimeMs: null);
+            Assert.IsNotNull(data1);
+            Assert.False(data1.Reliable);
+            DataChannel data2 = await pc1_.AddDataChannelAsync(43, "lifetime", ordered: true, reliable: false, maxRetransmits: null, maxPacketLifeTimeMs: 100);
+            Assert.IsNotNull(data2);
+            Assert.False(data2.Reliable);
+        }
+
         [Test]
         public void SctpError()
         {